@@ -0,0 +1,340 @@
+/**
+ * @file ConsoleCommandAlloc.h
+ * @brief 按命令和处理阶段统计内存分配
+ * @details 用于排查分配次数回归的插桩构建。定义 CCM_ALLOC_ACCOUNTING 后，
+ *          CommandManager 在分词、验证、帮助生成、执行各阶段标记当前阶段和命令，
+ *          替换后的全局 operator new/delete 把每次分配的次数和字节数记到当前阶段和当前命令上。
+ *
+ * 使用方式：
+ * - 所有翻译单元定义 CCM_ALLOC_ACCOUNTING，启用阶段标记和 stats 输出中的分配统计
+ * - 恰好一个翻译单元额外定义 CCM_ALLOC_DEFINE_OPERATORS，在其中生成替换的 operator new/delete
+ * - CMake 目标 filemanager_alloccount 就是这样构建的示例程序，退出时把分配报告写到标准错误
+ *
+ * 未定义 CCM_ALLOC_ACCOUNTING 时阶段标记展开为空语句，没有任何开销。
+ *
+ * 计数器是全局的 relaxed 原子变量：分配钩子里不能再分配内存，也不能依赖线程本地对象的构造，
+ * 所以没有使用 ConsoleCommandStats.h 的分片方案。插桩构建只用于定位问题，原子加法的开销可以接受。
+ */
+
+#ifndef CONSOLE_COMMAND_ALLOC_H
+#define CONSOLE_COMMAND_ALLOC_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ConsoleCommand {
+
+/**
+ * @brief 命令处理阶段
+ */
+enum class AllocPhase : uint8_t {
+    Other,      ///< 不在任何标记阶段内（命令自身以外的程序代码）
+    Parse,      ///< 分词和命令行解析
+    Validate,   ///< 参数验证
+    Help,       ///< 帮助文本生成
+    Dispatch,   ///< 命令执行
+    Count
+};
+
+const size_t ALLOC_PHASE_COUNT = static_cast<size_t>(AllocPhase::Count);
+const size_t ALLOC_MAX_COMMANDS = 1024;             ///< 单独统计的命令数，ID更大的命令计入最后一项
+const uint32_t ALLOC_NO_COMMAND = 0xFFFFFFFFu;      ///< 当前没有命令在执行
+
+/**
+ * @brief 一组分配计数
+ */
+struct AllocCounters {
+    uint64_t allocations = 0;  ///< 分配次数
+    uint64_t bytes = 0;        ///< 分配字节数
+    uint64_t frees = 0;        ///< 释放次数
+};
+
+namespace detail {
+
+struct AllocSlot {
+    std::atomic<uint64_t> allocations{0};
+    std::atomic<uint64_t> bytes{0};
+    std::atomic<uint64_t> frees{0};
+
+    AllocCounters load() const {
+        AllocCounters c;
+        c.allocations = allocations.load(std::memory_order_relaxed);
+        c.bytes = bytes.load(std::memory_order_relaxed);
+        c.frees = frees.load(std::memory_order_relaxed);
+        return c;
+    }
+
+    void clear() {
+        allocations.store(0, std::memory_order_relaxed);
+        bytes.store(0, std::memory_order_relaxed);
+        frees.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 线程当前所处的阶段和命令
+ * @details 平凡类型，常量初始化，分配钩子访问时不会触发线程本地对象的构造
+ */
+struct AllocThreadState {
+    AllocPhase phase;
+    uint32_t commandId;
+};
+
+} // namespace detail
+
+/**
+ * @class AllocAccounting
+ * @brief 进程级分配计数
+ */
+class AllocAccounting {
+public:
+    /**
+     * @brief 当前构建是否启用了分配统计
+     */
+    static constexpr bool compiledIn() {
+#ifdef CCM_ALLOC_ACCOUNTING
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    /**
+     * @brief 记录一次分配，由 operator new 调用
+     */
+    static void onAllocate(size_t size) {
+        const detail::AllocThreadState& t = threadState;
+        detail::AllocSlot& p = phases[static_cast<size_t>(t.phase)];
+        p.allocations.fetch_add(1, std::memory_order_relaxed);
+        p.bytes.fetch_add(size, std::memory_order_relaxed);
+        if (t.commandId != ALLOC_NO_COMMAND) {
+            detail::AllocSlot& c = commandSlot(t.commandId);
+            c.allocations.fetch_add(1, std::memory_order_relaxed);
+            c.bytes.fetch_add(size, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 记录一次释放，由 operator delete 调用
+     */
+    static void onFree() {
+        const detail::AllocThreadState& t = threadState;
+        phases[static_cast<size_t>(t.phase)].frees.fetch_add(1, std::memory_order_relaxed);
+        if (t.commandId != ALLOC_NO_COMMAND) {
+            commandSlot(t.commandId).frees.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    /**
+     * @brief 获取某个阶段的计数
+     */
+    static AllocCounters phase(AllocPhase p) {
+        return phases[static_cast<size_t>(p)].load();
+    }
+
+    /**
+     * @brief 获取某个命令的计数
+     */
+    static AllocCounters command(uint32_t commandId) {
+        return commandSlot(commandId).load();
+    }
+
+    /**
+     * @brief 清空所有计数
+     */
+    static void reset() {
+        for (auto& p : phases) p.clear();
+        for (auto& c : commands) c.clear();
+    }
+
+    /**
+     * @brief 获取阶段名称
+     */
+    static const char* phaseName(AllocPhase p) {
+        switch (p) {
+            case AllocPhase::Other:    return "other";
+            case AllocPhase::Parse:    return "parse";
+            case AllocPhase::Validate: return "validate";
+            case AllocPhase::Help:     return "help";
+            case AllocPhase::Dispatch: return "dispatch";
+            default:                   return "?";
+        }
+    }
+
+    /**
+     * @brief 输出分配报告：各阶段合计和有分配的命令
+     * @param os 输出流
+     * @param commandNames 命令ID到名称的映射
+     */
+    static void writeReport(std::ostream& os, const std::vector<std::string>& commandNames) {
+        // 先取完所有数字再输出，避免输出流自身的分配混进报告
+        AllocCounters phaseCounts[ALLOC_PHASE_COUNT];
+        for (size_t i = 0; i < ALLOC_PHASE_COUNT; ++i) {
+            phaseCounts[i] = phase(static_cast<AllocPhase>(i));
+        }
+        std::vector<std::pair<size_t, AllocCounters>> rows;
+        for (size_t id = 0; id < commandNames.size() && id < ALLOC_MAX_COMMANDS; ++id) {
+            AllocCounters c = command(static_cast<uint32_t>(id));
+            if (c.allocations > 0 || c.frees > 0) rows.emplace_back(id, c);
+        }
+
+        os << "阶段/命令       " << "        分配" << "          字节" << "        释放" << "   字节/次\n";
+        os << std::string(64, '-') << "\n";
+        for (size_t i = 0; i < ALLOC_PHASE_COUNT; ++i) {
+            writeRow(os, std::string("[") + phaseName(static_cast<AllocPhase>(i)) + "]", phaseCounts[i]);
+        }
+        for (const auto& row : rows) {
+            const std::string& name = commandNames[row.first];
+            bool overflow = row.first + 1 == ALLOC_MAX_COMMANDS && commandNames.size() > ALLOC_MAX_COMMANDS;
+            writeRow(os, overflow ? "(other)" : name, row.second);
+        }
+    }
+
+    /**
+     * @class Scope
+     * @brief 作用域阶段标记，析构时恢复外层的阶段和命令
+     */
+    class Scope {
+    private:
+        detail::AllocThreadState saved;
+
+    public:
+        explicit Scope(AllocPhase p) : saved(threadState) {
+            threadState.phase = p;
+        }
+
+        Scope(AllocPhase p, uint32_t commandId) : saved(threadState) {
+            threadState.phase = p;
+            threadState.commandId = commandId;
+        }
+
+        ~Scope() {
+            threadState = saved;
+        }
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+private:
+    static inline detail::AllocSlot phases[ALLOC_PHASE_COUNT];
+    static inline detail::AllocSlot commands[ALLOC_MAX_COMMANDS];
+    static inline thread_local detail::AllocThreadState threadState{AllocPhase::Other, ALLOC_NO_COMMAND};
+
+    static detail::AllocSlot& commandSlot(uint32_t commandId) {
+        return commands[commandId < ALLOC_MAX_COMMANDS ? commandId : ALLOC_MAX_COMMANDS - 1];
+    }
+
+    static void writeRow(std::ostream& os, const std::string& label, const AllocCounters& c) {
+        uint64_t perAlloc = c.allocations ? c.bytes / c.allocations : 0;
+        os << std::left << std::setw(16) << label << std::right
+           << std::setw(12) << c.allocations << std::setw(14) << c.bytes
+           << std::setw(12) << c.frees << std::setw(10) << perAlloc << "\n";
+    }
+};
+
+} // namespace ConsoleCommand
+
+#ifdef CCM_ALLOC_ACCOUNTING
+#define CCM_ALLOC_CONCAT_INNER(a, b) a##b
+#define CCM_ALLOC_CONCAT(a, b) CCM_ALLOC_CONCAT_INNER(a, b)
+/// 把当前作用域内的分配计入指定阶段
+#define CCM_ALLOC_PHASE(phase) \
+    ::ConsoleCommand::AllocAccounting::Scope CCM_ALLOC_CONCAT(ccmAllocScope, __LINE__)(phase)
+/// 把当前作用域内的分配计入指定阶段和命令
+#define CCM_ALLOC_PHASE_CMD(phase, commandId) \
+    ::ConsoleCommand::AllocAccounting::Scope CCM_ALLOC_CONCAT(ccmAllocScope, __LINE__)(phase, commandId)
+#else
+#define CCM_ALLOC_PHASE(phase) ((void)0)
+#define CCM_ALLOC_PHASE_CMD(phase, commandId) ((void)0)
+#endif
+
+// ============================================================================
+// 替换的全局 operator new/delete（只在一个翻译单元中生成）
+// ============================================================================
+
+#if defined(CCM_ALLOC_ACCOUNTING) && defined(CCM_ALLOC_DEFINE_OPERATORS)
+
+#include <cstdlib>
+#include <new>
+
+namespace ConsoleCommand {
+namespace detail {
+
+inline void* accountedAllocate(size_t size, size_t alignment, bool nothrow) {
+    if (size == 0) size = 1;
+    for (;;) {
+        void* p = nullptr;
+        if (alignment <= alignof(std::max_align_t)) {
+            p = std::malloc(size);
+        } else if (::posix_memalign(&p, alignment, size) != 0) {
+            p = nullptr;
+        }
+        if (p) {
+            AllocAccounting::onAllocate(size);
+            return p;
+        }
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) {
+            if (nothrow) return nullptr;
+            throw std::bad_alloc();
+        }
+        handler();
+    }
+}
+
+inline void accountedFree(void* p) noexcept {
+    if (!p) return;
+    AllocAccounting::onFree();
+    std::free(p);
+}
+
+} // namespace detail
+} // namespace ConsoleCommand
+
+void* operator new(std::size_t size) {
+    return ConsoleCommand::detail::accountedAllocate(size, 0, false);
+}
+void* operator new[](std::size_t size) {
+    return ConsoleCommand::detail::accountedAllocate(size, 0, false);
+}
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    try { return ConsoleCommand::detail::accountedAllocate(size, 0, true); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    try { return ConsoleCommand::detail::accountedAllocate(size, 0, true); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t al) {
+    return ConsoleCommand::detail::accountedAllocate(size, static_cast<size_t>(al), false);
+}
+void* operator new[](std::size_t size, std::align_val_t al) {
+    return ConsoleCommand::detail::accountedAllocate(size, static_cast<size_t>(al), false);
+}
+void* operator new(std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    try { return ConsoleCommand::detail::accountedAllocate(size, static_cast<size_t>(al), true); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, std::align_val_t al, const std::nothrow_t&) noexcept {
+    try { return ConsoleCommand::detail::accountedAllocate(size, static_cast<size_t>(al), true); } catch (...) { return nullptr; }
+}
+
+void operator delete(void* p) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete(void* p, std::size_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p, std::size_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete(void* p, std::align_val_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p, std::align_val_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept { ConsoleCommand::detail::accountedFree(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { ConsoleCommand::detail::accountedFree(p); }
+
+#endif // CCM_ALLOC_ACCOUNTING && CCM_ALLOC_DEFINE_OPERATORS
+
+#endif // CONSOLE_COMMAND_ALLOC_H
@@ -0,0 +1,443 @@
+/**
+ * @file ConsoleCommandCatalog.h
+ * @brief 按消息ID解析命令帮助文本的消息目录
+ * @details 描述、示例和帮助文本只在用户请求帮助时才被读取，却和命令定义一起常驻内存。
+ *          设置了消息ID的命令（CommandDefinition::setMessageId）在显示时从当前的消息目录中取得文本，
+ *          注册时可以不提供这些文本；切换语言只需加载另一个目录，不需要重新注册命令。
+ *
+ * 设计要点：
+ * - 目录由文本源文件编译为二进制文件（MessageCatalog::compile 或 catalog compile 内置命令），
+ *   加载时用 mmap 映射，只检查文件头，条目在查找时才被读入（按需分页）
+ * - 解析结果复制为 std::string 返回，不引用映射，也不进入 StringPool：
+ *   查找不需要池的全局锁，重新加载目录后旧文本随映射一起释放
+ * - 查找用文件中的开放寻址哈希表（FNV-1a，与标准库实现无关），键按 前缀 + 后缀 分段比较，不拼接字符串
+ * - 当前目录用 shared_ptr 原子发布，查找不加锁；每次查找在复制出文本前持有映射，
+ *   切换或卸载后，最后一个进行中的查找结束时旧的映射即被释放
+ * - 当前目录是进程级的：同一进程中所有 CommandManager（及其副本）共用，
+ *   catalog load/off 内置命令在任意管理器中执行都会影响全部管理器
+ *
+ * 源文件格式（UTF-8）：每行一个 "键 = 文本"，'#' 开头的行和空行忽略；
+ * 文本中 \n、\t、\\ 转义为换行、制表符和反斜杠。命令使用的键见 CommandDefinition::setMessageId。
+ */
+
+#ifndef CONSOLE_COMMAND_CATALOG_H
+#define CONSOLE_COMMAND_CATALOG_H
+
+#include "ConsoleCommandIntern.h"
+
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ConsoleCommand {
+
+namespace detail {
+
+constexpr char CATALOG_MAGIC[8] = {'C', 'C', 'M', 'C', 'A', 'T', 'L', '\0'};
+constexpr uint32_t CATALOG_VERSION = 1;
+constexpr uint32_t CATALOG_BYTE_ORDER = 0x01020304;
+
+/**
+ * @brief 目录文件头
+ */
+struct CatalogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;    ///< sizeof(CatalogHeader)
+    uint32_t count;         ///< 条目数
+    uint32_t capacity;      ///< 哈希表槽位数，2 的幂
+    uint32_t reserved;
+    uint64_t fileSize;
+    uint64_t slotsOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+/**
+ * @brief 哈希表槽位，key 为 0 表示空槽位
+ */
+struct CatalogSlot {
+    uint32_t hash;
+    uint32_t key;       ///< 键的字符串偏移
+    uint32_t text;      ///< 文本的字符串偏移，0 表示空文本
+};
+
+/** @brief FNV-1a，可以分段计算 */
+inline uint32_t catalogHash(std::string_view s, uint32_t h = 2166136261u) {
+    for (unsigned char c : s) {
+        h ^= c;
+        h *= 16777619u;
+    }
+    return h;
+}
+
+/**
+ * @class CatalogFile
+ * @brief 映射的目录文件
+ */
+class CatalogFile {
+public:
+    /**
+     * @brief 映射并检查目录文件
+     * @return 成功时返回映射，失败返回空指针
+     */
+    static std::unique_ptr<CatalogFile> open(const std::string& path, std::string& errorMsg) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            errorMsg = "无法打开 " + path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) < 0 || static_cast<size_t>(st.st_size) < sizeof(CatalogHeader)) {
+            errorMsg = path + " 不是消息目录（文件太小）";
+            ::close(fd);
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            errorMsg = "无法映射 " + path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        std::unique_ptr<CatalogFile> file(new CatalogFile(static_cast<const char*>(addr), size, path));
+        if (!file->validate(errorMsg)) {
+            errorMsg = path + ": " + errorMsg;
+            return nullptr;
+        }
+        return file;
+    }
+
+    ~CatalogFile() { ::munmap(const_cast<char*>(base), size); }
+
+    CatalogFile(const CatalogFile&) = delete;
+    CatalogFile& operator=(const CatalogFile&) = delete;
+
+    const std::string& path() const { return filePath; }
+    size_t bytes() const { return size; }
+    size_t count() const { return header().count; }
+
+    /**
+     * @brief 查找键 prefix + suffix
+     * @return 文本的字符数据（前有长度，后有 '\0'），不存在时返回nullptr
+     */
+    const char* find(std::string_view prefix, std::string_view suffix) const {
+        const CatalogHeader& h = header();
+        uint32_t hash = catalogHash(suffix, catalogHash(prefix));
+        const CatalogSlot* slots = reinterpret_cast<const CatalogSlot*>(base + h.slotsOffset);
+        size_t mask = h.capacity - 1;
+        for (size_t i = hash & mask, n = 0; n < h.capacity; i = (i + 1) & mask, ++n) {
+            const CatalogSlot& slot = slots[i];
+            if (slot.key == 0) return nullptr;
+            if (slot.hash != hash) continue;
+            std::string_view key = view(slot.key);
+            if (key.size() == prefix.size() + suffix.size() && key.compare(0, prefix.size(), prefix) == 0 &&
+                key.compare(prefix.size(), suffix.size(), suffix) == 0) {
+                const char* text = string(slot.text);
+                return text ? text : emptyText();
+            }
+        }
+        return nullptr;
+    }
+
+private:
+    const char* base;
+    size_t size;
+    std::string filePath;
+
+    CatalogFile(const char* b, size_t s, const std::string& p) : base(b), size(s), filePath(p) {}
+
+    const CatalogHeader& header() const { return *reinterpret_cast<const CatalogHeader*>(base); }
+
+    static const char* emptyText() {
+        alignas(uint32_t) static const char empty[sizeof(uint32_t) + 1] = {};
+        return empty + sizeof(uint32_t);
+    }
+
+    /** @brief 字符串偏移对应的字符数据，越界时返回nullptr */
+    const char* string(uint32_t offset) const {
+        const CatalogHeader& h = header();
+        if (offset < sizeof(uint32_t) || offset >= h.stringsSize) return nullptr;
+        const char* data = base + h.stringsOffset + offset;
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(uint32_t), sizeof(n));
+        if (n >= h.stringsSize - offset || data[n] != '\0') return nullptr;
+        return data;
+    }
+
+    std::string_view view(uint32_t offset) const {
+        const char* data = string(offset);
+        if (!data) return std::string_view();
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(uint32_t), sizeof(n));
+        return std::string_view(data, n);
+    }
+
+    bool validate(std::string& errorMsg) const {
+        const CatalogHeader& h = header();
+        if (std::memcmp(h.magic, CATALOG_MAGIC, sizeof(h.magic)) != 0) {
+            errorMsg = "不是消息目录";
+            return false;
+        }
+        if (h.byteOrder != CATALOG_BYTE_ORDER || h.version != CATALOG_VERSION ||
+            h.headerSize != sizeof(CatalogHeader)) {
+            errorMsg = "消息目录的版本或字节序与本机不兼容";
+            return false;
+        }
+        if (h.fileSize != size) {
+            errorMsg = "消息目录文件不完整";
+            return false;
+        }
+        if (h.capacity == 0 || (h.capacity & (h.capacity - 1)) != 0 || h.count >= h.capacity ||
+            h.slotsOffset % alignof(CatalogSlot) != 0 || h.slotsOffset > size ||
+            h.capacity > (size - h.slotsOffset) / sizeof(CatalogSlot) ||
+            h.stringsOffset > size || h.stringsSize > size - h.stringsOffset || h.stringsSize > UINT32_MAX) {
+            errorMsg = "消息目录的段超出文件范围";
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace detail
+
+/**
+ * @class MessageCatalog
+ * @brief 进程级的当前消息目录
+ * @details 所有 CommandManager 共用同一个当前目录，切换对整个进程生效
+ */
+class MessageCatalog {
+public:
+    /**
+     * @brief 加载目录并设为当前目录
+     * @param path 编译后的目录文件
+     * @param errorMsg 失败时的错误信息
+     * @return 成功返回true；失败时当前目录不变
+     */
+    static bool load(const std::string& path, std::string& errorMsg) {
+        std::unique_ptr<detail::CatalogFile> file = detail::CatalogFile::open(path, errorMsg);
+        if (!file) {
+            return false;
+        }
+        publish(std::shared_ptr<const detail::CatalogFile>(std::move(file)));
+        return true;
+    }
+
+    /**
+     * @brief 不再使用消息目录，之后显示注册时的文本
+     * @details 映射在进行中的查找结束后释放
+     */
+    static void unload() {
+        publish(nullptr);
+    }
+
+    /** @brief 当前目录的文件路径，未加载时为空 */
+    static std::string path() {
+        std::shared_ptr<const detail::CatalogFile> file = current();
+        return file ? file->path() : std::string();
+    }
+
+    /** @brief 当前目录的条目数 */
+    static size_t size() {
+        std::shared_ptr<const detail::CatalogFile> file = current();
+        return file ? file->count() : 0;
+    }
+
+    /**
+     * @brief 解析 id + suffix 对应的文本
+     * @param id 消息ID，为空时直接返回 fallback
+     * @param suffix 键的后缀，例如 ".description"
+     * @param fallback 目录中没有该键时返回的文本
+     * @return 目录中文本的副本（不引用映射）或 fallback 的副本
+     */
+    static std::string resolve(const PooledString& id, std::string_view suffix, const PooledString& fallback) {
+        if (id.empty()) return fallback.str();
+        std::shared_ptr<const detail::CatalogFile> file = current();
+        const char* text = file ? file->find(id.view(), suffix) : nullptr;
+        return text ? std::string(textView(text)) : fallback.str();
+    }
+
+    /**
+     * @brief 查找 id + suffix 并复制文本
+     * @param text 输出参数，找到时存储文本
+     * @return id 为空、没有当前目录或目录中没有该键时返回false
+     */
+    static bool find(const PooledString& id, std::string_view suffix, std::string& text) {
+        if (id.empty()) return false;
+        std::shared_ptr<const detail::CatalogFile> file = current();
+        const char* data = file ? file->find(id.view(), suffix) : nullptr;
+        if (!data) return false;
+        text.assign(textView(data));
+        return true;
+    }
+
+    /**
+     * @brief 把源文件编译为目录文件
+     * @param sourcePath 源文件（"键 = 文本" 格式）
+     * @param outputPath 输出文件，先写临时文件再原子替换
+     * @param errorMsg 失败时的错误信息（包含行号）
+     * @return 成功返回true
+     */
+    static bool compile(const std::string& sourcePath, const std::string& outputPath, std::string& errorMsg) {
+        std::ifstream in(sourcePath, std::ios::binary);
+        if (!in) {
+            errorMsg = "无法打开 " + sourcePath + ": " + std::strerror(errno);
+            return false;
+        }
+
+        std::vector<std::pair<std::string, std::string>> entries;
+        std::unordered_map<std::string, size_t> seen;
+        std::string line;
+        for (size_t lineNo = 1; std::getline(in, line); ++lineNo) {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t begin = line.find_first_not_of(" \t");
+            if (begin == std::string::npos || line[begin] == '#') continue;
+            size_t eq = line.find('=', begin);
+            std::string where = sourcePath + ":" + std::to_string(lineNo);
+            if (eq == std::string::npos) {
+                errorMsg = where + ": 缺少 '='";
+                return false;
+            }
+            size_t keyEnd = line.find_last_not_of(" \t", eq - 1);
+            if (eq == begin || keyEnd == std::string::npos || keyEnd < begin) {
+                errorMsg = where + ": 键为空";
+                return false;
+            }
+            std::string key = line.substr(begin, keyEnd + 1 - begin);
+            size_t valueBegin = line.find_first_not_of(" \t", eq + 1);
+            std::string text;
+            if (!unescape(valueBegin == std::string::npos ? std::string_view() :
+                          std::string_view(line).substr(valueBegin), text)) {
+                errorMsg = where + ": 无效的转义序列";
+                return false;
+            }
+            if (!seen.emplace(key, lineNo).second) {
+                errorMsg = where + ": 键 " + key + " 与第 " + std::to_string(seen[key]) + " 行重复";
+                return false;
+            }
+            entries.emplace_back(std::move(key), std::move(text));
+        }
+        return write(entries, outputPath, errorMsg);
+    }
+
+private:
+    struct State {
+        std::shared_ptr<const detail::CatalogFile> active;  ///< 只通过 std::atomic_load/atomic_store 访问
+    };
+
+    static State& state() {
+        static State* s = new State();  // 不析构：静态对象析构后其他线程仍可能在查找
+        return *s;
+    }
+
+    static std::shared_ptr<const detail::CatalogFile> current() {
+        return std::atomic_load_explicit(&state().active, std::memory_order_acquire);
+    }
+
+    static void publish(std::shared_ptr<const detail::CatalogFile> file) {
+        std::atomic_store_explicit(&state().active, std::move(file), std::memory_order_release);
+    }
+
+    /** @brief 目录中字符数据（前有 4 字节长度）对应的文本 */
+    static std::string_view textView(const char* data) {
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(uint32_t), sizeof(n));
+        return std::string_view(data, n);
+    }
+
+    static bool unescape(std::string_view in, std::string& out) {
+        for (size_t i = 0; i < in.size(); ++i) {
+            if (in[i] != '\\') {
+                out.push_back(in[i]);
+                continue;
+            }
+            if (++i == in.size()) return false;
+            switch (in[i]) {
+                case 'n': out.push_back('\n'); break;
+                case 't': out.push_back('\t'); break;
+                case '\\': out.push_back('\\'); break;
+                default: return false;
+            }
+        }
+        return true;
+    }
+
+    static bool write(const std::vector<std::pair<std::string, std::string>>& entries,
+                      const std::string& path, std::string& errorMsg) {
+        std::string strings(sizeof(uint32_t), '\0');   // 偏移 0 保留给空字符串
+        auto addString = [&strings](std::string_view s) -> uint32_t {
+            if (s.empty()) return 0;
+            uint32_t n = static_cast<uint32_t>(s.size());
+            strings.append(reinterpret_cast<const char*>(&n), sizeof(n));
+            uint32_t offset = static_cast<uint32_t>(strings.size());
+            strings.append(s.data(), s.size());
+            strings.push_back('\0');
+            return offset;
+        };
+
+        uint32_t capacity = 16;
+        while (capacity < entries.size() * 2) capacity *= 2;   // 负载不超过 0.5
+        std::vector<detail::CatalogSlot> slots(capacity, detail::CatalogSlot{0, 0, 0});
+        for (const auto& entry : entries) {
+            uint32_t hash = detail::catalogHash(entry.first);
+            size_t i = hash & (capacity - 1);
+            while (slots[i].key != 0) i = (i + 1) & (capacity - 1);
+            slots[i].hash = hash;
+            slots[i].key = addString(entry.first);
+            slots[i].text = addString(entry.second);
+        }
+        if (strings.size() > UINT32_MAX) {
+            errorMsg = "消息目录的字符串区超过 4GB";
+            return false;
+        }
+
+        detail::CatalogHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, detail::CATALOG_MAGIC, sizeof(h.magic));
+        h.version = detail::CATALOG_VERSION;
+        h.byteOrder = detail::CATALOG_BYTE_ORDER;
+        h.headerSize = sizeof(detail::CatalogHeader);
+        h.count = static_cast<uint32_t>(entries.size());
+        h.capacity = capacity;
+        h.slotsOffset = sizeof(detail::CatalogHeader);
+        h.stringsOffset = h.slotsOffset + slots.size() * sizeof(detail::CatalogSlot);
+        h.stringsSize = strings.size();
+        h.fileSize = h.stringsOffset + h.stringsSize;
+
+        std::string out(reinterpret_cast<const char*>(&h), sizeof(h));
+        out.append(reinterpret_cast<const char*>(slots.data()), slots.size() * sizeof(detail::CatalogSlot));
+        out += strings;
+
+        std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        {
+            std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+            if (!file || !file.write(out.data(), static_cast<std::streamsize>(out.size())) || !file.flush()) {
+                errorMsg = "写入 " + tmp + " 失败";
+                ::unlink(tmp.c_str());
+                return false;
+            }
+        }
+        if (::rename(tmp.c_str(), path.c_str()) < 0) {
+            errorMsg = "重命名为 " + path + " 失败: " + std::strerror(errno);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_CATALOG_H
@@ -0,0 +1,1015 @@
+/**
+ * @file ConsoleCommandFileOps.h
+ * @brief 文件命令使用的批量文件操作
+ * @details 示例文件管理器的 ls、cat、cp 在大目录、大文件和大目录树上的实现：
+ *          - OutputSink：输出是进程的标准输出时直接写文件描述符，其他输出流（服务器连接等）写 ostream，
+ *            调用者按大块写出，不再每行刷新一次
+ *          - DirectoryLister：用 getdents64 成批读取目录项，用 d_type 判断类型，
+ *            只对需要大小或 -l 字段的目录项调用 statx，并且只请求需要的字段；
+ *            输出拼接到缓冲区中成块写出，不保存整个目录
+ *          - WorkStealingPool：每个线程一个任务双端队列，空闲线程从其他线程的队列头部窃取任务
+ *          - TreeCopier：在 WorkStealingPool 上并行遍历和复制目录树，文件数据依次尝试
+ *            FICLONE（reflink）、copy_file_range、大块 read/write，并保留权限、属主和时间戳
+ *
+ * DirectoryLister 和 TreeCopier 只在 Linux 上可用（定义 CCM_HAS_FAST_FS），其他平台由调用者使用 std::filesystem。
+ */
+
+#ifndef CONSOLE_COMMAND_FILE_OPS_H
+#define CONSOLE_COMMAND_FILE_OPS_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#if defined(__linux__) && defined(STATX_SIZE)
+#define CCM_HAS_FAST_FS 1
+#include <dirent.h>
+#include <grp.h>
+#include <pwd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#if defined(__has_include) && __has_include(<linux/fs.h>)
+#include <linux/fs.h>
+#endif
+#ifndef FICLONE
+#define FICLONE _IOW(0x94, 9, int)
+#endif
+#endif
+
+namespace ConsoleCommand {
+
+/**
+ * @class OutputSink
+ * @brief 命令的大块输出目标
+ */
+class OutputSink {
+public:
+    /**
+     * @param os 命令的输出流
+     * @param fd 不小于 0 时直接写这个文件描述符（先刷新 os 和 stdio 中已缓冲的内容），否则写 os
+     */
+    OutputSink(std::ostream& os, int fd = -1) : os(os), fd(fd) {
+        if (fd >= 0) {
+            os.flush();
+            std::fflush(stdout);
+        }
+    }
+
+    /** @brief os 是进程的标准输出时直接写 STDOUT_FILENO，否则写 os */
+    static OutputSink forStream(std::ostream& os) {
+        return OutputSink(os, &os == &std::cout ? STDOUT_FILENO : -1);
+    }
+
+    /** @brief 输出的文件描述符，写 ostream 时为 -1 */
+    int descriptor() const { return fd; }
+
+    bool write(const char* data, size_t size, std::string& error) {
+        if (fd < 0) {
+            os.write(data, static_cast<std::streamsize>(size));
+            return true;
+        }
+        while (size > 0) {
+            ssize_t n = ::write(fd, data, size);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("写入失败: ") + std::strerror(errno);
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    bool write(const std::string& data, std::string& error) { return write(data.data(), data.size(), error); }
+
+    void flush() { os.flush(); }
+
+private:
+    std::ostream& os;
+    int fd;
+};
+
+#ifdef CCM_HAS_FAST_FS
+
+namespace detail {
+
+/** @brief getdents64 返回的记录 */
+struct Dirent64 {
+    uint64_t d_ino;
+    int64_t d_off;
+    unsigned short d_reclen;
+    unsigned char d_type;
+    char d_name[1];
+};
+
+} // namespace detail
+
+/**
+ * @brief 目录列表的选项
+ */
+struct ListOptions {
+    bool showAll = false;       ///< 包括以 '.' 开头的项（. 和 .. 除外）
+    bool longFormat = false;    ///< 每项显示类型和权限、链接数、属主、大小、修改时间
+};
+
+/**
+ * @brief 一次列表的计数
+ */
+struct ListStats {
+    uint64_t entries = 0;       ///< 读到的目录项数（含 . 和 ..）
+    uint64_t shown = 0;         ///< 输出的项数
+    uint64_t batches = 0;       ///< getdents64 调用次数
+    uint64_t statCalls = 0;     ///< statx 调用次数
+};
+
+/**
+ * @class DirectoryLister
+ * @brief 用 getdents64 和按需 statx 列出目录
+ * @details 默认格式与 std::filesystem 实现相同："[DIR] 名称" 或 "[FILE] 名称 (N bytes)"，
+ *          类型跟随符号链接。d_type 为目录时不调用 statx；普通文件只请求 STATX_SIZE；
+ *          符号链接和 d_type 未知的项才请求类型。-l 对每项请求一次不跟随链接的 statx。
+ *          输出顺序是目录项在目录中的顺序（与 directory_iterator 相同），不排序，
+ *          因此内存占用与目录大小无关
+ */
+class DirectoryLister {
+public:
+    static constexpr size_t DENTS_BUFFER = 1 << 20;     ///< 每次 getdents64 读取的字节数
+    static constexpr size_t OUTPUT_BUFFER = 256 * 1024; ///< 输出缓冲区写出阈值
+
+    /**
+     * @brief 列出目录
+     * @param path 目录路径
+     * @param options 选项
+     * @param out 输出目标
+     * @param error 失败时的错误信息
+     * @param stats 不为空时写入计数
+     * @return 成功返回true
+     */
+    static bool list(const std::string& path, const ListOptions& options, OutputSink& out,
+                     std::string& error, ListStats* stats = nullptr) {
+        int dir = ::open(path.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir < 0) {
+            error = "无法打开目录 " + path + ": " + std::strerror(errno);
+            return false;
+        }
+
+        DirectoryLister lister(dir, options);
+        bool ok = lister.run(out, error);
+        ::close(dir);
+        if (stats) *stats = lister.stats;
+        return ok;
+    }
+
+private:
+    int dir;
+    ListOptions options;
+    ListStats stats;
+    std::string pending;
+    std::unordered_map<uint32_t, std::string> users;    ///< uid 到用户名，-l 时按需查询
+    std::unordered_map<uint32_t, std::string> groups;
+
+    DirectoryLister(int d, const ListOptions& o) : dir(d), options(o) {
+        pending.reserve(OUTPUT_BUFFER + 4096);
+    }
+
+    bool run(OutputSink& out, std::string& error) {
+        std::unique_ptr<char[]> buffer(new char[DENTS_BUFFER]);
+        for (;;) {
+            long n = ::syscall(SYS_getdents64, dir, buffer.get(), DENTS_BUFFER);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("读取目录失败: ") + std::strerror(errno);
+                return false;
+            }
+            if (n == 0) break;
+            ++stats.batches;
+
+            for (long offset = 0; offset < n;) {
+                const detail::Dirent64* d = reinterpret_cast<const detail::Dirent64*>(buffer.get() + offset);
+                offset += d->d_reclen;
+                ++stats.entries;
+                const char* name = d->d_name;
+                if (name[0] == '.' &&
+                    (!options.showAll || name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+                    continue;
+                }
+                ++stats.shown;
+                if (options.longFormat) {
+                    appendLong(name);
+                } else {
+                    appendShort(name, d->d_type);
+                }
+                if (pending.size() >= OUTPUT_BUFFER) {
+                    if (!out.write(pending, error)) return false;
+                    pending.clear();
+                }
+            }
+        }
+        if (!out.write(pending, error)) return false;
+        pending.clear();
+        out.flush();
+        return true;
+    }
+
+    bool statAt(const char* name, int flags, unsigned mask, struct statx& stx) {
+        ++stats.statCalls;
+        return ::statx(dir, name, flags | AT_STATX_DONT_SYNC, mask, &stx) == 0;
+    }
+
+    void appendNumber(uint64_t value) {
+        char digits[24];
+        int len = std::snprintf(digits, sizeof(digits), "%llu", static_cast<unsigned long long>(value));
+        pending.append(digits, static_cast<size_t>(len));
+    }
+
+    void appendShort(const char* name, unsigned char type) {
+        bool isDirectory = type == DT_DIR;
+        bool isRegular = type == DT_REG;
+        uint64_t size = 0;
+        bool haveSize = false;
+        struct statx stx;
+        if (isRegular) {
+            if (statAt(name, AT_SYMLINK_NOFOLLOW, STATX_SIZE, stx)) {
+                haveSize = (stx.stx_mask & STATX_SIZE) != 0;
+                size = stx.stx_size;
+            }
+        } else if (type == DT_LNK || type == DT_UNKNOWN) {
+            // 与 directory_entry 的 is_directory/is_regular_file 一样跟随符号链接
+            if (statAt(name, 0, STATX_TYPE | STATX_SIZE, stx)) {
+                isDirectory = S_ISDIR(stx.stx_mode);
+                isRegular = S_ISREG(stx.stx_mode);
+                haveSize = isRegular && (stx.stx_mask & STATX_SIZE);
+                size = stx.stx_size;
+            }
+        }
+        pending.append(isDirectory ? "[DIR] " : "[FILE] ");
+        pending.append(name);
+        if (haveSize) {
+            pending.append(" (");
+            appendNumber(size);
+            pending.append(" bytes)");
+        }
+        pending.push_back('\n');
+    }
+
+    void appendLong(const char* name) {
+        struct statx stx;
+        const unsigned mask = STATX_TYPE | STATX_MODE | STATX_NLINK | STATX_UID | STATX_GID |
+                              STATX_SIZE | STATX_MTIME;
+        if (!statAt(name, AT_SYMLINK_NOFOLLOW, mask, stx)) {
+            pending.append("?????????? ");
+            pending.append(name);
+            pending.push_back('\n');
+            return;
+        }
+
+        char mode[11];
+        formatMode(stx.stx_mode, mode);
+        char time[32] = "";
+        std::time_t mtime = static_cast<std::time_t>(stx.stx_mtime.tv_sec);
+        struct tm tm;
+        if (localtime_r(&mtime, &tm)) std::strftime(time, sizeof(time), "%Y-%m-%d %H:%M", &tm);
+
+        char line[160];
+        int len = std::snprintf(line, sizeof(line), "%s %3u %-8s %-8s %12llu %s ", mode,
+                                static_cast<unsigned>(stx.stx_nlink), userName(stx.stx_uid).c_str(),
+                                groupName(stx.stx_gid).c_str(),
+                                static_cast<unsigned long long>(stx.stx_size), time);
+        pending.append(line, static_cast<size_t>(std::min<int>(len, sizeof(line) - 1)));
+        pending.append(name);
+        if (S_ISLNK(stx.stx_mode)) {
+            char target[4096];
+            ssize_t n = ::readlinkat(dir, name, target, sizeof(target));
+            if (n > 0) {
+                pending.append(" -> ");
+                pending.append(target, static_cast<size_t>(n));
+            }
+        }
+        pending.push_back('\n');
+    }
+
+    static void formatMode(uint32_t m, char out[11]) {
+        out[0] = S_ISDIR(m) ? 'd' : S_ISLNK(m) ? 'l' : S_ISCHR(m) ? 'c' : S_ISBLK(m) ? 'b' :
+                 S_ISFIFO(m) ? 'p' : S_ISSOCK(m) ? 's' : '-';
+        const char* rwx = "rwxrwxrwx";
+        for (int i = 0; i < 9; ++i) out[1 + i] = (m & (0400 >> i)) ? rwx[i] : '-';
+        if (m & S_ISUID) out[3] = (m & S_IXUSR) ? 's' : 'S';
+        if (m & S_ISGID) out[6] = (m & S_IXGRP) ? 's' : 'S';
+        if (m & S_ISVTX) out[9] = (m & S_IXOTH) ? 't' : 'T';
+        out[10] = '\0';
+    }
+
+    const std::string& userName(uint32_t uid) {
+        auto it = users.find(uid);
+        if (it != users.end()) return it->second;
+        struct passwd pw;
+        struct passwd* result = nullptr;
+        char buffer[1024];
+        std::string name = ::getpwuid_r(uid, &pw, buffer, sizeof(buffer), &result) == 0 && result
+            ? std::string(result->pw_name) : std::to_string(uid);
+        return users.emplace(uid, std::move(name)).first->second;
+    }
+
+    const std::string& groupName(uint32_t gid) {
+        auto it = groups.find(gid);
+        if (it != groups.end()) return it->second;
+        struct group gr;
+        struct group* result = nullptr;
+        char buffer[1024];
+        std::string name = ::getgrgid_r(gid, &gr, buffer, sizeof(buffer), &result) == 0 && result
+            ? std::string(result->gr_name) : std::to_string(gid);
+        return groups.emplace(gid, std::move(name)).first->second;
+    }
+};
+
+// ============================================================================
+// 并行目录树复制
+// ============================================================================
+
+/**
+ * @class WorkStealingPool
+ * @brief 任务窃取线程池
+ * @details 每个线程有自己的任务双端队列：在任务中提交的新任务压入当前线程队列的尾部，
+ *          并由该线程从尾部取出（深度优先，刚打开的目录很快处理完）；
+ *          自己的队列为空时从其他线程队列的头部窃取（广度方向上较早、通常较大的子树）。
+ *          run() 在调用线程和 threads-1 个新线程上执行，直到所有任务（包括任务中提交的任务）完成
+ */
+class WorkStealingPool {
+public:
+    using Task = std::function<void()>;
+
+    /**
+     * @param threads 线程数，0 表示 std::thread::hardware_concurrency()
+     */
+    explicit WorkStealingPool(unsigned threads) {
+        if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+        for (unsigned i = 0; i < threads; ++i) queues.emplace_back(new Queue());
+    }
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    /** @brief 线程数 */
+    unsigned size() const { return static_cast<unsigned>(queues.size()); }
+
+    /**
+     * @brief 提交任务
+     * @details 在本池的任务中调用时压入当前线程的队列，否则压入第一个队列
+     */
+    void submit(Task task) {
+        size_t index = current().pool == this ? current().index : 0;
+        pending.fetch_add(1, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(queues[index]->mutex);
+            queues[index]->tasks.push_back(std::move(task));
+        }
+        idle.notify_one();
+    }
+
+    /**
+     * @brief 执行 root 以及它直接或间接提交的所有任务，全部完成后返回
+     */
+    void run(Task root) {
+        submit(std::move(root));
+        std::vector<std::thread> workers;
+        for (size_t i = 1; i < queues.size(); ++i) {
+            workers.emplace_back([this, i] { workerLoop(i); });
+        }
+        workerLoop(0);
+        for (auto& t : workers) t.join();
+    }
+
+private:
+    struct alignas(64) Queue {
+        std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+
+    struct Worker {
+        WorkStealingPool* pool = nullptr;
+        size_t index = 0;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::atomic<size_t> pending{0};     ///< 已提交但尚未执行完的任务数
+    std::mutex idleMutex;
+    std::condition_variable idle;
+
+    static Worker& current() {
+        static thread_local Worker worker;
+        return worker;
+    }
+
+    bool take(size_t index, Task& task) {
+        {
+            Queue& own = *queues[index];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (size_t k = 1; k < queues.size(); ++k) {
+            Queue& victim = *queues[(index + k) % queues.size()];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(size_t index) {
+        Worker saved = current();
+        current() = Worker{this, index};
+        Task task;
+        for (;;) {
+            if (take(index, task)) {
+                task();
+                task = nullptr;
+                if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1) idle.notify_all();
+                continue;
+            }
+            if (pending.load(std::memory_order_acquire) == 0) break;
+            // 没有可取的任务，但其他线程的任务还可能提交新任务；短暂等待后重试（通知可能早于等待）
+            std::unique_lock<std::mutex> lock(idleMutex);
+            idle.wait_for(lock, std::chrono::milliseconds(1));
+        }
+        current() = saved;
+    }
+};
+
+/**
+ * @brief 目录树复制的选项
+ */
+struct CopyOptions {
+    unsigned threads = 0;       ///< 线程数，0 表示 CPU 核数
+    bool overwrite = false;     ///< 覆盖已存在的文件和符号链接（目录总是合并）
+};
+
+/**
+ * @brief 一次复制的计数
+ */
+struct CopyStats {
+    uint64_t files = 0;         ///< 复制的普通文件数
+    uint64_t directories = 0;   ///< 复制的目录数（含顶层目录）
+    uint64_t symlinks = 0;      ///< 复制的符号链接数
+    uint64_t bytes = 0;         ///< 普通文件的总字节数
+    uint64_t reflinked = 0;     ///< 用 FICLONE 共享数据块的文件数
+    uint64_t rangeCopied = 0;   ///< 用 copy_file_range 在内核中复制的文件数
+    uint64_t bufferCopied = 0;  ///< 用 read/write 复制的文件数
+    uint64_t errors = 0;        ///< 失败的项数
+    unsigned threads = 0;       ///< 使用的线程数
+    double seconds = 0.0;       ///< 总耗时
+};
+
+/**
+ * @class TreeCopier
+ * @brief 并行复制文件或目录树
+ * @details 语义与 std::filesystem::copy 的递归复制一致：源是目录时把其内容复制到目标目录
+ *          （不存在则创建，已存在则合并）；源是文件且目标是已存在的目录时复制到目标目录下的同名文件。
+ *          与 std::filesystem::copy 不同的是，树中的符号链接按链接本身复制（cp -a 的行为），
+ *          命名管道用 mkfifo 重建，其他特殊文件记为失败；硬链接的文件各自复制一份。
+ *
+ * 执行方式：
+ * - 每个目录是一个任务：用 getdents64 读取目录项，为子目录 mkdirat 后提交子任务，
+ *   文件按 FILE_BATCH 个一组提交任务，最后一组在当前线程直接复制；
+ *   同一目录的批次共享一对目录描述符，文件用 openat 相对打开，不拼接和解析完整路径
+ * - 文件数据依次尝试 FICLONE、copy_file_range、COPY_BUFFER 大小的 read/write；
+ *   某种方式返回"不支持"后本次复制不再尝试它，避免对数百万个小文件重复失败的系统调用
+ * - 文件的权限、属主（非 root 时失败会被忽略）和访问/修改时间在关闭前设置；
+ *   目录的元数据在所有内容复制完后统一设置，以免创建子项改变修改时间或只读目录无法写入
+ * - 出错的项计数并记录第一个错误，其余项继续复制
+ */
+class TreeCopier {
+public:
+    static constexpr size_t FILE_BATCH = 64;            ///< 每个任务复制的文件数
+    static constexpr size_t COPY_BUFFER = 1 << 20;      ///< read/write 回退路径的缓冲区大小
+
+    /**
+     * @brief 复制文件或目录树
+     * @param source 源路径（跟随符号链接）
+     * @param dest 目标路径
+     * @param options 选项
+     * @param error 失败时的错误信息（有多项失败时为第一个错误）
+     * @param stats 不为空时写入计数
+     * @return 全部复制成功返回true
+     */
+    static bool copy(const std::string& source, const std::string& dest, const CopyOptions& options,
+                     std::string& error, CopyStats* stats = nullptr) {
+        auto start = std::chrono::steady_clock::now();
+        TreeCopier copier(options);
+        bool ok = copier.copyRoot(source, dest, error);
+        if (ok && copier.errorCount.load() > 0) {
+            error = copier.firstError;
+            if (copier.errorCount.load() > 1) {
+                error += " (共 " + std::to_string(copier.errorCount.load()) + " 项失败)";
+            }
+            ok = false;
+        }
+        if (stats) {
+            *stats = copier.totals;
+            stats->errors = copier.errorCount.load();
+            stats->threads = copier.threads;
+            stats->seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        }
+        return ok;
+    }
+
+private:
+    /** @brief 一个目录的源和目标描述符，由该目录的所有批次任务共享 */
+    struct DirPair {
+        int src = -1;
+        int dst = -1;
+        std::string srcPath;
+        std::string dstPath;
+        ~DirPair() {
+            if (src >= 0) ::close(src);
+            if (dst >= 0) ::close(dst);
+        }
+    };
+
+    /** @brief 待复制的目录项 */
+    struct Item {
+        std::string name;
+        unsigned char type;
+    };
+
+    /** @brief 等待设置元数据的目录 */
+    struct PendingDir {
+        std::string path;
+        struct stat st;
+    };
+
+    CopyOptions options;
+    unsigned threads = 1;
+    std::atomic<bool> cloneSupported{true};
+    std::atomic<bool> rangeSupported{true};
+    std::atomic<uint64_t> errorCount{0};
+    std::mutex mutex;                   ///< 保护下面三个字段
+    std::string firstError;
+    CopyStats totals;
+    std::vector<PendingDir> directories;
+
+    uid_t euid;
+    gid_t egid;
+    int umaskBits;                      ///< 进程的 umask，未知时为 -1
+
+    explicit TreeCopier(const CopyOptions& o)
+        : options(o), euid(::geteuid()), egid(::getegid()), umaskBits(readUmask()) {}
+
+    void fail(const std::string& path, const char* what, int err) {
+        if (errorCount.fetch_add(1) == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            firstError = std::string(what) + " " + path + ": " + std::strerror(err);
+        }
+    }
+
+    /** @brief 源和目标是同一个 inode（cp 的 "are the same file"） */
+    void failSameFile(const std::string& source, const std::string& dest) {
+        if (errorCount.fetch_add(1) == 0) {
+            std::lock_guard<std::mutex> lock(mutex);
+            firstError = source + " 与 " + dest + " 是同一个文件";
+        }
+    }
+
+    /** @brief name 已存在且与 st 是同一个文件 */
+    static bool sameFile(int dir, const char* name, int flags, const struct stat& st) {
+        struct stat existing;
+        return ::fstatat(dir, name, &existing, flags) == 0 &&
+               existing.st_dev == st.st_dev && existing.st_ino == st.st_ino;
+    }
+
+    void merge(const CopyStats& local) {
+        std::lock_guard<std::mutex> lock(mutex);
+        totals.files += local.files;
+        totals.directories += local.directories;
+        totals.symlinks += local.symlinks;
+        totals.bytes += local.bytes;
+        totals.reflinked += local.reflinked;
+        totals.rangeCopied += local.rangeCopied;
+        totals.bufferCopied += local.bufferCopied;
+    }
+
+    bool copyRoot(const std::string& source, const std::string& dest, std::string& error) {
+        struct stat st;
+        if (::stat(source.c_str(), &st) < 0) {
+            error = "无法访问 " + source + ": " + std::strerror(errno);
+            return false;
+        }
+        struct stat target;
+        bool destExists = ::stat(dest.c_str(), &target) == 0;
+
+        if (!S_ISDIR(st.st_mode)) {
+            if (!S_ISREG(st.st_mode)) {
+                error = "不支持的文件类型: " + source;
+                return false;
+            }
+            std::string to = dest;
+            if (destExists && S_ISDIR(target.st_mode)) {
+                size_t slash = source.find_last_of('/');
+                to += "/" + (slash == std::string::npos ? source : source.substr(slash + 1));
+            }
+            CopyStats local;
+            copyFile(nullptr, source.c_str(), to.c_str(), local);
+            merge(local);
+            return true;
+        }
+
+        if (destExists && !S_ISDIR(target.st_mode)) {
+            error = "目标不是目录: " + dest;
+            return false;
+        }
+        if (isInside(source, dest)) {
+            error = "不能把目录复制到它自己的子目录中: " + dest;
+            return false;
+        }
+        if (!destExists && ::mkdir(dest.c_str(), 0700) < 0) {
+            error = "无法创建目录 " + dest + ": " + std::strerror(errno);
+            return false;
+        }
+        directories.push_back(PendingDir{dest, st});
+        totals.directories = 1;
+
+        WorkStealingPool pool(options.threads);
+        threads = pool.size();
+        pool.run([this, &pool, source, dest] { copyDirectory(pool, source, dest); });
+
+        // 所有内容已复制，设置目录的属主、权限和时间（子目录先于父目录）
+        for (auto it = directories.rbegin(); it != directories.rend(); ++it) {
+            applyMetadata(AT_FDCWD, it->path.c_str(), it->st, 0);
+        }
+        return true;
+    }
+
+    /** @brief dest 是否是 source 本身或位于 source 之下（dest 可以尚不存在） */
+    static bool isInside(const std::string& source, const std::string& dest) {
+        std::string resolvedDest;
+        if (char* d = ::realpath(dest.c_str(), nullptr)) {
+            resolvedDest = d;
+            std::free(d);
+        } else {
+            size_t slash = dest.find_last_of('/');
+            std::string parent = slash == std::string::npos ? "." : slash == 0 ? "/" : dest.substr(0, slash);
+            char* p = ::realpath(parent.c_str(), nullptr);
+            if (!p) return false;
+            resolvedDest = std::string(p) + "/" + dest.substr(slash == std::string::npos ? 0 : slash + 1);
+            std::free(p);
+        }
+        char* s = ::realpath(source.c_str(), nullptr);
+        if (!s) return false;
+        std::string resolvedSource = s;
+        std::free(s);
+        if (resolvedSource == "/") return true;
+        return resolvedDest == resolvedSource ||
+               resolvedDest.compare(0, resolvedSource.size() + 1, resolvedSource + "/") == 0;
+    }
+
+    /**
+     * @brief 读取一个目录，创建子目录并提交子任务，分批复制文件
+     */
+    void copyDirectory(WorkStealingPool& pool, const std::string& srcPath, const std::string& dstPath) {
+        auto dir = std::make_shared<DirPair>();
+        dir->srcPath = srcPath;
+        dir->dstPath = dstPath;
+        dir->src = ::open(srcPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir->src < 0) {
+            fail(srcPath, "无法打开目录", errno);
+            return;
+        }
+        dir->dst = ::open(dstPath.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+        if (dir->dst < 0) {
+            fail(dstPath, "无法打开目录", errno);
+            return;
+        }
+
+        CopyStats local;
+        std::vector<Item> batch;
+        batch.reserve(FILE_BATCH);
+        std::unique_ptr<char[]> buffer(new char[64 * 1024]);
+        for (;;) {
+            long n = ::syscall(SYS_getdents64, dir->src, buffer.get(), 64 * 1024);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                fail(srcPath, "读取目录失败", errno);
+                break;
+            }
+            if (n == 0) break;
+
+            for (long offset = 0; offset < n;) {
+                const detail::Dirent64* d = reinterpret_cast<const detail::Dirent64*>(buffer.get() + offset);
+                offset += d->d_reclen;
+                const char* name = d->d_name;
+                if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+                // 子目录需要元数据；类型未知时也只能 stat
+                unsigned char type = d->d_type;
+                struct stat st;
+                if (type == DT_UNKNOWN || type == DT_DIR) {
+                    if (::fstatat(dir->src, name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+                        fail(srcPath + "/" + name, "无法访问", errno);
+                        continue;
+                    }
+                    type = S_ISDIR(st.st_mode) ? DT_DIR : S_ISREG(st.st_mode) ? DT_REG :
+                           S_ISLNK(st.st_mode) ? DT_LNK : S_ISFIFO(st.st_mode) ? DT_FIFO : DT_UNKNOWN;
+                }
+
+                if (type == DT_DIR) {
+                    if (::mkdirat(dir->dst, name, 0700) < 0) {
+                        int err = errno;
+                        struct stat existing;
+                        if (err != EEXIST || ::fstatat(dir->dst, name, &existing, 0) < 0 ||
+                            !S_ISDIR(existing.st_mode)) {
+                            fail(dstPath + "/" + name, "无法创建目录", err);
+                            continue;
+                        }
+                    }
+                    std::string childSrc = srcPath + "/" + name;
+                    std::string childDst = dstPath + "/" + name;
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        directories.push_back(PendingDir{childDst, st});
+                    }
+                    ++local.directories;
+                    pool.submit([this, &pool, childSrc, childDst] { copyDirectory(pool, childSrc, childDst); });
+                    continue;
+                }
+
+                batch.push_back(Item{name, type});
+                if (batch.size() == FILE_BATCH) {
+                    pool.submit([this, dir, items = std::move(batch)] { copyItems(*dir, items); });
+                    batch.clear();
+                    batch.reserve(FILE_BATCH);
+                }
+            }
+        }
+        merge(local);
+        if (!batch.empty()) copyItems(*dir, batch);
+    }
+
+    void copyItems(const DirPair& dir, const std::vector<Item>& items) {
+        CopyStats local;
+        for (const Item& item : items) {
+            const char* name = item.name.c_str();
+            switch (item.type) {
+            case DT_REG:
+                copyFile(&dir, name, name, local);
+                break;
+            case DT_LNK:
+                copySymlink(dir, name, local);
+                break;
+            case DT_FIFO:
+                copyFifo(dir, name);
+                break;
+            default:
+                fail(dir.srcPath + "/" + item.name, "不支持的文件类型", ENOTSUP);
+                break;
+            }
+        }
+        merge(local);
+    }
+
+    /**
+     * @brief 复制一个普通文件及其元数据
+     * @param dir 所在目录；为空时 srcName、dstName 是顶层的完整路径，并跟随源符号链接
+     */
+    void copyFile(const DirPair* dir, const char* srcName, const char* dstName, CopyStats& local) {
+        int srcDir = dir ? dir->src : AT_FDCWD;
+        int dstDir = dir ? dir->dst : AT_FDCWD;
+        auto srcPath = [&] { return dir ? dir->srcPath + "/" + srcName : std::string(srcName); };
+        auto dstPath = [&] { return dir ? dir->dstPath + "/" + dstName : std::string(dstName); };
+
+        int in = ::openat(srcDir, srcName, O_RDONLY | O_CLOEXEC | (dir ? O_NOFOLLOW : 0));
+        if (in < 0) {
+            fail(srcPath(), "无法打开", errno);
+            return;
+        }
+        struct stat st;
+        if (::fstat(in, &st) < 0) {
+            fail(srcPath(), "无法访问", errno);
+            ::close(in);
+            return;
+        }
+        if (options.overwrite && sameFile(dstDir, dstName, 0, st)) {
+            // 否则下面的 O_TRUNC 会清空源文件
+            failSameFile(srcPath(), dstPath());
+            ::close(in);
+            return;
+        }
+
+        // 新建的文件直接以源文件的权限创建，umask 不影响这些权限位时不再需要 chmod
+        mode_t mode = st.st_mode & 0777;
+        int out = ::openat(dstDir, dstName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+        bool modeSet = out >= 0 && umaskBits >= 0 && (mode & static_cast<mode_t>(umaskBits)) == 0 &&
+                       (st.st_mode & 07000) == 0;
+        if (out < 0 && errno == EEXIST && options.overwrite) {
+            out = ::openat(dstDir, dstName, O_WRONLY | O_TRUNC | O_NOFOLLOW | O_CLOEXEC);
+            if (out < 0 && errno != EISDIR) {
+                // 目标是符号链接或不可写：与 cp -f 一样删除后重建
+                ::unlinkat(dstDir, dstName, 0);
+                out = ::openat(dstDir, dstName, O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, mode);
+            }
+        }
+        if (out < 0) {
+            fail(dstPath(), "无法创建", errno);
+            ::close(in);
+            return;
+        }
+
+        int err = copyData(in, out, static_cast<uint64_t>(st.st_size), local);
+        if (err == 0) {
+            applyMetadata(out, nullptr, st, 0, modeSet);
+            ++local.files;
+            local.bytes += static_cast<uint64_t>(st.st_size);
+        }
+        ::close(in);
+        if (::close(out) < 0 && err == 0) err = errno;
+        if (err != 0) fail(dstPath(), "复制失败", err);
+    }
+
+    /**
+     * @brief 复制文件数据
+     * @return 成功返回 0，否则返回 errno
+     */
+    int copyData(int in, int out, uint64_t size, CopyStats& local) {
+        if (size == 0) return 0;
+
+        if (cloneSupported.load(std::memory_order_relaxed)) {
+            if (::ioctl(out, FICLONE, in) == 0) {
+                ++local.reflinked;
+                return 0;
+            }
+            if (errno == EOPNOTSUPP || errno == ENOTTY || errno == EXDEV || errno == EINVAL ||
+                errno == ENOSYS || errno == EPERM) {
+                cloneSupported.store(false, std::memory_order_relaxed);
+            }
+        }
+
+        uint64_t copied = 0;
+#ifdef SYS_copy_file_range
+        if (rangeSupported.load(std::memory_order_relaxed)) {
+            while (copied < size) {
+                long n = ::syscall(SYS_copy_file_range, in, nullptr, out, nullptr,
+                                   static_cast<size_t>(std::min<uint64_t>(size - copied, 1u << 30)), 0u);
+                if (n > 0) {
+                    copied += static_cast<uint64_t>(n);
+                    continue;
+                }
+                if (n == 0) break;  // 文件在复制期间变短
+                if (errno == EINTR) continue;
+                if (copied == 0 && (errno == EXDEV || errno == ENOSYS || errno == EOPNOTSUPP ||
+                                    errno == EINVAL || errno == EPERM)) {
+                    rangeSupported.store(false, std::memory_order_relaxed);
+                    break;
+                }
+                return errno;
+            }
+            if (copied > 0) {
+                ++local.rangeCopied;
+                return 0;
+            }
+        }
+#endif
+
+        // 回退：大块读写到文件末尾（从 copy_file_range 停下的位置继续）
+        static thread_local std::unique_ptr<char[]> buffer;
+        if (!buffer) buffer.reset(new char[COPY_BUFFER]);
+        for (;;) {
+            ssize_t n = ::read(in, buffer.get(), COPY_BUFFER);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return errno;
+            }
+            if (n == 0) break;
+            for (ssize_t done = 0; done < n;) {
+                ssize_t w = ::write(out, buffer.get() + done, static_cast<size_t>(n - done));
+                if (w < 0) {
+                    if (errno == EINTR) continue;
+                    return errno;
+                }
+                done += w;
+            }
+        }
+        ++local.bufferCopied;
+        return 0;
+    }
+
+    void copySymlink(const DirPair& dir, const char* name, CopyStats& local) {
+        struct stat st;
+        char target[4096];
+        if (::fstatat(dir.src, name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+            fail(dir.srcPath + "/" + name, "无法访问", errno);
+            return;
+        }
+        ssize_t len = ::readlinkat(dir.src, name, target, sizeof(target) - 1);
+        if (len < 0) {
+            fail(dir.srcPath + "/" + name, "无法读取链接", errno);
+            return;
+        }
+        target[len] = '\0';
+        int rc = ::symlinkat(target, dir.dst, name);
+        if (rc < 0 && errno == EEXIST && options.overwrite) {
+            if (sameFile(dir.dst, name, AT_SYMLINK_NOFOLLOW, st)) {
+                failSameFile(dir.srcPath + "/" + name, dir.dstPath + "/" + name);
+                return;
+            }
+            ::unlinkat(dir.dst, name, 0);
+            rc = ::symlinkat(target, dir.dst, name);
+        }
+        if (rc < 0) {
+            fail(dir.dstPath + "/" + name, "无法创建链接", errno);
+            return;
+        }
+        applyMetadata(dir.dst, name, st, AT_SYMLINK_NOFOLLOW);
+        ++local.symlinks;
+    }
+
+    void copyFifo(const DirPair& dir, const char* name) {
+        struct stat st;
+        if (::fstatat(dir.src, name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+            fail(dir.srcPath + "/" + name, "无法访问", errno);
+            return;
+        }
+        if (::mkfifoat(dir.dst, name, 0600) < 0 && !(errno == EEXIST && options.overwrite)) {
+            fail(dir.dstPath + "/" + name, "无法创建管道", errno);
+            return;
+        }
+        applyMetadata(dir.dst, name, st, 0);
+    }
+
+    /**
+     * @brief 设置属主、权限和访问/修改时间
+     * @param fd name 为空时是已打开的文件，否则是 name 所在的目录
+     * @param flags AT_SYMLINK_NOFOLLOW 表示设置符号链接本身（不设置权限）
+     * @param modeSet 权限已在创建时设置好
+     */
+    void applyMetadata(int fd, const char* name, const struct stat& st, int flags, bool modeSet = false) {
+        // 属主不同才调用 chown；非 root 时失败是正常的，忽略。chown 会清除 setuid 位，所以在 chmod 之前
+        if (st.st_uid != euid || st.st_gid != egid) {
+            if (name) {
+                (void)::fchownat(fd, name, st.st_uid, st.st_gid, flags);
+            } else {
+                (void)::fchown(fd, st.st_uid, st.st_gid);
+            }
+            modeSet = false;
+        }
+        struct timespec times[2] = {st.st_atim, st.st_mtim};
+        if (name) {
+            if (!(flags & AT_SYMLINK_NOFOLLOW)) (void)::fchmodat(fd, name, st.st_mode & 07777, 0);
+            (void)::utimensat(fd, name, times, flags);
+        } else {
+            if (!modeSet) (void)::fchmod(fd, st.st_mode & 07777);
+            (void)::futimens(fd, times);
+        }
+    }
+
+    /**
+     * @brief 读取进程的 umask，读取失败返回 -1
+     * @details 调用 umask() 会临时修改整个进程的 umask，其他线程（例如服务器中的其他命令）
+     *          可能在这期间创建文件，因此从 /proc/self/status 读取
+     */
+    static int readUmask() {
+        std::FILE* f = std::fopen("/proc/self/status", "re");
+        if (!f) return -1;
+        int value = -1;
+        char line[256];
+        while (std::fgets(line, sizeof(line), f)) {
+            unsigned bits;
+            if (std::sscanf(line, "Umask: %o", &bits) == 1) {
+                value = static_cast<int>(bits & 0777);
+                break;
+            }
+        }
+        std::fclose(f);
+        return value;
+    }
+};
+
+#endif // CCM_HAS_FAST_FS
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_FILE_OPS_H
@@ -0,0 +1,572 @@
+/**
+ * @file ConsoleCommandHttp.h
+ * @brief 最小化的 HTTP/1.1 JSON 网关协议
+ * @details 供只能发送 HTTP 请求的工具调用命令。CommandServer 使用 ServerProtocol::Http 时，
+ *          每个请求按以下规则映射为 CommandContext：
+ *
+ * @code
+ * POST /cmd/<命令名> HTTP/1.1
+ * Content-Type: application/json
+ * Content-Length: <长度>
+ *
+ * {"args": ["a.txt", "b.txt"], "options": {"n": 5, "force": true}, "flags": ["verbose"]}
+ * @endcode
+ *
+ * - 三个字段都是可选的，请求体也可以为空；出现其他字段时返回 400
+ * - args 和 options 的值可以是字符串、数字或布尔值，统一转换为文本；
+ *   options 中值为 true 的键视为标志，值为 false 或 null 的键被忽略
+ *
+ * 响应体为 JSON：
+ * @code
+ * {"status": "ok", "success": true, "output": "<命令输出>"}
+ * @endcode
+ * status 取值为 ok / fail（命令执行失败，HTTP 200）、busy（过载，HTTP 503）或
+ * error（请求本身有误，HTTP 4xx/5xx，output 为错误描述）。
+ *
+ * 支持 keep-alive 和请求流水线：一次接收到的多个请求依次解析，响应按顺序写入同一个缓冲区。
+ * 不支持分块传输编码和 Expect: 100-continue。
+ */
+
+#ifndef CONSOLE_COMMAND_HTTP_H
+#define CONSOLE_COMMAND_HTTP_H
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandProtocol.h"
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+namespace ConsoleCommand {
+
+// ============================================================================
+// HTTP 请求
+// ============================================================================
+
+const char* const HTTP_COMMAND_PREFIX = "/cmd/";  ///< 命令请求的路径前缀
+
+/**
+ * @struct HttpRequest
+ * @brief 解析得到的 HTTP 请求
+ */
+struct HttpRequest {
+    std::string method;        ///< 请求方法
+    std::string target;        ///< 请求路径（未解码）
+    int minorVersion = 1;      ///< HTTP/1.x 的次版本号
+    bool keepAlive = true;     ///< 响应后是否保持连接
+    std::string body;          ///< 请求体
+};
+
+// ============================================================================
+// 内部辅助
+// ============================================================================
+
+namespace detail {
+
+inline char asciiLower(char c) {
+    return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+inline bool equalsIgnoreCase(std::string_view a, std::string_view b) {
+    if (a.size() != b.size()) return false;
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (asciiLower(a[i]) != asciiLower(b[i])) return false;
+    }
+    return true;
+}
+
+inline bool containsTokenIgnoreCase(std::string_view value, std::string_view token) {
+    size_t pos = 0;
+    while (pos <= value.size()) {
+        size_t comma = value.find(',', pos);
+        if (comma == std::string_view::npos) comma = value.size();
+        std::string_view item = value.substr(pos, comma - pos);
+        while (!item.empty() && (item.front() == ' ' || item.front() == '\t')) item.remove_prefix(1);
+        while (!item.empty() && (item.back() == ' ' || item.back() == '\t')) item.remove_suffix(1);
+        if (equalsIgnoreCase(item, token)) return true;
+        pos = comma + 1;
+    }
+    return false;
+}
+
+inline int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+/**
+ * @brief 解码路径中的百分号转义
+ */
+inline bool percentDecode(std::string_view in, std::string& out) {
+    out.clear();
+    out.reserve(in.size());
+    for (size_t i = 0; i < in.size(); ++i) {
+        if (in[i] != '%') {
+            out += in[i];
+            continue;
+        }
+        if (i + 2 >= in.size()) return false;
+        int hi = hexValue(in[i + 1]);
+        int lo = hexValue(in[i + 2]);
+        if (hi < 0 || lo < 0) return false;
+        out += static_cast<char>(hi * 16 + lo);
+        i += 2;
+    }
+    return true;
+}
+
+inline void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xC0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xE0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (cp & 0x3F));
+    }
+}
+
+/**
+ * @brief 只支持请求体所需子集的 JSON 读取器
+ * @details 能读取字符串、数字、布尔值和 null 标量，以及由调用者驱动的对象和数组
+ */
+class JsonReader {
+private:
+    const char* cur;
+    const char* end;
+
+public:
+    /** @brief 标量类型 */
+    enum Kind { String, Number, True, False, Null };
+
+    JsonReader(const char* data, size_t size) : cur(data), end(data + size) {}
+
+    void skipSpace() {
+        while (cur < end && (*cur == ' ' || *cur == '\t' || *cur == '\n' || *cur == '\r')) ++cur;
+    }
+
+    bool atEnd() {
+        skipSpace();
+        return cur == end;
+    }
+
+    /** @brief 读取指定字符（跳过前导空白） */
+    bool consume(char c) {
+        skipSpace();
+        if (cur < end && *cur == c) {
+            ++cur;
+            return true;
+        }
+        return false;
+    }
+
+    /** @brief 查看下一个非空白字符 */
+    char peek() {
+        skipSpace();
+        return cur < end ? *cur : '\0';
+    }
+
+    bool readHex4(uint32_t& v) {
+        if (end - cur < 4) return false;
+        v = 0;
+        for (int i = 0; i < 4; ++i) {
+            int h = hexValue(*cur++);
+            if (h < 0) return false;
+            v = (v << 4) | static_cast<uint32_t>(h);
+        }
+        return true;
+    }
+
+    /** @brief 读取字符串 */
+    bool readString(std::string& out) {
+        if (!consume('"')) return false;
+        out.clear();
+        while (cur < end) {
+            const char* run = cur;
+            while (cur < end && *cur != '"' && *cur != '\\' && static_cast<unsigned char>(*cur) >= 0x20) ++cur;
+            out.append(run, static_cast<size_t>(cur - run));
+            if (cur == end) return false;
+
+            char c = *cur++;
+            if (c == '"') return true;
+            if (c != '\\' || cur == end) return false;
+
+            char e = *cur++;
+            switch (e) {
+                case '"':  out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/':  out += '/'; break;
+                case 'b':  out += '\b'; break;
+                case 'f':  out += '\f'; break;
+                case 'n':  out += '\n'; break;
+                case 'r':  out += '\r'; break;
+                case 't':  out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!readHex4(cp)) return false;
+                    if (cp >= 0xD800 && cp < 0xDC00) {
+                        uint32_t low;
+                        if (end - cur < 6 || cur[0] != '\\' || cur[1] != 'u') return false;
+                        cur += 2;
+                        if (!readHex4(low) || low < 0xDC00 || low >= 0xE000) return false;
+                        cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    } else if (cp >= 0xDC00 && cp < 0xE000) {
+                        return false;
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default:
+                    return false;
+            }
+        }
+        return false;
+    }
+
+    /** @brief 读取标量，数字保留原始文本 */
+    bool readScalar(std::string& text, Kind& kind) {
+        char c = peek();
+        if (c == '"') {
+            kind = String;
+            return readString(text);
+        }
+
+        const char* start = cur;
+        while (cur < end && ((*cur >= '0' && *cur <= '9') || (*cur >= 'a' && *cur <= 'z') ||
+                             *cur == '-' || *cur == '+' || *cur == '.' || *cur == 'E')) {
+            ++cur;
+        }
+        text.assign(start, static_cast<size_t>(cur - start));
+        if (text == "true") kind = True;
+        else if (text == "false") kind = False;
+        else if (text == "null") kind = Null;
+        else if (!text.empty() && (text[0] == '-' || (text[0] >= '0' && text[0] <= '9')) &&
+                 text.find_first_of("abcdfghijklmnopqrstuvwxyz") == std::string::npos) kind = Number;
+        else return false;
+        return true;
+    }
+};
+
+/**
+ * @brief 读取 JSON 数组中的标量，转换为文本后交给回调
+ */
+template<typename Func>
+inline bool readScalarArray(JsonReader& reader, Func&& onValue) {
+    if (!reader.consume('[')) return false;
+    if (reader.consume(']')) return true;
+    std::string text;
+    JsonReader::Kind kind;
+    do {
+        if (!reader.readScalar(text, kind) || kind == JsonReader::Null) return false;
+        onValue(text);
+    } while (reader.consume(','));
+    return reader.consume(']');
+}
+
+/**
+ * @brief 计算字符串按 JSON 转义后的长度
+ */
+inline size_t jsonEscapedSize(const std::string& s) {
+    size_t n = s.size();
+    for (unsigned char c : s) {
+        if (c == '"' || c == '\\' || c == '\n' || c == '\r' || c == '\t' || c == '\b' || c == '\f') ++n;
+        else if (c < 0x20) n += 5;
+    }
+    return n;
+}
+
+/**
+ * @brief 把字符串按 JSON 转义后追加到缓冲区
+ */
+inline void appendJsonEscaped(const std::string& s, std::string& out) {
+    static const char hex[] = "0123456789abcdef";
+    const char* p = s.data();
+    const char* end = p + s.size();
+    while (p < end) {
+        const char* run = p;
+        while (p < end && *p != '"' && *p != '\\' && static_cast<unsigned char>(*p) >= 0x20) ++p;
+        out.append(run, static_cast<size_t>(p - run));
+        if (p == end) break;
+
+        unsigned char c = static_cast<unsigned char>(*p++);
+        out += '\\';
+        switch (c) {
+            case '"':  out += '"'; break;
+            case '\\': out += '\\'; break;
+            case '\n': out += 'n'; break;
+            case '\r': out += 'r'; break;
+            case '\t': out += 't'; break;
+            case '\b': out += 'b'; break;
+            case '\f': out += 'f'; break;
+            default:
+                out += "u00";
+                out += hex[c >> 4];
+                out += hex[c & 0xF];
+                break;
+        }
+    }
+}
+
+inline const char* httpReason(unsigned status) {
+    switch (status) {
+        case 200: return "OK";
+        case 400: return "Bad Request";
+        case 404: return "Not Found";
+        case 405: return "Method Not Allowed";
+        case 413: return "Payload Too Large";
+        case 431: return "Request Header Fields Too Large";
+        case 501: return "Not Implemented";
+        case 503: return "Service Unavailable";
+        default:  return "Error";
+    }
+}
+
+} // namespace detail
+
+// ============================================================================
+// 解析
+// ============================================================================
+
+/**
+ * @brief 从缓冲区解析一个完整的 HTTP 请求
+ * @param data 缓冲区起始地址
+ * @param size 缓冲区中的可用字节数
+ * @param consumed 输出参数，成功时为该请求占用的总字节数
+ * @param request 输出参数，解析结果
+ * @param errorStatus 输出参数，格式错误时应返回的 HTTP 状态码
+ * @param errorMsg 输出参数，格式错误时的描述
+ * @param maxSize 请求头和请求体各自允许的最大长度
+ * @return 解析状态，Malformed 时连接应在响应后关闭
+ */
+inline DecodeStatus decodeHttpRequest(const char* data, size_t size, size_t& consumed,
+                                      HttpRequest& request, unsigned& errorStatus,
+                                      std::string& errorMsg, size_t maxSize) {
+    std::string_view input(data, size);
+    size_t headerEnd = input.find("\r\n\r\n");
+    if (headerEnd == std::string_view::npos) {
+        if (size > maxSize) {
+            errorStatus = 431;
+            errorMsg = "请求头过长";
+            return DecodeStatus::Malformed;
+        }
+        return DecodeStatus::NeedMore;
+    }
+
+    auto malformed = [&](unsigned status, const char* what) {
+        errorStatus = status;
+        errorMsg = what;
+        return DecodeStatus::Malformed;
+    };
+
+    // 请求行: METHOD SP target SP HTTP/1.x
+    size_t lineEnd = input.find("\r\n");
+    std::string_view line = input.substr(0, lineEnd);
+    size_t sp1 = line.find(' ');
+    size_t sp2 = sp1 == std::string_view::npos ? sp1 : line.find(' ', sp1 + 1);
+    if (sp2 == std::string_view::npos || sp1 == 0 || sp2 == sp1 + 1) {
+        return malformed(400, "请求行格式错误");
+    }
+    std::string_view version = line.substr(sp2 + 1);
+    if (version.size() != 8 || version.substr(0, 7) != "HTTP/1." || version[7] < '0' || version[7] > '9') {
+        return malformed(400, "不支持的 HTTP 版本");
+    }
+    request.method.assign(line.data(), sp1);
+    request.target.assign(line.data() + sp1 + 1, sp2 - sp1 - 1);
+    request.minorVersion = version[7] - '0';
+
+    // 请求头，只关心决定消息边界和连接复用的几个字段
+    bool hasLength = false;
+    size_t contentLength = 0;
+    bool close = false;
+    bool keepAlive = false;
+
+    size_t pos = lineEnd + 2;
+    while (pos < headerEnd + 2) {
+        size_t next = input.find("\r\n", pos);
+        std::string_view header = input.substr(pos, next - pos);
+        pos = next + 2;
+
+        size_t colon = header.find(':');
+        if (colon == std::string_view::npos || colon == 0) {
+            return malformed(400, "请求头格式错误");
+        }
+        std::string_view name = header.substr(0, colon);
+        std::string_view value = header.substr(colon + 1);
+        while (!value.empty() && (value.front() == ' ' || value.front() == '\t')) value.remove_prefix(1);
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) value.remove_suffix(1);
+
+        if (detail::equalsIgnoreCase(name, "content-length")) {
+            if (value.empty() || value.size() > 18) return malformed(400, "无效的 Content-Length");
+            size_t length = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9') return malformed(400, "无效的 Content-Length");
+                length = length * 10 + static_cast<size_t>(c - '0');
+            }
+            if (hasLength && length != contentLength) return malformed(400, "重复的 Content-Length");
+            hasLength = true;
+            contentLength = length;
+        } else if (detail::equalsIgnoreCase(name, "transfer-encoding")) {
+            return malformed(501, "不支持 Transfer-Encoding");
+        } else if (detail::equalsIgnoreCase(name, "connection")) {
+            close = close || detail::containsTokenIgnoreCase(value, "close");
+            keepAlive = keepAlive || detail::containsTokenIgnoreCase(value, "keep-alive");
+        }
+    }
+
+    if (contentLength > maxSize) {
+        return malformed(413, "请求体过长");
+    }
+    size_t total = headerEnd + 4 + contentLength;
+    if (size < total) return DecodeStatus::NeedMore;
+
+    request.keepAlive = request.minorVersion >= 1 ? !close : keepAlive;
+    request.body.assign(data + headerEnd + 4, contentLength);
+    consumed = total;
+    return DecodeStatus::Ok;
+}
+
+/**
+ * @brief 把 HTTP 请求映射为命令上下文
+ * @param request HTTP 请求
+ * @param context 输出参数，命令上下文（调用前应为空）
+ * @param manager 用于检查命令是否存在的管理器
+ * @param errorStatus 输出参数，失败时应返回的 HTTP 状态码
+ * @param errorMsg 输出参数，失败时的描述
+ * @return 成功返回true
+ */
+inline bool httpRequestToContext(const HttpRequest& request, CommandContext& context,
+                                 const CommandManager& manager, unsigned& errorStatus,
+                                 std::string& errorMsg) {
+    std::string_view target(request.target);
+    std::string_view prefix(HTTP_COMMAND_PREFIX);
+    size_t query = target.find('?');
+    if (query != std::string_view::npos) target = target.substr(0, query);
+
+    if (target.substr(0, prefix.size()) != prefix || target.size() == prefix.size()) {
+        errorStatus = 404;
+        errorMsg = "路径必须为 " + std::string(HTTP_COMMAND_PREFIX) + "<命令名>";
+        return false;
+    }
+    if (request.method != "POST") {
+        errorStatus = 405;
+        errorMsg = "只支持 POST 方法";
+        return false;
+    }
+
+    std::string name;
+    if (!detail::percentDecode(target.substr(prefix.size()), name)) {
+        errorStatus = 400;
+        errorMsg = "路径中的转义序列无效";
+        return false;
+    }
+    if (!manager.commandExists(name)) {
+        errorStatus = 404;
+        errorMsg = "未知命令: " + name;
+        return false;
+    }
+    context.setCommandName(name);
+
+    detail::JsonReader reader(request.body.data(), request.body.size());
+    if (reader.atEnd()) return true;
+
+    auto invalid = [&](const std::string& what) {
+        errorStatus = 400;
+        errorMsg = "请求体格式错误: " + what;
+        return false;
+    };
+
+    if (!reader.consume('{')) return invalid("应为 JSON 对象");
+    if (!reader.consume('}')) {
+        std::string key;
+        std::string text;
+        detail::JsonReader::Kind kind;
+        do {
+            if (!reader.readString(key) || !reader.consume(':')) return invalid("应为字段名");
+
+            if (key == "args") {
+                if (!detail::readScalarArray(reader, [&](std::string& v) { context.addArgument(std::move(v)); })) {
+                    return invalid("args 必须是标量数组");
+                }
+            } else if (key == "flags") {
+                if (!detail::readScalarArray(reader, [&](std::string& v) { context.setFlag(v); })) {
+                    return invalid("flags 必须是字符串数组");
+                }
+            } else if (key == "options") {
+                if (!reader.consume('{')) return invalid("options 必须是对象");
+                if (!reader.consume('}')) {
+                    std::string optionName;
+                    do {
+                        if (!reader.readString(optionName) || !reader.consume(':') ||
+                            !reader.readScalar(text, kind)) {
+                            return invalid("options 的值必须是标量");
+                        }
+                        if (kind == detail::JsonReader::True) {
+                            context.setFlag(optionName);
+                        } else if (kind != detail::JsonReader::False && kind != detail::JsonReader::Null) {
+                            context.setOption(std::move(optionName), std::move(text));
+                        }
+                    } while (reader.consume(','));
+                    if (!reader.consume('}')) return invalid("options 未闭合");
+                }
+            } else {
+                return invalid("未知字段 " + key);
+            }
+        } while (reader.consume(','));
+        if (!reader.consume('}')) return invalid("对象未闭合");
+    }
+    if (!reader.atEnd()) return invalid("对象之后有多余内容");
+    return true;
+}
+
+// ============================================================================
+// 响应
+// ============================================================================
+
+/**
+ * @brief 把 JSON 响应追加到缓冲区
+ * @param httpStatus HTTP 状态码
+ * @param status JSON 中的 status 字段（ok/fail/busy/error）
+ * @param output 命令输出或错误描述
+ * @param keepAlive 是否保持连接
+ * @param out 输出缓冲区
+ * @details 先计算转义后的长度，再把状态行、头部和 JSON 直接写入输出缓冲区，
+ *          不经过中间字符串
+ */
+inline void encodeHttpResponse(unsigned httpStatus, const char* status, const std::string& output,
+                               bool keepAlive, std::string& out) {
+    bool success = std::string_view(status) == "ok";
+    std::string_view prefix = "{\"status\":\"";
+    std::string_view middle = success ? "\",\"success\":true,\"output\":\"" : "\",\"success\":false,\"output\":\"";
+    std::string_view suffix = "\"}";
+    size_t bodySize = prefix.size() + std::char_traits<char>::length(status) + middle.size() +
+                      detail::jsonEscapedSize(output) + suffix.size();
+
+    std::string length = std::to_string(bodySize);
+    out.reserve(out.size() + 128 + bodySize);
+    out += "HTTP/1.1 ";
+    out += std::to_string(httpStatus);
+    out += ' ';
+    out += detail::httpReason(httpStatus);
+    out += "\r\nContent-Type: application/json; charset=utf-8\r\nContent-Length: ";
+    out += length;
+    out += keepAlive ? "\r\n\r\n" : "\r\nConnection: close\r\n\r\n";
+
+    out += prefix;
+    out += status;
+    out += middle;
+    detail::appendJsonEscaped(output, out);
+    out += suffix;
+}
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_HTTP_H
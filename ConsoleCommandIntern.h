@@ -0,0 +1,271 @@
+/**
+ * @file ConsoleCommandIntern.h
+ * @brief 命令定义使用的字符串池
+ * @details 命令、参数和选项的文本在注册后不再修改，大型注册表中又有大量重复
+ *          （分类、参数名、选项名、默认值、类型描述）。这些文本保存在进程级的字符串池中，
+ *          定义里只存放 8 字节的 PooledString 句柄，而不是 32 字节的 std::string 加堆分配。
+ *
+ * 设计要点：
+ * - 字符串按顺序追加到 64KB 的连续块中，每个字符串前有 4 字节长度，后有结尾的 '\0'，
+ *   句柄指向字符数据本身，c_str() 不需要复制
+ * - StringPool::intern() 对相同内容只保存一份（分类、参数和选项的名称、描述、默认值）；
+ *   StringPool::store() 不查重直接追加（命令名、别名、命令描述、示例等通常唯一的文本），
+ *   省去查重索引的开销
+ * - 块在进程结束前不会释放，句柄可以在线程和管理器之间自由复制；
+ *   追加在互斥锁内完成，读取句柄不需要加锁
+ *
+ * 因为池只增不减，运行时反复构造新的定义（而不是注册一次后长期使用）会持续占用内存；
+ * 命令处理路径只读取句柄，不会向池中添加字符串。
+ */
+
+#ifndef CONSOLE_COMMAND_INTERN_H
+#define CONSOLE_COMMAND_INTERN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+#include <vector>
+
+namespace ConsoleCommand {
+
+class StringPool;
+
+/**
+ * @class PooledString
+ * @brief 字符串池中一个字符串的句柄
+ * @details 大小与一个指针相同，复制不分配内存。可以隐式转换为 std::string，
+ *          也可以直接与 std::string、C 字符串比较、拼接和输出，
+ *          因此大多数按 std::string 使用定义字段的代码不需要修改。
+ *          从 std::string 隐式构造时内容会被 intern 到进程级字符串池
+ */
+class PooledString {
+public:
+    /** @brief 空字符串 */
+    PooledString() : ptr(emptyData()) {}
+
+    /** @brief intern 一个字符串 */
+    PooledString(const std::string& s);
+
+    /** @brief intern 一个C字符串 */
+    PooledString(const char* s);
+
+    const char* c_str() const { return ptr; }
+    const char* data() const { return ptr; }
+
+    size_t size() const {
+        uint32_t n;
+        std::memcpy(&n, ptr - sizeof(uint32_t), sizeof(n));
+        return n;
+    }
+
+    size_t length() const { return size(); }
+    bool empty() const { return size() == 0; }
+    char operator[](size_t i) const { return ptr[i]; }
+    const char* begin() const { return ptr; }
+    const char* end() const { return ptr + size(); }
+
+    std::string_view view() const { return std::string_view(ptr, size()); }
+    std::string str() const { return std::string(ptr, size()); }
+    operator std::string() const { return str(); }
+
+    int compare(std::string_view other) const { return view().compare(other); }
+    int compare(size_t pos, size_t count, std::string_view other) const {
+        return view().compare(pos, count, other);
+    }
+    size_t find(std::string_view s, size_t pos = 0) const { return view().find(s, pos); }
+    size_t find(char c, size_t pos = 0) const { return view().find(c, pos); }
+
+    /**
+     * @brief 句柄是否指向同一份存储
+     * @details intern 得到的相同内容句柄相等；store 得到的句柄即使内容相同也不相等
+     */
+    bool sameStorage(const PooledString& other) const { return ptr == other.ptr; }
+
+    friend bool operator==(const PooledString& a, const PooledString& b) {
+        return a.ptr == b.ptr || a.view() == b.view();
+    }
+    friend bool operator==(const PooledString& a, const std::string& b) { return a.view() == b; }
+    friend bool operator==(const std::string& a, const PooledString& b) { return b.view() == a; }
+    friend bool operator==(const PooledString& a, const char* b) { return a.view() == b; }
+    friend bool operator==(const char* a, const PooledString& b) { return b.view() == a; }
+    friend bool operator!=(const PooledString& a, const PooledString& b) { return !(a == b); }
+    friend bool operator!=(const PooledString& a, const std::string& b) { return !(a == b); }
+    friend bool operator!=(const std::string& a, const PooledString& b) { return !(a == b); }
+    friend bool operator!=(const PooledString& a, const char* b) { return !(a == b); }
+    friend bool operator!=(const char* a, const PooledString& b) { return !(a == b); }
+    friend bool operator<(const PooledString& a, const PooledString& b) { return a.view() < b.view(); }
+
+    friend std::string operator+(const PooledString& a, const std::string& b) { return a.str() + b; }
+    friend std::string operator+(const std::string& a, const PooledString& b) {
+        std::string s = a;
+        s.append(b.ptr, b.size());
+        return s;
+    }
+    friend std::string operator+(const PooledString& a, const char* b) { return a.str() + b; }
+    friend std::string operator+(const char* a, const PooledString& b) {
+        std::string s = a;
+        s.append(b.ptr, b.size());
+        return s;
+    }
+    friend std::string operator+(const PooledString& a, char b) { return a.str() + b; }
+
+    friend std::ostream& operator<<(std::ostream& os, const PooledString& s) {
+        return os << s.view();
+    }
+
+private:
+    friend class StringPool;
+
+    explicit PooledString(const char* data, bool) : ptr(data) {}
+
+    static const char* emptyData() {
+        alignas(uint32_t) static const char empty[sizeof(uint32_t) + 1] = {};
+        return empty + sizeof(uint32_t);
+    }
+
+    const char* ptr;    ///< 字符数据，前面 4 字节是长度，后面是 '\0'
+};
+
+/**
+ * @class StringPool
+ * @brief 进程级字符串池
+ */
+class StringPool {
+public:
+    static constexpr size_t BLOCK_SIZE = 64 * 1024;    ///< 块大小，超过 1/4 块的字符串单独分配
+
+    /**
+     * @brief 池的使用情况
+     */
+    struct Usage {
+        size_t strings = 0;         ///< 池中的字符串数（intern 与 store 之和）
+        size_t internedStrings = 0; ///< intern 的不同字符串数
+        uint64_t internHits = 0;    ///< intern 时命中已有字符串的次数
+        size_t bytesUsed = 0;       ///< 已写入的字节数（含长度前缀和结尾 '\0'）
+        size_t bytesReserved = 0;   ///< 已分配块的总字节数
+        size_t indexBytes = 0;      ///< intern 查重索引的近似大小
+    };
+
+    /**
+     * @brief 获取与 s 内容相同的共享字符串
+     * @param s 字符串内容
+     * @return 句柄；相同内容总是返回同一份存储
+     */
+    static PooledString intern(std::string_view s) {
+        if (s.empty()) return PooledString();
+        State& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        auto it = st.index.find(s);
+        if (it != st.index.end()) {
+            ++st.internHits;
+            return PooledString(it->data(), true);
+        }
+        PooledString stored = append(st, s);
+        st.index.insert(stored.view());
+        return stored;
+    }
+
+    /**
+     * @brief 保存一份字符串，不查重
+     * @param s 字符串内容
+     * @return 句柄
+     */
+    static PooledString store(std::string_view s) {
+        if (s.empty()) return PooledString();
+        State& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        return append(st, s);
+    }
+
+    /**
+     * @brief 获取池的使用情况
+     */
+    static Usage usage() {
+        State& st = state();
+        std::lock_guard<std::mutex> lock(st.mutex);
+        Usage u;
+        u.strings = st.strings;
+        u.internedStrings = st.index.size();
+        u.internHits = st.internHits;
+        u.bytesUsed = st.bytesUsed;
+        u.bytesReserved = st.bytesReserved;
+        // 节点（next 指针、string_view、缓存的哈希值）加上每个桶的指针
+        u.indexBytes = st.index.size() * (sizeof(void*) + sizeof(std::string_view) + sizeof(size_t)) +
+                       st.index.bucket_count() * sizeof(void*);
+        return u;
+    }
+
+private:
+    struct State {
+        std::mutex mutex;
+        std::vector<std::unique_ptr<char[]>> blocks;
+        char* cursor = nullptr;         ///< 当前块的写入位置
+        size_t remaining = 0;           ///< 当前块剩余字节数
+        std::unordered_set<std::string_view> index;    ///< intern 的字符串，指向块内数据
+        size_t strings = 0;
+        uint64_t internHits = 0;
+        size_t bytesUsed = 0;
+        size_t bytesReserved = 0;
+    };
+
+    static State& state() {
+        static State* s = new State();  // 不析构：静态对象析构后仍可能有句柄被读取
+        return *s;
+    }
+
+    static PooledString append(State& st, std::string_view s) {
+        if (s.size() > UINT32_MAX) {
+            s = s.substr(0, UINT32_MAX);
+        }
+        size_t need = sizeof(uint32_t) + s.size() + 1;
+        char* dest;
+        if (need > BLOCK_SIZE / 4) {
+            st.blocks.emplace_back(new char[need]);
+            dest = st.blocks.back().get();
+            st.bytesReserved += need;
+        } else {
+            if (need > st.remaining) {
+                st.blocks.emplace_back(new char[BLOCK_SIZE]);
+                st.cursor = st.blocks.back().get();
+                st.remaining = BLOCK_SIZE;
+                st.bytesReserved += BLOCK_SIZE;
+            }
+            dest = st.cursor;
+            st.cursor += need;
+            st.remaining -= need;
+        }
+        uint32_t n = static_cast<uint32_t>(s.size());
+        std::memcpy(dest, &n, sizeof(n));
+        std::memcpy(dest + sizeof(n), s.data(), s.size());
+        dest[sizeof(n) + s.size()] = '\0';
+        ++st.strings;
+        st.bytesUsed += need;
+        return PooledString(dest + sizeof(n), true);
+    }
+};
+
+inline PooledString::PooledString(const std::string& s) : PooledString(StringPool::intern(s)) {}
+
+inline PooledString::PooledString(const char* s)
+    : PooledString(s ? StringPool::intern(s) : PooledString()) {}
+
+} // namespace ConsoleCommand
+
+namespace std {
+
+template<>
+struct hash<ConsoleCommand::PooledString> {
+    size_t operator()(const ConsoleCommand::PooledString& s) const noexcept {
+        return hash<string_view>()(s.view());
+    }
+};
+
+} // namespace std
+
+#endif // CONSOLE_COMMAND_INTERN_H
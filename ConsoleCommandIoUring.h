@@ -0,0 +1,398 @@
+/**
+ * @file ConsoleCommandIoUring.h
+ * @brief io_uring 的轻量封装
+ * @details 直接使用 io_uring_setup/io_uring_enter 系统调用，不依赖 liburing。
+ *          提供提交队列条目（SQE）的获取、批量提交和完成队列（CQE）的收割，
+ *          供命令服务器和示例程序中的文件命令使用。
+ *
+ * 仅在 Linux 且内核头文件提供 <linux/io_uring.h> 时可用，
+ * 可通过 CCM_HAS_IO_URING 宏判断。运行时可用性请使用 IoUring::isSupported()。
+ *
+ * 使用示例：
+ * @code
+ * ConsoleCommand::IoUring ring;
+ * std::string error;
+ * if (ring.init(64, error)) {
+ *     auto* sqe = ring.getSqe();
+ *     ConsoleCommand::IoUring::prepRead(sqe, fd, buffer, size, 0, 1);
+ *     ring.submit(1);
+ *     ring.forEachCompletion([](uint64_t userData, int res) { ... });
+ * }
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_IO_URING_H
+#define CONSOLE_COMMAND_IO_URING_H
+
+#if defined(__linux__) && defined(__has_include)
+#if __has_include(<linux/io_uring.h>)
+#define CCM_HAS_IO_URING 1
+#endif
+#endif
+
+#ifdef CCM_HAS_IO_URING
+
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+namespace ConsoleCommand {
+
+/**
+ * @class IoUring
+ * @brief io_uring 实例封装
+ *
+ * 管理一个 io_uring 实例的提交队列和完成队列映射。
+ * 调用者通过 getSqe() 获取条目并用 prep* 系列函数填充，
+ * 然后调用 submit() 一次性提交所有已准备的条目，
+ * 再用 forEachCompletion() 收割完成事件。
+ *
+ * @note 非线程安全，一个实例只应由一个线程使用
+ */
+class IoUring {
+private:
+    int ringFd = -1;                ///< io_uring 文件描述符
+    unsigned entries = 0;           ///< 提交队列容量
+
+    // 映射区域
+    void* sqRing = nullptr;         ///< 提交队列环映射
+    void* cqRing = nullptr;         ///< 完成队列环映射
+    size_t sqRingSize = 0;          ///< 提交队列环映射大小
+    size_t cqRingSize = 0;          ///< 完成队列环映射大小
+    io_uring_sqe* sqes = nullptr;   ///< 提交队列条目数组
+    size_t sqesSize = 0;            ///< 条目数组映射大小
+
+    // 提交队列指针
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned* sqMask = nullptr;
+    unsigned* sqArray = nullptr;
+
+    // 完成队列指针
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned* cqMask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    unsigned sqeHead = 0;           ///< 已放入数组但尚未提交的起点
+    unsigned sqeTail = 0;           ///< 已分配的条目终点
+
+public:
+    IoUring() = default;
+    ~IoUring() { close(); }
+
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    /**
+     * @brief 初始化 io_uring 实例
+     * @param queueDepth 提交队列深度
+     * @param errorMsg 输出参数，失败时存储错误信息
+     * @return 初始化成功返回true，否则返回false
+     * @details 要求内核支持 IORING_FEAT_FAST_POLL（5.7+），
+     *          以保证 accept/recv/send/statx 等操作码可用
+     */
+    bool init(unsigned queueDepth, std::string& errorMsg) {
+        close();
+
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+
+        int fd = static_cast<int>(syscall(__NR_io_uring_setup, queueDepth, &params));
+        if (fd < 0) {
+            errorMsg = std::string("io_uring_setup 失败: ") + std::strerror(errno);
+            return false;
+        }
+        ringFd = fd;
+
+        if (!(params.features & IORING_FEAT_FAST_POLL)) {
+            errorMsg = "内核版本过低，io_uring 不支持 FAST_POLL";
+            close();
+            return false;
+        }
+
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        bool singleMmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMmap) {
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+        }
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED) {
+            sqRing = nullptr;
+            errorMsg = std::string("映射提交队列失败: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+
+        if (singleMmap) {
+            cqRing = sqRing;
+        } else {
+            cqRing = mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE,
+                          MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+            if (cqRing == MAP_FAILED) {
+                cqRing = nullptr;
+                errorMsg = std::string("映射完成队列失败: ") + std::strerror(errno);
+                close();
+                return false;
+            }
+        }
+
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqePtr = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE,
+                            MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQES);
+        if (sqePtr == MAP_FAILED) {
+            errorMsg = std::string("映射提交队列条目失败: ") + std::strerror(errno);
+            close();
+            return false;
+        }
+        sqes = static_cast<io_uring_sqe*>(sqePtr);
+
+        char* sq = static_cast<char*>(sqRing);
+        sqHead = reinterpret_cast<unsigned*>(sq + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sqMask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sqArray = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+
+        char* cq = static_cast<char*>(cqRing);
+        cqHead = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cqMask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+
+        entries = params.sq_entries;
+        sqeHead = sqeTail = 0;
+        return true;
+    }
+
+    /**
+     * @brief 释放 io_uring 实例
+     * @details 关闭文件描述符后内核会取消所有未完成的请求
+     */
+    void close() {
+        if (sqes) munmap(sqes, sqesSize);
+        if (cqRing && cqRing != sqRing) munmap(cqRing, cqRingSize);
+        if (sqRing) munmap(sqRing, sqRingSize);
+        if (ringFd >= 0) ::close(ringFd);
+
+        sqes = nullptr;
+        sqRing = cqRing = nullptr;
+        ringFd = -1;
+        entries = 0;
+    }
+
+    /**
+     * @brief 检查实例是否已初始化
+     * @return 已初始化返回true
+     */
+    bool valid() const { return ringFd >= 0; }
+
+    /**
+     * @brief 获取提交队列容量
+     * @return 队列条目数
+     */
+    unsigned capacity() const { return entries; }
+
+    /**
+     * @brief 获取一个空闲的提交队列条目
+     * @return 已清零的条目指针，队列已满时返回nullptr
+     */
+    io_uring_sqe* getSqe() {
+        unsigned head = __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+        if (sqeTail - head >= entries) {
+            return nullptr;
+        }
+        io_uring_sqe* sqe = &sqes[sqeTail & *sqMask];
+        ++sqeTail;
+        std::memset(sqe, 0, sizeof(*sqe));
+        return sqe;
+    }
+
+    /**
+     * @brief 提交所有已准备的条目
+     * @param waitNr 等待完成的最小事件数，0表示不等待
+     * @return 成功提交的条目数，失败返回负的错误码
+     */
+    int submit(unsigned waitNr = 0) {
+        unsigned tail = *sqTail;
+        unsigned toSubmit = 0;
+        while (sqeHead != sqeTail) {
+            sqArray[tail & *sqMask] = sqeHead & *sqMask;
+            ++tail;
+            ++sqeHead;
+            ++toSubmit;
+        }
+        __atomic_store_n(sqTail, tail, __ATOMIC_RELEASE);
+
+        unsigned flags = waitNr > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while (true) {
+            int ret = static_cast<int>(syscall(__NR_io_uring_enter, ringFd, toSubmit,
+                                               waitNr, flags, nullptr, 0));
+            if (ret >= 0) return ret;
+            if (errno == EINTR) {
+                // 已提交的条目不会重复提交，中断后只需继续等待
+                toSubmit = 0;
+                continue;
+            }
+            return -errno;
+        }
+    }
+
+    /**
+     * @brief 收割所有已到达的完成事件
+     * @tparam Func 回调类型，签名为 void(uint64_t userData, int res)
+     * @param func 对每个完成事件调用的回调
+     * @return 处理的完成事件数
+     * @note 回调中可以继续调用 getSqe() 准备新的请求
+     */
+    template<typename Func>
+    unsigned forEachCompletion(Func&& func) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        unsigned count = 0;
+
+        while (head != tail) {
+            const io_uring_cqe& cqe = cqes[head & *cqMask];
+            uint64_t userData = cqe.user_data;
+            int res = cqe.res;
+            ++head;
+            ++count;
+            // 先归还槽位，回调中产生的新完成事件可在下一轮收割
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+            func(userData, res);
+        }
+
+        return count;
+    }
+
+    // ========================================================================
+    // 条目准备函数
+    // ========================================================================
+
+    /**
+     * @brief 准备 accept 请求
+     * @param sqe 提交队列条目
+     * @param fd 监听套接字
+     * @param userData 用户数据，在完成事件中原样返回
+     */
+    static void prepAccept(io_uring_sqe* sqe, int fd, uint64_t userData) {
+        sqe->opcode = IORING_OP_ACCEPT;
+        sqe->fd = fd;
+        sqe->accept_flags = SOCK_CLOEXEC;
+        sqe->user_data = userData;
+    }
+
+    /**
+     * @brief 准备 recv 请求
+     * @param sqe 提交队列条目
+     * @param fd 套接字
+     * @param buf 接收缓冲区
+     * @param len 缓冲区长度
+     * @param userData 用户数据
+     */
+    static void prepRecv(io_uring_sqe* sqe, int fd, void* buf, size_t len, uint64_t userData) {
+        prepRw(sqe, IORING_OP_RECV, fd, buf, static_cast<unsigned>(len), 0, userData);
+    }
+
+    /**
+     * @brief 准备 send 请求
+     * @param sqe 提交队列条目
+     * @param fd 套接字
+     * @param buf 发送缓冲区，在完成前必须保持有效
+     * @param len 发送长度
+     * @param userData 用户数据
+     */
+    static void prepSend(io_uring_sqe* sqe, int fd, const void* buf, size_t len, uint64_t userData) {
+        prepRw(sqe, IORING_OP_SEND, fd, buf, static_cast<unsigned>(len), 0, userData);
+        sqe->msg_flags = MSG_NOSIGNAL;
+    }
+
+    /**
+     * @brief 准备定位读请求
+     * @param sqe 提交队列条目
+     * @param fd 文件描述符
+     * @param buf 读缓冲区
+     * @param len 读取长度
+     * @param offset 文件偏移
+     * @param userData 用户数据
+     */
+    static void prepRead(io_uring_sqe* sqe, int fd, void* buf, size_t len,
+                         uint64_t offset, uint64_t userData) {
+        prepRw(sqe, IORING_OP_READ, fd, buf, static_cast<unsigned>(len), offset, userData);
+    }
+
+    /**
+     * @brief 准备定位写请求
+     * @param sqe 提交队列条目
+     * @param fd 文件描述符
+     * @param buf 写缓冲区
+     * @param len 写入长度
+     * @param offset 文件偏移
+     * @param userData 用户数据
+     */
+    static void prepWrite(io_uring_sqe* sqe, int fd, const void* buf, size_t len,
+                          uint64_t offset, uint64_t userData) {
+        prepRw(sqe, IORING_OP_WRITE, fd, buf, static_cast<unsigned>(len), offset, userData);
+    }
+
+    /**
+     * @brief 准备 statx 请求
+     * @param sqe 提交队列条目
+     * @param dirfd 目录文件描述符，AT_FDCWD 表示当前目录
+     * @param path 路径，在完成前必须保持有效
+     * @param flags AT_* 标志
+     * @param mask 请求的 STATX_* 字段
+     * @param statxbuf 结果缓冲区（struct statx*）
+     * @param userData 用户数据
+     */
+    static void prepStatx(io_uring_sqe* sqe, int dirfd, const char* path, int flags,
+                          unsigned mask, void* statxbuf, uint64_t userData) {
+        prepRw(sqe, IORING_OP_STATX, dirfd, path, mask,
+               reinterpret_cast<uint64_t>(statxbuf), userData);
+        sqe->statx_flags = static_cast<__u32>(flags);
+    }
+
+    /**
+     * @brief 检测当前内核是否可以使用 io_uring
+     * @return 可用返回true
+     * @details 结果在首次调用后缓存
+     */
+    static bool isSupported() {
+        static const bool supported = [] {
+            IoUring probe;
+            std::string ignored;
+            return probe.init(2, ignored);
+        }();
+        return supported;
+    }
+
+private:
+    /**
+     * @brief 填充通用读写类请求字段
+     */
+    static void prepRw(io_uring_sqe* sqe, int op, int fd, const void* addr,
+                       unsigned len, uint64_t offset, uint64_t userData) {
+        sqe->opcode = static_cast<__u8>(op);
+        sqe->fd = fd;
+        sqe->off = offset;
+        sqe->addr = reinterpret_cast<uint64_t>(addr);
+        sqe->len = len;
+        sqe->user_data = userData;
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CCM_HAS_IO_URING
+
+#endif // CONSOLE_COMMAND_IO_URING_H
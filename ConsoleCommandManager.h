@@ -50,13 +50,36 @@
 #include <string>
 #include <vector>
 #include <map>
+#include <memory_resource>
 #include <functional>
 #include <memory>
 #include <sstream>
 #include <algorithm>
 #include <optional>
 #include <cstring>
+#include <cstdint>
 #include <iomanip>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <exception>
+#include <unordered_map>
+#include <fstream>
+#include <chrono>
+#include <deque>
+#include <unordered_set>
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+
+#include "ConsoleCommandIntern.h"
+#include "ConsoleCommandCatalog.h"
+#include "ConsoleCommandStats.h"
+#include "ConsoleCommandTrace.h"
+#include "ConsoleCommandAlloc.h"
+#include "ConsoleCommandSlowLog.h"
+#include "ConsoleCommandSnapshot.h"
 
 namespace ConsoleCommand {
 
@@ -64,14 +87,270 @@ namespace ConsoleCommand {
 // 类型定义和常量
 // ============================================================================
 
-/** @brief 参数值类型的字符串表示 */
-const std::string TYPE_STRING = "string";    ///< 字符串类型
-const std::string TYPE_INTEGER = "int";      ///< 整数类型
-const std::string TYPE_FLOAT = "float";      ///< 浮点数类型
-const std::string TYPE_BOOL = "bool";        ///< 布尔类型
-const std::string TYPE_FILE = "file";        ///< 文件路径类型
-const std::string TYPE_PATH = "path";        ///< 路径类型
-const std::string TYPE_COMMAND = "command";  ///< 命令名称类型
+/**
+ * @brief 参数值类型ID
+ * @details 内置类型是下列枚举值；用户类型通过 ParamTypes::registerType 注册，
+ *          从 UserFirst 开始按注册顺序分配。类型的解析、验证和补全按ID查表完成
+ */
+enum class ParamType : uint8_t {
+    String,     ///< 字符串类型
+    Integer,    ///< 整数类型
+    Float,      ///< 浮点数类型
+    Bool,       ///< 布尔类型
+    File,       ///< 文件路径类型
+    Path,       ///< 路径类型
+    Command,    ///< 命令名称类型
+    UserFirst   ///< 第一个用户类型的ID
+};
+
+/** @brief 内置参数类型（保留原有名称） */
+constexpr ParamType TYPE_STRING = ParamType::String;    ///< 字符串类型
+constexpr ParamType TYPE_INTEGER = ParamType::Integer;  ///< 整数类型
+constexpr ParamType TYPE_FLOAT = ParamType::Float;      ///< 浮点数类型
+constexpr ParamType TYPE_BOOL = ParamType::Bool;        ///< 布尔类型
+constexpr ParamType TYPE_FILE = ParamType::File;        ///< 文件路径类型
+constexpr ParamType TYPE_PATH = ParamType::Path;        ///< 路径类型
+constexpr ParamType TYPE_COMMAND = ParamType::Command;  ///< 命令名称类型
+
+/**
+ * @struct ParamTypeInfo
+ * @brief 参数类型的名称和行为
+ * @details 三个函数都可以为空：没有 parse 时原样接受文本，没有 validate 时不做额外检查，
+ *          没有 complete 时不提供补全候选
+ */
+struct ParamTypeInfo {
+    std::string name;   ///< 类型名称，显示在帮助中，也用于按名称查找
+    
+    /// 把文本转换为规范形式（例如布尔值的 yes/on/1 转为 true），格式错误时返回false并设置错误信息
+    std::function<bool(const std::string& text, std::string& value, std::string& errorMsg)> parse;
+    
+    /// 检查解析后的值是否满足约束（范围、存在性等），不满足时返回false并设置错误信息
+    std::function<bool(const std::string& value, std::string& errorMsg)> validate;
+    
+    /// 返回以 prefix 开头的候选值
+    std::function<std::vector<std::string>(const std::string& prefix)> complete;
+};
+
+/**
+ * @class ParamTypes
+ * @brief 进程级参数类型表
+ * @details 按ID查表是无锁的：每个ID对应一个原子指针，注册时在互斥锁内发布。
+ *          重新注册同名类型会替换其行为并沿用原ID；旧的类型信息不会释放，
+ *          并发读取中的调用者看到的是完整的旧版本或新版本
+ */
+class ParamTypes {
+public:
+    static constexpr size_t MAX_TYPES = 256;    ///< 类型ID的上限（ParamType 为 uint8_t）
+    
+    /**
+     * @brief 注册或替换类型
+     * @param info 类型名称和行为，名称不能为空
+     * @return 类型ID；名称为空或类型表已满时输出错误并返回 TYPE_STRING
+     */
+    static ParamType registerType(const ParamTypeInfo& info) {
+        if (info.name.empty()) {
+            std::cerr << "错误: 参数类型名称不能为空" << std::endl;
+            return TYPE_STRING;
+        }
+        Table& t = table();
+        std::lock_guard<std::mutex> lock(t.mutex);
+        size_t id = t.count;
+        for (size_t i = 0; i < t.count; ++i) {
+            if (t.slots[i].load(std::memory_order_relaxed)->name == info.name) {
+                id = i;
+                break;
+            }
+        }
+        if (id == MAX_TYPES) {
+            std::cerr << "错误: 参数类型数量已达上限 " << MAX_TYPES << "，无法注册 " << info.name << std::endl;
+            return TYPE_STRING;
+        }
+        t.storage.push_back(info);
+        t.slots[id].store(&t.storage.back(), std::memory_order_release);
+        if (id == t.count) {
+            ++t.count;
+        }
+        return static_cast<ParamType>(id);
+    }
+    
+    /**
+     * @brief 按名称查找类型
+     * @param name 类型名称
+     * @param type 找到时写入类型ID
+     * @return 找到返回true
+     */
+    static bool find(const std::string& name, ParamType& type) {
+        Table& t = table();
+        std::lock_guard<std::mutex> lock(t.mutex);
+        for (size_t i = 0; i < t.count; ++i) {
+            if (t.slots[i].load(std::memory_order_relaxed)->name == name) {
+                type = static_cast<ParamType>(i);
+                return true;
+            }
+        }
+        return false;
+    }
+    
+    /**
+     * @brief 按名称获取类型，不存在时注册一个不做检查的同名类型
+     * @details 兼容以字符串指定类型的旧代码，例如 addParameter(..., "path")
+     */
+    static ParamType fromName(const std::string& name) {
+        ParamType type;
+        if (name.empty()) return TYPE_STRING;
+        if (find(name, type)) return type;
+        ParamTypeInfo info;
+        info.name = name;
+        return registerType(info);
+    }
+    
+    /**
+     * @brief 获取类型信息
+     * @return 未注册的ID返回nullptr
+     */
+    static const ParamTypeInfo* info(ParamType type) {
+        return table().slots[static_cast<size_t>(type)].load(std::memory_order_acquire);
+    }
+    
+    /**
+     * @brief 获取类型名称
+     */
+    static const std::string& name(ParamType type) {
+        static const std::string unknown = "unknown";
+        const ParamTypeInfo* i = info(type);
+        return i ? i->name : unknown;
+    }
+    
+    /**
+     * @brief 解析并验证一个值
+     * @param type 类型ID
+     * @param text 输入文本
+     * @param value 输出规范形式
+     * @param errorMsg 失败时的错误信息
+     * @return 值合法返回true
+     */
+    static bool parse(ParamType type, const std::string& text, std::string& value, std::string& errorMsg) {
+        const ParamTypeInfo* i = info(type);
+        if (!i) {
+            errorMsg = "未注册的参数类型";
+            return false;
+        }
+        if (i->parse) {
+            if (!i->parse(text, value, errorMsg)) return false;
+        } else {
+            value = text;
+        }
+        return !i->validate || i->validate(value, errorMsg);
+    }
+    
+    /**
+     * @brief 获取补全候选
+     * @return 类型没有补全函数时返回空列表
+     */
+    static std::vector<std::string> complete(ParamType type, const std::string& prefix) {
+        const ParamTypeInfo* i = info(type);
+        if (!i || !i->complete) return {};
+        return i->complete(prefix);
+    }
+    
+private:
+    struct Table {
+        std::mutex mutex;
+        std::atomic<const ParamTypeInfo*> slots[MAX_TYPES] = {};
+        std::deque<ParamTypeInfo> storage;  ///< 所有注册过的类型信息，地址稳定
+        size_t count = 0;                   ///< 已分配的ID数
+        
+        Table() {
+            const char* names[] = {"string", "int", "float", "bool", "file", "path", "command"};
+            for (const char* n : names) {
+                ParamTypeInfo i;
+                i.name = n;
+                storage.push_back(std::move(i));
+                slots[count++].store(&storage.back(), std::memory_order_relaxed);
+            }
+            storage[static_cast<size_t>(ParamType::Integer)].parse = parseInteger;
+            storage[static_cast<size_t>(ParamType::Float)].parse = parseFloat;
+            storage[static_cast<size_t>(ParamType::Bool)].parse = parseBool;
+            storage[static_cast<size_t>(ParamType::Bool)].complete = [](const std::string& prefix) {
+                std::vector<std::string> out;
+                for (const char* v : {"true", "false"}) {
+                    if (std::strncmp(v, prefix.c_str(), prefix.size()) == 0) out.push_back(v);
+                }
+                return out;
+            };
+            storage[static_cast<size_t>(ParamType::File)].complete = completePath;
+            storage[static_cast<size_t>(ParamType::Path)].complete = completePath;
+        }
+    };
+    
+    static Table& table() {
+        static Table t;
+        return t;
+    }
+    
+    static bool parseInteger(const std::string& text, std::string& value, std::string& errorMsg) {
+        size_t i = (!text.empty() && (text[0] == '-' || text[0] == '+')) ? 1 : 0;
+        if (i == text.size() || text.find_first_not_of("0123456789", i) != std::string::npos) {
+            errorMsg = "应为整数";
+            return false;
+        }
+        errno = 0;
+        std::strtoll(text.c_str(), nullptr, 10);
+        if (errno == ERANGE) {
+            errorMsg = "整数超出范围";
+            return false;
+        }
+        value = text;
+        return true;
+    }
+    
+    static bool parseFloat(const std::string& text, std::string& value, std::string& errorMsg) {
+        char* end = nullptr;
+        errno = 0;
+        double d = std::strtod(text.c_str(), &end);
+        if (text.empty() || end != text.c_str() + text.size() || errno == ERANGE || d != d) {
+            errorMsg = "应为数字";
+            return false;
+        }
+        value = text;
+        return true;
+    }
+    
+    static bool parseBool(const std::string& text, std::string& value, std::string& errorMsg) {
+        std::string lower = text;
+        std::transform(lower.begin(), lower.end(), lower.begin(),
+                       [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+        if (lower == "true" || lower == "yes" || lower == "on" || lower == "1") {
+            value = "true";
+        } else if (lower == "false" || lower == "no" || lower == "off" || lower == "0") {
+            value = "false";
+        } else {
+            errorMsg = "应为 true/false、yes/no、on/off 或 1/0";
+            return false;
+        }
+        return true;
+    }
+    
+    static std::vector<std::string> completePath(const std::string& prefix) {
+        std::vector<std::string> out;
+        size_t slash = prefix.rfind('/');
+        std::string dir = slash == std::string::npos ? "." : (slash == 0 ? "/" : prefix.substr(0, slash));
+        std::string head = slash == std::string::npos ? "" : prefix.substr(0, slash + 1);
+        std::string base = slash == std::string::npos ? prefix : prefix.substr(slash + 1);
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+            std::string file = entry.path().filename().string();
+            if (file.compare(0, base.size(), base) != 0) continue;
+            if (base.empty() && !file.empty() && file[0] == '.') continue;
+            out.push_back(head + file + (entry.is_directory(ec) ? "/" : ""));
+        }
+        std::sort(out.begin(), out.end());
+        return out;
+    }
+};
+
+/** @brief 无效命令ID，表示命令不存在 */
+const uint32_t INVALID_COMMAND_ID = 0xFFFFFFFFu;
 
 /** @brief 默认配置常量 */
 const std::string DEFAULT_PROMPT = "> ";     ///< 默认命令行提示符
@@ -89,11 +368,11 @@ const int DEFAULT_MAX_SUGGESTIONS = 5;       ///< 默认最大建议命令数
  * 每个参数都应该有完整的描述信息，以便自动生成帮助文档。
  */
 struct ParameterDefinition {
-    std::string name;        ///< 参数名称（在帮助文档中显示）
-    std::string description; ///< 参数描述，说明参数的作用和用法
-    bool required;          ///< 是否为必需参数，必需参数必须提供
-    std::string defaultValue; ///< 默认值，当参数未提供时使用此值
-    std::string type;       ///< 参数值类型，用于类型检查和帮助文档生成
+    PooledString name;        ///< 参数名称（在帮助文档中显示）
+    PooledString description; ///< 参数描述，说明参数的作用和用法
+    PooledString defaultValue; ///< 默认值，当参数未提供时使用此值
+    bool required;            ///< 是否为必需参数，必需参数必须提供
+    ParamType type;           ///< 参数值类型，用于类型检查、补全和帮助文档生成
     
     /**
      * @brief 构造函数
@@ -107,9 +386,39 @@ struct ParameterDefinition {
                        const std::string& desc = "",
                        bool req = false,
                        const std::string& defVal = "",
-                       const std::string& t = TYPE_STRING)
-        : name(n), description(desc), required(req), 
-          defaultValue(defVal), type(t) {}
+                       ParamType t = TYPE_STRING)
+        : name(n), description(desc), defaultValue(defVal),
+          required(req), type(t) {}
+    
+    /**
+     * @brief 构造函数（按名称指定类型）
+     * @param t 类型名称，未注册的名称会注册为不做检查的类型
+     */
+    ParameterDefinition(const std::string& n,
+                       const std::string& desc,
+                       bool req,
+                       const std::string& defVal,
+                       const std::string& t)
+        : ParameterDefinition(n, desc, req, defVal, ParamTypes::fromName(t)) {}
+    
+    /**
+     * @brief 检查并规范化一个参数值
+     * @param text 输入文本
+     * @param value 输出规范形式
+     * @param errorMsg 失败时的错误信息
+     * @return 值符合参数类型返回true
+     */
+    bool checkValue(std::string_view text, std::string& value, std::string& errorMsg) const {
+        if (type == TYPE_STRING) {
+            value.assign(text.data(), text.size());
+            return true;
+        }
+        std::string input(text);
+        std::string reason;
+        if (ParamTypes::parse(type, input, value, reason)) return true;
+        errorMsg = "参数 " + name + " 的值无效: " + input + "（" + reason + "）";
+        return false;
+    }
     
     /**
      * @brief 获取参数的用法表示
@@ -122,6 +431,11 @@ struct ParameterDefinition {
             return "[" + name + "]";
         }
     }
+    
+    bool operator==(const ParameterDefinition& other) const {
+        return name == other.name && description == other.description && required == other.required &&
+               defaultValue == other.defaultValue && type == other.type;
+    }
 };
 
 // ============================================================================
@@ -136,12 +450,12 @@ struct ParameterDefinition {
  * 支持短选项（如 -h）和长选项（如 --help），可以指定是否需要值。
  */
 struct OptionDefinition {
-    std::string name;        ///< 长选项名（不带"--"前缀）
-    std::string shortName;   ///< 短选项名（不带"-"前缀），单字符
-    std::string description; ///< 选项描述，说明选项的作用和用法
-    bool requiresValue;      ///< 选项是否需要值，true表示需要附加参数值
-    std::string defaultValue; ///< 默认值，当选项未提供值但需要值时使用
-    std::string valueType;   ///< 选项值的类型描述，用于帮助文档生成
+    PooledString name;        ///< 长选项名（不带"--"前缀）
+    PooledString shortName;   ///< 短选项名（不带"-"前缀），单字符
+    PooledString description; ///< 选项描述，说明选项的作用和用法
+    bool requiresValue;       ///< 选项是否需要值，true表示需要附加参数值
+    PooledString defaultValue; ///< 默认值，当选项未提供值但需要值时使用
+    PooledString valueType;   ///< 选项值的类型描述，用于帮助文档生成
     
     /**
      * @brief 构造函数
@@ -183,11 +497,169 @@ struct OptionDefinition {
         
         // 如果需要值，添加值占位符
         if (requiresValue) {
-            usage += " <" + (valueType.empty() ? "value" : valueType) + ">";
+            usage += " <" + (valueType.empty() ? std::string("value") : valueType.str()) + ">";
         }
         
         return usage;
     }
+    
+    bool operator==(const OptionDefinition& other) const {
+        return name == other.name && shortName == other.shortName && description == other.description &&
+               requiresValue == other.requiresValue && defaultValue == other.defaultValue &&
+               valueType == other.valueType;
+    }
+};
+
+// ============================================================================
+// 会话类
+// ============================================================================
+
+/**
+ * @class Session
+ * @brief 每个客户端的会话状态
+ * 
+ * 保存工作目录、会话变量以及提示符、错误详细程度等可按会话覆盖的设置。
+ * 多个会话共享同一个CommandManager中的命令注册表，创建会话不会重新注册任何命令，
+ * 默认构造时不分配堆内存，适合服务器为每个连接创建一个会话。
+ * 
+ * 执行器通过CommandContext::getSession()访问当前会话。
+ * 
+ * @note 会话本身不是线程安全的，同一时刻只应有一个命令使用同一个会话
+ */
+class Session {
+private:
+    uint64_t id = 0;                                  ///< 会话ID
+    std::string workingDirectory;                     ///< 工作目录，为空表示进程当前目录
+    std::map<std::string, std::string> variables;     ///< 会话变量
+    std::string prompt = DEFAULT_PROMPT;              ///< 命令行提示符
+    bool verboseErrors = true;                        ///< 是否详细显示错误
+    bool autoHelp = true;                             ///< 失败时是否自动显示帮助
+    
+public:
+    /**
+     * @brief 构造函数
+     * @param sessionId 会话ID
+     */
+    explicit Session(uint64_t sessionId = 0) : id(sessionId) {}
+    
+    /**
+     * @brief 获取会话ID
+     * @return 会话ID
+     */
+    uint64_t getId() const { return id; }
+    
+    // ========================================================================
+    // 工作目录
+    // ========================================================================
+    
+    /**
+     * @brief 设置工作目录
+     * @param dir 目录路径，为空表示使用进程当前目录
+     */
+    void setWorkingDirectory(const std::string& dir) { workingDirectory = dir; }
+    
+    /**
+     * @brief 获取工作目录
+     * @return 工作目录，为空表示使用进程当前目录
+     */
+    const std::string& getWorkingDirectory() const { return workingDirectory; }
+    
+    /**
+     * @brief 把相对路径解析为相对于会话工作目录的路径
+     * @param path 用户输入的路径
+     * @return 绝对路径或工作目录下的路径，工作目录为空时原样返回
+     */
+    std::string resolvePath(const std::string& path) const {
+        if (workingDirectory.empty() || (!path.empty() && path[0] == '/')) {
+            return path;
+        }
+        if (path.empty() || path == ".") {
+            return workingDirectory;
+        }
+        if (workingDirectory.back() == '/') {
+            return workingDirectory + path;
+        }
+        return workingDirectory + "/" + path;
+    }
+    
+    // ========================================================================
+    // 会话变量
+    // ========================================================================
+    
+    /**
+     * @brief 设置会话变量
+     * @param name 变量名
+     * @param value 变量值
+     */
+    void setVariable(const std::string& name, const std::string& value) {
+        variables[name] = value;
+    }
+    
+    /**
+     * @brief 获取会话变量
+     * @param name 变量名
+     * @return 变量值的可选类型，不存在时返回std::nullopt
+     */
+    std::optional<std::string> getVariable(const std::string& name) const {
+        auto it = variables.find(name);
+        if (it != variables.end()) return it->second;
+        return std::nullopt;
+    }
+    
+    /**
+     * @brief 删除会话变量
+     * @param name 变量名
+     * @return 变量存在并被删除返回true
+     */
+    bool unsetVariable(const std::string& name) {
+        return variables.erase(name) > 0;
+    }
+    
+    /**
+     * @brief 获取所有会话变量
+     * @return 变量映射的常量引用
+     */
+    const std::map<std::string, std::string>& getVariables() const { return variables; }
+    
+    // ========================================================================
+    // 会话设置
+    // ========================================================================
+    
+    /**
+     * @brief 设置命令行提示符
+     * @param p 提示符字符串
+     */
+    void setPrompt(const std::string& p) { prompt = p; }
+    
+    /**
+     * @brief 获取命令行提示符
+     * @return 提示符字符串
+     */
+    const std::string& getPrompt() const { return prompt; }
+    
+    /**
+     * @brief 设置是否详细显示错误
+     * @param enable 启用或禁用
+     */
+    void setVerboseErrors(bool enable) { verboseErrors = enable; }
+    
+    /**
+     * @brief 是否详细显示错误
+     * @return 启用返回true
+     */
+    bool getVerboseErrors() const { return verboseErrors; }
+    
+    /**
+     * @brief 设置失败时是否自动显示帮助
+     * @param enable 启用或禁用
+     */
+    void setAutoHelp(bool enable) { autoHelp = enable; }
+    
+    /**
+     * @brief 失败时是否自动显示帮助
+     * @return 启用返回true
+     */
+    bool getAutoHelp() const { return autoHelp; }
 };
 
 // ============================================================================
@@ -200,63 +672,114 @@ struct OptionDefinition {
  * 
  * 封装了命令执行时所需的所有信息，包括命令名称、参数、选项等。
  * 提供了便捷的方法来获取和解析命令行输入。
+ * 
+ * 命令名、参数、选项、标志和元数据（以及分词时的临时数组）都从构造时指定的
+ * std::pmr::memory_resource 分配，未指定时使用 std::pmr::get_default_resource()。
+ * 每个线程处理请求时可以用自己的 unsynchronized_pool_resource，
+ * 或在每条命令前后创建、丢弃一个 monotonic_buffer_resource。
+ * 资源必须比上下文活得更久；复制得到的上下文使用默认资源（与标准 pmr 容器一致）。
  */
+class CommandManager;
+
 class CommandContext {
+public:
+    using String = std::pmr::string;                                  ///< 上下文中的字符串
+    using StringList = std::pmr::vector<String>;                      ///< 位置参数列表
+    using StringMap = std::pmr::map<String, String, std::less<>>;     ///< 选项、标志和元数据映射
+    
 private:
-    std::string commandName;      ///< 当前执行的命令名称
-    std::map<std::string, std::string> options;  ///< 选项键值对映射
-    std::map<std::string, std::string> flags;    ///< 标志选项映射（布尔选项）
-    std::vector<std::string> args;               ///< 位置参数列表
-    std::map<std::string, std::string> metadata; ///< 附加元数据存储
+    String commandName;           ///< 当前执行的命令名称
+    StringMap options;            ///< 选项键值对映射
+    StringMap flags;              ///< 标志选项映射（布尔选项）
+    StringList args;              ///< 位置参数列表
+    StringMap metadata;           ///< 附加元数据存储
+    std::ostream* output = nullptr;              ///< 标准输出流，为空时使用std::cout
+    std::ostream* errorOutput = nullptr;         ///< 错误输出流，为空时使用std::cerr
+    Session* session = nullptr;                  ///< 当前会话，由调用者保证生命周期
+    const Session* sessionView = nullptr;        ///< 未设置会话时只读使用的会话（管理器的默认会话）
+    CommandManager* manager = nullptr;           ///< 正在分发本命令的管理器
     
 public:
     /**
-     * @brief 默认构造函数
+     * @brief 默认构造函数，使用 std::pmr::get_default_resource()
+     */
+    CommandContext() : CommandContext(std::pmr::get_default_resource()) {}
+    
+    /**
+     * @brief 构造使用指定内存资源的空上下文
+     * @param mr 内存资源
      */
-    CommandContext() = default;
+    explicit CommandContext(std::pmr::memory_resource* mr)
+        : commandName(mr), options(mr), flags(mr), args(mr), metadata(mr) {}
     
     /**
      * @brief 从main函数参数构造命令上下文
      * @param argc 参数个数
      * @param argv 参数数组
+     * @param mr 内存资源
      * @details 自动解析命令行参数，区分命令、选项和参数
      */
-    explicit CommandContext(int argc, char* argv[]) {
+    CommandContext(int argc, char* argv[], std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : CommandContext(mr) {
         parseArgs(argc, argv);
     }
     
     /**
      * @brief 从字符串构造命令上下文
      * @param input 命令行字符串
+     * @param mr 内存资源
      * @details 将字符串分割为tokens，然后解析为命令上下文
      */
-    explicit CommandContext(const std::string& input) {
+    explicit CommandContext(std::string_view input,
+                            std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : CommandContext(mr) {
         parseString(input);
     }
     
+    /**
+     * @brief 复制到指定的内存资源上
+     * @param other 源上下文
+     * @param mr 内存资源
+     */
+    CommandContext(const CommandContext& other, std::pmr::memory_resource* mr)
+        : commandName(other.commandName, mr), options(other.options, mr), flags(other.flags, mr),
+          args(other.args, mr), metadata(other.metadata, mr), output(other.output),
+          errorOutput(other.errorOutput), session(other.session), sessionView(other.sessionView),
+          manager(other.manager) {}
+    
+    CommandContext(const CommandContext&) = default;
+    CommandContext(CommandContext&&) = default;
+    CommandContext& operator=(const CommandContext&) = default;
+    CommandContext& operator=(CommandContext&&) = default;
+    
     // ========================================================================
     // 公共接口方法
     // ========================================================================
     
+    /**
+     * @brief 获取上下文使用的内存资源
+     */
+    std::pmr::memory_resource* getResource() const { return args.get_allocator().resource(); }
+    
     /**
      * @brief 设置命令名称
      * @param name 命令名称
      */
-    void setCommandName(const std::string& name) { commandName = name; }
+    void setCommandName(std::string_view name) { commandName.assign(name.data(), name.size()); }
     
     /**
      * @brief 获取命令名称
      * @return 当前命令名称
      */
-    const std::string& getCommandName() const { return commandName; }
+    const String& getCommandName() const { return commandName; }
     
     /**
      * @brief 设置选项值
      * @param key 选项名称（不带"--"前缀）
      * @param value 选项值
      */
-    void setOption(const std::string& key, const std::string& value) {
-        options[key] = value;
+    void setOption(std::string_view key, std::string_view value) {
+        put(options, key, value);
     }
     
     /**
@@ -264,9 +787,9 @@ public:
      * @param key 选项名称
      * @return 选项值的可选类型，如果选项不存在返回std::nullopt
      */
-    std::optional<std::string> getOption(const std::string& key) const {
+    std::optional<std::string> getOption(std::string_view key) const {
         auto it = options.find(key);
-        if (it != options.end()) return it->second;
+        if (it != options.end()) return std::string(it->second);
         return std::nullopt;
     }
     
@@ -276,17 +799,23 @@ public:
      * @param defaultValue 默认值
      * @return 选项值或默认值
      */
-    std::string getOption(const std::string& key, const std::string& defaultValue) const {
-        auto val = getOption(key);
-        return val.has_value() ? val.value() : defaultValue;
+    std::string getOption(std::string_view key, const std::string& defaultValue) const {
+        auto it = options.find(key);
+        return it != options.end() ? std::string(it->second) : defaultValue;
     }
     
+    /**
+     * @brief 获取所有选项
+     * @return 选项映射的常量引用
+     */
+    const StringMap& getAllOptions() const { return options; }
+    
     /**
      * @brief 设置标志选项（布尔选项）
      * @param flag 标志名称
      */
-    void setFlag(const std::string& flag) {
-        flags[flag] = "true";
+    void setFlag(std::string_view flag) {
+        put(flags, flag, "true");
     }
     
     /**
@@ -294,16 +823,31 @@ public:
      * @param flag 标志名称
      * @return 如果标志存在返回true，否则返回false
      */
-    bool hasFlag(const std::string& flag) const {
+    bool hasFlag(std::string_view flag) const {
         return flags.find(flag) != flags.end();
     }
     
+    /**
+     * @brief 获取所有标志
+     * @return 标志映射的常量引用
+     */
+    const StringMap& getAllFlags() const { return flags; }
+    
     /**
      * @brief 添加位置参数
      * @param arg 参数值
      */
-    void addArgument(const std::string& arg) {
-        args.push_back(arg);
+    void addArgument(std::string_view arg) {
+        args.emplace_back(arg);
+    }
+    
+    /**
+     * @brief 替换指定位置的参数值
+     * @param index 参数索引，超出范围时忽略
+     * @param value 新的参数值
+     */
+    void setArgument(size_t index, std::string_view value) {
+        if (index < args.size()) args[index].assign(value.data(), value.size());
     }
     
     /**
@@ -313,7 +857,7 @@ public:
      * @return 参数值或默认值
      */
     std::string getArgument(size_t index, const std::string& defaultValue = "") const {
-        if (index < args.size()) return args[index];
+        if (index < args.size()) return std::string(args[index]);
         return defaultValue;
     }
     
@@ -321,7 +865,7 @@ public:
      * @brief 获取所有参数
      * @return 参数列表的常量引用
      */
-    const std::vector<std::string>& getArguments() const {
+    const StringList& getArguments() const {
         return args;
     }
     
@@ -338,8 +882,8 @@ public:
      * @param key 元数据键
      * @param value 元数据值
      */
-    void setMetadata(const std::string& key, const std::string& value) {
-        metadata[key] = value;
+    void setMetadata(std::string_view key, std::string_view value) {
+        put(metadata, key, value);
     }
     
     /**
@@ -347,14 +891,80 @@ public:
      * @param key 元数据键
      * @return 元数据的可选类型，如果不存在返回std::nullopt
      */
-    std::optional<std::string> getMetadata(const std::string& key) const {
+    std::optional<std::string> getMetadata(std::string_view key) const {
         auto it = metadata.find(key);
-        if (it != metadata.end()) return it->second;
+        if (it != metadata.end()) return std::string(it->second);
         return std::nullopt;
     }
     
+    /**
+     * @brief 设置命令的标准输出流
+     * @param os 输出流指针，传入nullptr恢复为std::cout
+     * @details 服务器模式下用于捕获每个请求的输出，流的生命周期由调用者保证
+     */
+    void setOutput(std::ostream* os) { output = os; }
+    
+    /**
+     * @brief 设置命令的错误输出流
+     * @param os 输出流指针，传入nullptr恢复为std::cerr
+     */
+    void setErrorOutput(std::ostream* os) { errorOutput = os; }
+    
+    /**
+     * @brief 获取命令的标准输出流
+     * @return 已设置的输出流，未设置时返回std::cout
+     * @note 执行器应通过此方法输出，而不是直接使用std::cout
+     */
+    std::ostream& out() const { return output ? *output : std::cout; }
+    
+    /**
+     * @brief 获取命令的错误输出流
+     * @return 已设置的错误输出流，未设置时返回std::cerr
+     */
+    std::ostream& err() const { return errorOutput ? *errorOutput : std::cerr; }
+    
+    /**
+     * @brief 设置当前会话
+     * @param s 会话指针
+     */
+    void setSession(Session* s) { session = s; }
+    
+    /**
+     * @brief 获取当前会话
+     * @return 可修改的会话指针，执行器可以通过它读写工作目录、变量和会话设置；
+     *         调用者没有提供会话时为空，修改会话的命令应报告错误
+     */
+    Session* getSession() const { return session; }
+    
+    /**
+     * @brief 设置只读会话
+     * @param s 会话指针
+     * @note 由 CommandManager::processCommand 在未设置会话时填入管理器的默认会话
+     */
+    void setSessionView(const Session* s) { sessionView = s; }
+    
+    /**
+     * @brief 获取用于读取的会话
+     * @return 当前会话，未设置时为只读的默认会话；都没有时为空
+     */
+    const Session* getSessionView() const { return session ? session : sessionView; }
+    
+    /**
+     * @brief 设置分发命令的管理器
+     * @note 由 CommandManager::processCommand 在分发前填入
+     */
+    void setManager(CommandManager* m) { manager = m; }
+    
+    /**
+     * @brief 获取分发命令的管理器
+     * @return 管理器指针；执行器应通过它访问管理器，而不是捕获管理器的地址，
+     *         这样管理器被移动或复制后执行器仍然有效
+     */
+    CommandManager* getManager() const { return manager; }
+    
     /**
      * @brief 清空上下文内容
+     * @note 输出流和会话设置不会被清空
      */
     void clear() {
         commandName.clear();
@@ -364,11 +974,33 @@ public:
         metadata.clear();
     }
     
+    /**
+     * @brief 清空并重新解析命令行字符串
+     * @param input 命令行字符串
+     * @note 输出流和会话设置保持不变，适合批量处理时复用同一个上下文
+     */
+    void parse(std::string_view input) {
+        clear();
+        parseString(input);
+    }
+    
 private:
     // ========================================================================
     // 私有辅助方法
     // ========================================================================
     
+    /**
+     * @brief 插入或更新映射中的键，键和值都从映射的内存资源分配
+     */
+    static void put(StringMap& map, std::string_view key, std::string_view value) {
+        auto it = map.find(key);
+        if (it != map.end()) {
+            it->second.assign(value.data(), value.size());
+        } else {
+            map.emplace(key, value);
+        }
+    }
+    
     /**
      * @brief 解析命令行参数
      * @param argc 参数个数
@@ -381,16 +1013,18 @@ private:
      */
     void parseArgs(int argc, char* argv[]) {
         if (argc == 0) return;
+        CCM_TRACE_SPAN("parseArgs");
+        CCM_ALLOC_PHASE(AllocPhase::Parse);
         
         commandName = argv[0];
         
         for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
+            std::string_view arg = argv[i];
             
             if (arg == "--") {
                 // 分隔符，后面的都是参数
                 for (int j = i + 1; j < argc; ++j) {
-                    args.push_back(argv[j]);
+                    args.emplace_back(argv[j]);
                 }
                 break;
             } else if (arg.size() > 2 && arg.substr(0, 2) == "--") {
@@ -401,7 +1035,7 @@ private:
                 parseShortOption(arg.substr(1), i, argc, argv);
             } else {
                 // 位置参数
-                args.push_back(arg);
+                args.emplace_back(arg);
             }
         }
     }
@@ -409,45 +1043,54 @@ private:
     /**
      * @brief 解析字符串命令
      * @param input 命令行字符串
-     * @details 将字符串分割为tokens，处理引号包围的参数
+     * @details 按空白字符分割为tokens，处理引号包围的参数。
+     *          tokens 和 argv 数组都从上下文的内存资源分配
      */
-    void parseString(const std::string& input) {
-        std::vector<std::string> tokens;
-        std::istringstream iss(input);
-        std::string token;
+    void parseString(std::string_view input) {
+        CCM_TRACE_SPAN("tokenize");
+        CCM_ALLOC_PHASE(AllocPhase::Parse);
+        StringList tokens(getResource());
         
         // 分割字符串，处理带引号的参数
-        while (iss >> token) {
+        auto isSpace = [](char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; };
+        size_t pos = 0;
+        while (pos < input.size()) {
+            while (pos < input.size() && isSpace(input[pos])) ++pos;
+            size_t start = pos;
+            while (pos < input.size() && !isSpace(input[pos])) ++pos;
+            if (start == pos) break;
+            std::string_view token = input.substr(start, pos - start);
             if (!tokens.empty() && tokens.back().front() == '"' && tokens.back().back() != '"') {
                 // 续接被空格分割的带引号字符串
-                tokens.back() += " " + token;
+                tokens.back() += ' ';
+                tokens.back().append(token.data(), token.size());
             } else {
-                tokens.push_back(token);
+                tokens.emplace_back(token);
             }
         }
         
         // 清理引号
         for (auto& t : tokens) {
             if (t.front() == '"' && t.back() == '"') {
-                t = t.substr(1, t.size() - 2);
+                if (t.size() == 1) {
+                    t.clear();
+                } else {
+                    t.pop_back();
+                    t.erase(0, 1);
+                }
             }
         }
         
         if (tokens.empty()) return;
         
         // 转换为argc/argv格式进行解析
-        std::vector<char*> argv;
-        std::vector<std::string> argvStorage;
-        
-        for (const auto& t : tokens) {
-            argvStorage.push_back(t);
-        }
-        
-        for (auto& s : argvStorage) {
-            argv.push_back(&s[0]);
+        std::pmr::vector<char*> argv(getResource());
+        argv.reserve(tokens.size());
+        for (auto& t : tokens) {
+            argv.push_back(t.data());
         }
         
-        parseArgs(argv.size(), argv.data());
+        parseArgs(static_cast<int>(argv.size()), argv.data());
     }
     
     /**
@@ -457,22 +1100,20 @@ private:
      * @param argc 参数总数
      * @param argv 参数数组
      */
-    void parseLongOption(const std::string& opt, int& index, int argc, char* argv[]) {
+    void parseLongOption(std::string_view opt, int& index, int argc, char* argv[]) {
         size_t eqPos = opt.find('=');
         
-        if (eqPos != std::string::npos) {
+        if (eqPos != std::string_view::npos) {
             // 格式: --key=value
-            std::string key = opt.substr(0, eqPos);
-            std::string value = opt.substr(eqPos + 1);
-            options[key] = value;
+            put(options, opt.substr(0, eqPos), opt.substr(eqPos + 1));
         } else {
             // 检查下一个参数是否为值
             if (index + 1 < argc && argv[index + 1][0] != '-') {
-                options[opt] = argv[index + 1];
+                put(options, opt, argv[index + 1]);
                 ++index;  // 跳过值参数
             } else {
                 // 布尔标志
-                flags[opt] = "true";
+                put(flags, opt, "true");
             }
         }
     }
@@ -485,22 +1126,21 @@ private:
      * @param argv 参数数组
      * @details 支持单字符选项（-o）和组合选项（-xyz）
      */
-    void parseShortOption(const std::string& opt, int& index, int argc, char* argv[]) {
+    void parseShortOption(std::string_view opt, int& index, int argc, char* argv[]) {
         if (opt.empty()) return;
         
         if (opt.size() == 1) {
             // 单字符选项
-            char c = opt[0];
             if (index + 1 < argc && argv[index + 1][0] != '-') {
-                options[std::string(1, c)] = argv[index + 1];
+                put(options, opt, argv[index + 1]);
                 ++index;  // 跳过值参数
             } else {
-                flags[std::string(1, c)] = "true";
+                put(flags, opt, "true");
             }
         } else {
             // 组合短选项，如 -xyz
-            for (char c : opt) {
-                flags[std::string(1, c)] = "true";
+            for (size_t i = 0; i < opt.size(); ++i) {
+                put(flags, opt.substr(i, 1), "true");
             }
         }
     }
@@ -510,30 +1150,141 @@ private:
 // 命令定义类
 // ============================================================================
 
+namespace detail {
+class CommandTable;
+}
+
 /**
  * @class CommandDefinition
  * @brief 命令定义类
  * 
  * 封装了命令的完整定义，包括名称、描述、参数、选项、执行器等。
  * 提供了流式接口（Fluent Interface）便于构建命令定义。
- */
-class CommandDefinition {
+ * 
+ * 文本字段保存在 StringPool 中，定义里只有句柄。参数、选项、示例和附加说明放在
+ * 可共享的 Details 中：CommandManager 注册时让内容相同的定义共享同一份，
+ * 修改共享的 Details 前先复制（写时复制），因此共享对使用者不可见。
+ * 
+ * 别名列表和 Details 从构造时指定的 std::pmr::memory_resource 分配，
+ * 注册到 CommandManager 时复制到管理器的资源上。
+ * 
+ * 设置了消息ID的定义在显示时从 MessageCatalog 取得描述和帮助文本（见 setMessageId），
+ * 注册时的文本只在目录中没有对应条目时使用。
+ */
+class CommandDefinition {
+public:
+    /**
+     * @struct Details
+     * @brief 参数、选项、示例和附加说明
+     * @details 大型注册表中很多命令的这部分完全相同，由 CommandManager 在注册时去重共享
+     */
+    struct Details {
+        std::pmr::vector<ParameterDefinition> parameters;  ///< 参数定义列表
+        std::pmr::vector<OptionDefinition> options;        ///< 选项定义列表
+        std::pmr::vector<PooledString> examples;           ///< 使用示例列表
+        PooledString usage;     ///< 使用说明，如果为空则自动生成
+        PooledString helpText;  ///< 自定义帮助文本，如果为空则自动生成
+        PooledString version;   ///< 命令版本
+        PooledString author;    ///< 命令作者
+        
+        Details() = default;
+        Details(const Details&) = default;
+        
+        explicit Details(std::pmr::memory_resource* mr) : parameters(mr), options(mr), examples(mr) {}
+        
+        /** @brief 复制到指定的内存资源上 */
+        Details(const Details& other, std::pmr::memory_resource* mr)
+            : parameters(other.parameters, mr), options(other.options, mr), examples(other.examples, mr),
+              usage(other.usage), helpText(other.helpText), version(other.version), author(other.author) {}
+        
+        /** @brief 列表使用的内存资源 */
+        std::pmr::memory_resource* resource() const { return parameters.get_allocator().resource(); }
+        
+        bool operator==(const Details& other) const {
+            return parameters == other.parameters && options == other.options && examples == other.examples &&
+                   usage == other.usage && helpText == other.helpText && version == other.version &&
+                   author == other.author;
+        }
+        
+        /**
+         * @brief 内容哈希，用于注册时查找内容相同的 Details
+         */
+        size_t hash() const {
+            size_t h = parameters.size() * 31 + options.size();
+            auto mix = [&h](const PooledString& s) {
+                h ^= std::hash<PooledString>()(s) + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+            };
+            for (const auto& p : parameters) {
+                mix(p.name);
+                mix(p.description);
+                mix(p.defaultValue);
+                h = h * 31 + (p.required ? 1 : 0) + static_cast<size_t>(p.type) * 2;
+            }
+            for (const auto& o : options) {
+                mix(o.name);
+                mix(o.shortName);
+                mix(o.description);
+                mix(o.defaultValue);
+                mix(o.valueType);
+                h = h * 31 + (o.requiresValue ? 1 : 0);
+            }
+            for (const auto& e : examples) mix(e);
+            mix(usage);
+            mix(helpText);
+            mix(version);
+            mix(author);
+            return h;
+        }
+        
+        /**
+         * @brief 估算占用的堆内存（不含字符串池中的文本）
+         */
+        size_t heapBytes() const {
+            return sizeof(Details) + parameters.capacity() * sizeof(ParameterDefinition) +
+                   options.capacity() * sizeof(OptionDefinition) + examples.capacity() * sizeof(PooledString);
+        }
+    };
+    
 private:
     // 命令基本信息
-    std::string name;        ///< 命令名称（主名称）
-    std::string description; ///< 命令描述，说明命令的作用
-    std::string category;    ///< 命令分类，用于组织命令
-    std::string usage;       ///< 使用说明，如果为空则自动生成
-    std::vector<std::string> aliases;  ///< 命令别名列表
-    std::vector<ParameterDefinition> parameters;  ///< 参数定义列表
-    std::vector<OptionDefinition> options;        ///< 选项定义列表
+    PooledString name;        ///< 命令名称（主名称）
+    PooledString description; ///< 命令描述，说明命令的作用
+    PooledString category;    ///< 命令分类，用于组织命令
+    PooledString messageId;   ///< 消息目录中文本的键前缀，为空表示只使用注册时的文本
+    std::pmr::vector<PooledString> aliases;  ///< 命令别名列表，其内存资源也用于分配 Details
+    std::shared_ptr<Details> details;   ///< 参数、选项和附加说明，为空表示都没有；可能与其他定义共享
     std::function<bool(const CommandContext&)> executor;  ///< 命令执行函数
+    uint32_t commandId = INVALID_COMMAND_ID;  ///< 注册时由 CommandManager 分配的命令ID
+    bool coalescable = false;          ///< 并发的相同请求是否合并为一次执行
+    bool builtin = false;              ///< 是否为 CommandManager 注册的内置命令
+    
+    friend class detail::CommandTable;  // 从快照记录直接构造定义，字符串不经过 StringPool
+    friend class CommandManager;        // 注册内置命令时设置 builtin
+    
+    /**
+     * @brief 获取可修改的 Details，与其他定义共享时先复制
+     */
+    Details& mutableDetails() {
+        if (!details) {
+            details = std::allocate_shared<Details>(std::pmr::polymorphic_allocator<Details>(getResource()),
+                                                    getResource());
+        } else if (details.use_count() > 1 || details->resource() != getResource()) {
+            details = copyDetails(*details);
+        }
+        return *details;
+    }
+    
+    std::shared_ptr<Details> copyDetails(const Details& d) const {
+        return std::allocate_shared<Details>(std::pmr::polymorphic_allocator<Details>(getResource()),
+                                             d, getResource());
+    }
+    
+    static const Details& emptyDetails() {
+        static const Details empty;
+        return empty;
+    }
     
-    // 附加信息
-    std::vector<std::string> examples; ///< 使用示例列表
-    std::string version;               ///< 命令版本
-    std::string author;                ///< 命令作者
-    std::string helpText;              ///< 自定义帮助文本，如果为空则自动生成
+    const Details& view() const { return details ? *details : emptyDetails(); }
     
 public:
     /**
@@ -541,8 +1292,25 @@ public:
      * @param n 命令名称
      * @param desc 命令描述
      */
-    CommandDefinition(const std::string& n = "", const std::string& desc = "")
-        : name(n), description(desc), category("General") {}
+    CommandDefinition(const std::string& n = "", const std::string& desc = "",
+                      std::pmr::memory_resource* mr = std::pmr::get_default_resource())
+        : name(StringPool::store(n)), description(StringPool::store(desc)), category("General"), aliases(mr) {}
+    
+    /**
+     * @brief 复制到指定的内存资源上
+     * @param other 源定义
+     * @param mr 内存资源
+     * @details 别名列表复制到 mr 上；Details 仍与源定义共享，需要时调用 localizeDetails() 复制
+     */
+    CommandDefinition(const CommandDefinition& other, std::pmr::memory_resource* mr)
+        : name(other.name), description(other.description), category(other.category),
+          messageId(other.messageId), aliases(other.aliases, mr), details(other.details), executor(other.executor),
+          commandId(other.commandId), coalescable(other.coalescable), builtin(other.builtin) {}
+    
+    CommandDefinition(const CommandDefinition&) = default;
+    CommandDefinition(CommandDefinition&&) = default;
+    CommandDefinition& operator=(const CommandDefinition&) = default;
+    CommandDefinition& operator=(CommandDefinition&&) = default;
     
     // ========================================================================
     // 流式接口设置方法（返回*this以便链式调用）
@@ -553,14 +1321,17 @@ public:
      * @param n 命令名称
      * @return 当前对象的引用（支持链式调用）
      */
-    CommandDefinition& setName(const std::string& n) { name = n; return *this; }
+    CommandDefinition& setName(const std::string& n) { name = StringPool::store(n); return *this; }
     
     /**
      * @brief 设置命令描述
      * @param desc 命令描述
      * @return 当前对象的引用
      */
-    CommandDefinition& setDescription(const std::string& desc) { description = desc; return *this; }
+    CommandDefinition& setDescription(const std::string& desc) {
+        description = StringPool::store(desc);
+        return *this;
+    }
     
     /**
      * @brief 设置命令分类
@@ -569,12 +1340,30 @@ public:
      */
     CommandDefinition& setCategory(const std::string& cat) { category = cat; return *this; }
     
+    /**
+     * @brief 设置消息ID，描述和帮助文本改为从消息目录中解析
+     * @param id 键前缀，例如 "files.ls"
+     * @return 当前对象的引用
+     * @details 使用的键（目录中没有的键使用注册时的文本）：
+     *          - id.description：命令描述
+     *          - id.usage：使用说明
+     *          - id.help：自定义帮助文本
+     *          - id.examples：使用示例，每行一个
+     *          - id.param.<参数名>、id.option.<长选项名>：参数和选项的描述
+     *          
+     *          文本在显示时解析，切换 MessageCatalog 的当前目录后立即生效，不需要重新注册
+     */
+    CommandDefinition& setMessageId(const std::string& id) { messageId = id; return *this; }
+    
     /**
      * @brief 设置使用说明
      * @param use 使用说明字符串
      * @return 当前对象的引用
      */
-    CommandDefinition& setUsage(const std::string& use) { usage = use; return *this; }
+    CommandDefinition& setUsage(const std::string& use) {
+        mutableDetails().usage = StringPool::store(use);
+        return *this;
+    }
     
     /**
      * @brief 设置命令执行器
@@ -591,21 +1380,39 @@ public:
      * @param text 帮助文本
      * @return 当前对象的引用
      */
-    CommandDefinition& setHelpText(const std::string& text) { helpText = text; return *this; }
+    CommandDefinition& setHelpText(const std::string& text) {
+        mutableDetails().helpText = StringPool::store(text);
+        return *this;
+    }
     
     /**
      * @brief 设置命令版本
      * @param ver 版本字符串
      * @return 当前对象的引用
      */
-    CommandDefinition& setVersion(const std::string& ver) { version = ver; return *this; }
+    CommandDefinition& setVersion(const std::string& ver) {
+        mutableDetails().version = StringPool::intern(ver);
+        return *this;
+    }
     
     /**
      * @brief 设置命令作者
      * @param auth 作者信息
      * @return 当前对象的引用
      */
-    CommandDefinition& setAuthor(const std::string& auth) { author = auth; return *this; }
+    CommandDefinition& setAuthor(const std::string& auth) {
+        mutableDetails().author = StringPool::intern(auth);
+        return *this;
+    }
+    
+    /**
+     * @brief 设置是否合并并发的相同请求
+     * @param enable 启用后，参数、选项和工作目录都相同的并发请求只执行一次，
+     *               结果（输出和返回值）分发给所有等待者；输出超过 1 MiB 的执行不再合并
+     * @return 当前对象的引用
+     * @warning 只应对只读、无副作用且输出只取决于参数的命令启用
+     */
+    CommandDefinition& setCoalescable(bool enable = true) { coalescable = enable; return *this; }
     
     /**
      * @brief 添加命令别名
@@ -613,7 +1420,7 @@ public:
      * @return 当前对象的引用
      */
     CommandDefinition& addAlias(const std::string& alias) {
-        aliases.push_back(alias);
+        aliases.push_back(StringPool::store(alias));
         return *this;
     }
     
@@ -623,7 +1430,7 @@ public:
      * @return 当前对象的引用
      */
     CommandDefinition& addParameter(const ParameterDefinition& param) {
-        parameters.push_back(param);
+        mutableDetails().parameters.push_back(param);
         return *this;
     }
     
@@ -633,25 +1440,50 @@ public:
      * @param description 参数描述
      * @param required 是否必需，默认为false
      * @param defaultValue 默认值，默认为空
-     * @param type 参数类型，默认为"string"
+     * @param type 参数类型，默认为 TYPE_STRING
      * @return 当前对象的引用
      */
     CommandDefinition& addParameter(const std::string& name, 
                                    const std::string& description = "",
                                    bool required = false,
                                    const std::string& defaultValue = "",
-                                   const std::string& type = TYPE_STRING) {
-        parameters.emplace_back(name, description, required, defaultValue, type);
+                                   ParamType type = TYPE_STRING) {
+        mutableDetails().parameters.emplace_back(name, description, required, defaultValue, type);
+        return *this;
+    }
+    
+    /**
+     * @brief 添加参数（按名称指定类型）
+     * @param type 参数类型名称，如"int"或用户注册的类型名
+     * @return 当前对象的引用
+     */
+    CommandDefinition& addParameter(const std::string& name, 
+                                   const std::string& description,
+                                   bool required,
+                                   const std::string& defaultValue,
+                                   const std::string& type) {
+        mutableDetails().parameters.emplace_back(name, description, required, defaultValue, type);
         return *this;
     }
     
+    /**
+     * @brief 添加参数（按名称指定类型）
+     */
+    CommandDefinition& addParameter(const std::string& name, 
+                                   const std::string& description,
+                                   bool required,
+                                   const std::string& defaultValue,
+                                   const char* type) {
+        return addParameter(name, description, required, defaultValue, std::string(type));
+    }
+    
     /**
      * @brief 添加选项定义
      * @param opt 选项定义对象
      * @return 当前对象的引用
      */
     CommandDefinition& addOption(const OptionDefinition& opt) {
-        options.push_back(opt);
+        mutableDetails().options.push_back(opt);
         return *this;
     }
     
@@ -671,7 +1503,7 @@ public:
                                 bool requiresValue = false,
                                 const std::string& defaultValue = "",
                                 const std::string& valueType = "") {
-        options.emplace_back(name, shortName, description, requiresValue, defaultValue, valueType);
+        mutableDetails().options.emplace_back(name, shortName, description, requiresValue, defaultValue, valueType);
         return *this;
     }
     
@@ -681,7 +1513,7 @@ public:
      * @return 当前对象的引用
      */
     CommandDefinition& addExample(const std::string& example) {
-        examples.push_back(example);
+        mutableDetails().examples.push_back(StringPool::store(example));
         return *this;
     }
     
@@ -693,72 +1525,147 @@ public:
      * @brief 获取命令名称
      * @return 命令名称
      */
-    const std::string& getName() const { return name; }
+    const PooledString& getName() const { return name; }
     
     /**
      * @brief 获取命令描述
      * @return 命令描述
      */
-    const std::string& getDescription() const { return description; }
+    std::string getDescription() const { return MessageCatalog::resolve(messageId, ".description", description); }
+    
+    /**
+     * @brief 获取注册时的命令描述（不经过消息目录）
+     */
+    const PooledString& getInlineDescription() const { return description; }
+    
+    /**
+     * @brief 获取消息ID
+     * @return 消息ID，未设置时为空
+     */
+    const PooledString& getMessageId() const { return messageId; }
     
     /**
      * @brief 获取命令分类
      * @return 命令分类
      */
-    const std::string& getCategory() const { return category; }
+    const PooledString& getCategory() const { return category; }
     
     /**
      * @brief 获取使用说明
      * @return 使用说明
      */
-    const std::string& getUsage() const { return usage; }
+    std::string getUsage() const { return MessageCatalog::resolve(messageId, ".usage", view().usage); }
     
     /**
      * @brief 获取命令别名列表
      * @return 别名列表的常量引用
      */
-    const std::vector<std::string>& getAliases() const { return aliases; }
+    const std::pmr::vector<PooledString>& getAliases() const { return aliases; }
     
     /**
      * @brief 获取参数定义列表
      * @return 参数定义列表的常量引用
      */
-    const std::vector<ParameterDefinition>& getParameters() const { return parameters; }
+    const std::pmr::vector<ParameterDefinition>& getParameters() const { return view().parameters; }
     
     /**
      * @brief 获取选项定义列表
      * @return 选项定义列表的常量引用
      */
-    const std::vector<OptionDefinition>& getOptions() const { return options; }
+    const std::pmr::vector<OptionDefinition>& getOptions() const { return view().options; }
     
     /**
      * @brief 获取使用示例列表
      * @return 示例列表的常量引用
      */
-    const std::vector<std::string>& getExamples() const { return examples; }
+    const std::pmr::vector<PooledString>& getExamples() const { return view().examples; }
     
     /**
      * @brief 获取命令版本
      * @return 版本字符串
      */
-    const std::string& getVersion() const { return version; }
+    const PooledString& getVersion() const { return view().version; }
     
     /**
      * @brief 获取命令作者
      * @return 作者信息
      */
-    const std::string& getAuthor() const { return author; }
+    const PooledString& getAuthor() const { return view().author; }
     
     /**
      * @brief 获取自定义帮助文本
      * @return 帮助文本
      */
-    const std::string& getHelpText() const { return helpText; }
+    std::string getHelpText() const { return MessageCatalog::resolve(messageId, ".help", view().helpText); }
+    
+    /**
+     * @brief 获取参数、选项和附加说明的存储
+     * @return 没有任何参数、选项和附加说明时返回nullptr；返回的对象可能与其他定义共享
+     */
+    const Details* getDetails() const { return details.get(); }
+    
+    /**
+     * @brief 与内容相同的另一个定义共享 Details
+     * @param other 另一个定义
+     * @return 内容相同（此后共享同一份存储）返回true，内容不同返回false
+     */
+    bool shareDetails(const CommandDefinition& other) {
+        if (details == other.details) return true;
+        if (!details || !other.details || !(*details == *other.details)) return false;
+        details = other.details;
+        return true;
+    }
+    
+    /**
+     * @brief 获取别名列表和 Details 使用的内存资源
+     */
+    std::pmr::memory_resource* getResource() const { return aliases.get_allocator().resource(); }
+    
+    /**
+     * @brief 确保 Details 从本定义的内存资源分配
+     * @details Details 来自其他资源（例如复制自另一个管理器的定义）时复制一份，
+     *          之后不再依赖原资源的生命周期
+     */
+    void localizeDetails() {
+        if (details && details->resource() != getResource()) {
+            details = copyDetails(*details);
+        }
+    }
     
     // ========================================================================
     // 功能方法
     // ========================================================================
     
+    /**
+     * @brief 检查是否合并并发的相同请求
+     * @return 启用合并返回true
+     */
+    bool isCoalescable() const { return coalescable; }
+    
+    /**
+     * @brief 检查是否为内置命令（help、set、stats 等）
+     * @return 由 CommandManager 自身注册的命令返回true
+     */
+    bool isBuiltin() const { return builtin; }
+    
+    /**
+     * @brief 获取命令ID
+     * @return 注册后分配的ID，未注册时返回 INVALID_COMMAND_ID
+     */
+    uint32_t getId() const { return commandId; }
+    
+    /**
+     * @brief 设置命令ID（由 CommandManager 在注册时调用）
+     * @param id 命令ID
+     */
+    void setId(uint32_t id) { commandId = id; }
+    
+    /**
+     * @brief 获取命令执行器
+     * @return 执行器，未设置时为空
+     */
+    const std::function<bool(const CommandContext&)>& getExecutor() const { return executor; }
+    
     /**
      * @brief 检查命令是否可执行
      * @return 如果设置了执行器返回true，否则返回false
@@ -787,23 +1694,7 @@ public:
      * @return 验证通过返回true，否则返回false
      */
     bool validateArguments(const CommandContext& context, std::string& errorMsg) const {
-        size_t argCount = context.argumentCount();
-        
-        // 检查必需参数
-        for (size_t i = 0; i < parameters.size(); ++i) {
-            if (parameters[i].required && i >= argCount) {
-                errorMsg = "缺少必需参数: " + parameters[i].name;
-                return false;
-            }
-        }
-        
-        // 检查参数数量是否过多（如果没有定义可变参数）
-        if (!hasVariadicParameters() && argCount > parameters.size()) {
-            errorMsg = "参数数量过多，最多允许 " + std::to_string(parameters.size()) + " 个参数";
-            return false;
-        }
-        
-        return true;
+        return checkArguments(context, errorMsg, nullptr);
     }
     
     /**
@@ -812,6 +1703,8 @@ public:
      * @details 如果设置了自定义usage则使用之，否则根据参数定义自动生成
      */
     std::string generateUsage() const {
+        const Details& d = view();
+        std::string usage = getUsage();
         if (!usage.empty()) {
             return usage;
         }
@@ -820,12 +1713,12 @@ public:
         ss << name;
         
         // 添加参数
-        for (const auto& param : parameters) {
+        for (const auto& param : d.parameters) {
             ss << " " << param.getUsage();
         }
         
         // 添加选项占位符
-        if (!options.empty()) {
+        if (!d.options.empty()) {
             ss << " [选项...]";
         }
         
@@ -839,6 +1732,8 @@ public:
      * @details 如果设置了自定义helpText且不需要详细帮助，则使用自定义文本
      */
     std::string generateHelp(bool detailed = false) const {
+        const Details& d = view();
+        std::string helpText = getHelpText();
         if (!helpText.empty() && !detailed) {
             return helpText;
         }
@@ -857,46 +1752,47 @@ public:
         }
         ss << "\n";
         
-        if (!description.empty()) {
-            ss << "描述: " << description << "\n";
+        std::string desc = getDescription();
+        if (!desc.empty()) {
+            ss << "描述: " << desc << "\n";
         }
         
         if (!category.empty() && category != "General") {
             ss << "分类: " << category << "\n";
         }
         
-        if (!version.empty()) {
-            ss << "版本: " << version << "\n";
+        if (!d.version.empty()) {
+            ss << "版本: " << d.version << "\n";
         }
         
-        if (!author.empty()) {
-            ss << "作者: " << author << "\n";
+        if (!d.author.empty()) {
+            ss << "作者: " << d.author << "\n";
         }
         
         ss << "\n用法: " << generateUsage() << "\n";
         
         // 参数说明
-        if (!parameters.empty()) {
+        if (!d.parameters.empty()) {
             ss << "\n参数:\n";
-            for (const auto& param : parameters) {
+            for (const auto& param : d.parameters) {
                 ss << "  " << std::left << std::setw(20) << param.getUsage();
-                ss << " " << param.description;
+                ss << " " << localized(".param.", param.name, param.description);
                 if (!param.defaultValue.empty()) {
                     ss << " [默认: " << param.defaultValue << "]";
                 }
-                if (!param.type.empty() && param.type != TYPE_STRING) {
-                    ss << " (" << param.type << ")";
+                if (param.type != TYPE_STRING) {
+                    ss << " (" << ParamTypes::name(param.type) << ")";
                 }
                 ss << "\n";
             }
         }
         
         // 选项说明
-        if (!options.empty()) {
+        if (!d.options.empty()) {
             ss << "\n选项:\n";
-            for (const auto& opt : options) {
+            for (const auto& opt : d.options) {
                 ss << "  " << std::left << std::setw(40) << opt.getUsage();
-                ss << " " << opt.description;
+                ss << " " << localized(".option.", opt.name, opt.description);
                 if (!opt.defaultValue.empty()) {
                     ss << " [默认: " << opt.defaultValue << "]";
                 }
@@ -905,9 +1801,18 @@ public:
         }
         
         // 使用示例
-        if (!examples.empty() && detailed) {
+        std::string examples;
+        if (detailed && MessageCatalog::find(messageId, ".examples", examples) && !examples.empty()) {
+            ss << "\n示例:\n";
+            std::string_view rest = examples;
+            while (!rest.empty()) {
+                size_t end = rest.find('\n');
+                ss << "  " << rest.substr(0, end) << "\n";
+                rest = end == std::string_view::npos ? std::string_view() : rest.substr(end + 1);
+            }
+        } else if (!d.examples.empty() && detailed) {
             ss << "\n示例:\n";
-            for (const auto& example : examples) {
+            for (const auto& example : d.examples) {
                 ss << "  " << example << "\n";
             }
         }
@@ -916,517 +1821,2515 @@ public:
     }
     
 private:
+    /**
+     * @brief 验证参数，并可选地收集与原文不同的规范形式
+     * @param context 命令上下文，包含实际参数
+     * @param errorMsg 输出参数，验证失败时存储错误信息
+     * @param normalized 不为空时追加 (参数索引, 规范形式)，例如 bool 的 "yes" 对应 "true"
+     * @return 验证通过返回true，否则返回false
+     */
+    bool checkArguments(const CommandContext& context, std::string& errorMsg,
+                        std::vector<std::pair<size_t, std::string>>* normalized) const {
+        const auto& parameters = view().parameters;
+        size_t argCount = context.argumentCount();
+        
+        // 检查必需参数
+        for (size_t i = 0; i < parameters.size(); ++i) {
+            if (parameters[i].required && i >= argCount) {
+                errorMsg = "缺少必需参数: " + parameters[i].name;
+                return false;
+            }
+        }
+        
+        // 检查参数数量是否过多（如果没有定义可变参数）
+        if (!hasVariadicParameters() && argCount > parameters.size()) {
+            errorMsg = "参数数量过多，最多允许 " + std::to_string(parameters.size()) + " 个参数";
+            return false;
+        }
+        
+        // 检查参数类型，超出定义的参数按可变参数的类型检查
+        const auto& args = context.getArguments();
+        std::string value;
+        for (size_t i = 0; i < args.size() && !parameters.empty(); ++i) {
+            const ParameterDefinition& param = parameters[std::min(i, parameters.size() - 1)];
+            if (!param.checkValue(args[i], value, errorMsg)) {
+                return false;
+            }
+            if (normalized && std::string_view(value) != std::string_view(args[i])) {
+                normalized->emplace_back(i, value);
+            }
+        }
+        
+        return true;
+    }
+    
+    /**
+     * @brief 参数或选项描述：目录中的 messageId + kind + name，没有时为注册时的文本
+     */
+    std::string localized(std::string_view kind, const PooledString& item, const PooledString& fallback) const {
+        if (messageId.empty()) return fallback.str();
+        std::string suffix(kind);
+        suffix.append(item.data(), item.size());
+        return MessageCatalog::resolve(messageId, suffix, fallback);
+    }
+    
     /**
      * @brief 检查是否包含可变参数
      * @return 如果最后一个参数是"..."则返回true，表示支持可变参数
      */
     bool hasVariadicParameters() const {
+        const auto& parameters = view().parameters;
         return !parameters.empty() && parameters.back().name == "...";
     }
 };
 
-// ============================================================================
-// 命令管理器类（核心类）
-// ============================================================================
+namespace detail {
 
 /**
- * @class CommandManager
- * @brief 命令管理器类
- * 
- * 管理所有注册的命令，提供命令注册、查找、执行等功能。
- * 支持交互式命令行模式、参数解析、帮助系统等。
+ * @class NameIndex
+ * @brief 命令名和别名到命令ID的开放寻址哈希索引
+ * @details 每个槽位 8 字节（32 位哈希值和一个引用），负载因子不超过 0.7，线性探测。
+ *          引用编码为 ((命令ID + 1) << 8) | 序号，序号 0 表示命令名、k 表示第 k 个别名，
+ *          键本身不复制，比较时通过回调从命令定义中取得。
+ *          命令名优先于别名：别名不会覆盖已存在的命令名，命令名会覆盖同名的别名。
+ *          槽位数组可以是外部的（加载的快照中的数组），扩容时才复制到自己的存储中。
  */
-class CommandManager {
-private:
-    // 命令存储结构
-    std::map<std::string, CommandDefinition> commands;  ///< 命令名称到定义的映射
-    std::map<std::string, std::string> aliasToCommand;  ///< 别名到命令名称的映射
-    std::map<std::string, std::vector<std::string>> categoryToCommands;  ///< 分类到命令列表的映射
-    
-    // 全局选项定义
-    std::vector<OptionDefinition> globalOptions;
-    
-    // 配置结构
-    struct Config {
-        std::string prompt = DEFAULT_PROMPT;  ///< 命令行提示符
-        bool autoHelp = true;                 ///< 是否自动显示帮助
-        bool verboseErrors = true;            ///< 是否详细显示错误
-        bool colorOutput = true;              ///< 是否使用彩色输出
-        int maxSuggestions = DEFAULT_MAX_SUGGESTIONS;  ///< 最大建议命令数
-    } config;
-    
+class NameIndex {
 public:
+    static constexpr uint32_t MAX_ID = (1u << 24) - 2;     ///< 可索引的最大命令ID
+    static constexpr size_t MAX_ALIASES = 255;             ///< 每个命令可索引的别名数
+    
     /**
-     * @brief 构造函数
-     * @details 初始化全局选项和内置命令
+     * @brief 槽位，布局与快照文件中的 SnapshotSlot 相同
      */
-    CommandManager() {
-        setupGlobalOptions();
-        setupBuiltinCommands();
-    }
+    struct Slot {
+        uint32_t hash = 0;
+        uint32_t ref = EMPTY;
+    };
     
-    // ========================================================================
-    // 配置方法
-    // ========================================================================
+    NameIndex() = default;
+    explicit NameIndex(std::pmr::memory_resource* mr) : slots(mr) {}
     
-    /**
-     * @brief 设置命令行提示符
-     * @param prompt 提示符字符串
-     */
-    void setPrompt(const std::string& prompt) { config.prompt = prompt; }
+    NameIndex(const NameIndex& other, std::pmr::memory_resource* mr)
+        : slots(other.table, other.table + other.capacity, mr), table(slots.data()), capacity(other.capacity),
+          used(other.used), live(other.live), aliases(other.aliases) {}
     
-    /**
-     * @brief 设置是否自动显示帮助
-     * @param enable 启用或禁用自动帮助
-     */
-    void setAutoHelp(bool enable) { config.autoHelp = enable; }
+    NameIndex(const NameIndex& other) : NameIndex(other, std::pmr::get_default_resource()) {}
     
-    /**
-     * @brief 设置是否详细显示错误
-     * @param enable 启用或禁用详细错误
-     */
-    void setVerboseErrors(bool enable) { config.verboseErrors = enable; }
+    NameIndex(NameIndex&& other) noexcept
+        : slots(std::move(other.slots)), table(other.table), capacity(other.capacity),
+          used(other.used), live(other.live), aliases(other.aliases) {
+        other.reset();
+    }
     
-    /**
-     * @brief 设置是否使用彩色输出
-     * @param enable 启用或禁用彩色输出
-     */
-    void setColorOutput(bool enable) { config.colorOutput = enable; }
+    NameIndex& operator=(const NameIndex& other) {
+        if (this != &other) {
+            slots.assign(other.table, other.table + other.capacity);
+            table = slots.data();
+            copyCounts(other);
+        }
+        return *this;
+    }
     
-    /**
-     * @brief 设置最大建议命令数
-     * @param max 最大建议数
-     */
-    void setMaxSuggestions(int max) { config.maxSuggestions = max; }
+    NameIndex& operator=(NameIndex&& other) {
+        if (this != &other) {
+            bool external = other.isExternal();
+            slots = std::move(other.slots);    // 资源不同时逐个复制到本对象的存储
+            table = external ? other.table : slots.data();
+            copyCounts(other);
+            other.reset();
+        }
+        return *this;
+    }
     
-    // ========================================================================
-    // 命令注册方法
-    // ========================================================================
+    static uint32_t makeRef(uint32_t id, size_t which) {
+        return ((id + 1) << 8) | static_cast<uint32_t>(which);
+    }
+    static uint32_t refId(uint32_t ref) { return (ref >> 8) - 1; }
+    static size_t refWhich(uint32_t ref) { return ref & 0xFF; }
+    
+    static uint32_t hashOf(std::string_view key) {
+        uint64_t h = std::hash<std::string_view>()(key);
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
     
     /**
-     * @brief 注册完整命令定义
-     * @param cmd 命令定义对象
-     * @return 注册成功返回true，失败返回false
-     * @note 如果命令已存在，会发出警告并覆盖
+     * @brief 查找键
+     * @param keyOf 由引用取得键的回调
+     * @return 引用，不存在时返回0
      */
-    bool registerCommand(const CommandDefinition& cmd) {
-        if (cmd.getName().empty()) {
-            std::cerr << "错误: 命令名称不能为空" << std::endl;
-            return false;
+    template<typename KeyOf>
+    uint32_t find(std::string_view key, KeyOf&& keyOf) const {
+        if (capacity == 0) return 0;
+        uint32_t h = hashOf(key);
+        size_t mask = capacity - 1;
+        // 最多探测 capacity 次：外部数组来自文件，不能假定其中一定有空槽位
+        for (size_t i = h & mask, n = 0; n < capacity; i = (i + 1) & mask, ++n) {
+            const Slot& slot = table[i];
+            if (slot.ref == EMPTY) return 0;
+            if (slot.ref != TOMBSTONE && slot.hash == h && keyOf(slot.ref) == key) return slot.ref;
         }
-        
-        if (commands.find(cmd.getName()) != commands.end()) {
-            std::cerr << "警告: 命令 '" << cmd.getName() << "' 已存在，将被覆盖" << std::endl;
+        return 0;
+    }
+    
+    /**
+     * @brief 插入或更新键
+     * @return 键已存在且被保留（别名不覆盖命令名）时返回false
+     */
+    template<typename KeyOf>
+    bool insert(std::string_view key, uint32_t ref, KeyOf&& keyOf) {
+        if ((used + 1) * 10 > capacity * 7) {
+            size_t newCapacity = 16;
+            while ((live + 1) * 2 > newCapacity) newCapacity *= 2;   // 重建后负载不超过 0.5
+            rehash(newCapacity);
         }
-        
-        // 注册主命令
-        commands[cmd.getName()] = cmd;
-        
-        // 注册别名
-        for (const auto& alias : cmd.getAliases()) {
-            if (!alias.empty() && alias != cmd.getName()) {
-                aliasToCommand[alias] = cmd.getName();
+        uint32_t h = hashOf(key);
+        size_t mask = capacity - 1;
+        Slot* free = nullptr;
+        size_t n = 0;
+        for (size_t i = h & mask; n < capacity; i = (i + 1) & mask, ++n) {
+            Slot& slot = table[i];
+            if (slot.ref == EMPTY) {
+                if (!free) {
+                    free = &slot;
+                    ++used;
+                }
+                break;
+            }
+            if (slot.ref == TOMBSTONE) {
+                if (!free) free = &slot;
+                continue;
+            }
+            if (slot.hash == h && keyOf(slot.ref) == key) {
+                if (refWhich(slot.ref) == 0 && refWhich(ref) != 0 && refId(slot.ref) != refId(ref)) {
+                    return false;
+                }
+                if (refWhich(slot.ref) != 0) --aliases;
+                if (refWhich(ref) != 0) ++aliases;
+                slot.ref = ref;
+                return true;
             }
         }
-        
-        // 按分类存储
-        categoryToCommands[cmd.getCategory()].push_back(cmd.getName());
-        
+        if (n == capacity && !free) {
+            // 外部数组的计数与内容不符时没有空槽位，重建后重试
+            rehash(capacity * 2);
+            return insert(key, ref, keyOf);
+        }
+        free->hash = h;
+        free->ref = ref;
+        ++live;
+        if (refWhich(ref) != 0) ++aliases;
         return true;
     }
     
     /**
-     * @brief 创建并注册命令（便捷方法，不带执行器）
-     * @param name 命令名称
-     * @param description 命令描述
-     * @return 已注册命令定义的引用，可后续设置执行器
-     * @warning 返回的引用在命令重新注册后可能失效
+     * @brief 删除指向 ref 的键（键已指向其他引用时不删除）
      */
-    CommandDefinition& createCommand(const std::string& name, 
-                                    const std::string& description) {
-        CommandDefinition cmd(name, description);
-        
-        // 存储并返回引用
-        commands[name] = cmd;
-        categoryToCommands[cmd.getCategory()].push_back(name);
-        
-        return commands[name];
+    template<typename KeyOf>
+    void erase(std::string_view key, uint32_t ref, KeyOf&& keyOf) {
+        if (capacity == 0) return;
+        uint32_t h = hashOf(key);
+        size_t mask = capacity - 1;
+        for (size_t i = h & mask, n = 0; n < capacity; i = (i + 1) & mask, ++n) {
+            Slot& slot = table[i];
+            if (slot.ref == EMPTY) return;
+            if (slot.ref == ref && slot.hash == h && keyOf(slot.ref) == key) {
+                slot.ref = TOMBSTONE;
+                --live;
+                if (refWhich(ref) != 0) --aliases;
+                return;
+            }
+        }
     }
     
     /**
-     * @brief 创建并注册命令（便捷方法，带执行器）
-     * @tparam Func 执行函数类型
-     * @param name 命令名称
+     * @brief 使用外部的槽位数组（快照文件中的索引），不复制
+     * @param external 槽位数组，容量为 2 的幂，必须比索引活得更久；修改会直接写入该数组
+     */
+    void adopt(Slot* external, size_t cap, size_t usedSlots, size_t liveKeys, size_t aliasKeys) {
+        slots.clear();
+        slots.shrink_to_fit();
+        table = cap ? external : nullptr;
+        capacity = cap;
+        used = usedSlots;
+        live = liveKeys;
+        aliases = aliasKeys;
+    }
+    
+    /** @brief 清除墓碑（保持容量） */
+    void compact() {
+        if (capacity != 0) rehash(capacity);
+    }
+    
+    const Slot* data() const { return table; }
+    size_t slotCount() const { return capacity; }
+    size_t usedCount() const { return used; }
+    size_t liveCount() const { return live; }
+    size_t aliasCount() const { return aliases; }
+    
+    /** @brief 自有存储的字节数（外部数组不计） */
+    size_t bytes() const { return slots.capacity() * sizeof(Slot); }
+    
+private:
+    static constexpr uint32_t EMPTY = 0;
+    static constexpr uint32_t TOMBSTONE = 1;    ///< 序号 1、命令ID -1，不会是有效引用
+    
+    std::pmr::vector<Slot> slots;   ///< 自有存储
+    Slot* table = nullptr;          ///< 当前槽位：slots.data() 或外部数组，大小总是 2 的幂
+    size_t capacity = 0;            ///< 槽位数
+    size_t used = 0;                ///< 非空槽位数（含墓碑）
+    size_t live = 0;                ///< 有效键数
+    size_t aliases = 0;             ///< 有效的别名键数
+    
+    bool isExternal() const { return table && table != slots.data(); }
+    
+    void copyCounts(const NameIndex& other) {
+        capacity = other.capacity;
+        used = other.used;
+        live = other.live;
+        aliases = other.aliases;
+    }
+    
+    void reset() {
+        table = nullptr;
+        capacity = used = live = aliases = 0;
+    }
+    
+    void rehash(size_t newCapacity) {
+        std::pmr::vector<Slot> fresh(newCapacity, Slot(), slots.get_allocator());
+        size_t mask = newCapacity - 1;
+        for (size_t k = 0; k < capacity; ++k) {
+            const Slot& slot = table[k];
+            if (slot.ref == EMPTY || slot.ref == TOMBSTONE) continue;
+            size_t i = slot.hash & mask;
+            while (fresh[i].ref != EMPTY) i = (i + 1) & mask;
+            fresh[i] = slot;
+        }
+        slots.swap(fresh);
+        table = slots.data();
+        capacity = newCapacity;
+        used = live;
+    }
+};
+
+static_assert(sizeof(NameIndex::Slot) == sizeof(SnapshotSlot), "快照槽位布局必须与 NameIndex 一致");
+
+/**
+ * @class CommandTable
+ * @brief 按命令ID存放命令定义的分块数组
+ * @details 每块 CHUNK 个定义，追加时已有定义的地址不变（createCommand 返回的引用保持有效），
+ *          没有 std::vector 扩容时的空闲容量，也没有 std::map 每个节点的指针和键副本；
+ *          块和定义的别名列表都从表的内存资源分配，同一资源上的移动只转移块指针。
+ *
+ *          从快照构造的表中，ID 0 到 commandCount-1 的定义在第一次访问时才由快照记录构造
+ *          （字符串复制到字符串池，相同的 Details 只构造一次）。已构造的定义由每块一个的位图发布，
+ *          读取只需两次 acquire 加载，构造在互斥锁内完成，因此多个线程可以并发地查找和执行命令
+ */
+class CommandTable {
+public:
+    static constexpr size_t CHUNK = 64;     ///< 每块的定义数
+    
+    CommandTable() : CommandTable(std::pmr::get_default_resource()) {}
+    explicit CommandTable(std::pmr::memory_resource* mr) : chunks(mr) {}
+    
+    /**
+     * @brief 以快照中的命令作为前 commandCount 个定义
+     * @param file 已映射的快照
+     * @param mr 内存资源
+     */
+    CommandTable(std::shared_ptr<const SnapshotFile> file, std::pmr::memory_resource* mr) : chunks(mr) {
+        uint32_t n = file->commandCount();
+        lazy = createLazy(std::move(file), n);
+        base = n;
+    }
+    
+    CommandTable(const CommandTable& other, std::pmr::memory_resource* mr) : chunks(mr) {
+        try {
+            if (other.lazy) {
+                lazy = createLazy(other.lazy->file, other.base);
+                base = other.base;
+                other.forEachLoaded([this](size_t i, const CommandDefinition& cmd) {
+                    Block* block = blockFor(i);
+                    new (&block->defs()[i % CHUNK]) CommandDefinition(cmd, resource());
+                    block->ready.fetch_or(uint64_t(1) << (i % CHUNK), std::memory_order_relaxed);
+                });
+            }
+            for (size_t i = 0; i < other.count; ++i) push_back(other[other.base + i]);
+        } catch (...) {
+            clear();
+            throw;
+        }
+    }
+    
+    CommandTable(const CommandTable& other) : CommandTable(other, std::pmr::get_default_resource()) {}
+    
+    CommandTable(CommandTable&& other) noexcept
+        : chunks(std::move(other.chunks)), count(std::exchange(other.count, 0)),
+          base(std::exchange(other.base, 0)), lazy(std::exchange(other.lazy, nullptr)) {}
+    
+    /** @brief 复制赋值，保留本表的内存资源 */
+    CommandTable& operator=(const CommandTable& other) {
+        if (this != &other) {
+            CommandTable copy(other, resource());
+            swap(copy);
+        }
+        return *this;
+    }
+    
+    /** @brief 移动赋值，资源不同时退化为逐个复制 */
+    CommandTable& operator=(CommandTable&& other) {
+        if (this != &other) {
+            if (resource() == other.resource()) {
+                clear();
+                swap(other);
+            } else {
+                *this = static_cast<const CommandTable&>(other);
+            }
+        }
+        return *this;
+    }
+    
+    ~CommandTable() { clear(); }
+    
+    std::pmr::memory_resource* resource() const { return chunks.get_allocator().resource(); }
+    size_t size() const { return base + count; }
+    
+    CommandDefinition& operator[](size_t i) {
+        return const_cast<CommandDefinition&>(static_cast<const CommandTable&>(*this)[i]);
+    }
+    
+    const CommandDefinition& operator[](size_t i) const {
+        if (i < base) {
+            const Block* block = lazy->blocks[i / CHUNK].load(std::memory_order_acquire);
+            if (block && (block->ready.load(std::memory_order_acquire) >> (i % CHUNK) & 1)) {
+                return block->defs()[i % CHUNK];
+            }
+            return load(i);
+        }
+        i -= base;
+        return chunks[i / CHUNK][i % CHUNK];
+    }
+    
+    /**
+     * @brief 已构造的定义
+     * @return 快照中尚未访问过的命令返回nullptr
+     */
+    const CommandDefinition* peek(size_t i) const {
+        if (i >= base) return &(*this)[i];
+        const Block* block = lazy->blocks[i / CHUNK].load(std::memory_order_acquire);
+        if (block && (block->ready.load(std::memory_order_acquire) >> (i % CHUNK) & 1)) {
+            return &block->defs()[i % CHUNK];
+        }
+        return nullptr;
+    }
+    
+    /**
+     * @brief 命令名（which 为 0）或第 which 个别名，不构造定义
+     */
+    std::string_view key(size_t id, size_t which) const {
+        if (id >= size()) return std::string_view();
+        if (const CommandDefinition* cmd = peek(id)) {
+            if (which == 0) return cmd->getName().view();
+            const auto& aliases = cmd->getAliases();
+            return which <= aliases.size() ? aliases[which - 1].view() : std::string_view();
+        }
+        const SnapshotFile& file = *lazy->file;
+        const SnapshotCommand& rec = file.command(static_cast<uint32_t>(id));
+        if (which == 0) return file.view(rec.name);
+        const uint32_t* refs = file.refs(rec.aliasFirst, rec.aliasCount);
+        return refs && which <= rec.aliasCount ? file.view(refs[which - 1]) : std::string_view();
+    }
+    
+    std::string_view name(size_t id) const { return key(id, 0); }
+    
+    CommandDefinition& push_back(const CommandDefinition& cmd) {
+        if (count == chunks.size() * CHUNK) {
+            CommandDefinition* chunk = allocator<CommandDefinition>().allocate(CHUNK);
+            try {
+                chunks.push_back(chunk);
+            } catch (...) {
+                allocator<CommandDefinition>().deallocate(chunk, CHUNK);
+                throw;
+            }
+        }
+        CommandDefinition* slot = &chunks[count / CHUNK][count % CHUNK];
+        new (slot) CommandDefinition(cmd, resource());
+        ++count;
+        return *slot;
+    }
+    
+    /** @brief 块和块指针数组占用的字节数（不含快照映射） */
+    size_t bytes() const {
+        size_t total = chunks.size() * CHUNK * sizeof(CommandDefinition) + chunks.capacity() * sizeof(CommandDefinition*);
+        if (lazy) {
+            total += sizeof(Lazy) + blockCount() * sizeof(std::atomic<Block*>);
+            for (size_t b = 0; b < blockCount(); ++b) {
+                if (lazy->blocks[b].load(std::memory_order_acquire)) total += sizeof(Block);
+            }
+        }
+        return total;
+    }
+    
+    /** @brief 快照中的命令数 */
+    size_t snapshotCount() const { return base; }
+    
+    /** @brief 映射的快照文件大小 */
+    size_t snapshotBytes() const { return lazy ? lazy->file->bytes() : 0; }
+    
+private:
+    /**
+     * @brief 快照中 CHUNK 个命令的定义存储，ready 的第 k 位表示第 k 个已构造
+     */
+    struct Block {
+        std::atomic<uint64_t> ready{0};
+        alignas(CommandDefinition) unsigned char storage[CHUNK * sizeof(CommandDefinition)];
+        
+        CommandDefinition* defs() { return reinterpret_cast<CommandDefinition*>(storage); }
+        const CommandDefinition* defs() const { return reinterpret_cast<const CommandDefinition*>(storage); }
+    };
+    
+    /**
+     * @brief 快照状态
+     */
+    struct Lazy {
+        std::shared_ptr<const SnapshotFile> file;
+        std::atomic<Block*>* blocks;    ///< 每 CHUNK 个命令一项，首次访问时分配
+        std::mutex mutex;               ///< 构造定义和 Details 时持有
+        std::pmr::unordered_map<uint32_t, std::shared_ptr<CommandDefinition::Details>> details;  ///< 按记录下标
+        
+        Lazy(std::shared_ptr<const SnapshotFile> f, std::atomic<Block*>* b, std::pmr::memory_resource* mr)
+            : file(std::move(f)), blocks(b), details(mr) {}
+    };
+    
+    std::pmr::vector<CommandDefinition*> chunks;    ///< 每块 CHUNK 个定义的存储，只构造前 count 个
+    size_t count = 0;       ///< 快照之后追加的定义数
+    size_t base = 0;        ///< 快照中的命令数，这些命令的ID在追加的命令之前
+    Lazy* lazy = nullptr;   ///< 快照状态，不是从快照构造时为空
+    
+    template<typename T>
+    std::pmr::polymorphic_allocator<T> allocator() const {
+        return std::pmr::polymorphic_allocator<T>(resource());
+    }
+    
+    size_t blockCount() const { return (base + CHUNK - 1) / CHUNK; }
+    
+    Lazy* createLazy(std::shared_ptr<const SnapshotFile> file, size_t n) {
+        size_t blocks = (n + CHUNK - 1) / CHUNK;
+        std::atomic<Block*>* dir = allocator<std::atomic<Block*>>().allocate(blocks);
+        for (size_t b = 0; b < blocks; ++b) new (&dir[b]) std::atomic<Block*>(nullptr);
+        Lazy* state = allocator<Lazy>().allocate(1);
+        new (state) Lazy(std::move(file), dir, resource());
+        return state;
+    }
+    
+    /** @brief 取得（必要时分配）第 i 个快照命令所在的块，调用者持有锁或独占本表 */
+    Block* blockFor(size_t i) {
+        std::atomic<Block*>& slot = lazy->blocks[i / CHUNK];
+        Block* block = slot.load(std::memory_order_relaxed);
+        if (!block) {
+            block = allocator<Block>().allocate(1);
+            new (block) Block();
+            slot.store(block, std::memory_order_release);
+        }
+        return block;
+    }
+    
+    template<typename Func>
+    void forEachLoaded(Func&& func) const {
+        for (size_t b = 0; b < blockCount(); ++b) {
+            const Block* block = lazy->blocks[b].load(std::memory_order_acquire);
+            if (!block) continue;
+            uint64_t ready = block->ready.load(std::memory_order_acquire);
+            for (size_t k = 0; k < CHUNK; ++k) {
+                if (ready >> k & 1) func(b * CHUNK + k, block->defs()[k]);
+            }
+        }
+    }
+    
+    /**
+     * @brief 把快照中的字符串复制到字符串池
+     * @details 定义可以被复制到管理器之外，句柄必须与其他 PooledString 一样在整个进程中有效，
+     *          因此不直接指向映射（映射在管理器析构或加载另一个快照时解除）
+     */
+    static PooledString stored(const SnapshotFile& file, uint32_t ref) { return StringPool::store(file.view(ref)); }
+    static PooledString interned(const SnapshotFile& file, uint32_t ref) { return StringPool::intern(file.view(ref)); }
+    
+    /**
+     * @brief 由快照记录构造第 i 个定义
+     */
+    const CommandDefinition& load(size_t i) const {
+        CommandTable& self = const_cast<CommandTable&>(*this);
+        std::lock_guard<std::mutex> lock(lazy->mutex);
+        Block* block = self.blockFor(i);
+        uint64_t bit = uint64_t(1) << (i % CHUNK);
+        CommandDefinition* cmd = &block->defs()[i % CHUNK];
+        if (block->ready.load(std::memory_order_relaxed) & bit) {
+            return *cmd;
+        }
+        
+        const SnapshotFile& file = *lazy->file;
+        const SnapshotCommand& rec = file.command(static_cast<uint32_t>(i));
+        new (cmd) CommandDefinition(std::string(), std::string(), resource());
+        try {
+            cmd->name = stored(file, rec.name);
+            cmd->description = stored(file, rec.description);
+            cmd->category = interned(file, rec.category);
+            cmd->messageId = stored(file, rec.messageId);
+            if (const uint32_t* refs = file.refs(rec.aliasFirst, rec.aliasCount)) {
+                cmd->aliases.reserve(rec.aliasCount);
+                for (uint32_t k = 0; k < rec.aliasCount; ++k) {
+                    cmd->aliases.push_back(stored(file, refs[k]));
+                }
+            }
+            cmd->details = self.loadDetails(rec.details);
+            cmd->commandId = static_cast<uint32_t>(i);
+            cmd->coalescable = (rec.flags & SNAPSHOT_COALESCABLE) != 0;
+            cmd->builtin = (rec.flags & SNAPSHOT_BUILTIN) != 0;
+        } catch (...) {
+            cmd->~CommandDefinition();
+            throw;
+        }
+        block->ready.fetch_or(bit, std::memory_order_release);
+        return *cmd;
+    }
+    
+    /**
+     * @brief 由快照记录构造（或取得已构造的）Details，调用者持有锁
+     */
+    std::shared_ptr<CommandDefinition::Details> loadDetails(uint32_t index) {
+        const SnapshotFile& file = *lazy->file;
+        const SnapshotDetails* rec = file.details(index);
+        if (!rec) return nullptr;
+        auto it = lazy->details.find(index);
+        if (it != lazy->details.end()) return it->second;
+        
+        auto details = std::allocate_shared<CommandDefinition::Details>(
+            allocator<CommandDefinition::Details>(), resource());
+        if (const SnapshotParameter* params = file.parameters(rec->parameterFirst, rec->parameterCount)) {
+            details->parameters.reserve(rec->parameterCount);
+            for (uint32_t k = 0; k < rec->parameterCount; ++k) {
+                const SnapshotParameter& p = params[k];
+                ParameterDefinition& param = details->parameters.emplace_back();
+                param.name = interned(file, p.name);
+                param.description = stored(file, p.description);
+                param.defaultValue = interned(file, p.defaultValue);
+                param.required = p.required != 0;
+                param.type = p.type < static_cast<uint8_t>(ParamType::UserFirst)
+                    ? static_cast<ParamType>(p.type) : ParamTypes::fromName(std::string(file.view(p.typeName)));
+            }
+        }
+        if (const SnapshotOption* opts = file.options(rec->optionFirst, rec->optionCount)) {
+            details->options.reserve(rec->optionCount);
+            for (uint32_t k = 0; k < rec->optionCount; ++k) {
+                const SnapshotOption& o = opts[k];
+                OptionDefinition& opt = details->options.emplace_back();
+                opt.name = interned(file, o.name);
+                opt.shortName = interned(file, o.shortName);
+                opt.description = stored(file, o.description);
+                opt.defaultValue = interned(file, o.defaultValue);
+                opt.valueType = interned(file, o.valueType);
+                opt.requiresValue = o.requiresValue != 0;
+            }
+        }
+        if (const uint32_t* refs = file.refs(rec->exampleFirst, rec->exampleCount)) {
+            details->examples.reserve(rec->exampleCount);
+            for (uint32_t k = 0; k < rec->exampleCount; ++k) {
+                details->examples.push_back(stored(file, refs[k]));
+            }
+        }
+        details->usage = stored(file, rec->usage);
+        details->helpText = stored(file, rec->helpText);
+        details->version = interned(file, rec->version);
+        details->author = interned(file, rec->author);
+        lazy->details.emplace(index, details);
+        return details;
+    }
+    
+    void swap(CommandTable& other) noexcept {
+        chunks.swap(other.chunks);
+        std::swap(count, other.count);
+        std::swap(base, other.base);
+        std::swap(lazy, other.lazy);
+    }
+    
+    void clear() noexcept {
+        for (size_t i = count; i > 0; --i) chunks[(i - 1) / CHUNK][(i - 1) % CHUNK].~CommandDefinition();
+        for (CommandDefinition* chunk : chunks) allocator<CommandDefinition>().deallocate(chunk, CHUNK);
+        chunks.clear();
+        count = 0;
+        if (lazy) {
+            for (size_t b = 0; b < blockCount(); ++b) {
+                Block* block = lazy->blocks[b].load(std::memory_order_relaxed);
+                if (!block) continue;
+                uint64_t ready = block->ready.load(std::memory_order_relaxed);
+                for (size_t k = 0; k < CHUNK; ++k) {
+                    if (ready >> k & 1) block->defs()[k].~CommandDefinition();
+                }
+                block->~Block();
+                allocator<Block>().deallocate(block, 1);
+            }
+            allocator<std::atomic<Block*>>().deallocate(lazy->blocks, blockCount());
+            lazy->~Lazy();
+            allocator<Lazy>().deallocate(lazy, 1);
+            lazy = nullptr;
+        }
+        base = 0;
+    }
+};
+
+/**
+ * @brief 由名称索引的引用取得命令名或别名
+ */
+struct CommandKeyOf {
+    const CommandTable& commands;
+    
+    std::string_view operator()(uint32_t ref) const {
+        return commands.key(NameIndex::refId(ref), NameIndex::refWhich(ref));
+    }
+};
+
+/**
+ * @class TeeBuffer
+ * @brief 把写入直接转发到目标流，同时在上限内保留一份副本
+ * @details 用于请求合并：执行者的输出不经缓冲直接写出，副本留给等待相同结果的请求。
+ *          副本超过上限时丢弃并调用 onOverflow，之后只转发不再复制。
+ */
+class TeeBuffer : public std::streambuf {
+public:
+    TeeBuffer(std::streambuf* target, size_t limit, std::function<void()> onOverflow)
+        : target(target), limit(limit), onOverflow(std::move(onOverflow)) {}
+    
+    const std::string& captured() const { return copy; }
+    bool overflowed() const { return dropped; }
+    
+protected:
+    int_type overflow(int_type ch) override {
+        if (traits_type::eq_int_type(ch, traits_type::eof())) return traits_type::not_eof(ch);
+        char c = traits_type::to_char_type(ch);
+        return xsputn(&c, 1) == 1 ? ch : traits_type::eof();
+    }
+    
+    std::streamsize xsputn(const char* data, std::streamsize size) override {
+        std::streamsize written = target ? target->sputn(data, size) : size;
+        if (!dropped) {
+            if (copy.size() + static_cast<size_t>(size) > limit) {
+                dropped = true;
+                std::string().swap(copy);
+                if (onOverflow) onOverflow();
+            } else {
+                copy.append(data, static_cast<size_t>(size));
+            }
+        }
+        return written;
+    }
+    
+    int sync() override {
+        return target ? target->pubsync() : 0;
+    }
+    
+private:
+    std::streambuf* target;
+    size_t limit;
+    std::function<void()> onOverflow;
+    std::string copy;
+    bool dropped = false;
+};
+
+} // namespace detail
+
+// ============================================================================
+// 命令管理器类（核心类）
+// ============================================================================
+
+/**
+ * @class CommandManager
+ * @brief 命令管理器类
+ * 
+ * 管理所有注册的命令，提供命令注册、查找、执行等功能。
+ * 支持交互式命令行模式、参数解析、帮助系统等。
+ */
+class CommandManager {
+public:
+    /**
+     * @brief 管理器配置
+     * @details 交互设置用作新会话的初始值；服务器相关的字段由CommandServer在启动时读取
+     */
+    struct Config {
+        std::string prompt = DEFAULT_PROMPT;  ///< 命令行提示符
+        bool autoHelp = true;                 ///< 是否自动显示帮助
+        bool verboseErrors = true;            ///< 是否详细显示错误
+        bool colorOutput = true;              ///< 是否使用彩色输出
+        int maxSuggestions = DEFAULT_MAX_SUGGESTIONS;  ///< 最大建议命令数
+        
+        // 服务器准入控制
+        size_t maxClients = 1024;             ///< 同时连接的客户端数上限，超出时新连接被立即关闭，0表示不限制
+        size_t dispatchThreads = 0;           ///< 执行命令的工作线程数，0表示在I/O线程中直接执行
+        size_t maxQueueDepth = 1024;          ///< 等待工作线程的请求数上限，超出时返回busy
+        size_t maxPendingPerClient = 64;      ///< 每个客户端排队和执行中的请求数上限
+        double clientRateLimit = 0.0;         ///< 每个客户端每秒允许的请求数，0表示不限制
+        double clientRateBurst = 0.0;         ///< 速率令牌桶容量，0表示与clientRateLimit相同
+        uint32_t maxQueueTimeMs = 0;          ///< 请求排队超过此时间不再执行而是返回busy，0表示不限制
+        
+        // 统计
+        bool collectStats = true;             ///< 是否记录每个命令的延迟和执行结果
+        bool collectPerfCounters = false;     ///< 是否在执行前后读取硬件性能计数器（需要 collectStats）
+        uint32_t slowCommandThresholdUs = 0;  ///< 耗时达到此值（微秒）的命令写入慢命令日志，0表示不记录
+        std::string slowLogPath;              ///< 慢命令日志文件（JSON Lines），为空时只保留在内存中
+    };
+    
+    /**
+     * @brief 注册表内存占用（由容器容量估算，不含执行器捕获的状态和分配器的额外开销）
+     */
+    struct RegistryMemory {
+        size_t commands = 0;            ///< 命令数
+        size_t aliases = 0;             ///< 已索引的别名数
+        size_t definitionBytes = 0;     ///< 命令定义数组
+        size_t aliasBytes = 0;          ///< 各命令的别名列表
+        size_t detailsCount = 0;        ///< 不同的 Details 数（参数、选项和附加说明）
+        size_t detailsShared = 0;       ///< 与其他命令共享 Details 的命令数
+        size_t detailsBytes = 0;        ///< Details 及其中的参数、选项、示例列表
+        size_t indexBytes = 0;          ///< 名称索引和 Details 查重表
+        size_t snapshotBytes = 0;       ///< 加载的快照文件映射（按需读入，只有被写的索引页面是私有副本）
+        size_t snapshotPending = 0;     ///< 快照中尚未访问、还没有构造定义的命令数
+        StringPool::Usage pool;         ///< 进程级字符串池（所有管理器共用）
+        
+        /** @brief 本管理器独占的字节数（不含字符串池） */
+        size_t ownBytes() const { return definitionBytes + aliasBytes + detailsBytes + indexBytes; }
+    };
+    
+private:
+    // 命令存储结构
+    detail::CommandTable commands;      ///< 命令定义，下标即命令ID
+    detail::NameIndex nameIndex;        ///< 命令名和别名到命令ID的索引
+    std::pmr::unordered_multimap<size_t, uint32_t> detailsByHash;   ///< Details 内容哈希到持有它的命令ID
+    uint32_t pendingDetails = INVALID_COMMAND_ID;  ///< createCommand 返回后可能仍在修改、尚未参与共享的命令
+    
+    // 全局选项定义
+    std::pmr::vector<OptionDefinition> globalOptions;
+    
+    // 配置
+    Config config;
+    
+    Session defaultSession;  ///< 调用者未提供会话时使用的默认会话
+    
+    /**
+     * @brief 一次正在进行的合并执行
+     */
+    struct Flight {
+        std::mutex mutex;
+        std::condition_variable done;
+        bool finished = false;
+        bool abandoned = false;           ///< 输出超过 COALESCE_CAPTURE_LIMIT，等待者各自执行
+        bool success = false;
+        std::string output;               ///< 执行期间的标准输出
+        std::string errorOutput;          ///< 执行期间的错误输出
+        std::exception_ptr exception;     ///< 执行器抛出的异常
+    };
+    
+    static constexpr size_t COALESCE_CAPTURE_LIMIT = 1 << 20;  ///< 为等待者保留的输出上限（标准输出和错误输出各自计算）
+    
+    /**
+     * @brief 请求合并状态，每个管理器一份（合并键以命令ID开头，副本的注册表可能不同）
+     */
+    struct CoalescingState {
+        std::mutex mutex;
+        std::unordered_map<std::string, std::shared_ptr<Flight>> inFlight;  ///< 合并键到执行的映射
+        std::atomic<uint64_t> coalesced{0};  ///< 被合并（未实际执行）的请求数
+    };
+    std::shared_ptr<CoalescingState> coalescing = std::make_shared<CoalescingState>();
+    
+    std::shared_ptr<CommandStats> stats = std::make_shared<CommandStats>();  ///< 命令统计，按命令ID记录，每个管理器一份
+    std::shared_ptr<SlowLog> slowLog;  ///< 慢命令日志，首次启用时创建，副本之间共享
+    
+public:
+    /**
+     * @brief 构造函数
+     * @details 初始化全局选项和内置命令，注册表使用 std::pmr::get_default_resource()
+     */
+    CommandManager() : CommandManager(std::pmr::get_default_resource()) {}
+    
+    /**
+     * @brief 构造使用指定内存资源的管理器
+     * @param mr 注册表的内存资源：命令定义、别名列表、参数和选项列表、名称索引、Details 查重表
+     *           和全局选项都从这里分配。资源必须比管理器（及其移动目标）活得更久。
+     * @details 注册表只在注册命令时修改，命令处理路径只读取它，
+     *          因此只在单个线程注册命令时可以使用非线程安全的资源。
+     *          processString 等方法创建的临时上下文使用默认资源；
+     *          需要按线程或按请求控制分配时，用 CommandContext(input, mr) 构造上下文并调用 processCommand
+     */
+    explicit CommandManager(std::pmr::memory_resource* mr)
+        : commands(mr), nameIndex(mr), detailsByHash(mr), globalOptions(mr), defaultSession(nextSessionId()) {
+        setupGlobalOptions();
+        setupBuiltinCommands();
+    }
+    
+    /**
+     * @brief 复制到指定的内存资源上
+     * @param other 源管理器
+     * @param mr 副本注册表的内存资源
+     * @details 复制注册表和配置，共享的 Details 在副本中仍然共享；
+     *          慢命令日志与源对象共享；统计和请求合并状态按命令ID记录，副本从空状态开始
+     */
+    CommandManager(const CommandManager& other, std::pmr::memory_resource* mr)
+        : commands(other.commands, mr), nameIndex(other.nameIndex, mr), detailsByHash(other.detailsByHash, mr),
+          pendingDetails(other.pendingDetails), globalOptions(other.globalOptions, mr), config(other.config),
+          defaultSession(other.defaultSession), slowLog(other.slowLog) {
+        localizeDetails();
+    }
+    
+    /**
+     * @brief 复制构造
+     * @details 与标准 pmr 容器一致，副本使用 std::pmr::get_default_resource()
+     */
+    CommandManager(const CommandManager& other) : CommandManager(other, std::pmr::get_default_resource()) {}
+    
+    /**
+     * @brief 移动构造
+     * @details 内置命令通过 CommandContext::getManager() 访问管理器，不保存管理器地址，
+     *          因此移动只转移注册表的所有权（连同内存资源），不需要重新注册命令。
+     *          移动后的源对象只能被析构或重新赋值
+     */
+    CommandManager(CommandManager&&) noexcept = default;
+    
+    /**
+     * @brief 复制赋值，保留本管理器的内存资源
+     */
+    CommandManager& operator=(const CommandManager& other) {
+        if (this != &other) {
+            *this = CommandManager(other, getResource());
+        }
+        return *this;
+    }
+    
+    /**
+     * @brief 移动赋值
+     * @details 两个管理器使用同一资源时只转移所有权，否则按复制赋值处理
+     */
+    CommandManager& operator=(CommandManager&& other) {
+        if (this == &other) {
+            return *this;
+        }
+        if (getResource() != other.getResource()) {
+            return *this = static_cast<const CommandManager&>(other);
+        }
+        commands = std::move(other.commands);
+        nameIndex = std::move(other.nameIndex);
+        detailsByHash = std::move(other.detailsByHash);
+        pendingDetails = other.pendingDetails;
+        globalOptions = std::move(other.globalOptions);
+        config = std::move(other.config);
+        defaultSession = std::move(other.defaultSession);
+        coalescing = std::move(other.coalescing);
+        stats = std::move(other.stats);
+        slowLog = std::move(other.slowLog);
+        return *this;
+    }
+    
+    /**
+     * @brief 获取注册表使用的内存资源
+     */
+    std::pmr::memory_resource* getResource() const { return commands.resource(); }
+    
+    // ========================================================================
+    // 配置方法
+    // ========================================================================
+    
+    /**
+     * @brief 设置命令行提示符
+     * @param prompt 提示符字符串
+     */
+    void setPrompt(const std::string& prompt) {
+        config.prompt = prompt;
+        defaultSession.setPrompt(prompt);
+    }
+    
+    /**
+     * @brief 设置是否自动显示帮助
+     * @param enable 启用或禁用自动帮助
+     */
+    void setAutoHelp(bool enable) {
+        config.autoHelp = enable;
+        defaultSession.setAutoHelp(enable);
+    }
+    
+    /**
+     * @brief 设置是否详细显示错误
+     * @param enable 启用或禁用详细错误
+     */
+    void setVerboseErrors(bool enable) {
+        config.verboseErrors = enable;
+        defaultSession.setVerboseErrors(enable);
+    }
+    
+    /**
+     * @brief 设置是否使用彩色输出
+     * @param enable 启用或禁用彩色输出
+     */
+    void setColorOutput(bool enable) { config.colorOutput = enable; }
+    
+    /**
+     * @brief 设置最大建议命令数
+     * @param max 最大建议数
+     */
+    void setMaxSuggestions(int max) { config.maxSuggestions = max; }
+    
+    /**
+     * @brief 替换全部配置
+     * @param cfg 新配置
+     * @note 默认会话的设置同步更新，已创建的会话不受影响
+     */
+    void setConfig(const Config& cfg) {
+        config = cfg;
+        defaultSession.setPrompt(cfg.prompt);
+        defaultSession.setAutoHelp(cfg.autoHelp);
+        defaultSession.setVerboseErrors(cfg.verboseErrors);
+        if (cfg.slowCommandThresholdUs > 0 && !slowLog) {
+            slowLog = std::make_shared<SlowLog>();
+        }
+        if (slowLog) {
+            slowLog->setPath(cfg.slowLogPath);
+        }
+    }
+    
+    /**
+     * @brief 获取当前配置
+     * @return 配置的常量引用
+     */
+    const Config& getConfig() const { return config; }
+    
+    // ========================================================================
+    // 会话方法
+    // ========================================================================
+    
+    /**
+     * @brief 创建新会话
+     * @return 以当前配置（提示符、错误详细程度、自动帮助）初始化的会话
+     * @details 会话共享本管理器的命令注册表，不会复制或重新注册任何命令。
+     *          服务器模式下应为每个客户端创建一个会话
+     */
+    Session createSession() const {
+        Session session(nextSessionId());
+        session.setPrompt(config.prompt);
+        session.setVerboseErrors(config.verboseErrors);
+        session.setAutoHelp(config.autoHelp);
+        return session;
+    }
+    
+    /**
+     * @brief 获取默认会话
+     * @return 未指定会话的命令以其副本为初始状态的会话；命令对副本的修改不会写回
+     */
+    Session& getDefaultSession() { return defaultSession; }
+    
+    // ========================================================================
+    // 命令注册方法
+    // ========================================================================
+    
+    /**
+     * @brief 注册完整命令定义
+     * @param cmd 命令定义对象
+     * @return 注册成功返回true，失败返回false
+     * @note 如果命令已存在，会发出警告并覆盖；覆盖内置命令（help、set、unset 等）后该名称不再是内置命令
+     */
+    bool registerCommand(const CommandDefinition& cmd) {
+        if (cmd.getName().empty()) {
+            std::cerr << "错误: 命令名称不能为空" << std::endl;
+            return false;
+        }
+        
+        uint32_t id;
+        if (!placeCommand(cmd, true, id)) {
+            return false;
+        }
+        shareDetails(id);
+        return true;
+    }
+    
+    /**
+     * @brief 创建并注册命令（便捷方法，不带执行器）
+     * @param name 命令名称
+     * @param description 命令描述
+     * @return 已注册命令定义的引用，可后续设置执行器
+     * @warning 返回的引用在命令重新注册后可能失效
+     */
+    CommandDefinition& createCommand(const std::string& name, 
+                                    const std::string& description) {
+        uint32_t id;
+        if (!placeCommand(CommandDefinition(name, description, getResource()), false, id)) {
+            // 未注册的定义，调用者的后续设置不会生效
+            static thread_local CommandDefinition detached;
+            detached = CommandDefinition(name, description);
+            return detached;
+        }
+        
+        // 调用者通常会继续链式添加参数和选项，等下一次注册时再参与 Details 共享
+        pendingDetails = id;
+        return commands[id];
+    }
+    
+    /**
+     * @brief 创建并注册命令（便捷方法，带执行器）
+     * @tparam Func 执行函数类型
+     * @param name 命令名称
      * @param description 命令描述
      * @param executor 命令执行函数
      * @return 已注册命令定义的引用
      * @warning 返回的引用在命令重新注册后可能失效
      */
-    template<typename Func>
-    CommandDefinition& createCommand(const std::string& name, 
-                                    const std::string& description,
-                                    Func executor) {
-        CommandDefinition& cmd = createCommand(name, description);
-        cmd.setExecutor(executor);
+    template<typename Func>
+    CommandDefinition& createCommand(const std::string& name, 
+                                    const std::string& description,
+                                    Func executor) {
+        CommandDefinition& cmd = createCommand(name, description);
+        cmd.setExecutor(executor);
+        
+        return cmd;
+    }
+    
+    // ========================================================================
+    // 命令处理核心方法
+    // ========================================================================
+    
+    /**
+     * @brief 处理单个命令（统一入口）
+     * @param context 命令上下文
+     * @param parseNanos 调用者解析该上下文的耗时，只用于慢命令日志，未测量时为0
+     * @return 执行成功返回true，失败返回false
+     * 
+     * 上下文未设置会话时，命令只能通过 getSessionView() 读取默认会话，getSession() 为空，
+     * set、unset 等修改会话的命令报告错误；返回前恢复上下文原来的只读会话和管理器。
+     * 
+     * 处理流程：
+     * 1. 检查命令是否存在
+     * 2. 处理帮助请求（-h或--help）
+     * 3. 验证参数
+     * 4. 执行命令
+     * 5. 处理执行结果
+     */
+    bool processCommand(CommandContext& context, uint64_t parseNanos = 0) {
+        std::string_view cmdName = context.getCommandName();
+        
+        // 空命令
+        if (cmdName.empty()) {
+            return true;
+        }
+        
+        // 未指定会话时只读使用默认会话；返回时恢复调用者的上下文
+        struct ContextScope {
+            CommandContext& context;
+            const Session* sessionView;
+            CommandManager* manager;
+            ~ContextScope() {
+                if (!context.getSession()) context.setSessionView(sessionView);
+                context.setManager(manager);
+            }
+        } scope{context, context.getSessionView(), context.getManager()};
+        if (!context.getSession()) {
+            context.setSessionView(&defaultSession);
+        }
+        context.setManager(this);
+        const bool autoHelp = context.getSessionView()->getAutoHelp();
+        
+        const bool collectStats = config.collectStats;
+        const uint64_t slowThresholdNanos = uint64_t(config.slowCommandThresholdUs) * 1000;
+        CCM_TRACE_SPAN("processCommand");
+        
+        // 查找命令
+        DispatchResult result;
+        result.measurePerf = collectStats && config.collectPerfCounters;
+        result.measurePhases = slowThresholdNanos > 0;
+        auto start = std::chrono::steady_clock::now();
+        const CommandDefinition* cmdDef;
+        {
+            CCM_TRACE_SPAN("findCommand");
+            PhaseTimer timer(result.measurePhases ? &result.lookupNanos : nullptr);
+            cmdDef = findCommand(cmdName);
+        }
+        if (!cmdDef) {
+            // 命令未找到，显示错误和帮助
+            if (collectStats) {
+                stats->recordUnknown();
+            }
+            handleUnknownCommand(cmdName, context.out(), context.err());
+            return false;
+        }
+        
+        if (!collectStats && slowThresholdNanos == 0) {
+            return dispatchCommand(*cmdDef, context, autoHelp, result);
+        }
+        
+        result.outcome = CommandStats::Outcome::Exception;
+        try {
+            bool success = dispatchCommand(*cmdDef, context, autoHelp, result);
+            uint64_t nanos = elapsedNanos(start);
+            if (collectStats) {
+                if (result.perf.events != 0) {
+                    stats->recordPerf(cmdDef->getId(), result.perf);
+                }
+                stats->record(cmdDef->getId(), result.outcome, nanos);
+            }
+            if (slowThresholdNanos > 0 && nanos + parseNanos >= slowThresholdNanos) {
+                recordSlowCommand(*cmdDef, context, result, parseNanos, nanos);
+            }
+            return success;
+        } catch (...) {
+            // 非 std::exception 的异常继续向上传播，但仍计入统计
+            uint64_t nanos = elapsedNanos(start);
+            if (collectStats) {
+                stats->record(cmdDef->getId(), result.outcome, nanos);
+            }
+            if (slowThresholdNanos > 0 && nanos + parseNanos >= slowThresholdNanos) {
+                recordSlowCommand(*cmdDef, context, result, parseNanos, nanos);
+            }
+            throw;
+        }
+    }
+    
+    /**
+     * @brief 处理字符串命令
+     * @param input 命令行字符串
+     * @return 执行成功返回true，失败返回false
+     */
+    bool processString(const std::string& input) {
+        if (config.slowCommandThresholdUs == 0) {
+            CommandContext context(input);
+            return processCommand(context);
+        }
+        auto start = std::chrono::steady_clock::now();
+        CommandContext context(input);
+        return processCommand(context, elapsedNanos(start));
+    }
+    
+    /**
+     * @brief 在指定会话中处理字符串命令
+     * @param input 命令行字符串
+     * @param session 执行命令的会话
+     * @return 执行成功返回true，失败返回false
+     */
+    bool processString(const std::string& input, Session& session) {
+        auto start = std::chrono::steady_clock::now();
+        CommandContext context(input);
+        uint64_t parseNanos = config.slowCommandThresholdUs ? elapsedNanos(start) : 0;
+        context.setSession(&session);
+        return processCommand(context, parseNanos);
+    }
+    
+    /**
+     * @brief 在同一会话中依次处理一批字符串命令
+     * @param inputs 命令行字符串列表
+     * @param session 执行命令的会话
+     * @param os 命令的标准输出流，为空时使用std::cout
+     * @param es 命令的错误输出流，为空时使用std::cerr
+     * @param results 不为空时写入每条命令的执行结果，与inputs一一对应
+     * @return 执行成功的命令数
+     * @details 所有命令复用一个上下文，会话和输出流只设置一次。
+     *          某条命令失败不会中断后续命令，与逐条调用processString的结果相同
+     */
+    size_t processBatch(const std::vector<std::string>& inputs, Session& session,
+                        std::ostream* os = nullptr, std::ostream* es = nullptr,
+                        std::vector<bool>* results = nullptr) {
+        if (results) {
+            results->assign(inputs.size(), false);
+        }
+        const bool measureParse = config.slowCommandThresholdUs > 0;
+        CommandContext context;
+        context.setSession(&session);
+        context.setOutput(os);
+        context.setErrorOutput(es);
+        
+        size_t succeeded = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            context.parse(inputs[i]);
+            bool ok = processCommand(context, measureParse ? elapsedNanos(start) : 0);
+            if (ok) {
+                ++succeeded;
+            }
+            if (results) {
+                (*results)[i] = ok;
+            }
+        }
+        return succeeded;
+    }
+    
+    /**
+     * @brief 在默认会话中依次处理一批字符串命令
+     * @param inputs 命令行字符串列表
+     * @param results 不为空时写入每条命令的执行结果
+     * @return 执行成功的命令数
+     * @details 与不带会话的 processString 相同，默认会话只读，修改会话的命令失败
+     */
+    size_t processBatch(const std::vector<std::string>& inputs, std::vector<bool>* results = nullptr) {
+        if (results) {
+            results->assign(inputs.size(), false);
+        }
+        CommandContext context;
+        size_t succeeded = 0;
+        for (size_t i = 0; i < inputs.size(); ++i) {
+            auto start = std::chrono::steady_clock::now();
+            context.parse(inputs[i]);
+            bool ok = processCommand(context, config.slowCommandThresholdUs ? elapsedNanos(start) : 0);
+            if (ok) {
+                ++succeeded;
+            }
+            if (results) {
+                (*results)[i] = ok;
+            }
+        }
+        return succeeded;
+    }
+    
+    /**
+     * @brief 处理main函数参数
+     * @param argc 参数个数
+     * @param argv 参数数组
+     * @return 执行成功返回true，失败返回false
+     */
+    bool processArgs(int argc, char* argv[]) {
+        if (argc < 1) return true;
+        
+        auto start = std::chrono::steady_clock::now();
+        CommandContext context(argc, argv);
+        return processCommand(context, config.slowCommandThresholdUs ? elapsedNanos(start) : 0);
+    }
+    
+    /**
+     * @brief 循环处理argv中的每个命令
+     * @param argc 参数个数
+     * @param argv 参数数组
+     * @return 所有命令都执行成功返回true，否则返回false
+     * 
+     * 处理模式：
+     * for(遍历argv) {
+     *     if(当前参数不是选项) {
+     *         创建命令上下文
+     *         收集该命令的参数
+     *         处理命令
+     *     }
+     * }
+     */
+    bool processArgLoop(int argc, char* argv[]) {
+        bool allSuccess = true;
+        
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            
+            // 跳过全局选项
+            if (arg[0] == '-') {
+                continue;
+            }
+            
+            // 创建命令上下文
+            CommandContext context;
+            context.setCommandName(arg);
+            
+            // 收集该命令的参数
+            std::vector<std::string> cmdArgs;
+            while (i + 1 < argc && argv[i + 1][0] != '-') {
+                cmdArgs.push_back(argv[++i]);
+            }
+            
+            // 添加参数到上下文
+            for (const auto& arg : cmdArgs) {
+                context.addArgument(arg);
+            }
+            
+            // 处理命令
+            if (!processCommand(context)) {
+                allSuccess = false;
+            }
+        }
+        
+        return allSuccess;
+    }
+    
+    // ========================================================================
+    // 帮助系统方法
+    // ========================================================================
+    
+    /**
+     * @brief 显示所有命令的简要帮助
+     * @param byCategory 是否按分类显示，默认true
+     * @param os 输出流，默认为std::cout
+     * 
+     * 显示格式：
+     * 可用命令:
+     * ============================================================
+     * 
+     * 分类1:
+     *   命令1     命令1的描述
+     *   命令2     命令2的描述
+     * 
+     * 分类2:
+     *   命令3     命令3的描述
+     */
+    void showAllCommands(bool byCategory = true, std::ostream& os = std::cout) const {
+        os << "\n可用命令:\n";
+        os << std::string(60, '=') << "\n";
+        
+        if (byCategory) {
+            // 按分类显示，分类内按注册顺序
+            std::map<std::string_view, std::vector<uint32_t>> byName;
+            for (uint32_t id = 0; id < commands.size(); ++id) {
+                byName[commands[id].getCategory().view()].push_back(id);
+            }
+            for (const auto& category : byName) {
+                os << "\n" << category.first << ":\n";
+                for (uint32_t id : category.second) {
+                    os << "  " << std::left << std::setw(20) << commands[id].getName().str()
+                             << " " << commands[id].getDescription() << "\n";
+                }
+            }
+        } else {
+            // 所有命令按字母排序
+            for (uint32_t id : sortedIds()) {
+                os << "  " << std::left << std::setw(20) << commands[id].getName().str()
+                         << " " << commands[id].getDescription() << "\n";
+            }
+        }
+        
+        os << "\n使用 'help <命令名>' 查看详细帮助\n";
+        os << std::endl;
+    }
+    
+    /**
+     * @brief 显示特定命令的详细帮助
+     * @param commandName 命令名称
+     * @param os 输出流，默认为std::cout
+     * 
+     * 显示格式：
+     * 命令: 命令名 (别名: 别名1, 别名2)
+     * 描述: 命令描述
+     * 分类: 命令分类
+     * 版本: 1.0.0
+     * 作者: 作者名
+     * 
+     * 用法: 命令名 <参数1> [参数2] [选项...]
+     * 
+     * 参数:
+     *   <参数1>      参数1的描述 [默认: 默认值] (类型)
+     * 
+     * 选项:
+     *   -h, --help   显示帮助信息
+     * 
+     * 示例:
+     *   示例1
+     *   示例2
+     */
+    void showCommandHelp(const std::string& commandName, std::ostream& os = std::cout) const {
+        CCM_TRACE_SPAN("help");
+        CCM_ALLOC_PHASE(AllocPhase::Help);
+        auto cmdDef = findCommand(commandName);
+        if (cmdDef) {
+            os << cmdDef->generateHelp(true) << std::endl;
+        } else {
+            os << "未找到命令: " << commandName << std::endl;
+            showAllCommands(true, os);
+        }
+    }
+    
+    /**
+     * @brief 显示全局帮助
+     * @param os 输出流，默认为std::cout
+     * 
+     * 显示格式：
+     * 命令行工具 - 全局帮助
+     * ============================================================
+     * 全局选项:
+     *   -h, --help                显示帮助信息
+     * 
+     * 特殊命令:
+     *   help [命令]               显示帮助信息
+     *   list                      列出所有命令
+     *   exit                      退出交互模式
+     * 
+     * 使用示例:
+     *   1. 获取命令帮助: help <命令名>
+     *   2. 使用命令: <命令名> [参数...] [选项...]
+     *   3. 获取帮助: -h 或 --help
+     */
+    void showGlobalHelp(std::ostream& os = std::cout) const {
+        CCM_TRACE_SPAN("help");
+        CCM_ALLOC_PHASE(AllocPhase::Help);
+        os << "\n命令行工具 - 全局帮助\n";
+        os << std::string(60, '=') << "\n";
+        
+        os << "全局选项:\n";
+        for (const auto& opt : globalOptions) {
+            os << "  " << std::left << std::setw(40) << opt.getUsage()
+                     << " " << opt.description << "\n";
+        }
+        
+        os << "\n特殊命令:\n";
+        os << "  help [命令]      显示帮助信息\n";
+        os << "  list             列出所有命令\n";
+        os << "  exit             退出交互模式\n";
+        
+        os << "\n使用示例:\n";
+        os << "  1. 获取命令帮助: help <命令名>\n";
+        os << "  2. 使用命令: <命令名> [参数...] [选项...]\n";
+        os << "  3. 获取帮助: -h 或 --help\n";
+        os << std::endl;
+    }
+    
+    // ========================================================================
+    // 交互模式方法
+    // ========================================================================
+    
+    /**
+     * @brief 运行交互式命令行模式
+     * 
+     * 启动一个交互式命令行界面，用户可以输入命令并查看结果。
+     * 支持特殊命令：
+     *   help - 显示帮助
+     *   list - 列出所有命令
+     *   exit/quit - 退出
+     */
+    void runInteractive() {
+        std::string input;
+        Session session = createSession();
+        
+        std::cout << "ConsoleCommandManager 交互模式\n";
+        std::cout << "输入 'help' 查看帮助，'list' 列出命令，'exit' 退出\n\n";
+        
+        while (true) {
+            std::cout << session.getPrompt();
+            
+            if (!std::getline(std::cin, input)) {
+                break; // EOF
+            }
+            
+            // 跳过空白输入
+            if (input.empty()) continue;
+            
+            // 检查特殊命令
+            if (input == "exit" || input == "quit") {
+                std::cout << "再见！" << std::endl;
+                break;
+            } else if (input == "help") {
+                showGlobalHelp();
+                continue;
+            } else if (input == "list") {
+                showAllCommands();
+                continue;
+            }
+            
+            // 处理命令
+            if (!processString(input, session)) {
+                if (session.getVerboseErrors()) {
+                    std::cout << "命令执行失败，输入 'help' 查看帮助" << std::endl;
+                }
+            }
+        }
+    }
+    
+    // ========================================================================
+    // 查询方法
+    // ========================================================================
+    
+    /**
+     * @brief 检查命令是否存在
+     * @param name 命令名称或别名
+     * @return 命令存在返回true，否则返回false
+     */
+    bool commandExists(const std::string& name) const {
+        return findCommand(name) != nullptr;
+    }
+    
+    /**
+     * @brief 获取命令定义
+     * @param name 命令名称或别名
+     * @return 命令定义的指针，如果找不到返回nullptr
+     */
+    const CommandDefinition* getCommand(const std::string& name) const {
+        return findCommand(name);
+    }
+    
+    /**
+     * @brief 按参数类型补全参数值
+     * @param name 命令名称或别名
+     * @param index 参数位置，超出定义的位置按可变参数处理
+     * @param prefix 已输入的部分
+     * @return 候选值列表；命令不存在或参数类型不提供补全时为空
+     * @details TYPE_COMMAND 参数补全为已注册的命令名和别名，其他类型使用类型表中的补全函数
+     */
+    std::vector<std::string> completeArgument(const std::string& name, size_t index,
+                                              const std::string& prefix) const {
+        const CommandDefinition* cmd = findCommand(name);
+        if (!cmd || cmd->getParameters().empty()) {
+            return {};
+        }
+        const auto& params = cmd->getParameters();
+        if (index >= params.size() && params.back().name != "...") {
+            return {};
+        }
+        ParamType type = params[std::min(index, params.size() - 1)].type;
+        if (type != TYPE_COMMAND) {
+            return ParamTypes::complete(type, prefix);
+        }
+        
+        std::vector<std::string> out;
+        auto consider = [&out, &prefix, this](std::string_view key) {
+            if (key.compare(0, prefix.size(), prefix) == 0 && findCommand(key)) out.emplace_back(key);
+        };
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            // 只读名称，不构造快照中尚未访问的定义
+            for (size_t which = 0; which <= detail::NameIndex::MAX_ALIASES; ++which) {
+                std::string_view key = commands.key(id, which);
+                if (key.empty()) {
+                    if (which == 0) continue;
+                    break;
+                }
+                consider(key);
+            }
+        }
+        std::sort(out.begin(), out.end());
+        out.erase(std::unique(out.begin(), out.end()), out.end());
+        return out;
+    }
+    
+    // ==================== 注册表快照 ====================
+    
+    /**
+     * @brief 把注册表的元数据保存为快照文件
+     * @param path 文件路径，先写临时文件再原子替换
+     * @param errorMsg 失败时的错误信息
+     * @return 成功返回true
+     * @details 保存命令名、别名、分类、参数和选项定义、帮助文本和名称索引；执行器是代码，不保存，
+     *          加载后用 bindExecutor() 按名称绑定。内容相同的 Details 和字符串只写一份
+     */
+    bool saveSnapshot(const std::string& path, std::string& errorMsg) const {
+        detail::SnapshotWriter w;
+        std::unordered_map<const CommandDefinition::Details*, uint32_t> byPointer;
+        std::unordered_multimap<size_t, std::pair<const CommandDefinition::Details*, uint32_t>> byContent;
+        
+        auto addDetails = [&w, &byPointer, &byContent](const CommandDefinition::Details& d) {
+            auto known = byPointer.find(&d);
+            if (known != byPointer.end()) return known->second;
+            size_t hash = d.hash();
+            auto range = byContent.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it) {
+                if (*it->second.first == d) {
+                    byPointer.emplace(&d, it->second.second);
+                    return it->second.second;
+                }
+            }
+            
+            detail::SnapshotDetails rec{};
+            rec.parameterFirst = static_cast<uint32_t>(w.parameters.size());
+            rec.parameterCount = static_cast<uint32_t>(d.parameters.size());
+            for (const auto& p : d.parameters) {
+                detail::SnapshotParameter r{};
+                r.name = w.addString(p.name.view());
+                r.description = w.addString(p.description.view());
+                r.defaultValue = w.addString(p.defaultValue.view());
+                r.typeName = w.addString(ParamTypes::name(p.type));
+                r.required = p.required ? 1 : 0;
+                r.type = static_cast<uint8_t>(p.type);
+                w.parameters.push_back(r);
+            }
+            rec.optionFirst = static_cast<uint32_t>(w.options.size());
+            rec.optionCount = static_cast<uint32_t>(d.options.size());
+            for (const auto& o : d.options) {
+                detail::SnapshotOption r{};
+                r.name = w.addString(o.name.view());
+                r.shortName = w.addString(o.shortName.view());
+                r.description = w.addString(o.description.view());
+                r.defaultValue = w.addString(o.defaultValue.view());
+                r.valueType = w.addString(o.valueType.view());
+                r.requiresValue = o.requiresValue ? 1 : 0;
+                w.options.push_back(r);
+            }
+            rec.exampleFirst = static_cast<uint32_t>(w.refs.size());
+            rec.exampleCount = static_cast<uint32_t>(d.examples.size());
+            for (const auto& e : d.examples) w.refs.push_back(w.addString(e.view()));
+            rec.usage = w.addString(d.usage.view());
+            rec.helpText = w.addString(d.helpText.view());
+            rec.version = w.addString(d.version.view());
+            rec.author = w.addString(d.author.view());
+            
+            uint32_t index = static_cast<uint32_t>(w.details.size());
+            w.details.push_back(rec);
+            byPointer.emplace(&d, index);
+            byContent.emplace(hash, std::make_pair(&d, index));
+            return index;
+        };
+        
+        w.commands.reserve(commands.size());
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            const CommandDefinition& cmd = commands[id];
+            detail::SnapshotCommand rec{};
+            rec.name = w.addString(cmd.getName().view());
+            rec.description = w.addString(cmd.getInlineDescription().view());
+            rec.messageId = w.addString(cmd.getMessageId().view());
+            rec.category = w.addString(cmd.getCategory().view());
+            rec.aliasFirst = static_cast<uint32_t>(w.refs.size());
+            rec.aliasCount = static_cast<uint32_t>(cmd.getAliases().size());
+            for (const auto& alias : cmd.getAliases()) w.refs.push_back(w.addString(alias.view()));
+            rec.details = cmd.getDetails() ? addDetails(*cmd.getDetails()) : detail::SNAPSHOT_NONE;
+            rec.flags = (cmd.isCoalescable() ? detail::SNAPSHOT_COALESCABLE : 0) |
+                        (cmd.isBuiltin() ? detail::SNAPSHOT_BUILTIN : 0);
+            w.commands.push_back(rec);
+        }
+        
+        // 去掉墓碑后写入，加载时直接使用
+        detail::NameIndex index(nameIndex);
+        index.compact();
+        w.index.resize(index.slotCount());
+        if (index.slotCount() > 0) {
+            std::memcpy(w.index.data(), index.data(), index.slotCount() * sizeof(detail::SnapshotSlot));
+        }
+        w.indexUsed = static_cast<uint32_t>(index.usedCount());
+        w.indexLive = static_cast<uint32_t>(index.liveCount());
+        w.indexAliases = static_cast<uint32_t>(index.aliasCount());
+        w.indexHashCheck = detail::NameIndex::hashOf(detail::SNAPSHOT_HASH_PROBE);
+        return w.write(path, errorMsg);
+    }
+    
+    /**
+     * @brief 保存快照，失败时输出错误信息
+     */
+    bool saveSnapshot(const std::string& path) const {
+        std::string errorMsg;
+        if (!saveSnapshot(path, errorMsg)) {
+            std::cerr << "错误: " << errorMsg << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 映射快照文件并用作注册表
+     * @param path saveSnapshot() 写入的文件
+     * @param errorMsg 失败时的错误信息
+     * @return 成功返回true；失败时注册表不变
+     * @details 只检查文件头和各段的边界，耗时与命令数无关：名称索引直接使用映射中的槽位，
+     *          命令定义在第一次被访问时才从映射中构造，其字符串复制到进程级字符串池，
+     *          因此定义的副本在管理器析构或加载另一个快照后仍然有效。
+     *          快照中的命令使用快照中的ID；加载前已注册、快照中也有的命令保留其执行器，
+     *          快照中没有的命令（例如内置命令）在快照的命令之后重新注册。
+     *          快照中的命令没有执行器，用 bindExecutor() 按名称绑定。
+     *          命令ID改变，命令统计随之清空。
+     */
+    bool loadSnapshot(const std::string& path, std::string& errorMsg) {
+        std::shared_ptr<detail::SnapshotFile> file = detail::SnapshotFile::open(path, errorMsg);
+        if (!file) {
+            return false;
+        }
+        const detail::SnapshotHeader& h = file->header();
+        if (h.commandCount > detail::NameIndex::MAX_ID + 1) {
+            errorMsg = path + ": 快照中的命令数超过上限";
+            return false;
+        }
         
-        return cmd;
+        flushPendingDetails();
+        detail::CommandTable previous(std::move(commands));
+        commands = detail::CommandTable(file, getResource());
+        nameIndex = detail::NameIndex(getResource());
+        auto keyOf = keyResolver();
+        if (h.indexHashCheck == detail::NameIndex::hashOf(detail::SNAPSHOT_HASH_PROBE)) {
+            nameIndex.adopt(reinterpret_cast<detail::NameIndex::Slot*>(file->indexSlots()), h.indexCapacity,
+                            h.indexUsed, h.indexLive, h.indexAliases);
+        } else {
+            // 哈希函数不同（不同的标准库实现），按名称重建索引，仍然不构造定义
+            for (uint32_t id = 0; id < commands.size(); ++id) {
+                nameIndex.insert(commands.name(id), detail::NameIndex::makeRef(id, 0), keyOf);
+            }
+            for (uint32_t id = 0; id < commands.size(); ++id) {
+                for (size_t which = 1; which <= detail::NameIndex::MAX_ALIASES; ++which) {
+                    std::string_view alias = commands.key(id, which);
+                    if (alias.empty()) break;
+                    if (alias != commands.name(id)) {
+                        nameIndex.insert(alias, detail::NameIndex::makeRef(id, which), keyOf);
+                    }
+                }
+            }
+        }
+        detailsByHash.clear();
+        pendingDetails = INVALID_COMMAND_ID;
+        
+        for (uint32_t oldId = 0; oldId < previous.size(); ++oldId) {
+            const CommandDefinition& old = previous[oldId];
+            uint32_t ref = nameIndex.find(old.getName().view(), keyOf);
+            if (ref && detail::NameIndex::refWhich(ref) == 0 && detail::NameIndex::refId(ref) < commands.size()) {
+                CommandDefinition& loaded = commands[detail::NameIndex::refId(ref)];
+                if (old.isExecutable()) {
+                    loaded.setExecutor(old.getExecutor());
+                }
+                loaded.builtin = loaded.builtin || old.builtin;
+                continue;
+            }
+            uint32_t id;
+            if (placeCommand(old, false, id)) {
+                shareDetails(id);
+            }
+        }
+        stats->reset();
+        return true;
+    }
+    
+    /**
+     * @brief 加载快照，失败时输出错误信息
+     */
+    bool loadSnapshot(const std::string& path) {
+        std::string errorMsg;
+        if (!loadSnapshot(path, errorMsg)) {
+            std::cerr << "错误: " << errorMsg << std::endl;
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 为已注册的命令设置执行器
+     * @param name 命令名称或别名
+     * @param executor 执行函数
+     * @return 命令不存在时返回false
+     * @details 用于给从快照加载的命令绑定代码；只构造这一个命令的定义。
+     *          与 createCommand() 返回的引用一样，应在开始处理命令之前调用
+     */
+    bool bindExecutor(std::string_view name, std::function<bool(const CommandContext&)> executor) {
+        uint32_t ref = nameIndex.find(name, keyResolver());
+        if (!ref || detail::NameIndex::refId(ref) >= commands.size()) {
+            return false;
+        }
+        commands[detail::NameIndex::refId(ref)].setExecutor(std::move(executor));
+        return true;
+    }
+    
+    /**
+     * @brief 获取已注册的命令数
+     */
+    size_t getCommandCount() const {
+        return commands.size();
+    }
+    
+    /**
+     * @brief 获取已注册的别名数
+     */
+    size_t getAliasCount() const {
+        return nameIndex.aliasCount();
+    }
+    
+    /**
+     * @brief 估算注册表的内存占用
+     * @return 各部分的字节数
+     */
+    RegistryMemory getRegistryMemory() const {
+        RegistryMemory m;
+        m.commands = commands.size();
+        m.aliases = nameIndex.aliasCount();
+        m.definitionBytes = commands.bytes();
+        
+        // shared_ptr 控制块与对象一起分配，额外是两个计数器和虚表指针
+        const size_t controlBlock = 2 * sizeof(long) + sizeof(void*);
+        std::unordered_set<const CommandDefinition::Details*> seen;
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            const CommandDefinition* cmd = commands.peek(id);
+            if (!cmd) {
+                ++m.snapshotPending;
+                continue;
+            }
+            m.aliasBytes += cmd->getAliases().capacity() * sizeof(PooledString);
+            const CommandDefinition::Details* details = cmd->getDetails();
+            if (!details) continue;
+            if (seen.insert(details).second) {
+                m.detailsBytes += details->heapBytes() + controlBlock;
+            } else {
+                ++m.detailsShared;
+            }
+        }
+        m.detailsCount = seen.size();
+        m.indexBytes = nameIndex.bytes() +
+                       detailsByHash.size() * (sizeof(void*) + sizeof(size_t) * 2 + sizeof(uint32_t)) +
+                       detailsByHash.bucket_count() * sizeof(void*);
+        m.snapshotBytes = commands.snapshotBytes();
+        m.pool = StringPool::usage();
+        return m;
+    }
+    
+    /**
+     * @brief 获取所有命令名称列表
+     * @return 命令名称列表
+     */
+    std::vector<std::string> getCommandList() const {
+        std::vector<std::string> list;
+        for (uint32_t id : sortedIds()) {
+            list.push_back(commands[id].getName());
+        }
+        return list;
+    }
+    
+    /**
+     * @brief 按分类获取命令
+     * @return 分类到命令列表的映射
+     */
+    std::map<std::string, std::vector<std::string>> getCommandsByCategory() const {
+        std::map<std::string, std::vector<std::string>> result;
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            result[commands[id].getCategory()].push_back(commands[id].getName());
+        }
+        return result;
+    }
+    
+    /**
+     * @brief 获取命令统计快照
+     * @return 各命令的调用次数、执行结果和延迟分布
+     * @details 合并所有线程的统计分片，可在其他线程执行命令的同时调用
+     */
+    StatsSnapshot getStats() const {
+        return stats->snapshot(commandNames());
+    }
+    
+    /**
+     * @brief 清空命令统计并重新开始计时
+     */
+    void resetStats() {
+        stats->reset();
+        AllocAccounting::reset();
     }
     
+    /**
+     * @brief 输出按阶段和命令统计的内存分配报告
+     * @param os 输出流
+     * @details 只有定义了 CCM_ALLOC_ACCOUNTING 并替换了全局 operator new/delete 的构建才有数据，
+     *          见 ConsoleCommandAlloc.h
+     */
+    void writeAllocationReport(std::ostream& os) const {
+        if (!AllocAccounting::compiledIn()) {
+            os << "未启用分配统计（需要定义 CCM_ALLOC_ACCOUNTING）" << std::endl;
+            return;
+        }
+        AllocAccounting::writeReport(os, commandNames());
+    }
+    
+    /**
+     * @brief 获取被合并的请求数
+     * @return 因与正在执行的相同请求合并而未实际执行的请求总数
+     */
+    uint64_t getCoalescedCount() const {
+        return coalescing->coalesced.load(std::memory_order_relaxed);
+    }
+    
+    /**
+     * @brief 获取命令的数字ID
+     * @param name 命令名称或别名
+     * @return 命令ID，命令不存在时返回INVALID_COMMAND_ID
+     * @details ID在命令首次注册时按顺序分配，覆盖注册不会改变ID，
+     *          远程调用者可以用ID代替名称以省去字符串查找
+     */
+    uint32_t getCommandId(const std::string& name) const {
+        uint32_t ref = nameIndex.find(name, keyResolver());
+        return ref && detail::NameIndex::refId(ref) < commands.size() ? detail::NameIndex::refId(ref) : INVALID_COMMAND_ID;
+    }
+    
+    /**
+     * @brief 根据命令ID获取命令名称
+     * @param id 命令ID
+     * @return 命令名称的指针，ID无效时返回nullptr
+     */
+    const PooledString* getCommandNameById(uint32_t id) const {
+        if (id < commands.size()) {
+            return &commands[id].getName();
+        }
+        return nullptr;
+    }
+    
+private:
     // ========================================================================
-    // 命令处理核心方法
+    // 私有辅助方法
     // ========================================================================
     
     /**
-     * @brief 处理单个命令（统一入口）
-     * @param context 命令上下文
-     * @return 执行成功返回true，失败返回false
-     * 
-     * 处理流程：
-     * 1. 检查命令是否存在
-     * 2. 处理帮助请求（-h或--help）
-     * 3. 验证参数
-     * 4. 执行命令
-     * 5. 处理执行结果
+     * @brief 一次命令分派的测量选项和结果
+     */
+    struct DispatchResult {
+        bool measurePerf = false;       ///< 是否读取执行器前后的性能计数器
+        bool measurePhases = false;     ///< 是否测量各阶段耗时
+        CommandStats::Outcome outcome = CommandStats::Outcome::Failure;  ///< 用于统计的执行结果
+        PerfSample perf;                ///< 执行器的计数器差值，未测量或执行器抛出异常时 events 为0
+        uint64_t lookupNanos = 0;       ///< 命令查找耗时
+        uint64_t validateNanos = 0;     ///< 参数验证耗时
+        uint64_t executeNanos = 0;      ///< 执行器耗时
+        uint64_t helpNanos = 0;         ///< 帮助文本生成耗时
+    };
+    
+    /**
+     * @brief 作用域计时器，析构时把耗时累加到指定位置；位置为空时不读取时钟
      */
-    bool processCommand(CommandContext& context) {
-        std::string cmdName = context.getCommandName();
+    class PhaseTimer {
+    private:
+        uint64_t* slot;
+        std::chrono::steady_clock::time_point start;
         
-        // 空命令
-        if (cmdName.empty()) {
-            return true;
+    public:
+        explicit PhaseTimer(uint64_t* s) : slot(s) {
+            if (slot) start = std::chrono::steady_clock::now();
         }
-        
-        // 查找命令
-        auto cmdDef = findCommand(cmdName);
-        if (!cmdDef) {
-            // 命令未找到，显示错误和帮助
-            handleUnknownCommand(cmdName);
-            return false;
+        ~PhaseTimer() {
+            if (slot) *slot += elapsedNanos(start);
         }
+        PhaseTimer(const PhaseTimer&) = delete;
+        PhaseTimer& operator=(const PhaseTimer&) = delete;
+    };
+    
+    /**
+     * @brief 处理已找到定义的命令：帮助请求、参数验证和执行
+     * @param cmdDef 命令定义
+     * @param context 命令上下文
+     * @param autoHelp 失败时是否显示使用帮助
+     * @param result 测量选项，以及输出的执行结果、性能计数器和阶段耗时
+     * @return 执行成功返回true，失败返回false
+     */
+    bool dispatchCommand(const CommandDefinition& cmdDef, CommandContext& context, bool autoHelp,
+                         DispatchResult& result) const {
+        result.outcome = CommandStats::Outcome::Failure;
+        uint64_t* helpSlot = result.measurePhases ? &result.helpNanos : nullptr;
         
         // 检查帮助请求
         if (context.hasFlag("h") || context.hasFlag("help")) {
-            std::cout << cmdDef->generateHelp(true) << std::endl;
+            CCM_TRACE_SPAN_CMD("help", cmdDef.getId());
+            CCM_ALLOC_PHASE_CMD(AllocPhase::Help, cmdDef.getId());
+            PhaseTimer timer(helpSlot);
+            context.out() << cmdDef.generateHelp(true) << std::endl;
+            result.outcome = CommandStats::Outcome::Success;
             return true;
         }
         
         // 验证参数
         std::string validationError;
-        if (!cmdDef->validateArguments(context, validationError)) {
-            std::cerr << "错误: " << validationError << std::endl;
-            if (config.autoHelp) {
-                std::cout << "\n使用帮助:\n" << cmdDef->generateHelp() << std::endl;
+        std::vector<std::pair<size_t, std::string>> normalized;
+        bool valid;
+        {
+            CCM_TRACE_SPAN_CMD("validateArguments", cmdDef.getId());
+            CCM_ALLOC_PHASE_CMD(AllocPhase::Validate, cmdDef.getId());
+            PhaseTimer timer(result.measurePhases ? &result.validateNanos : nullptr);
+            valid = cmdDef.checkArguments(context, validationError, &normalized);
+        }
+        if (!valid) {
+            context.err() << "错误: " << validationError << std::endl;
+            if (autoHelp) {
+                CCM_TRACE_SPAN_CMD("help", cmdDef.getId());
+                CCM_ALLOC_PHASE_CMD(AllocPhase::Help, cmdDef.getId());
+                PhaseTimer timer(helpSlot);
+                context.out() << "\n使用帮助:\n" << cmdDef.generateHelp() << std::endl;
             }
             return false;
         }
         
+        // 执行器看到的是规范形式（例如 bool 的 "yes" 改为 "true"）
+        for (const auto& entry : normalized) {
+            context.setArgument(entry.first, entry.second);
+        }
+        
         // 执行命令
         try {
-            bool success = cmdDef->execute(context);
-            if (!success && config.autoHelp) {
-                std::cout << "\n命令执行失败，请参考使用说明:\n" 
-                         << cmdDef->generateHelp() << std::endl;
+            bool success;
+            {
+                CCM_TRACE_SPAN_CMD("execute", cmdDef.getId());
+                CCM_ALLOC_PHASE_CMD(AllocPhase::Dispatch, cmdDef.getId());
+                PhaseTimer timer(result.measurePhases ? &result.executeNanos : nullptr);
+                PerfSample before;
+                const PerfCounters* counters = result.measurePerf ? &PerfCounters::local() : nullptr;
+                bool measured = counters && counters->read(before);
+                success = cmdDef.isCoalescable()
+                    ? executeCoalesced(cmdDef, context)
+                    : cmdDef.execute(context);
+                PerfSample after;
+                if (measured && counters->read(after)) {
+                    result.perf = after.since(before);
+                }
+            }
+            result.outcome = success ? CommandStats::Outcome::Success : CommandStats::Outcome::Failure;
+            if (!success && autoHelp) {
+                CCM_TRACE_SPAN_CMD("help", cmdDef.getId());
+                CCM_ALLOC_PHASE_CMD(AllocPhase::Help, cmdDef.getId());
+                PhaseTimer timer(helpSlot);
+                context.out() << "\n命令执行失败，请参考使用说明:\n" 
+                         << cmdDef.generateHelp() << std::endl;
             }
             return success;
         } catch (const std::exception& e) {
-            std::cerr << "命令执行错误: " << e.what() << std::endl;
-            if (config.autoHelp) {
-                std::cout << "\n请参考使用说明:\n" << cmdDef->generateHelp() << std::endl;
+            result.outcome = CommandStats::Outcome::Exception;
+            context.err() << "命令执行错误: " << e.what() << std::endl;
+            if (autoHelp) {
+                CCM_TRACE_SPAN_CMD("help", cmdDef.getId());
+                CCM_ALLOC_PHASE_CMD(AllocPhase::Help, cmdDef.getId());
+                PhaseTimer timer(helpSlot);
+                context.out() << "\n请参考使用说明:\n" << cmdDef.generateHelp() << std::endl;
             }
             return false;
         }
     }
     
     /**
-     * @brief 处理字符串命令
-     * @param input 命令行字符串
-     * @return 执行成功返回true，失败返回false
+     * @brief 计算从指定时间点到现在的纳秒数
      */
-    bool processString(const std::string& input) {
-        CommandContext context(input);
-        return processCommand(context);
+    static uint64_t elapsedNanos(std::chrono::steady_clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now() - start).count());
     }
     
     /**
-     * @brief 处理main函数参数
-     * @param argc 参数个数
-     * @param argv 参数数组
-     * @return 执行成功返回true，失败返回false
+     * @brief 把一次慢命令放入慢命令日志队列
+     * @param cmdDef 命令定义
+     * @param context 命令上下文
+     * @param result 分派结果和阶段耗时
+     * @param parseNanos 解析耗时
+     * @param nanos 查找到执行结束的耗时
      */
-    bool processArgs(int argc, char* argv[]) {
-        if (argc < 1) return true;
+    void recordSlowCommand(const CommandDefinition& cmdDef, const CommandContext& context,
+                           const DispatchResult& result, uint64_t parseNanos, uint64_t nanos) const {
+        if (!slowLog) return;
         
-        CommandContext context(argc, argv);
-        return processCommand(context);
+        SlowCommandRecord record;
+        record.timestampMs = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::system_clock::now().time_since_epoch()).count();
+        record.thread = detail::currentThreadTag();
+        record.command = cmdDef.getName();
+        record.commandLine = formatCommandLine(context);
+        record.options.assign(context.getAllOptions().begin(), context.getAllOptions().end());
+        for (const auto& flag : context.getAllFlags()) record.flags.emplace_back(flag.first);
+        switch (result.outcome) {
+            case CommandStats::Outcome::Success:   record.outcome = "success"; break;
+            case CommandStats::Outcome::Failure:   record.outcome = "failure"; break;
+            case CommandStats::Outcome::Exception: record.outcome = "exception"; break;
+        }
+        record.totalNanos = parseNanos + nanos;
+        record.parseNanos = parseNanos;
+        record.lookupNanos = result.lookupNanos;
+        record.validateNanos = result.validateNanos;
+        record.executeNanos = result.executeNanos;
+        record.helpNanos = result.helpNanos;
+        slowLog->submit(std::move(record));
     }
     
     /**
-     * @brief 循环处理argv中的每个命令
-     * @param argc 参数个数
-     * @param argv 参数数组
-     * @return 所有命令都执行成功返回true，否则返回false
-     * 
-     * 处理模式：
-     * for(遍历argv) {
-     *     if(当前参数不是选项) {
-     *         创建命令上下文
-     *         收集该命令的参数
-     *         处理命令
-     *     }
-     * }
+     * @brief 由上下文重建可以重新执行的命令行
+     * @details 参数在前，选项和标志在后，避免参数被前面的短选项当作值；含空白或引号的部分加双引号
      */
-    bool processArgLoop(int argc, char* argv[]) {
-        bool allSuccess = true;
-        
-        for (int i = 1; i < argc; ++i) {
-            std::string arg = argv[i];
-            
-            // 跳过全局选项
-            if (arg[0] == '-') {
-                continue;
+    static std::string formatCommandLine(const CommandContext& context) {
+        std::string line(context.getCommandName());
+        auto append = [&line](std::string_view token) {
+            line += ' ';
+            if (!token.empty() && token.find_first_of(" \t\"") == std::string_view::npos) {
+                line += token;
+            } else {
+                line += '"';
+                line += token;
+                line += '"';
             }
-            
-            // 创建命令上下文
-            CommandContext context;
-            context.setCommandName(arg);
-            
-            // 收集该命令的参数
-            std::vector<std::string> cmdArgs;
-            while (i + 1 < argc && argv[i + 1][0] != '-') {
-                cmdArgs.push_back(argv[++i]);
+        };
+        auto dash = [&line](std::string_view key) {
+            line += key.size() == 1 ? "-" : "--";
+            line += key;
+        };
+        
+        for (const auto& arg : context.getArguments()) append(arg);
+        for (const auto& opt : context.getAllOptions()) {
+            line += ' ';
+            dash(opt.first);
+            append(opt.second);
+        }
+        for (const auto& flag : context.getAllFlags()) {
+            line += ' ';
+            dash(flag.first);
+        }
+        return line;
+    }
+    
+    /**
+     * @brief 输出命令统计表
+     * @param filter 只显示该命令，为空时显示全部
+     * @param os 输出流
+     * @return 找到要显示的命令返回true
+     */
+    bool showStats(const std::string& filter, std::ostream& os) const {
+        StatsSnapshot snapshot = getStats();
+        
+        std::vector<const CommandStatsSnapshot*> rows;
+        if (filter.empty()) {
+            for (const auto& c : snapshot.commands) rows.push_back(&c);
+        } else {
+            uint32_t id = getCommandId(filter);
+            for (const auto& c : snapshot.commands) {
+                if (c.commandId == id) rows.push_back(&c);
             }
-            
-            // 添加参数到上下文
-            for (const auto& arg : cmdArgs) {
-                context.addArgument(arg);
+            if (rows.empty()) {
+                os << "命令 '" << filter << "' 没有统计数据" << std::endl;
+                return id != INVALID_COMMAND_ID;
             }
+        }
+        
+        // 中文表头按显示宽度手动对齐
+        os << "命令            " << "      调用" << "    失败" << "    异常"
+           << std::right << std::setw(10) << "QPS" << std::setw(10) << "p50" << std::setw(10) << "p90"
+           << std::setw(10) << "p99" << std::setw(10) << "max" << "\n";
+        os << std::string(92, '-') << "\n";
+        for (const auto* c : rows) {
+            std::ostringstream qps;
+            qps << std::fixed << std::setprecision(1) << snapshot.qps(*c);
+            os << std::left << std::setw(16) << c->name
+               << std::right << std::setw(10) << c->calls() << std::setw(8) << c->failures
+               << std::setw(8) << c->exceptions << std::setw(10) << qps.str()
+               << std::setw(10) << formatDuration(c->latency.percentile(0.50))
+               << std::setw(10) << formatDuration(c->latency.percentile(0.90))
+               << std::setw(10) << formatDuration(c->latency.percentile(0.99))
+               << std::setw(10) << formatDuration(c->latency.max()) << "\n";
+        }
+        
+        showPerfStats(rows, os);
+        
+        std::ostringstream elapsed;
+        elapsed << std::fixed << std::setprecision(1) << snapshot.elapsedSeconds;
+        os << "\n统计时长: " << elapsed.str() << " 秒";
+        if (snapshot.unknownCommands > 0) {
+            os << "，未知命令: " << snapshot.unknownCommands << " 次";
+        }
+        os << std::endl;
+        
+        if (AllocAccounting::compiledIn() && filter.empty()) {
+            os << "\n内存分配:\n";
+            writeAllocationReport(os);
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 输出性能计数器表（每次执行的平均值）
+     * @param rows 要显示的命令
+     * @param os 输出流
+     * @details 没有任何命令带计数器读数时不输出；不可用的事件显示为 "-"
+     */
+    static void showPerfStats(const std::vector<const CommandStatsSnapshot*>& rows, std::ostream& os) {
+        bool any = false;
+        for (const auto* c : rows) any = any || c->perfSamples > 0;
+        if (!any) return;
+        
+        auto cell = [](bool valid, double value, int precision) {
+            if (!valid) return std::string("-");
+            std::ostringstream ss;
+            ss << std::fixed << std::setprecision(precision) << value;
+            return ss.str();
+        };
+        
+        os << "\n性能计数器（每次执行平均，仅用户态）:\n";
+        os << "命令            " << "      采样"
+           << std::right << std::setw(10) << "CPU" << std::setw(8) << "CPU%" << std::setw(12) << "cycles"
+           << std::setw(12) << "instr" << std::setw(7) << "IPC" << std::setw(10) << "LLC/kI"
+           << std::setw(10) << "BR/kI" << "\n";
+        os << std::string(95, '-') << "\n";
+        for (const auto* c : rows) {
+            if (c->perfSamples == 0) continue;
+            const PerfSample& p = c->perf;
+            double n = static_cast<double>(c->perfSamples);
+            double kiloInstr = static_cast<double>(p.instructions) / 1000.0;
+            bool hasClock = (p.events & PERF_TASK_CLOCK) != 0;
+            bool hasCycles = (p.events & PERF_CYCLES) != 0;
+            bool hasInstr = (p.events & PERF_INSTRUCTIONS) != 0 && p.instructions > 0;
+            // CPU% 只在每次执行都有读数时有意义（与墙钟总耗时比较）
+            bool hasShare = hasClock && c->perfSamples == c->latency.count() && c->latency.getSum() > 0;
             
-            // 处理命令
-            if (!processCommand(context)) {
-                allSuccess = false;
-            }
+            os << std::left << std::setw(16) << c->name << std::right << std::setw(10) << c->perfSamples
+               << std::setw(10) << (hasClock ? formatDuration(p.taskClockNanos / c->perfSamples) : "-")
+               << std::setw(8) << cell(hasShare, 100.0 * static_cast<double>(p.taskClockNanos) /
+                                                 static_cast<double>(c->latency.getSum()), 0)
+               << std::setw(12) << cell(hasCycles, static_cast<double>(p.cycles) / n, 0)
+               << std::setw(12) << cell(hasInstr, static_cast<double>(p.instructions) / n, 0)
+               << std::setw(7) << cell(hasCycles && hasInstr && p.cycles > 0,
+                                       static_cast<double>(p.instructions) / static_cast<double>(p.cycles), 2)
+               << std::setw(10) << cell(hasInstr && (p.events & PERF_CACHE_MISSES),
+                                        static_cast<double>(p.cacheMisses) / kiloInstr, 2)
+               << std::setw(10) << cell(hasInstr && (p.events & PERF_BRANCH_MISSES),
+                                        static_cast<double>(p.branchMisses) / kiloInstr, 2) << "\n";
         }
         
-        return allSuccess;
+        const uint32_t hardware = PERF_CYCLES | PERF_INSTRUCTIONS | PERF_CACHE_MISSES | PERF_BRANCH_MISSES;
+        if ((PerfCounters::availableEvents() & hardware) != hardware) {
+            os << "计数器状态: " << PerfCounters::status() << "\n";
+        }
     }
     
-    // ========================================================================
-    // 帮助系统方法
-    // ========================================================================
+    /**
+     * @brief 生成请求合并键
+     * @param cmd 命令定义
+     * @param context 命令上下文
+     * @return 由命令ID、工作目录、参数、选项和标志组成的键
+     * @details 每个字段都带长度前缀，避免不同字段拼接后产生歧义；
+     *          选项和标志来自有序映射，顺序不同的相同请求得到相同的键
+     */
+    std::string makeCoalescingKey(const CommandDefinition& cmd, const CommandContext& context) const {
+        std::string key;
+        auto append = [&key](std::string_view field) {
+            key += std::to_string(field.size());
+            key += ':';
+            key += field;
+        };
+        
+        key += std::to_string(cmd.getId());
+        key += '|';
+        append(context.getSessionView() ? context.getSessionView()->getWorkingDirectory() : std::string());
+        for (const auto& arg : context.getArguments()) append(arg);
+        key += '|';
+        for (const auto& opt : context.getAllOptions()) {
+            append(opt.first);
+            append(opt.second);
+        }
+        key += '|';
+        for (const auto& flag : context.getAllFlags()) append(flag.first);
+        return key;
+    }
     
     /**
-     * @brief 显示所有命令的简要帮助
-     * @param byCategory 是否按分类显示，默认true
-     * 
-     * 显示格式：
-     * 可用命令:
-     * ============================================================
-     * 
-     * 分类1:
-     *   命令1     命令1的描述
-     *   命令2     命令2的描述
+     * @brief 以合并方式执行命令
+     * @param cmd 命令定义
+     * @param context 命令上下文
+     * @return 执行结果
+     * @throws 重新抛出执行器的异常，所有等待者都会收到同一个异常
      * 
-     * 分类2:
-     *   命令3     命令3的描述
+     * 第一个到达的请求成为执行者，输出直接写到它自己的流，同时保留一份副本；
+     * 相同键的后续请求等待执行者完成，然后把副本写入各自的输出流。
+     * 副本超过 COALESCE_CAPTURE_LIMIT 时放弃合并：等待者立即自己执行，之后的请求也不再合并到这次执行。
      */
-    void showAllCommands(bool byCategory = true) const {
-        std::cout << "\n可用命令:\n";
-        std::cout << std::string(60, '=') << "\n";
+    bool executeCoalesced(const CommandDefinition& cmd, CommandContext& context) const {
+        std::string key = makeCoalescingKey(cmd, context);
+        std::shared_ptr<Flight> flight;
+        bool leader = false;
         
-        if (byCategory) {
-            // 按分类显示
-            for (const auto& category : categoryToCommands) {
-                std::cout << "\n" << category.first << ":\n";
-                for (const auto& cmdName : category.second) {
-                    auto it = commands.find(cmdName);
-                    if (it != commands.end()) {
-                        std::cout << "  " << std::left << std::setw(20) << cmdName
-                                 << " " << it->second.getDescription() << "\n";
-                    }
-                }
+        {
+            std::lock_guard<std::mutex> lock(coalescing->mutex);
+            auto& slot = coalescing->inFlight[key];
+            if (!slot) {
+                slot = std::make_shared<Flight>();
+                leader = true;
             }
-        } else {
-            // 所有命令按字母排序
-            std::vector<std::string> sortedNames;
-            for (const auto& cmd : commands) {
-                sortedNames.push_back(cmd.first);
+            flight = slot;
+        }
+        
+        if (leader) {
+            // 从表中移除，之后到达的请求会重新执行；键可能已被新的执行占用，只移除自己
+            auto detach = [this, &key, &flight] {
+                std::lock_guard<std::mutex> lock(coalescing->mutex);
+                auto it = coalescing->inFlight.find(key);
+                if (it != coalescing->inFlight.end() && it->second == flight) {
+                    coalescing->inFlight.erase(it);
+                }
+            };
+            auto abandon = [&detach, &flight] {
+                detach();
+                {
+                    std::lock_guard<std::mutex> lock(flight->mutex);
+                    if (flight->abandoned) return;
+                    flight->abandoned = true;
+                }
+                flight->done.notify_all();
+            };
+            
+            std::ostream& out = context.out();
+            std::ostream& err = context.err();
+            detail::TeeBuffer outBuffer(out.rdbuf(), COALESCE_CAPTURE_LIMIT, abandon);
+            detail::TeeBuffer errBuffer(err.rdbuf(), COALESCE_CAPTURE_LIMIT, abandon);
+            std::ostream teeOut(&outBuffer);
+            std::ostream teeErr(&errBuffer);
+            context.setOutput(&teeOut);
+            context.setErrorOutput(&teeErr);
+            
+            bool success = false;
+            std::exception_ptr exception;
+            try {
+                success = cmd.execute(context);
+            } catch (...) {
+                exception = std::current_exception();
             }
-            std::sort(sortedNames.begin(), sortedNames.end());
+            teeOut.flush();
+            teeErr.flush();
+            context.setOutput(&out);
+            context.setErrorOutput(&err);
             
-            for (const auto& name : sortedNames) {
-                auto it = commands.find(name);
-                if (it != commands.end()) {
-                    std::cout << "  " << std::left << std::setw(20) << name
-                             << " " << it->second.getDescription() << "\n";
+            detach();
+            {
+                std::lock_guard<std::mutex> lock(flight->mutex);
+                flight->success = success;
+                if (!flight->abandoned) {
+                    flight->output = outBuffer.captured();
+                    flight->errorOutput = errBuffer.captured();
                 }
+                flight->exception = exception;
+                flight->finished = true;
+            }
+            flight->done.notify_all();
+            
+            if (exception) {
+                std::rethrow_exception(exception);
+            }
+            return success;
+        }
+        
+        {
+            std::unique_lock<std::mutex> lock(flight->mutex);
+            flight->done.wait(lock, [&flight] { return flight->finished || flight->abandoned; });
+            if (flight->abandoned) {
+                lock.unlock();
+                return cmd.execute(context);
             }
         }
         
-        std::cout << "\n使用 'help <命令名>' 查看详细帮助\n";
-        std::cout << std::endl;
+        coalescing->coalesced.fetch_add(1, std::memory_order_relaxed);
+        context.out() << flight->output;
+        context.err() << flight->errorOutput;
+        if (flight->exception) {
+            std::rethrow_exception(flight->exception);
+        }
+        return flight->success;
     }
     
     /**
-     * @brief 显示特定命令的详细帮助
-     * @param commandName 命令名称
-     * 
-     * 显示格式：
-     * 命令: 命令名 (别名: 别名1, 别名2)
-     * 描述: 命令描述
-     * 分类: 命令分类
-     * 版本: 1.0.0
-     * 作者: 作者名
-     * 
-     * 用法: 命令名 <参数1> [参数2] [选项...]
-     * 
-     * 参数:
-     *   <参数1>      参数1的描述 [默认: 默认值] (类型)
-     * 
-     * 选项:
-     *   -h, --help   显示帮助信息
-     * 
-     * 示例:
-     *   示例1
-     *   示例2
+     * @brief 生成全局唯一的会话ID
+     * @return 新的会话ID
      */
-    void showCommandHelp(const std::string& commandName) const {
-        auto cmdDef = findCommand(commandName);
-        if (cmdDef) {
-            std::cout << cmdDef->generateHelp(true) << std::endl;
-        } else {
-            std::cout << "未找到命令: " << commandName << std::endl;
-            showAllCommands();
-        }
+    static uint64_t nextSessionId() {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
     }
     
     /**
-     * @brief 显示全局帮助
-     * 
-     * 显示格式：
-     * 命令行工具 - 全局帮助
-     * ============================================================
-     * 全局选项:
-     *   -h, --help                显示帮助信息
-     * 
-     * 特殊命令:
-     *   help [命令]               显示帮助信息
-     *   list                      列出所有命令
-     *   exit                      退出交互模式
-     * 
-     * 使用示例:
-     *   1. 获取命令帮助: help <命令名>
-     *   2. 使用命令: <命令名> [参数...] [选项...]
-     *   3. 获取帮助: -h 或 --help
+     * @brief 名称索引用来由引用取得键的回调
      */
-    void showGlobalHelp() const {
-        std::cout << "\n命令行工具 - 全局帮助\n";
-        std::cout << std::string(60, '=') << "\n";
-        
-        std::cout << "全局选项:\n";
-        for (const auto& opt : globalOptions) {
-            std::cout << "  " << std::left << std::setw(40) << opt.getUsage()
-                     << " " << opt.description << "\n";
-        }
-        
-        std::cout << "\n特殊命令:\n";
-        std::cout << "  help [命令]      显示帮助信息\n";
-        std::cout << "  list             列出所有命令\n";
-        std::cout << "  exit             退出交互模式\n";
-        
-        std::cout << "\n使用示例:\n";
-        std::cout << "  1. 获取命令帮助: help <命令名>\n";
-        std::cout << "  2. 使用命令: <命令名> [参数...] [选项...]\n";
-        std::cout << "  3. 获取帮助: -h 或 --help\n";
-        std::cout << std::endl;
+    detail::CommandKeyOf keyResolver() const {
+        return detail::CommandKeyOf{commands};
     }
     
-    // ========================================================================
-    // 交互模式方法
-    // ========================================================================
-    
     /**
-     * @brief 运行交互式命令行模式
-     * 
-     * 启动一个交互式命令行界面，用户可以输入命令并查看结果。
-     * 支持特殊命令：
-     *   help - 显示帮助
-     *   list - 列出所有命令
-     *   exit/quit - 退出
+     * @brief 保存命令定义并更新名称索引
+     * @param cmd 命令定义
+     * @param warnIfExists 覆盖同名命令时是否输出警告
+     * @param id 输出命令ID，重新注册的命令保持原ID
+     * @return 命令数量超出索引上限时返回false
      */
-    void runInteractive() {
-        std::string input;
-        
-        std::cout << "ConsoleCommandManager 交互模式\n";
-        std::cout << "输入 'help' 查看帮助，'list' 列出命令，'exit' 退出\n\n";
+    bool placeCommand(const CommandDefinition& cmd, bool warnIfExists, uint32_t& id) {
+        flushPendingDetails();
+        auto keyOf = keyResolver();
+        uint32_t ref = nameIndex.find(cmd.getName().view(), keyOf);
         
-        while (true) {
-            std::cout << config.prompt;
-            
-            if (!std::getline(std::cin, input)) {
-                break; // EOF
+        if (ref && detail::NameIndex::refWhich(ref) == 0) {
+            id = detail::NameIndex::refId(ref);
+            if (warnIfExists) {
+                std::cerr << "警告: 命令 '" << cmd.getName() << "' 已存在，将被覆盖" << std::endl;
             }
-            
-            // 跳过空白输入
-            if (input.empty()) continue;
-            
-            // 检查特殊命令
-            if (input == "exit" || input == "quit") {
-                std::cout << "再见！" << std::endl;
-                break;
-            } else if (input == "help") {
-                showGlobalHelp();
-                continue;
-            } else if (input == "list") {
-                showAllCommands();
+            // 旧定义的别名不再指向此命令
+            const auto& oldAliases = commands[id].getAliases();
+            for (size_t i = 0; i < oldAliases.size() && i < detail::NameIndex::MAX_ALIASES; ++i) {
+                nameIndex.erase(oldAliases[i].view(), detail::NameIndex::makeRef(id, i + 1), keyOf);
+            }
+            commands[id] = cmd;
+        } else {
+            if (commands.size() > detail::NameIndex::MAX_ID) {
+                std::cerr << "错误: 命令数量已达上限，无法注册 '" << cmd.getName() << "'" << std::endl;
+                return false;
+            }
+            id = static_cast<uint32_t>(commands.size());
+            commands.push_back(cmd);
+            nameIndex.insert(cmd.getName().view(), detail::NameIndex::makeRef(id, 0), keyOf);
+        }
+        commands[id].setId(id);
+        
+        // 注册别名
+        const auto& aliases = commands[id].getAliases();
+        for (size_t i = 0; i < aliases.size(); ++i) {
+            if (aliases[i].empty() || aliases[i] == cmd.getName()) {
                 continue;
             }
-            
-            // 处理命令
-            if (!processString(input)) {
-                if (config.verboseErrors) {
-                    std::cout << "命令执行失败，输入 'help' 查看帮助" << std::endl;
-                }
+            if (i >= detail::NameIndex::MAX_ALIASES) {
+                std::cerr << "警告: 命令 '" << cmd.getName() << "' 的别名超过 "
+                          << detail::NameIndex::MAX_ALIASES << " 个，其余别名被忽略" << std::endl;
+                break;
             }
+            nameIndex.insert(aliases[i].view(), detail::NameIndex::makeRef(id, i + 1), keyOf);
         }
+        return true;
     }
     
-    // ========================================================================
-    // 查询方法
-    // ========================================================================
+    /**
+     * @brief 让命令与已注册的、内容相同的命令共享 Details
+     * @param id 命令ID
+     */
+    void shareDetails(uint32_t id) {
+        CommandDefinition& cmd = commands[id];
+        const CommandDefinition::Details* details = cmd.getDetails();
+        if (!details) {
+            return;
+        }
+        size_t hash = details->hash();
+        auto range = detailsByHash.equal_range(hash);
+        for (auto it = range.first; it != range.second; ++it) {
+            if (it->second == id) {
+                return;
+            }
+            if (cmd.shareDetails(commands[it->second])) {
+                return;
+            }
+        }
+        cmd.localizeDetails();
+        detailsByHash.emplace(hash, id);
+    }
     
     /**
-     * @brief 检查命令是否存在
-     * @param name 命令名称或别名
-     * @return 命令存在返回true，否则返回false
+     * @brief 把复制自其他资源的 Details 复制到本管理器的资源上
+     * @details 原来共享同一份 Details 的命令复制后仍然共享
      */
-    bool commandExists(const std::string& name) const {
-        return findCommand(name) != nullptr;
+    void localizeDetails() {
+        std::unordered_map<const CommandDefinition::Details*, uint32_t> moved;
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            if (!commands.peek(id)) {
+                continue;   // 快照中尚未访问的命令会在本管理器的资源上构造
+            }
+            CommandDefinition& cmd = commands[id];
+            const CommandDefinition::Details* details = cmd.getDetails();
+            if (!details || details->resource() == getResource()) {
+                continue;
+            }
+            auto inserted = moved.emplace(details, id);
+            if (inserted.second) {
+                cmd.localizeDetails();
+            } else {
+                cmd.shareDetails(commands[inserted.first->second]);
+            }
+        }
     }
     
     /**
-     * @brief 获取所有命令名称列表
-     * @return 命令名称列表
+     * @brief 让上一个 createCommand 创建的命令参与 Details 共享
      */
-    std::vector<std::string> getCommandList() const {
-        std::vector<std::string> list;
-        for (const auto& cmd : commands) {
-            list.push_back(cmd.first);
+    void flushPendingDetails() {
+        if (pendingDetails < commands.size()) {
+            shareDetails(pendingDetails);
         }
-        return list;
+        pendingDetails = INVALID_COMMAND_ID;
     }
     
     /**
-     * @brief 按分类获取命令
-     * @return 分类到命令列表的映射
+     * @brief 按名称排序的命令ID列表
      */
-    std::map<std::string, std::vector<std::string>> getCommandsByCategory() const {
-        return categoryToCommands;
+    std::vector<uint32_t> sortedIds() const {
+        std::vector<uint32_t> ids(commands.size());
+        for (uint32_t id = 0; id < ids.size(); ++id) ids[id] = id;
+        std::sort(ids.begin(), ids.end(), [this](uint32_t a, uint32_t b) {
+            return commands.name(a) < commands.name(b);
+        });
+        return ids;
     }
     
-private:
-    // ========================================================================
-    // 私有辅助方法
-    // ========================================================================
+    /**
+     * @brief 命令ID到命令名称的映射（ID即下标），供统计、追踪和分配报告使用
+     */
+    std::vector<std::string> commandNames() const {
+        std::vector<std::string> names;
+        names.reserve(commands.size());
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            names.emplace_back(commands.name(id));
+        }
+        return names;
+    }
     
     /**
      * @brief 设置全局选项
@@ -1441,6 +4344,14 @@ private:
         };
     }
     
+    /**
+     * @brief 注册内置命令，标记后可由 CommandDefinition::isBuiltin() 区分
+     */
+    void registerBuiltin(CommandDefinition& cmd) {
+        cmd.builtin = true;
+        registerCommand(cmd);
+    }
+    
     /**
      * @brief 设置内置命令
      */
@@ -1451,14 +4362,16 @@ private:
             ParameterDefinition("command", "命令名称", false, "", TYPE_COMMAND)
         );
         helpCmd.addAlias("?");
-        helpCmd.setExecutor([this](const CommandContext& ctx) {
+        helpCmd.setExecutor([](const CommandContext& ctx) {
+            CommandManager* self = ctx.getManager();
+            if (!self) return false;
             if (ctx.argumentCount() > 0) {
                 // 显示特定命令的帮助
                 std::string cmdName = ctx.getArgument(0);
-                showCommandHelp(cmdName);
+                self->showCommandHelp(cmdName, ctx.out());
             } else {
                 // 显示全局帮助
-                showGlobalHelp();
+                self->showGlobalHelp(ctx.out());
             }
             return true;
         });
@@ -1466,85 +4379,389 @@ private:
         helpCmd.addExample("help              # 显示全局帮助");
         helpCmd.addExample("help <命令名>     # 显示特定命令的帮助");
         
-        registerCommand(helpCmd);
+        registerBuiltin(helpCmd);
         
         // 内置列表命令
         CommandDefinition listCmd("list", "列出所有可用命令");
         listCmd.addOption(
             OptionDefinition("category", "c", "按分类显示", false)
         );
-        listCmd.setExecutor([this](const CommandContext& ctx) {
+        listCmd.setExecutor([](const CommandContext& ctx) {
+            CommandManager* self = ctx.getManager();
+            if (!self) return false;
             bool byCategory = ctx.hasFlag("c") || ctx.hasFlag("category");
-            showAllCommands(byCategory);
+            self->showAllCommands(byCategory, ctx.out());
             return true;
         });
         
         listCmd.addExample("list              # 列出所有命令");
         listCmd.addExample("list -c           # 按分类列出命令");
         
-        registerCommand(listCmd);
+        registerBuiltin(listCmd);
+        
+        // 内置会话设置命令
+        CommandDefinition setCmd("set", "查看或修改会话变量和设置");
+        setCmd.addParameter(ParameterDefinition("name", "变量或设置名称（prompt/verbose/autohelp）", false));
+        setCmd.addParameter(ParameterDefinition("value", "新的值", false));
+        setCmd.setExecutor([](const CommandContext& ctx) {
+            if (ctx.argumentCount() == 0) {
+                const Session* view = ctx.getSessionView();
+                if (!view) {
+                    ctx.err() << "错误: 当前没有会话" << std::endl;
+                    return false;
+                }
+                ctx.out() << "prompt   = \"" << view->getPrompt() << "\"\n";
+                ctx.out() << "verbose  = " << (view->getVerboseErrors() ? "on" : "off") << "\n";
+                ctx.out() << "autohelp = " << (view->getAutoHelp() ? "on" : "off") << "\n";
+                for (const auto& var : view->getVariables()) {
+                    ctx.out() << var.first << " = " << var.second << "\n";
+                }
+                return true;
+            }
+            
+            Session* session = ctx.getSession();
+            if (!session) {
+                ctx.err() << "错误: 当前没有会话，无法修改设置" << std::endl;
+                return false;
+            }
+            std::string name = ctx.getArgument(0);
+            std::string value = ctx.getArgument(1);
+            bool on = value == "on" || value == "true" || value == "1";
+            if (name == "prompt") {
+                session->setPrompt(value);
+            } else if (name == "verbose") {
+                session->setVerboseErrors(on);
+            } else if (name == "autohelp") {
+                session->setAutoHelp(on);
+            } else {
+                session->setVariable(name, value);
+            }
+            return true;
+        });
+        
+        setCmd.addExample("set                   # 显示会话设置和变量");
+        setCmd.addExample("set prompt \"fm# \"     # 修改本会话的提示符");
+        setCmd.addExample("set verbose off       # 关闭详细错误");
+        setCmd.addExample("set name value        # 设置会话变量");
+        
+        registerBuiltin(setCmd);
+        
+        // 内置变量删除命令
+        CommandDefinition unsetCmd("unset", "删除会话变量");
+        unsetCmd.addParameter(ParameterDefinition("name", "变量名称", true));
+        unsetCmd.setExecutor([](const CommandContext& ctx) {
+            Session* session = ctx.getSession();
+            if (!session) {
+                ctx.err() << "错误: 当前没有会话，无法删除变量" << std::endl;
+                return false;
+            }
+            if (!session->unsetVariable(ctx.getArgument(0))) {
+                ctx.err() << "错误: 变量不存在: " << ctx.getArgument(0) << std::endl;
+                return false;
+            }
+            return true;
+        });
+        
+        registerBuiltin(unsetCmd);
+        
+        // 内置统计命令
+        CommandDefinition statsCmd("stats", "显示各命令的调用次数和延迟分布");
+        statsCmd.addParameter(
+            ParameterDefinition("command", "只显示该命令", false, "", TYPE_COMMAND)
+        );
+        statsCmd.addOption(
+            OptionDefinition("reset", "r", "显示后清空统计", false)
+        );
+        statsCmd.setExecutor([](const CommandContext& ctx) {
+            CommandManager* self = ctx.getManager();
+            if (!self) return false;
+            bool found = self->showStats(ctx.getArgument(0), ctx.out());
+            if (ctx.hasFlag("r") || ctx.hasFlag("reset")) {
+                self->resetStats();
+            }
+            return found;
+        });
+        
+        statsCmd.addExample("stats             # 显示所有命令的统计");
+        statsCmd.addExample("stats ls          # 只显示ls命令");
+        statsCmd.addExample("stats -r          # 显示后清空统计");
+        
+        registerBuiltin(statsCmd);
+        
+        // 内置追踪命令
+        CommandDefinition traceCmd("trace", "记录命令处理各阶段的耗时，导出为Chrome trace格式");
+        traceCmd.addParameter(ParameterDefinition("action", "start/stop/status/dump", true));
+        traceCmd.addParameter(ParameterDefinition("file", "dump的输出文件", false, "ccm_trace.json", TYPE_PATH));
+        traceCmd.setExecutor([](const CommandContext& ctx) {
+            return ctx.getManager() && ctx.getManager()->handleTrace(ctx);
+        });
+        
+        traceCmd.addExample("trace start             # 开始记录（丢弃上一轮的事件）");
+        traceCmd.addExample("trace stop              # 停止记录");
+        traceCmd.addExample("trace dump out.json     # 写出Chrome trace_event JSON");
+        
+        registerBuiltin(traceCmd);
+        
+        // 内置慢命令日志查看命令
+        CommandDefinition slowlogCmd("slowlog", "显示最近超过慢命令阈值的命令");
+        slowlogCmd.addParameter(ParameterDefinition("count", "显示的条数", false, "10", TYPE_INTEGER));
+        slowlogCmd.setExecutor([](const CommandContext& ctx) {
+            return ctx.getManager() && ctx.getManager()->showSlowLog(ctx);
+        });
+        
+        slowlogCmd.addExample("slowlog                 # 显示最近10条慢命令");
+        slowlogCmd.addExample("slowlog 50              # 显示最近50条");
+        
+        registerBuiltin(slowlogCmd);
+        
+        // 内置注册表信息命令
+        CommandDefinition registryCmd("registry", "显示命令注册表的信息");
+        registryCmd.addParameter(ParameterDefinition("action", "memory: 内存占用；snapshot: 保存快照", true));
+        registryCmd.addParameter(ParameterDefinition("path", "snapshot 的输出文件", false));
+        registryCmd.setExecutor([](const CommandContext& ctx) {
+            if (!ctx.getManager()) return false;
+            std::string action = ctx.getArgument(0);
+            if (action == "memory") {
+                ctx.getManager()->showRegistryMemory(ctx.out());
+                return true;
+            }
+            if (action == "snapshot") {
+                if (fileBuiltinsDisabled(ctx)) return false;
+                if (ctx.getArguments().size() < 2) {
+                    ctx.err() << "错误: 缺少快照文件路径" << std::endl;
+                    return false;
+                }
+                std::string errorMsg;
+                if (!ctx.getManager()->saveSnapshot(ctx.getArgument(1), errorMsg)) {
+                    ctx.err() << "错误: " << errorMsg << std::endl;
+                    return false;
+                }
+                ctx.out() << "已保存 " << ctx.getManager()->getCommandCount() << " 个命令到 "
+                          << ctx.getArgument(1) << std::endl;
+                return true;
+            }
+            ctx.err() << "错误: 未知操作 " << action << "，应为 memory 或 snapshot" << std::endl;
+            return false;
+        });
+        
+        registryCmd.addExample("registry memory         # 按组成部分显示注册表内存占用");
+        registryCmd.addExample("registry snapshot reg.snap  # 保存注册表快照，下次启动用 loadSnapshot 加载");
+        
+        registerBuiltin(registryCmd);
+        
+        // 内置消息目录命令
+        CommandDefinition catalogCmd("catalog", "切换或编译帮助文本的消息目录");
+        catalogCmd.addParameter(ParameterDefinition("action", "load、off 或 compile，省略时显示当前目录", false));
+        catalogCmd.addParameter(ParameterDefinition("...", "load 的目录文件，或 compile 的源文件和输出文件", false));
+        catalogCmd.setExecutor([](const CommandContext& ctx) {
+            const auto& args = ctx.getArguments();
+            std::string errorMsg;
+            if (args.empty()) {
+                std::string path = MessageCatalog::path();
+                if (path.empty()) {
+                    ctx.out() << "未加载消息目录，显示注册时的文本" << std::endl;
+                } else {
+                    ctx.out() << "当前目录: " << path << "，" << MessageCatalog::size() << " 条" << std::endl;
+                }
+                return true;
+            }
+            if (args[0] == "off" && args.size() == 1) {
+                if (fileBuiltinsDisabled(ctx)) return false;
+                MessageCatalog::unload();
+                return true;
+            }
+            if (args[0] == "load" && args.size() == 2) {
+                if (fileBuiltinsDisabled(ctx)) return false;
+                if (!MessageCatalog::load(std::string(args[1]), errorMsg)) {
+                    ctx.err() << "错误: " << errorMsg << std::endl;
+                    return false;
+                }
+                ctx.out() << "已加载 " << MessageCatalog::size() << " 条消息" << std::endl;
+                return true;
+            }
+            if (args[0] == "compile" && args.size() == 3) {
+                if (fileBuiltinsDisabled(ctx)) return false;
+                if (!MessageCatalog::compile(std::string(args[1]), std::string(args[2]), errorMsg)) {
+                    ctx.err() << "错误: " << errorMsg << std::endl;
+                    return false;
+                }
+                return true;
+            }
+            ctx.err() << "用法: catalog [load <目录文件> | off | compile <源文件> <输出文件>]" << std::endl;
+            return false;
+        });
+        
+        catalogCmd.addExample("catalog load help.en_US.cat    # 切换到英文帮助文本");
+        catalogCmd.addExample("catalog compile help.en_US.txt help.en_US.cat");
+        catalogCmd.addExample("catalog off                    # 恢复注册时的文本");
+        
+        registerBuiltin(catalogCmd);
     }
     
     /**
-     * @brief 查找命令（处理别名）
-     * @param name 命令名称或别名
-     * @return 命令定义的指针，如果找不到返回nullptr
+     * @brief 写文件或修改进程级状态的内置操作（registry snapshot、catalog load/off/compile）是否被禁用
+     * @details 编译时定义 CCM_DISABLE_FILE_BUILTINS 后这些操作只报告错误，供 fuzz 目标等不可信输入的场景使用
+     * @return 已禁用时输出错误并返回true
+     */
+    static bool fileBuiltinsDisabled(const CommandContext& ctx) {
+#ifdef CCM_DISABLE_FILE_BUILTINS
+        ctx.err() << "错误: 编译时已通过 CCM_DISABLE_FILE_BUILTINS 禁用此操作" << std::endl;
+        return true;
+#else
+        (void)ctx;
+        return false;
+#endif
+    }
+    
+    /**
+     * @brief 输出注册表内存占用报告
+     */
+    void showRegistryMemory(std::ostream& os) const {
+        RegistryMemory m = getRegistryMemory();
+        auto row = [&os, &m](const char* label, size_t bytes) {
+            os << "  " << label << std::right << std::setw(14) << bytes << " 字节";
+            if (m.commands > 0) {
+                os << std::setw(10) << std::fixed << std::setprecision(1)
+                   << static_cast<double>(bytes) / static_cast<double>(m.commands) << " 字节/命令";
+            }
+            os << "\n";
+        };
+        
+        os << "命令: " << m.commands << "，别名: " << m.aliases
+           << "，不同的参数/选项组合: " << m.detailsCount << "（" << m.detailsShared << " 个命令共享）\n";
+        row("命令定义      ", m.definitionBytes);
+        row("别名列表      ", m.aliasBytes);
+        row("参数/选项     ", m.detailsBytes);
+        row("名称索引      ", m.indexBytes);
+        row("合计          ", m.ownBytes());
+        if (m.snapshotBytes > 0) {
+            os << "快照映射: " << m.snapshotBytes << " 字节，" << m.snapshotPending << " 个命令尚未访问\n";
+        }
+        os << "字符串池（进程内所有管理器共用）: " << m.pool.strings << " 个字符串，其中 "
+           << m.pool.internedStrings << " 个去重（命中 " << m.pool.internHits << " 次），已用 "
+           << m.pool.bytesUsed << " / " << m.pool.bytesReserved << " 字节，查重索引约 "
+           << m.pool.indexBytes << " 字节" << std::endl;
+        os.unsetf(std::ios::fixed);
+    }
+    
+    /**
+     * @brief 处理slowlog内置命令
      */
-    const CommandDefinition* findCommand(const std::string& name) const {
-        // 直接查找
-        auto it = commands.find(name);
-        if (it != commands.end()) {
-            return &it->second;
+    bool showSlowLog(const CommandContext& ctx) const {
+        if (config.slowCommandThresholdUs == 0 || !slowLog) {
+            ctx.out() << "慢命令日志未启用（Config::slowCommandThresholdUs 为0）" << std::endl;
+            return true;
         }
         
-        // 通过别名查找
-        auto aliasIt = aliasToCommand.find(name);
-        if (aliasIt != aliasToCommand.end()) {
-            auto cmdIt = commands.find(aliasIt->second);
-            if (cmdIt != commands.end()) {
-                return &cmdIt->second;
+        // 只接受十进制数字（std::stoul 会把 "-5" 回绕成极大值），超过保留条数时按保留条数处理
+        std::string text = ctx.getArgument(0, "10");
+        if (text.empty() || text.find_first_not_of("0123456789") != std::string::npos) {
+            ctx.err() << "错误: 条数必须是非负整数: " << text << std::endl;
+            return false;
+        }
+        size_t count = text.size() > 9 ? SlowLog::RECENT_LIMIT
+                                       : std::min<size_t>(std::stoul(text), SlowLog::RECENT_LIMIT);
+        std::vector<std::string> lines = slowLog->recent(count);
+        std::string path = slowLog->getPath();
+        ctx.out() << "阈值: " << formatDuration(uint64_t(config.slowCommandThresholdUs) * 1000)
+                  << "，已记录: " << slowLog->submittedCount()
+                  << "，队列满丢弃: " << slowLog->droppedCount()
+                  << "，日志文件: " << (path.empty() ? "(无)" : path) << std::endl;
+        for (const auto& line : lines) {
+            ctx.out() << line << "\n";
+        }
+        ctx.out().flush();
+        return true;
+    }
+    
+    /**
+     * @brief 处理trace内置命令
+     */
+    bool handleTrace(const CommandContext& ctx) const {
+#ifdef CCM_DISABLE_TRACING
+        ctx.err() << "错误: 编译时已通过 CCM_DISABLE_TRACING 禁用追踪" << std::endl;
+        return false;
+#else
+        std::string action = ctx.getArgument(0);
+        if (action == "start") {
+            Tracer::start();
+            ctx.out() << "追踪已开始" << std::endl;
+        } else if (action == "stop") {
+            Tracer::stop();
+            ctx.out() << "追踪已停止，保留 " << Tracer::eventCount() << " 个事件" << std::endl;
+        } else if (action == "status") {
+            ctx.out() << "追踪" << (Tracer::enabled() ? "进行中" : "未开启")
+                      << "，保留 " << Tracer::eventCount() << " 个事件" << std::endl;
+        } else if (action == "dump") {
+            std::string path = ctx.getArgument(1, "ccm_trace.json");
+            if (const Session* view = ctx.getSessionView()) {
+                path = view->resolvePath(path);
+            }
+            std::ofstream file(path);
+            if (!file) {
+                ctx.err() << "错误: 无法写入 " << path << std::endl;
+                return false;
             }
+            size_t count = Tracer::writeChromeTrace(file, commandNames());
+            ctx.out() << "已写入 " << count << " 个事件到 " << path << std::endl;
+        } else {
+            ctx.err() << "错误: 未知操作 " << action << "，应为 start/stop/status/dump" << std::endl;
+            return false;
         }
-        
-        return nullptr;
+        return true;
+#endif
+    }
+    
+    /**
+     * @brief 查找命令（处理别名）
+     * @param name 命令名称或别名
+     * @return 命令定义的指针，如果找不到返回nullptr
+     */
+    const CommandDefinition* findCommand(std::string_view name) const {
+        // 命令名和别名在同一个索引中，命令名优先
+        uint32_t ref = nameIndex.find(name, keyResolver());
+        return ref && detail::NameIndex::refId(ref) < commands.size() ? &commands[detail::NameIndex::refId(ref)] : nullptr;
     }
     
     /**
      * @brief 处理未知命令
      * @param cmdName 用户输入的命令名称
+     * @param os 标准输出流
+     * @param es 错误输出流
      * 
      * 处理流程：
      * 1. 显示错误信息
      * 2. 查找相似命令并提供建议
      * 3. 显示可用命令提示
      */
-    void handleUnknownCommand(const std::string& cmdName) const {
-        std::cerr << "错误: 未知命令 '" << cmdName << "'" << std::endl;
+    void handleUnknownCommand(std::string_view cmdName, std::ostream& os, std::ostream& es) const {
+        es << "错误: 未知命令 '" << cmdName << "'" << std::endl;
         
         // 查找相似命令
-        std::vector<std::string> suggestions;
-        for (const auto& cmd : commands) {
-            if (isSimilar(cmdName, cmd.first)) {
-                suggestions.push_back(cmd.first);
-                if (suggestions.size() >= config.maxSuggestions) {
-                    break;
-                }
+        // 按名称排序后取前 maxSuggestions 个
+        std::vector<uint32_t> suggestions;
+        for (uint32_t id = 0; id < commands.size(); ++id) {
+            if (isSimilar(cmdName, commands.name(id))) {
+                suggestions.push_back(id);
             }
         }
+        size_t limit = std::min(suggestions.size(), static_cast<size_t>(std::max(config.maxSuggestions, 0)));
+        std::partial_sort(suggestions.begin(), suggestions.begin() + limit, suggestions.end(),
+                          [this](uint32_t a, uint32_t b) {
+                              return commands.name(a) < commands.name(b);
+                          });
+        suggestions.resize(limit);
         
         if (!suggestions.empty()) {
-            std::cout << "\n您是否想输入以下命令？\n";
-            for (const auto& suggestion : suggestions) {
-                auto it = commands.find(suggestion);
-                if (it != commands.end()) {
-                    std::cout << "  " << suggestion << " - " << it->second.getDescription() << "\n";
-                }
+            os << "\n您是否想输入以下命令？\n";
+            for (uint32_t id : suggestions) {
+                os << "  " << commands[id].getName() << " - " << commands[id].getDescription() << "\n";
             }
         } else {
-            std::cout << "\n使用 'list' 查看所有可用命令\n";
+            os << "\n使用 'list' 查看所有可用命令\n";
         }
         
-        std::cout << std::endl;
+        os << std::endl;
     }
     
     /**
@@ -1558,11 +4775,11 @@ private:
      * 2. 长度相差不大
      * 3. 字符匹配度超过60%
      */
-    bool isSimilar(const std::string& a, const std::string& b) const {
+    bool isSimilar(std::string_view a, std::string_view b) const {
         if (a.empty() || b.empty()) return false;
         
         // 前缀匹配
-        if (b.find(a) == 0) return true;
+        if (b.compare(0, a.size(), a) == 0) return true;
         
         // 编辑距离简单判断
         if (std::abs(static_cast<int>(a.size()) - static_cast<int>(b.size())) > 2) {
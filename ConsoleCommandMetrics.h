@@ -0,0 +1,501 @@
+/**
+ * @file ConsoleCommandMetrics.h
+ * @brief Prometheus 文本格式的指标导出
+ * @details 把 CommandManager 的统计（以及可选的 CommandServer 准入统计）渲染为
+ *          Prometheus 文本格式 0.0.4，通过以下任一方式提供给监控系统：
+ * - 回环 TCP 端口或 Unix 域套接字上的 HTTP 端点（GET /metrics）
+ * - 定期写入文件（先写临时文件再 rename，读取方不会看到写了一半的内容），
+ *   适用于 node_exporter 的 textfile collector
+ *
+ * 导出的指标：
+ * - ccm_command_calls_total{command,outcome}：按命令和结果（success/failure/exception）的调用次数
+ * - ccm_command_duration_seconds{command}：按命令的延迟直方图
+ * - ccm_errors_total{type}：按类型的错误数（命令失败、异常、未知命令、各类准入拒绝）
+ * - ccm_server_queue_depth、ccm_server_admitted_total 等：服务器准入控制状态
+ * - ccm_registry_commands、ccm_registry_aliases：注册表大小
+ *
+ * 采集只读取统计分片，命令执行路径上的写入方不加锁也不感知导出器的存在。
+ *
+ * 使用示例：
+ * @code
+ * ConsoleCommand::MetricsConfig mc;
+ * mc.port = 9464;
+ * ConsoleCommand::MetricsExporter exporter(manager, mc);
+ * exporter.setServer(&server);  // 可选
+ * std::string error;
+ * if (!exporter.start(error)) { ... }
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_METRICS_H
+#define CONSOLE_COMMAND_METRICS_H
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandServer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace ConsoleCommand {
+
+/**
+ * @struct MetricsConfig
+ * @brief 指标导出配置
+ * @details unixPath 和 port 决定 HTTP 端点（unixPath 非空时优先，两者都未设置时不监听）；
+ *          filePath 非空时每隔 fileIntervalMs 写一次文件。两种方式可以同时使用。
+ */
+struct MetricsConfig {
+    std::string host = "127.0.0.1";   ///< TCP 监听地址，默认只监听回环地址
+    uint16_t port = 0;                ///< TCP 端口，0 表示不监听 TCP
+    std::string unixPath;             ///< Unix 域套接字路径
+    std::string filePath;             ///< 定期写入的文件路径
+    uint32_t fileIntervalMs = 10000;  ///< 写文件间隔（毫秒）
+};
+
+namespace detail {
+
+/// 延迟直方图导出的桶上界（纳秒），1us 到 10s 按 1-2.5-5 递增
+const uint64_t METRICS_LATENCY_BOUNDS[] = {
+    1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000, 50000000, 100000000, 250000000, 500000000,
+    1000000000, 2500000000ull, 5000000000ull, 10000000000ull
+};
+
+inline void appendLabelValue(std::string& out, const std::string& value) {
+    for (char c : value) {
+        if (c == '\\' || c == '"') {
+            out += '\\';
+            out += c;
+        } else if (c == '\n') {
+            out += "\\n";
+        } else {
+            out += c;
+        }
+    }
+}
+
+inline void appendUnsigned(std::string& out, uint64_t value) {
+    char buf[24];
+    int n = std::snprintf(buf, sizeof(buf), "%llu", static_cast<unsigned long long>(value));
+    out.append(buf, static_cast<size_t>(n));
+}
+
+inline void appendSeconds(std::string& out, uint64_t nanos) {
+    char buf[32];
+    int n = std::snprintf(buf, sizeof(buf), "%.9g", static_cast<double>(nanos) / 1e9);
+    out.append(buf, static_cast<size_t>(n));
+}
+
+inline void appendHeader(std::string& out, const char* name, const char* type, const char* help) {
+    out += "# HELP ";
+    out += name;
+    out += ' ';
+    out += help;
+    out += "\n# TYPE ";
+    out += name;
+    out += ' ';
+    out += type;
+    out += '\n';
+}
+
+/**
+ * @brief 输出一行样本：name{label="value",...} value
+ * @param labels 已格式化的标签内容（不含花括号），为空时不输出标签
+ */
+inline void appendSample(std::string& out, const char* name, const std::string& labels, uint64_t value) {
+    out += name;
+    if (!labels.empty()) {
+        out += '{';
+        out += labels;
+        out += '}';
+    }
+    out += ' ';
+    appendUnsigned(out, value);
+    out += '\n';
+}
+
+} // namespace detail
+
+/**
+ * @brief 以 Prometheus 文本格式渲染指标
+ * @param manager 命令管理器
+ * @param server 提供准入统计的服务器，可以为空
+ * @param out 输出缓冲区，渲染结果追加在末尾
+ */
+inline void formatPrometheus(const CommandManager& manager, CommandServer* server, std::string& out) {
+    StatsSnapshot snapshot = manager.getStats();
+
+    detail::appendHeader(out, "ccm_command_calls_total", "counter", "Commands processed, by command and outcome.");
+    uint64_t failures = 0;
+    uint64_t exceptions = 0;
+    std::string labels;
+    for (const auto& c : snapshot.commands) {
+        const std::pair<const char*, uint64_t> outcomes[] = {
+            {"success", c.successes}, {"failure", c.failures}, {"exception", c.exceptions}};
+        for (const auto& o : outcomes) {
+            labels = "command=\"";
+            detail::appendLabelValue(labels, c.name);
+            labels += "\",outcome=\"";
+            labels += o.first;
+            labels += '"';
+            detail::appendSample(out, "ccm_command_calls_total", labels, o.second);
+        }
+        failures += c.failures;
+        exceptions += c.exceptions;
+    }
+
+    detail::appendHeader(out, "ccm_command_duration_seconds", "histogram", "Command latency, by command.");
+    for (const auto& c : snapshot.commands) {
+        std::string command = "command=\"";
+        detail::appendLabelValue(command, c.name);
+        command += '"';
+
+        // 直方图的桶按上界归入导出桶，跨越边界的桶计入更大的一档，不会低估延迟
+        uint64_t cumulative = 0;
+        size_t bucket = 0;
+        for (uint64_t bound : detail::METRICS_LATENCY_BOUNDS) {
+            for (; bucket < LatencyHistogram::BUCKET_COUNT &&
+                   LatencyHistogram::bucketUpperBound(bucket) <= bound; ++bucket) {
+                cumulative += c.latency.bucketCount(bucket);
+            }
+            labels = command;
+            labels += ",le=\"";
+            detail::appendSeconds(labels, bound);
+            labels += '"';
+            detail::appendSample(out, "ccm_command_duration_seconds_bucket", labels, cumulative);
+        }
+        detail::appendSample(out, "ccm_command_duration_seconds_bucket", command + ",le=\"+Inf\"",
+                             c.latency.count());
+        out += "ccm_command_duration_seconds_sum{";
+        out += command;
+        out += "} ";
+        detail::appendSeconds(out, c.latency.getSum());
+        out += '\n';
+        detail::appendSample(out, "ccm_command_duration_seconds_count", command, c.latency.count());
+    }
+
+    AdmissionStats admission;
+    if (server) {
+        admission = server->getAdmissionStats();
+    }
+
+    detail::appendHeader(out, "ccm_errors_total", "counter", "Errors, by type.");
+    const std::pair<const char*, uint64_t> errors[] = {
+        {"failure", failures},
+        {"exception", exceptions},
+        {"unknown_command", snapshot.unknownCommands},
+        {"rejected_connection_limit", admission.rejectedConnections},
+        {"rejected_rate", admission.rejectedRate},
+        {"rejected_client_limit", admission.rejectedClientLimit},
+        {"rejected_queue_full", admission.rejectedQueueFull},
+        {"rejected_queue_timeout", admission.rejectedQueueTimeout}};
+    for (const auto& e : errors) {
+        detail::appendSample(out, "ccm_errors_total", std::string("type=\"") + e.first + '"', e.second);
+    }
+
+    detail::appendHeader(out, "ccm_coalesced_requests_total", "counter",
+                         "Requests answered by joining an identical in-flight request.");
+    detail::appendSample(out, "ccm_coalesced_requests_total", "", manager.getCoalescedCount());
+
+    if (server) {
+        detail::appendHeader(out, "ccm_server_queue_depth", "gauge", "Requests waiting for a dispatch thread.");
+        detail::appendSample(out, "ccm_server_queue_depth", "", admission.queueDepth);
+        detail::appendHeader(out, "ccm_server_admitted_total", "counter", "Requests that passed admission control.");
+        detail::appendSample(out, "ccm_server_admitted_total", "", admission.admitted);
+        detail::appendHeader(out, "ccm_server_completed_total", "counter", "Admitted requests that finished executing.");
+        detail::appendSample(out, "ccm_server_completed_total", "", admission.completed);
+        detail::appendHeader(out, "ccm_server_queue_time_seconds_total", "counter", "Total time requests spent queued.");
+        out += "ccm_server_queue_time_seconds_total ";
+        detail::appendSeconds(out, admission.queueTimeTotalUs * 1000);
+        out += '\n';
+    }
+
+    detail::appendHeader(out, "ccm_registry_commands", "gauge", "Registered commands.");
+    detail::appendSample(out, "ccm_registry_commands", "", manager.getCommandCount());
+    detail::appendHeader(out, "ccm_registry_aliases", "gauge", "Registered command aliases.");
+    detail::appendSample(out, "ccm_registry_aliases", "", manager.getAliasCount());
+}
+
+/**
+ * @class MetricsExporter
+ * @brief 在后台线程中提供 HTTP 指标端点和/或定期写指标文件
+ */
+class MetricsExporter {
+private:
+    const CommandManager& manager;
+    MetricsConfig config;
+    std::atomic<CommandServer*> server{nullptr};
+
+    int listenFd = -1;
+    int stopPipe[2] = {-1, -1};       ///< 写入一个字节唤醒后台线程退出
+    uint16_t boundPort = 0;
+    std::thread worker;
+
+public:
+    MetricsExporter(const CommandManager& mgr, const MetricsConfig& cfg = MetricsConfig())
+        : manager(mgr), config(cfg) {}
+
+    ~MetricsExporter() { stop(); }
+
+    MetricsExporter(const MetricsExporter&) = delete;
+    MetricsExporter& operator=(const MetricsExporter&) = delete;
+
+    /**
+     * @brief 设置提供准入统计的服务器
+     * @param s 服务器，为空时不导出服务器指标；必须在导出器停止前保持有效
+     */
+    void setServer(CommandServer* s) {
+        server.store(s, std::memory_order_release);
+    }
+
+    /**
+     * @brief 获取实际监听的 TCP 端口
+     */
+    uint16_t port() const { return boundPort; }
+
+    /**
+     * @brief 渲染当前指标
+     */
+    std::string render() const {
+        std::string out;
+        out.reserve(16 * 1024);
+        formatPrometheus(manager, server.load(std::memory_order_acquire), out);
+        return out;
+    }
+
+    /**
+     * @brief 把当前指标原子地写入文件
+     * @param path 目标路径
+     * @param errorMsg 失败时的错误信息
+     * @return 成功返回true
+     * @details 先写同目录下的临时文件并 fsync，再 rename 覆盖目标文件
+     */
+    bool writeFile(const std::string& path, std::string& errorMsg) const {
+        std::string body = render();
+        std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            errorMsg = "无法创建 " + tmp + ": " + std::strerror(errno);
+            return false;
+        }
+        size_t offset = 0;
+        while (offset < body.size()) {
+            ssize_t n = ::write(fd, body.data() + offset, body.size() - offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                errorMsg = "写入 " + tmp + " 失败: " + std::strerror(errno);
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                return false;
+            }
+            offset += static_cast<size_t>(n);
+        }
+        ::fsync(fd);
+        ::close(fd);
+        if (::rename(tmp.c_str(), path.c_str()) < 0) {
+            errorMsg = "重命名为 " + path + " 失败: " + std::strerror(errno);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief 打开监听套接字并启动后台线程
+     * @param errorMsg 失败时的错误信息
+     * @return 成功返回true
+     */
+    bool start(std::string& errorMsg) {
+        if (worker.joinable()) {
+            errorMsg = "指标导出器已在运行";
+            return false;
+        }
+        if (config.port == 0 && config.unixPath.empty() && config.filePath.empty()) {
+            errorMsg = "未指定指标端口、Unix 套接字或文件";
+            return false;
+        }
+        if ((!config.unixPath.empty() || config.port != 0) && !openListener(errorMsg)) {
+            return false;
+        }
+        if (!config.filePath.empty() && !writeFile(config.filePath, errorMsg)) {
+            closeListener();
+            return false;
+        }
+        if (::pipe(stopPipe) < 0) {
+            errorMsg = std::string("创建管道失败: ") + std::strerror(errno);
+            closeListener();
+            return false;
+        }
+        worker = std::thread([this] { run(); });
+        return true;
+    }
+
+    /**
+     * @brief 停止后台线程并关闭监听套接字
+     */
+    void stop() {
+        if (worker.joinable()) {
+            char byte = 0;
+            while (::write(stopPipe[1], &byte, 1) < 0 && errno == EINTR) {}
+            worker.join();
+        }
+        for (int& fd : stopPipe) {
+            if (fd >= 0) ::close(fd);
+            fd = -1;
+        }
+        closeListener();
+    }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    void run() {
+        auto nextWrite = Clock::now() + std::chrono::milliseconds(config.fileIntervalMs);
+        for (;;) {
+            int timeout = -1;
+            if (!config.filePath.empty()) {
+                auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(nextWrite - Clock::now());
+                timeout = static_cast<int>(std::max<int64_t>(0, wait.count()));
+            }
+
+            pollfd fds[2] = {{stopPipe[0], POLLIN, 0}, {listenFd, POLLIN, 0}};
+            int rc = ::poll(fds, listenFd >= 0 ? 2 : 1, timeout);
+            if (rc < 0 && errno != EINTR) return;
+            if (fds[0].revents) return;
+
+            if (listenFd >= 0 && (fds[1].revents & POLLIN)) {
+                int client = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+                if (client >= 0) {
+                    serveClient(client);
+                    ::close(client);
+                }
+            }
+
+            if (!config.filePath.empty() && Clock::now() >= nextWrite) {
+                std::string error;
+                writeFile(config.filePath, error);
+                nextWrite = Clock::now() + std::chrono::milliseconds(config.fileIntervalMs);
+            }
+        }
+    }
+
+    /**
+     * @brief 读取一个 HTTP 请求头并返回指标，然后关闭连接
+     * @details 抓取请求很少，逐个串行处理；读写超时防止异常客户端阻塞后台线程
+     */
+    void serveClient(int fd) {
+        timeval tv{1, 0};
+        ::setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+        ::setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+
+        std::string request;
+        char buf[1024];
+        while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+            ssize_t n = ::recv(fd, buf, sizeof(buf), 0);
+            if (n <= 0) return;
+            request.append(buf, static_cast<size_t>(n));
+        }
+
+        std::string status = "200 OK";
+        std::string body;
+        if (request.compare(0, 4, "GET ") != 0) {
+            status = "405 Method Not Allowed";
+        } else if (request.compare(4, 9, "/metrics ") != 0 && request.compare(4, 2, "/ ") != 0) {
+            status = "404 Not Found";
+        } else {
+            body = render();
+        }
+
+        std::string response = "HTTP/1.1 " + status + "\r\n"
+            "Content-Type: text/plain; version=0.0.4; charset=utf-8\r\n"
+            "Content-Length: " + std::to_string(body.size()) + "\r\n"
+            "Connection: close\r\n\r\n" + body;
+        size_t offset = 0;
+        while (offset < response.size()) {
+            ssize_t n = ::send(fd, response.data() + offset, response.size() - offset, MSG_NOSIGNAL);
+            if (n <= 0) return;
+            offset += static_cast<size_t>(n);
+        }
+    }
+
+    bool openListener(std::string& errorMsg) {
+        bool useUnix = !config.unixPath.empty();
+        int fd = ::socket(useUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            errorMsg = std::string("创建套接字失败: ") + std::strerror(errno);
+            return false;
+        }
+
+        int rc;
+        if (useUnix) {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (config.unixPath.size() >= sizeof(addr.sun_path)) {
+                ::close(fd);
+                errorMsg = "Unix 套接字路径过长: " + config.unixPath;
+                return false;
+            }
+            std::memcpy(addr.sun_path, config.unixPath.c_str(), config.unixPath.size() + 1);
+            ::unlink(config.unixPath.c_str());
+            rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        } else {
+            int reuse = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(config.port);
+            if (::inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr) != 1) {
+                ::close(fd);
+                errorMsg = "无效的监听地址: " + config.host;
+                return false;
+            }
+            rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+
+        if (rc < 0 || ::listen(fd, 16) < 0) {
+            errorMsg = std::string("绑定指标地址失败: ") + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        if (!useUnix) {
+            sockaddr_in bound;
+            socklen_t len = sizeof(bound);
+            if (::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &len) == 0) {
+                boundPort = ntohs(bound.sin_port);
+            }
+        }
+        listenFd = fd;
+        return true;
+    }
+
+    void closeListener() {
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+            if (!config.unixPath.empty()) ::unlink(config.unixPath.c_str());
+        }
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_METRICS_H
@@ -0,0 +1,242 @@
+/**
+ * @file ConsoleCommandPerf.h
+ * @brief 基于 perf_event_open 的每线程硬件性能计数器
+ * @details CommandManager::Config::collectPerfCounters 开启后，命令执行前后各读取一次当前线程的计数器，
+ *          差值按命令累计到统计分片中，在 stats 输出中显示 IPC 和每千条指令的缓存/分支未命中数。
+ *
+ * 计数器：
+ * - 硬件事件组（周期数、指令数、缓存未命中、分支未命中），一次 read() 读出整组
+ * - 软件事件 task-clock（线程实际占用 CPU 的纳秒数），与墙钟延迟对比可以看出命令阻塞的时间
+ *
+ * 只统计用户态（exclude_kernel），在 perf_event_paranoid <= 2 时无需特权。
+ * 计数器在每个线程首次使用时打开；打不开的事件（非 Linux、容器禁用、虚拟机没有 PMU 等）
+ * 会被跳过，PerfCounters::status() 给出原因，其余事件照常统计。
+ */
+
+#ifndef CONSOLE_COMMAND_PERF_H
+#define CONSOLE_COMMAND_PERF_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+
+#ifdef __linux__
+#include <cerrno>
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ConsoleCommand {
+
+/**
+ * @brief 性能计数器事件位
+ */
+enum PerfEvent : uint32_t {
+    PERF_TASK_CLOCK = 1u << 0,      ///< 线程CPU时间（纳秒）
+    PERF_CYCLES = 1u << 1,          ///< CPU周期数
+    PERF_INSTRUCTIONS = 1u << 2,    ///< 退休指令数
+    PERF_CACHE_MISSES = 1u << 3,    ///< 末级缓存未命中
+    PERF_BRANCH_MISSES = 1u << 4    ///< 分支预测失败
+};
+
+/**
+ * @struct PerfSample
+ * @brief 一组计数器读数或两次读数的差值
+ */
+struct PerfSample {
+    uint32_t events = 0;            ///< 有效事件的位掩码（PerfEvent）
+    uint64_t taskClockNanos = 0;    ///< 线程CPU时间（纳秒）
+    uint64_t cycles = 0;            ///< CPU周期数
+    uint64_t instructions = 0;      ///< 退休指令数
+    uint64_t cacheMisses = 0;       ///< 缓存未命中数
+    uint64_t branchMisses = 0;      ///< 分支预测失败数
+
+    /**
+     * @brief 计算从 earlier 到本读数的差值
+     */
+    PerfSample since(const PerfSample& earlier) const {
+        PerfSample d;
+        d.events = events & earlier.events;
+        d.taskClockNanos = taskClockNanos - earlier.taskClockNanos;
+        d.cycles = cycles - earlier.cycles;
+        d.instructions = instructions - earlier.instructions;
+        d.cacheMisses = cacheMisses - earlier.cacheMisses;
+        d.branchMisses = branchMisses - earlier.branchMisses;
+        return d;
+    }
+};
+
+/**
+ * @class PerfCounters
+ * @brief 当前线程的性能计数器
+ */
+class PerfCounters {
+private:
+    int groupFd = -1;                   ///< 硬件事件组的组长
+    int siblingFds[3] = {-1, -1, -1};   ///< 组内其余硬件事件
+    int taskClockFd = -1;               ///< 软件事件 task-clock
+    uint32_t hardwareEvents = 0;        ///< 组内事件的位掩码
+    uint32_t hardwareOrder[4] = {};     ///< 组内事件按打开顺序排列，对应 read() 返回值的顺序
+    uint32_t hardwareCount = 0;
+
+public:
+    PerfCounters() { open(); }
+
+    ~PerfCounters() {
+#ifdef __linux__
+        if (groupFd >= 0) ::close(groupFd);
+        if (taskClockFd >= 0) ::close(taskClockFd);
+        for (int fd : siblingFds) {
+            if (fd >= 0) ::close(fd);
+        }
+#endif
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    /**
+     * @brief 获取当前线程的计数器，首次调用时打开
+     */
+    static PerfCounters& local() {
+        thread_local PerfCounters counters;
+        return counters;
+    }
+
+    /**
+     * @brief 本线程可用的事件位掩码
+     */
+    uint32_t events() const {
+        return hardwareEvents | (taskClockFd >= 0 ? PERF_TASK_CLOCK : 0u);
+    }
+
+    /**
+     * @brief 读取当前计数值
+     * @param out 读数，out.events 标明哪些字段有效
+     * @return 至少有一个事件可用时返回true
+     */
+    bool read(PerfSample& out) const {
+        out = PerfSample();
+#ifdef __linux__
+        if (taskClockFd >= 0) {
+            uint64_t value = 0;
+            if (::read(taskClockFd, &value, sizeof(value)) == static_cast<ssize_t>(sizeof(value))) {
+                out.taskClockNanos = value;
+                out.events |= PERF_TASK_CLOCK;
+            }
+        }
+        if (groupFd >= 0) {
+            // PERF_FORMAT_GROUP: { nr, values[nr] }
+            uint64_t buf[1 + 4];
+            ssize_t expected = static_cast<ssize_t>(sizeof(uint64_t) * (1 + hardwareCount));
+            if (::read(groupFd, buf, sizeof(buf)) == expected) {
+                for (uint32_t i = 0; i < hardwareCount; ++i) {
+                    uint64_t value = buf[1 + i];
+                    switch (hardwareOrder[i]) {
+                        case PERF_CYCLES:        out.cycles = value; break;
+                        case PERF_INSTRUCTIONS:  out.instructions = value; break;
+                        case PERF_CACHE_MISSES:  out.cacheMisses = value; break;
+                        case PERF_BRANCH_MISSES: out.branchMisses = value; break;
+                        default: break;
+                    }
+                }
+                out.events |= hardwareEvents;
+            }
+        }
+#endif
+        return out.events != 0;
+    }
+
+    /**
+     * @brief 进程内所有线程打开过的事件的并集
+     */
+    static uint32_t availableEvents() {
+        return globalState().available.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 计数器状态说明，例如哪些事件不可用及原因
+     * @return 尚未有线程打开计数器时返回空字符串
+     */
+    static std::string status() {
+        GlobalState& g = globalState();
+        std::lock_guard<std::mutex> lock(g.mutex);
+        return g.status;
+    }
+
+private:
+#ifdef __linux__
+    static int openEvent(uint32_t type, uint64_t config, int groupLeader, bool group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.type = type;
+        attr.size = sizeof(attr);
+        attr.config = config;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        if (group) attr.read_format = PERF_FORMAT_GROUP;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, groupLeader, PERF_FLAG_FD_CLOEXEC));
+    }
+#endif
+
+    void open() {
+        std::string problem;
+#ifdef __linux__
+        taskClockFd = openEvent(PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK, -1, false);
+        if (taskClockFd < 0) {
+            problem = std::string("task-clock: ") + std::strerror(errno);
+        }
+
+        const struct { uint32_t bit; uint64_t config; const char* name; } hardware[] = {
+            {PERF_CYCLES, PERF_COUNT_HW_CPU_CYCLES, "cycles"},
+            {PERF_INSTRUCTIONS, PERF_COUNT_HW_INSTRUCTIONS, "instructions"},
+            {PERF_CACHE_MISSES, PERF_COUNT_HW_CACHE_MISSES, "cache-misses"},
+            {PERF_BRANCH_MISSES, PERF_COUNT_HW_BRANCH_MISSES, "branch-misses"},
+        };
+        for (const auto& h : hardware) {
+            int fd = openEvent(PERF_TYPE_HARDWARE, h.config, groupFd, true);
+            if (fd < 0) {
+                if (!problem.empty()) problem += "; ";
+                problem += std::string(h.name) + ": " + std::strerror(errno);
+                continue;
+            }
+            if (groupFd < 0) {
+                groupFd = fd;
+            } else {
+                siblingFds[hardwareCount - 1] = fd;
+            }
+            hardwareOrder[hardwareCount++] = h.bit;
+            hardwareEvents |= h.bit;
+        }
+#else
+        problem = "perf_event_open 仅在 Linux 上可用";
+#endif
+
+        GlobalState& g = globalState();
+        g.available.fetch_or(events(), std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(g.mutex);
+        if (!g.reported) {
+            g.reported = true;
+            g.status = problem.empty() ? "全部事件可用" : "不可用的事件: " + problem;
+        }
+    }
+
+    struct GlobalState {
+        std::atomic<uint32_t> available{0};
+        std::mutex mutex;
+        bool reported = false;
+        std::string status;
+    };
+
+    static GlobalState& globalState() {
+        static GlobalState g;
+        return g;
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_PERF_H
@@ -0,0 +1,364 @@
+/**
+ * @file ConsoleCommandProtocol.h
+ * @brief 预分词的二进制线路协议
+ * @details 远程调用者已经知道命令名称和各个参数，把它们拼成字符串再交给
+ *          CommandContext::parseString 重新分词是多余的。本文件定义一种长度前缀的
+ *          二进制帧，解码时直接填充 CommandContext，不经过任何分词步骤。
+ *
+ * 请求帧格式（所有整数均为小端序）：
+ * @code
+ * u32  帧体长度（不含本字段）
+ * u8   版本号，当前为 1
+ * u8   命令标识方式：0 = 名称，1 = 命令ID
+ * 名称: u16 长度 + 字节    或    ID: u32 命令ID（见 CommandManager::getCommandId）
+ * u16  位置参数个数，每个为 u32 长度 + 字节
+ * u16  选项个数，每个为 u16 键长度 + 键 + u32 值长度 + 值
+ * u16  标志个数，每个为 u16 长度 + 字节
+ * @endcode
+ *
+ * 响应帧格式：
+ * @code
+ * u32  帧体长度（不含本字段）
+ * u8   状态：0 = 成功，1 = 失败，2 = 服务器繁忙（请求未执行）
+ * 其余 输出内容
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_PROTOCOL_H
+#define CONSOLE_COMMAND_PROTOCOL_H
+
+#include "ConsoleCommandManager.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace ConsoleCommand {
+
+// ============================================================================
+// 协议常量
+// ============================================================================
+
+const uint8_t WIRE_VERSION = 1;              ///< 当前协议版本
+const uint8_t WIRE_BY_NAME = 0;              ///< 以名称标识命令
+const uint8_t WIRE_BY_ID = 1;                ///< 以ID标识命令
+const uint8_t WIRE_STATUS_OK = 0;            ///< 执行成功
+const uint8_t WIRE_STATUS_FAIL = 1;          ///< 执行失败
+const uint8_t WIRE_STATUS_BUSY = 2;          ///< 服务器繁忙，请求被拒绝且未执行
+const size_t WIRE_HEADER_SIZE = 4;           ///< 长度前缀字节数
+const uint32_t WIRE_DEFAULT_MAX_FRAME = 1024 * 1024;  ///< 默认最大帧体长度
+
+/**
+ * @enum DecodeStatus
+ * @brief 帧解码结果
+ */
+enum class DecodeStatus {
+    Ok,          ///< 成功解码一个完整帧
+    NeedMore,    ///< 数据不足，需要继续接收
+    Malformed    ///< 帧格式错误，连接应被关闭
+};
+
+/**
+ * @struct WireRequest
+ * @brief 编码端使用的请求描述
+ * @details commandId 不为 INVALID_COMMAND_ID 时按ID编码，否则按名称编码
+ */
+struct WireRequest {
+    uint32_t commandId = INVALID_COMMAND_ID;  ///< 命令ID
+    std::string commandName;                  ///< 命令名称
+    std::vector<std::string> args;            ///< 位置参数
+    std::vector<std::pair<std::string, std::string>> options;  ///< 选项键值对
+    std::vector<std::string> flags;           ///< 标志选项
+};
+
+// ============================================================================
+// 内部读写辅助
+// ============================================================================
+
+namespace detail {
+
+inline void putU16(std::string& out, uint16_t v) {
+    out += static_cast<char>(v & 0xff);
+    out += static_cast<char>((v >> 8) & 0xff);
+}
+
+inline void putU32(std::string& out, uint32_t v) {
+    out += static_cast<char>(v & 0xff);
+    out += static_cast<char>((v >> 8) & 0xff);
+    out += static_cast<char>((v >> 16) & 0xff);
+    out += static_cast<char>((v >> 24) & 0xff);
+}
+
+inline uint32_t loadU32(const unsigned char* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/**
+ * @brief 带边界检查的帧体读取器
+ */
+class FrameReader {
+private:
+    const unsigned char* cur;
+    const unsigned char* end;
+
+public:
+    FrameReader(const char* data, size_t size)
+        : cur(reinterpret_cast<const unsigned char*>(data)),
+          end(reinterpret_cast<const unsigned char*>(data) + size) {}
+
+    bool u8(uint8_t& v) {
+        if (end - cur < 1) return false;
+        v = *cur++;
+        return true;
+    }
+
+    bool u16(uint16_t& v) {
+        if (end - cur < 2) return false;
+        v = static_cast<uint16_t>(cur[0] | (cur[1] << 8));
+        cur += 2;
+        return true;
+    }
+
+    bool u32(uint32_t& v) {
+        if (end - cur < 4) return false;
+        v = loadU32(cur);
+        cur += 4;
+        return true;
+    }
+
+    bool bytes(size_t len, std::string& v) {
+        if (static_cast<size_t>(end - cur) < len) return false;
+        v.assign(reinterpret_cast<const char*>(cur), len);
+        cur += len;
+        return true;
+    }
+
+    bool done() const { return cur == end; }
+};
+
+} // namespace detail
+
+// ============================================================================
+// 编码
+// ============================================================================
+
+/**
+ * @brief 把请求编码为帧并追加到缓冲区
+ * @param req 请求描述
+ * @param out 输出缓冲区
+ * @return 成功返回true，字段长度超出格式限制时返回false且不修改缓冲区
+ */
+inline bool encodeRequest(const WireRequest& req, std::string& out) {
+    const size_t u16Max = 0xffff;
+    if (req.args.size() > u16Max || req.options.size() > u16Max || req.flags.size() > u16Max ||
+        req.commandName.size() > u16Max) {
+        return false;
+    }
+
+    size_t body = 2 + (req.commandId != INVALID_COMMAND_ID ? 4 : 2 + req.commandName.size()) + 6;
+    for (const auto& a : req.args) body += 4 + a.size();
+    for (const auto& o : req.options) {
+        if (o.first.size() > u16Max) return false;
+        body += 2 + o.first.size() + 4 + o.second.size();
+    }
+    for (const auto& f : req.flags) {
+        if (f.size() > u16Max) return false;
+        body += 2 + f.size();
+    }
+    if (body > 0xffffffffu) return false;
+
+    out.reserve(out.size() + WIRE_HEADER_SIZE + body);
+    detail::putU32(out, static_cast<uint32_t>(body));
+    out += static_cast<char>(WIRE_VERSION);
+
+    if (req.commandId != INVALID_COMMAND_ID) {
+        out += static_cast<char>(WIRE_BY_ID);
+        detail::putU32(out, req.commandId);
+    } else {
+        out += static_cast<char>(WIRE_BY_NAME);
+        detail::putU16(out, static_cast<uint16_t>(req.commandName.size()));
+        out += req.commandName;
+    }
+
+    detail::putU16(out, static_cast<uint16_t>(req.args.size()));
+    for (const auto& a : req.args) {
+        detail::putU32(out, static_cast<uint32_t>(a.size()));
+        out += a;
+    }
+
+    detail::putU16(out, static_cast<uint16_t>(req.options.size()));
+    for (const auto& o : req.options) {
+        detail::putU16(out, static_cast<uint16_t>(o.first.size()));
+        out += o.first;
+        detail::putU32(out, static_cast<uint32_t>(o.second.size()));
+        out += o.second;
+    }
+
+    detail::putU16(out, static_cast<uint16_t>(req.flags.size()));
+    for (const auto& f : req.flags) {
+        detail::putU16(out, static_cast<uint16_t>(f.size()));
+        out += f;
+    }
+    return true;
+}
+
+/**
+ * @brief 把指定状态的响应帧追加到缓冲区
+ * @param status 状态码（WIRE_STATUS_*）
+ * @param body 响应内容
+ * @param out 输出缓冲区
+ */
+inline void encodeResponse(uint8_t status, const std::string& body, std::string& out) {
+    out.reserve(out.size() + WIRE_HEADER_SIZE + 1 + body.size());
+    detail::putU32(out, static_cast<uint32_t>(body.size() + 1));
+    out += static_cast<char>(status);
+    out += body;
+}
+
+/**
+ * @brief 把执行结果编码为响应帧并追加到缓冲区
+ * @param success 命令是否执行成功
+ * @param body 命令输出
+ * @param out 输出缓冲区
+ */
+inline void encodeResponse(bool success, const std::string& body, std::string& out) {
+    encodeResponse(success ? WIRE_STATUS_OK : WIRE_STATUS_FAIL, body, out);
+}
+
+// ============================================================================
+// 解码
+// ============================================================================
+
+/**
+ * @brief 从缓冲区解码一个请求帧，直接填充命令上下文
+ * @param data 缓冲区起始地址
+ * @param size 缓冲区中的可用字节数
+ * @param consumed 输出参数，成功时为该帧占用的总字节数
+ * @param context 输出参数，解码得到的命令上下文（调用前应为空）
+ * @param manager 用于把命令ID解析为名称的管理器
+ * @param errorMsg 输出参数，格式错误时的描述
+ * @param maxFrame 允许的最大帧体长度
+ * @return 解码状态
+ */
+inline DecodeStatus decodeRequest(const char* data, size_t size, size_t& consumed,
+                                  CommandContext& context, const CommandManager& manager,
+                                  std::string& errorMsg,
+                                  uint32_t maxFrame = WIRE_DEFAULT_MAX_FRAME) {
+    if (size < WIRE_HEADER_SIZE) return DecodeStatus::NeedMore;
+
+    uint32_t bodyLen = detail::loadU32(reinterpret_cast<const unsigned char*>(data));
+    if (bodyLen > maxFrame) {
+        errorMsg = "帧长度超出限制: " + std::to_string(bodyLen);
+        return DecodeStatus::Malformed;
+    }
+    if (size - WIRE_HEADER_SIZE < bodyLen) return DecodeStatus::NeedMore;
+
+    detail::FrameReader reader(data + WIRE_HEADER_SIZE, bodyLen);
+    auto malformed = [&errorMsg](const char* what) {
+        errorMsg = std::string("帧格式错误: ") + what;
+        return DecodeStatus::Malformed;
+    };
+
+    uint8_t version = 0, kind = 0;
+    if (!reader.u8(version) || version != WIRE_VERSION) return malformed("不支持的版本");
+    if (!reader.u8(kind)) return malformed("缺少命令标识");
+
+    std::string name;
+    if (kind == WIRE_BY_ID) {
+        uint32_t id = 0;
+        if (!reader.u32(id)) return malformed("命令ID截断");
+        const PooledString* resolved = manager.getCommandNameById(id);
+        if (!resolved) {
+            // 未知ID交给processCommand按未知命令处理
+            name = "#" + std::to_string(id);
+        } else {
+            name = *resolved;
+        }
+    } else if (kind == WIRE_BY_NAME) {
+        uint16_t len = 0;
+        if (!reader.u16(len) || !reader.bytes(len, name)) return malformed("命令名称截断");
+    } else {
+        return malformed("未知的命令标识方式");
+    }
+    context.setCommandName(name);
+
+    uint16_t count = 0;
+    if (!reader.u16(count)) return malformed("参数个数截断");
+    for (uint16_t i = 0; i < count; ++i) {
+        uint32_t len = 0;
+        std::string arg;
+        if (!reader.u32(len) || !reader.bytes(len, arg)) return malformed("参数截断");
+        context.addArgument(std::move(arg));
+    }
+
+    if (!reader.u16(count)) return malformed("选项个数截断");
+    for (uint16_t i = 0; i < count; ++i) {
+        uint16_t keyLen = 0;
+        uint32_t valueLen = 0;
+        std::string key, value;
+        if (!reader.u16(keyLen) || !reader.bytes(keyLen, key) ||
+            !reader.u32(valueLen) || !reader.bytes(valueLen, value)) {
+            return malformed("选项截断");
+        }
+        context.setOption(std::move(key), std::move(value));
+    }
+
+    if (!reader.u16(count)) return malformed("标志个数截断");
+    for (uint16_t i = 0; i < count; ++i) {
+        uint16_t len = 0;
+        std::string flag;
+        if (!reader.u16(len) || !reader.bytes(len, flag)) return malformed("标志截断");
+        context.setFlag(flag);
+    }
+
+    if (!reader.done()) return malformed("帧尾部有多余数据");
+
+    consumed = WIRE_HEADER_SIZE + bodyLen;
+    return DecodeStatus::Ok;
+}
+
+/**
+ * @brief 从缓冲区解码一个响应帧
+ * @param data 缓冲区起始地址
+ * @param size 缓冲区中的可用字节数
+ * @param consumed 输出参数，成功时为该帧占用的总字节数
+ * @param status 输出参数，响应状态码（WIRE_STATUS_*）
+ * @param body 输出参数，命令输出
+ * @return 解码状态
+ */
+inline DecodeStatus decodeResponse(const char* data, size_t size, size_t& consumed,
+                                   uint8_t& status, std::string& body) {
+    if (size < WIRE_HEADER_SIZE) return DecodeStatus::NeedMore;
+
+    uint32_t bodyLen = detail::loadU32(reinterpret_cast<const unsigned char*>(data));
+    if (bodyLen < 1) return DecodeStatus::Malformed;
+    if (size - WIRE_HEADER_SIZE < bodyLen) return DecodeStatus::NeedMore;
+
+    status = static_cast<uint8_t>(data[WIRE_HEADER_SIZE]);
+    body.assign(data + WIRE_HEADER_SIZE + 1, bodyLen - 1);
+    consumed = WIRE_HEADER_SIZE + bodyLen;
+    return DecodeStatus::Ok;
+}
+
+/**
+ * @brief 从缓冲区解码一个响应帧（只关心是否成功）
+ * @param data 缓冲区起始地址
+ * @param size 缓冲区中的可用字节数
+ * @param consumed 输出参数，成功时为该帧占用的总字节数
+ * @param success 输出参数，命令是否执行成功
+ * @param body 输出参数，命令输出
+ * @return 解码状态
+ */
+inline DecodeStatus decodeResponse(const char* data, size_t size, size_t& consumed,
+                                   bool& success, std::string& body) {
+    uint8_t status = WIRE_STATUS_FAIL;
+    DecodeStatus result = decodeResponse(data, size, consumed, status, body);
+    success = status == WIRE_STATUS_OK;
+    return result;
+}
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_PROTOCOL_H
@@ -0,0 +1,1438 @@
+/**
+ * @file ConsoleCommandServer.h
+ * @brief 命令服务器
+ * @details 将 CommandManager 通过本地套接字（TCP 回环地址或 Unix 域套接字）提供给远程调用者。
+ *          每个请求是一行命令文本，服务器解析后交给 CommandManager::processCommand 执行，
+ *          并把执行期间的输出作为响应返回。
+ *
+ * 支持三种 I/O 后端：
+ * 1. Blocking：每个连接一个线程，使用阻塞读写，适用于任何 POSIX 系统
+ * 2. Epoll：单线程事件循环，非阻塞套接字 + epoll（仅 Linux）
+ * 3. IoUring：单线程事件循环，accept/recv/send 批量提交到 io_uring（仅 Linux 5.7+）
+ *
+ * Auto 模式按 IoUring -> Epoll -> Blocking 的顺序选择第一个可用的后端。
+ *
+ * 支持两种协议（ServerConfig::protocol）：
+ * - Line（默认）：
+ *   - 请求：一行命令文本，以 '\\n' 结束（允许 "\\r\\n"）
+ *   - 响应：状态行 "<STATUS> <长度>\\n" 后跟指定长度的输出内容，
+ *           STATUS 为 OK（执行成功）、FAIL（执行失败）或 BUSY（过载，请求未执行）
+ * - Binary：长度前缀的预分词帧，格式见 ConsoleCommandProtocol.h
+ * - Http：HTTP/1.1 JSON 网关，POST /cmd/<命令名>，格式见 ConsoleCommandHttp.h
+ *
+ * 准入控制（由 CommandManager::Config 配置，在 start() 时读取）：
+ * - 同时连接的客户端数超过 maxClients 时新连接被立即关闭
+ * - dispatchThreads > 0 时命令在有界的工作线程池中执行，I/O 线程只负责收发；
+ *   等待工作线程的请求超过 maxQueueDepth 时新请求直接返回 BUSY
+ * - 每个客户端（连接）排队和执行中的请求数不超过 maxPendingPerClient，
+ *   并可通过 clientRateLimit/clientRateBurst 限制请求速率
+ * - 排队时间超过 maxQueueTimeMs 的请求不再执行，直接返回 BUSY
+ * - 同一连接的请求按顺序执行并按顺序响应，保证会话状态不被并发修改
+ *
+ * 使用示例：
+ * @code
+ * auto manager = ConsoleCommand::createManager();
+ * ConsoleCommand::ServerConfig cfg;
+ * cfg.port = 9000;
+ * ConsoleCommand::CommandServer server(manager, cfg);
+ * std::string error;
+ * if (server.start(error)) {
+ *     server.run();  // 阻塞，直到其他线程调用 server.stop()
+ * }
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_SERVER_H
+#define CONSOLE_COMMAND_SERVER_H
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandIoUring.h"
+#include "ConsoleCommandProtocol.h"
+#include "ConsoleCommandHttp.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <functional>
+#include <future>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+
+namespace ConsoleCommand {
+
+// ============================================================================
+// 服务器配置
+// ============================================================================
+
+/**
+ * @enum ServerBackend
+ * @brief 服务器 I/O 后端
+ */
+enum class ServerBackend {
+    Auto,       ///< 自动选择可用的最佳后端
+    Blocking,   ///< 每连接一个线程的阻塞 I/O
+    Epoll,      ///< epoll 事件循环（仅 Linux）
+    IoUring     ///< io_uring 事件循环（仅 Linux）
+};
+
+/**
+ * @brief 获取后端名称
+ * @param backend 后端枚举值
+ * @return 后端名称字符串
+ */
+inline const char* backendName(ServerBackend backend) {
+    switch (backend) {
+        case ServerBackend::Auto:     return "auto";
+        case ServerBackend::Blocking: return "blocking";
+        case ServerBackend::Epoll:    return "epoll";
+        case ServerBackend::IoUring:  return "uring";
+    }
+    return "unknown";
+}
+
+/**
+ * @brief 从名称解析后端
+ * @param name 后端名称（auto/blocking/epoll/uring）
+ * @param backend 输出参数，解析结果
+ * @return 名称有效返回true，否则返回false
+ */
+inline bool parseBackend(const std::string& name, ServerBackend& backend) {
+    if (name == "auto") backend = ServerBackend::Auto;
+    else if (name == "blocking") backend = ServerBackend::Blocking;
+    else if (name == "epoll") backend = ServerBackend::Epoll;
+    else if (name == "uring" || name == "io_uring") backend = ServerBackend::IoUring;
+    else return false;
+    return true;
+}
+
+/**
+ * @enum ServerProtocol
+ * @brief 服务器请求协议
+ */
+enum class ServerProtocol {
+    Line,       ///< 按行分隔的命令文本
+    Binary,     ///< 长度前缀的二进制帧
+    Http        ///< HTTP/1.1 JSON 网关
+};
+
+/**
+ * @struct ServerConfig
+ * @brief 命令服务器配置
+ */
+struct ServerConfig {
+    std::string host = "127.0.0.1";        ///< TCP 监听地址，默认只监听回环地址
+    uint16_t port = 0;                     ///< TCP 端口，0 表示由系统分配
+    std::string unixPath;                  ///< Unix 域套接字路径，非空时优先于 TCP
+    ServerBackend backend = ServerBackend::Auto;  ///< I/O 后端
+    ServerProtocol protocol = ServerProtocol::Line;  ///< 请求协议
+    int backlog = 128;                     ///< 监听队列长度
+    unsigned ringEntries = 256;            ///< io_uring 提交队列深度
+    size_t recvBufferSize = 16 * 1024;     ///< 每次接收的缓冲区大小
+    size_t maxRequestSize = 64 * 1024;     ///< 单个请求的最大长度
+};
+
+/**
+ * @enum ResponseStatus
+ * @brief 服务器响应状态
+ */
+enum class ResponseStatus {
+    Ok,         ///< 命令执行成功
+    Fail,       ///< 命令执行失败
+    Busy        ///< 服务器过载，请求未执行
+};
+
+/**
+ * @struct AdmissionStats
+ * @brief 准入控制统计快照
+ */
+struct AdmissionStats {
+    uint64_t admitted = 0;              ///< 通过准入检查的请求数
+    uint64_t completed = 0;             ///< 执行完成的请求数
+    uint64_t rejectedConnections = 0;   ///< 因客户端连接数上限被关闭的连接数
+    uint64_t rejectedRate = 0;          ///< 因客户端速率限制被拒绝的请求数
+    uint64_t rejectedClientLimit = 0;   ///< 因客户端并发上限被拒绝的请求数
+    uint64_t rejectedQueueFull = 0;     ///< 因队列已满被拒绝的请求数
+    uint64_t rejectedQueueTimeout = 0;  ///< 因排队超时被丢弃的请求数
+    uint64_t queueTimeTotalUs = 0;      ///< 所有已执行请求的排队时间总和（微秒）
+    uint64_t queueTimeMaxUs = 0;        ///< 最长排队时间（微秒）
+    size_t queueDepth = 0;              ///< 当前等待工作线程的请求数
+};
+
+// ============================================================================
+// 工作线程池
+// ============================================================================
+
+/**
+ * @class DispatchPool
+ * @brief 有界队列的固定大小线程池
+ *
+ * 队列已满时 trySubmit() 立即失败而不是阻塞，调用者据此返回 BUSY。
+ * 析构时丢弃尚未开始的任务并等待正在执行的任务结束。
+ */
+class DispatchPool {
+private:
+    std::mutex mutex;
+    std::condition_variable ready;
+    std::deque<std::function<void()>> tasks;
+    std::vector<std::thread> workers;
+    size_t capacity;
+    bool stopping = false;
+
+public:
+    /**
+     * @brief 构造函数
+     * @param threads 工作线程数
+     * @param maxQueue 队列容量
+     */
+    DispatchPool(size_t threads, size_t maxQueue) : capacity(maxQueue) {
+        for (size_t i = 0; i < threads; ++i) {
+            workers.emplace_back([this] { workerLoop(); });
+        }
+    }
+
+    ~DispatchPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+            tasks.clear();
+        }
+        ready.notify_all();
+        for (auto& t : workers) t.join();
+    }
+
+    DispatchPool(const DispatchPool&) = delete;
+    DispatchPool& operator=(const DispatchPool&) = delete;
+
+    /**
+     * @brief 尝试提交任务
+     * @param task 任务
+     * @return 队列未满返回true，否则返回false且任务不会执行
+     */
+    bool trySubmit(std::function<void()> task) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (stopping || tasks.size() >= capacity) return false;
+            tasks.push_back(std::move(task));
+        }
+        ready.notify_one();
+        return true;
+    }
+
+    /**
+     * @brief 获取当前排队的任务数
+     * @return 队列长度
+     */
+    size_t depth() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return tasks.size();
+    }
+
+private:
+    void workerLoop() {
+        while (true) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+                if (stopping) return;
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+            task();
+        }
+    }
+};
+
+/**
+ * @struct TokenBucket
+ * @brief 客户端请求速率令牌桶
+ */
+struct TokenBucket {
+    double tokens = -1.0;   ///< 当前令牌数，负数表示尚未初始化
+    std::chrono::steady_clock::time_point last;  ///< 上次补充令牌的时间
+
+    /**
+     * @brief 尝试取走一个令牌
+     * @param rate 每秒补充的令牌数
+     * @param burst 桶容量
+     * @param now 当前时间
+     * @return 有令牌返回true
+     */
+    bool take(double rate, double burst, std::chrono::steady_clock::time_point now) {
+        if (tokens < 0.0) {
+            tokens = burst;
+            last = now;
+        }
+        double elapsed = std::chrono::duration<double>(now - last).count();
+        tokens = std::min(burst, tokens + elapsed * rate);
+        last = now;
+        if (tokens < 1.0) return false;
+        tokens -= 1.0;
+        return true;
+    }
+};
+
+// ============================================================================
+// 命令服务器类
+// ============================================================================
+
+/**
+ * @class CommandServer
+ * @brief 命令服务器
+ *
+ * 在本地套接字上接受连接，按行读取命令并交给 CommandManager 执行。
+ * 命令的标准输出和错误输出都通过 CommandContext::setOutput 捕获到响应中。
+ * 每个连接拥有独立的 Session，所有连接共享同一个命令注册表。
+ *
+ * @note 不同连接的命令可能在多个线程中并发执行，注册的执行器需要是线程安全的；
+ *       服务器运行期间不应再注册命令
+ */
+class CommandServer {
+private:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 已解析、等待执行的请求
+     */
+    struct Request {
+        CommandContext context;               ///< 解析得到的命令上下文
+        bool rejected = false;                ///< 是否已在解析或准入时被拒绝
+        ResponseStatus rejectStatus = ResponseStatus::Busy;  ///< 被拒绝时的响应状态
+        std::string rejectReason;             ///< 拒绝原因
+        unsigned httpStatus = 0;              ///< 请求本身有误时的 HTTP 状态码
+        bool keepAlive = true;                ///< HTTP 响应后是否保持连接
+    };
+
+    /**
+     * @brief 连接状态
+     */
+    struct Connection {
+        uint64_t id = 0;             ///< 连接ID
+        int fd = -1;                 ///< 客户端套接字
+        std::string input;           ///< 尚未解析的输入
+        std::string output;          ///< 待发送的输出
+        size_t outputOffset = 0;     ///< 已发送的字节数
+        bool closing = false;        ///< 对端已关闭或出错，处理完已接收的请求后关闭
+        bool dead = false;           ///< 套接字已不可写，完成后立即关闭
+        Session session;             ///< 该连接的会话状态（工作目录、变量、设置）
+
+        // 准入控制
+        std::deque<Request> backlog; ///< 按到达顺序排列的请求
+        size_t pending = 0;          ///< 已准入但尚未完成的请求数
+        bool executing = false;      ///< 是否有请求正在工作线程中执行
+        bool readPaused = false;     ///< 积压过多时暂停读取
+        TokenBucket bucket;          ///< 速率令牌桶
+
+        // io_uring 后端专用
+        std::vector<char> recvBuffer; ///< 接收缓冲区
+        std::string sending;          ///< 正在发送的缓冲区，完成前不能修改
+        size_t sendingOffset = 0;     ///< 已发送的字节数
+        bool recvPending = false;     ///< 是否有未完成的 recv
+        bool sendPending = false;     ///< 是否有未完成的 send
+    };
+
+    /**
+     * @brief 工作线程执行完成的结果
+     */
+    struct Completion {
+        uint64_t connId;
+        std::string response;
+    };
+
+    CommandManager& manager;         ///< 执行命令的管理器
+    ServerConfig config;             ///< 服务器配置
+    CommandManager::Config limits;   ///< 启动时读取的准入控制配置
+    int listenFd = -1;               ///< 监听套接字
+    int wakeFd = -1;                 ///< 用于唤醒事件循环的 eventfd
+    uint16_t boundPort = 0;          ///< 实际绑定的端口
+    ServerBackend active = ServerBackend::Blocking;  ///< 实际使用的后端
+    std::atomic<bool> stopping{false};  ///< 停止标志
+
+    // 工作线程池及其完成队列；pool 只由运行 run() 的线程修改，
+    // 其他线程读取时持有 poolMutex，线程池在解除关联后才析构
+    std::atomic<DispatchPool*> pool{nullptr};
+    std::mutex poolMutex;
+    std::mutex completionsMutex;
+    std::vector<Completion> completions;
+
+    // 准入统计
+    std::atomic<uint64_t> statAdmitted{0};
+    std::atomic<uint64_t> statRejectedConnection{0};
+    std::atomic<uint64_t> statCompleted{0};
+    std::atomic<uint64_t> statRejectedRate{0};
+    std::atomic<uint64_t> statRejectedClient{0};
+    std::atomic<uint64_t> statRejectedQueue{0};
+    std::atomic<uint64_t> statRejectedTimeout{0};
+    std::atomic<uint64_t> statQueueTimeTotal{0};
+    std::atomic<uint64_t> statQueueTimeMax{0};
+
+    /**
+     * @brief Blocking 后端的客户端线程
+     */
+    struct ClientThread {
+        std::thread thread;
+        bool finished = false;  ///< 连接已关闭，线程可以回收（由 clientsMutex 保护）
+    };
+
+    // Blocking 后端的客户端线程
+    std::mutex clientsMutex;
+    std::vector<int> clientFds;
+    std::list<ClientThread> clientThreads;
+
+    static constexpr uint64_t LISTEN_ID = 0;  ///< epoll 中监听套接字的标识
+    static constexpr uint64_t WAKE_ID = 1;    ///< epoll 中唤醒描述符的标识
+
+public:
+    /**
+     * @brief 构造函数
+     * @param mgr 命令管理器，生命周期必须长于服务器
+     * @param cfg 服务器配置
+     */
+    explicit CommandServer(CommandManager& mgr, ServerConfig cfg = ServerConfig())
+        : manager(mgr), config(std::move(cfg)) {}
+
+    ~CommandServer() {
+        stop();
+        closeListener();
+    }
+
+    CommandServer(const CommandServer&) = delete;
+    CommandServer& operator=(const CommandServer&) = delete;
+
+    /**
+     * @brief 创建监听套接字并选择后端
+     * @param errorMsg 输出参数，失败时存储错误信息
+     * @return 成功返回true，否则返回false
+     */
+    bool start(std::string& errorMsg) {
+        limits = manager.getConfig();
+        if (limits.clientRateLimit > 0.0 && limits.clientRateBurst <= 0.0) {
+            limits.clientRateBurst = std::max(1.0, limits.clientRateLimit);
+        }
+        if (limits.maxPendingPerClient == 0) {
+            limits.maxPendingPerClient = 1;
+        }
+
+        if (!resolveBackend(errorMsg)) {
+            return false;
+        }
+        return openListener(errorMsg);
+    }
+
+    /**
+     * @brief 运行服务器主循环
+     * @details 阻塞调用线程，直到 stop() 被调用
+     */
+    void run() {
+        if (listenFd < 0) return;
+
+        // 线程池先于连接状态析构，保证工作线程不会访问已释放的会话
+        std::unique_ptr<DispatchPool> workers;
+        if (limits.dispatchThreads > 0) {
+            workers.reset(new DispatchPool(limits.dispatchThreads, std::max<size_t>(1, limits.maxQueueDepth)));
+        }
+        attachPool(workers.get());
+
+        switch (active) {
+#ifdef __linux__
+            case ServerBackend::Epoll:
+                runEpoll(workers);
+                break;
+#endif
+#ifdef CCM_HAS_IO_URING
+            case ServerBackend::IoUring:
+                runIoUring(workers);
+                break;
+#endif
+            default:
+                runBlocking(workers);
+                break;
+        }
+
+        attachPool(nullptr);
+    }
+
+    /**
+     * @brief 请求停止服务器
+     * @details 可从任意线程调用，run() 会在处理完当前事件后返回
+     */
+    void stop() {
+        if (stopping.exchange(true)) return;
+
+        wake();
+        // 唤醒阻塞在 accept 上的线程
+        if (listenFd >= 0) {
+            ::shutdown(listenFd, SHUT_RDWR);
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        for (int fd : clientFds) {
+            ::shutdown(fd, SHUT_RDWR);
+        }
+    }
+
+    /**
+     * @brief 获取实际绑定的 TCP 端口
+     * @return 端口号，使用 Unix 域套接字时返回0
+     */
+    uint16_t port() const { return boundPort; }
+
+    /**
+     * @brief 获取实际使用的后端
+     * @return 后端枚举值
+     */
+    ServerBackend backend() const { return active; }
+
+    /**
+     * @brief 获取准入控制统计
+     * @return 统计快照
+     */
+    AdmissionStats getAdmissionStats() {
+        AdmissionStats stats;
+        stats.admitted = statAdmitted.load(std::memory_order_relaxed);
+        stats.rejectedConnections = statRejectedConnection.load(std::memory_order_relaxed);
+        stats.completed = statCompleted.load(std::memory_order_relaxed);
+        stats.rejectedRate = statRejectedRate.load(std::memory_order_relaxed);
+        stats.rejectedClientLimit = statRejectedClient.load(std::memory_order_relaxed);
+        stats.rejectedQueueFull = statRejectedQueue.load(std::memory_order_relaxed);
+        stats.rejectedQueueTimeout = statRejectedTimeout.load(std::memory_order_relaxed);
+        stats.queueTimeTotalUs = statQueueTimeTotal.load(std::memory_order_relaxed);
+        stats.queueTimeMaxUs = statQueueTimeMax.load(std::memory_order_relaxed);
+        std::lock_guard<std::mutex> lock(poolMutex);
+        DispatchPool* current = pool.load();
+        stats.queueDepth = current ? current->depth() : 0;
+        return stats;
+    }
+
+    /**
+     * @brief 执行已解码的命令上下文
+     * @param context 命令上下文
+     * @param session 发起请求的连接的会话
+     * @param body 输出参数，命令执行期间捕获的输出
+     * @return 执行成功返回true
+     * @details 各协议共用的执行入口
+     */
+    bool execute(CommandContext& context, Session& session, std::string& body) {
+        std::ostringstream captured;
+        context.setOutput(&captured);
+        context.setErrorOutput(&captured);
+        context.setSession(&session);
+
+        bool success = manager.processCommand(context);
+
+        body = captured.str();
+        return success;
+    }
+
+private:
+    // ========================================================================
+    // 公共辅助方法
+    // ========================================================================
+
+    /**
+     * @brief 根据配置和运行环境确定后端
+     */
+    bool resolveBackend(std::string& errorMsg) {
+        ServerBackend wanted = config.backend;
+
+        if (wanted == ServerBackend::Auto) {
+#ifdef CCM_HAS_IO_URING
+            if (IoUring::isSupported()) {
+                active = ServerBackend::IoUring;
+                return true;
+            }
+#endif
+#ifdef __linux__
+            active = ServerBackend::Epoll;
+#else
+            active = ServerBackend::Blocking;
+#endif
+            return true;
+        }
+
+        if (wanted == ServerBackend::IoUring) {
+#ifdef CCM_HAS_IO_URING
+            if (!IoUring::isSupported()) {
+                errorMsg = "当前内核不支持 io_uring";
+                return false;
+            }
+#else
+            errorMsg = "编译环境不支持 io_uring";
+            return false;
+#endif
+        }
+
+#ifndef __linux__
+        if (wanted == ServerBackend::Epoll) {
+            errorMsg = "epoll 仅在 Linux 上可用";
+            return false;
+        }
+#endif
+
+        active = wanted;
+        return true;
+    }
+
+    /**
+     * @brief 创建、绑定并监听套接字
+     */
+    bool openListener(std::string& errorMsg) {
+        bool useUnix = !config.unixPath.empty();
+        int fd = ::socket(useUnix ? AF_UNIX : AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd < 0) {
+            errorMsg = std::string("创建套接字失败: ") + std::strerror(errno);
+            return false;
+        }
+
+        int rc;
+        if (useUnix) {
+            sockaddr_un addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sun_family = AF_UNIX;
+            if (config.unixPath.size() >= sizeof(addr.sun_path)) {
+                ::close(fd);
+                errorMsg = "Unix 套接字路径过长: " + config.unixPath;
+                return false;
+            }
+            std::memcpy(addr.sun_path, config.unixPath.c_str(), config.unixPath.size() + 1);
+            ::unlink(config.unixPath.c_str());
+            rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        } else {
+            int reuse = 1;
+            ::setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons(config.port);
+            if (::inet_pton(AF_INET, config.host.c_str(), &addr.sin_addr) != 1) {
+                ::close(fd);
+                errorMsg = "无效的监听地址: " + config.host;
+                return false;
+            }
+            rc = ::bind(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+        }
+
+        if (rc < 0 || ::listen(fd, config.backlog) < 0) {
+            errorMsg = std::string("绑定监听地址失败: ") + std::strerror(errno);
+            ::close(fd);
+            return false;
+        }
+
+        if (!useUnix) {
+            sockaddr_in bound;
+            socklen_t len = sizeof(bound);
+            if (::getsockname(fd, reinterpret_cast<sockaddr*>(&bound), &len) == 0) {
+                boundPort = ntohs(bound.sin_port);
+            }
+        }
+
+#ifdef __linux__
+        wakeFd = ::eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+#endif
+        listenFd = fd;
+        stopping = false;
+        return true;
+    }
+
+    /**
+     * @brief 关闭监听套接字和唤醒描述符
+     */
+    void closeListener() {
+        if (listenFd >= 0) {
+            ::close(listenFd);
+            listenFd = -1;
+            if (!config.unixPath.empty()) {
+                ::unlink(config.unixPath.c_str());
+            }
+        }
+        if (wakeFd >= 0) {
+            ::close(wakeFd);
+            wakeFd = -1;
+        }
+    }
+
+    /**
+     * @brief 唤醒事件循环
+     */
+    void wake() {
+#ifdef __linux__
+        if (wakeFd >= 0) {
+            uint64_t one = 1;
+            ssize_t ignored = ::write(wakeFd, &one, sizeof(one));
+            (void)ignored;
+        }
+#endif
+    }
+
+    /**
+     * @brief 按协议格式把响应追加到缓冲区
+     */
+    void appendResponse(const Request& request, ResponseStatus status, const std::string& body,
+                        std::string& out) const {
+        if (config.protocol == ServerProtocol::Http) {
+            if (request.httpStatus != 0) {
+                encodeHttpResponse(request.httpStatus, "error", body, request.keepAlive, out);
+            } else if (status == ResponseStatus::Busy) {
+                encodeHttpResponse(503, "busy", body, request.keepAlive, out);
+            } else {
+                encodeHttpResponse(200, status == ResponseStatus::Ok ? "ok" : "fail", body, request.keepAlive, out);
+            }
+            return;
+        }
+        if (config.protocol == ServerProtocol::Binary) {
+            uint8_t code = status == ResponseStatus::Ok ? WIRE_STATUS_OK
+                         : status == ResponseStatus::Fail ? WIRE_STATUS_FAIL : WIRE_STATUS_BUSY;
+            encodeResponse(code, body, out);
+            return;
+        }
+        out += status == ResponseStatus::Ok ? "OK " : status == ResponseStatus::Fail ? "FAIL " : "BUSY ";
+        out += std::to_string(body.size());
+        out += '\n';
+        out += body;
+    }
+
+    /**
+     * @brief 执行请求并生成完整响应
+     * @param request 请求
+     * @param session 连接的会话
+     * @param enqueued 请求进入队列的时间，用于排队时间统计和超时丢弃
+     * @return 响应字节
+     */
+    std::string runRequest(Request& request, Session& session, Clock::time_point enqueued) {
+        uint64_t waitedUs = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - enqueued).count());
+        statQueueTimeTotal.fetch_add(waitedUs, std::memory_order_relaxed);
+        uint64_t prevMax = statQueueTimeMax.load(std::memory_order_relaxed);
+        while (waitedUs > prevMax &&
+               !statQueueTimeMax.compare_exchange_weak(prevMax, waitedUs, std::memory_order_relaxed)) {
+        }
+
+        std::string response;
+        if (limits.maxQueueTimeMs > 0 && waitedUs > static_cast<uint64_t>(limits.maxQueueTimeMs) * 1000) {
+            statRejectedTimeout.fetch_add(1, std::memory_order_relaxed);
+            appendResponse(request, ResponseStatus::Busy, "排队超时", response);
+            return response;
+        }
+
+        std::string body;
+        bool success = execute(request.context, session, body);
+        statCompleted.fetch_add(1, std::memory_order_relaxed);
+        appendResponse(request, success ? ResponseStatus::Ok : ResponseStatus::Fail, body, response);
+        return response;
+    }
+
+    /**
+     * @brief 从输入缓冲区解析所有完整请求，进行准入检查后加入积压队列
+     * @param conn 连接状态
+     * @return 可以继续读取返回true；请求过长、格式错误或 HTTP 对端要求关闭连接时返回false
+     */
+    bool parseInput(Connection& conn) {
+        size_t start = 0;
+        bool ok = true;
+
+        while (start < conn.input.size()) {
+            Request request;
+            if (config.protocol == ServerProtocol::Binary) {
+                size_t consumed = 0;
+                std::string error;
+                DecodeStatus status = decodeRequest(conn.input.data() + start, conn.input.size() - start,
+                                                    consumed, request.context, manager, error,
+                                                    static_cast<uint32_t>(config.maxRequestSize));
+                if (status == DecodeStatus::NeedMore) break;
+                if (status == DecodeStatus::Malformed) {
+                    request.rejected = true;
+                    request.rejectStatus = ResponseStatus::Fail;
+                    request.rejectReason = error;
+                    conn.backlog.push_back(std::move(request));
+                    ok = false;
+                    break;
+                }
+                start += consumed;
+            } else if (config.protocol == ServerProtocol::Http) {
+                size_t consumed = 0;
+                HttpRequest http;
+                std::string error;
+                DecodeStatus status = decodeHttpRequest(conn.input.data() + start, conn.input.size() - start,
+                                                        consumed, http, request.httpStatus, error,
+                                                        config.maxRequestSize);
+                if (status == DecodeStatus::NeedMore) break;
+                if (status == DecodeStatus::Malformed) {
+                    request.rejected = true;
+                    request.rejectStatus = ResponseStatus::Fail;
+                    request.rejectReason = error;
+                    request.keepAlive = false;
+                    conn.backlog.push_back(std::move(request));
+                    ok = false;
+                    break;
+                }
+                start += consumed;
+                request.keepAlive = http.keepAlive;
+
+                // 对端要求关闭连接时不再解析后续请求，响应完成后关闭
+                if (!httpRequestToContext(http, request.context, manager, request.httpStatus, error)) {
+                    request.rejected = true;
+                    request.rejectStatus = ResponseStatus::Fail;
+                    request.rejectReason = error;
+                } else {
+                    request.httpStatus = 0;
+                    admit(conn, request);
+                }
+                conn.backlog.push_back(std::move(request));
+                if (!http.keepAlive) {
+                    ok = false;
+                    break;
+                }
+                continue;
+            } else {
+                size_t newline = conn.input.find('\n', start);
+                if (newline == std::string::npos) break;
+                size_t end = newline;
+                if (end > start && conn.input[end - 1] == '\r') --end;
+                request.context = CommandContext(conn.input.substr(start, end - start));
+                start = newline + 1;
+            }
+
+            admit(conn, request);
+            conn.backlog.push_back(std::move(request));
+        }
+        conn.input.erase(0, start);
+
+        if (ok && config.protocol == ServerProtocol::Line && conn.input.size() > config.maxRequestSize) {
+            Request request;
+            request.rejected = true;
+            request.rejectStatus = ResponseStatus::Fail;
+            request.rejectReason = "请求过长";
+            conn.backlog.push_back(std::move(request));
+            ok = false;
+        }
+        return ok;
+    }
+
+    /**
+     * @brief 设置或解除当前的工作线程池
+     * @details 解除后其他线程不会再访问旧线程池，调用者随后可以安全地析构它
+     */
+    void attachPool(DispatchPool* current) {
+        std::lock_guard<std::mutex> lock(poolMutex);
+        pool.store(current);
+    }
+
+    /**
+     * @brief 检查是否还能接受新的客户端连接
+     * @param connected 当前的连接数
+     * @param fd 新连接的套接字，超出上限时被关闭
+     * @return 可以接受返回true
+     */
+    bool admitConnection(size_t connected, int fd) {
+        if (limits.maxClients == 0 || connected < limits.maxClients) return true;
+        statRejectedConnection.fetch_add(1, std::memory_order_relaxed);
+        ::close(fd);
+        return false;
+    }
+
+    /**
+     * @brief 对新到达的请求进行客户端级准入检查
+     */
+    void admit(Connection& conn, Request& request) {
+        if (limits.clientRateLimit > 0.0 &&
+            !conn.bucket.take(limits.clientRateLimit, limits.clientRateBurst, Clock::now())) {
+            statRejectedRate.fetch_add(1, std::memory_order_relaxed);
+            request.rejected = true;
+            request.rejectReason = "超出客户端速率限制";
+            return;
+        }
+        if (conn.pending >= limits.maxPendingPerClient) {
+            statRejectedClient.fetch_add(1, std::memory_order_relaxed);
+            request.rejected = true;
+            request.rejectReason = "超出客户端并发请求上限";
+            return;
+        }
+        ++conn.pending;
+        statAdmitted.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 按顺序处理积压队列，直到有请求交给工作线程或队列为空
+     * @param conn 连接状态
+     * @details 同一连接的请求串行执行，保证响应顺序且会话不会被并发修改
+     */
+    void pump(Connection& conn) {
+        while (!conn.executing && !conn.backlog.empty()) {
+            Request& front = conn.backlog.front();
+
+            if (front.rejected) {
+                appendResponse(front, front.rejectStatus, front.rejectReason, conn.output);
+                conn.backlog.pop_front();
+                continue;
+            }
+
+            DispatchPool* workers = pool.load(std::memory_order_relaxed);
+            if (!workers) {
+                conn.output += runRequest(front, conn.session, Clock::now());
+                --conn.pending;
+                conn.backlog.pop_front();
+                continue;
+            }
+
+            // 交给工作线程；连接在执行期间不会被释放，会话指针保持有效
+            auto request = std::make_shared<Request>(std::move(front));
+            conn.backlog.pop_front();
+            uint64_t connId = conn.id;
+            Session* session = &conn.session;
+            Clock::time_point enqueued = Clock::now();
+
+            bool accepted = workers->trySubmit([this, request, connId, session, enqueued] {
+                std::string response = runRequest(*request, *session, enqueued);
+                {
+                    std::lock_guard<std::mutex> lock(completionsMutex);
+                    completions.push_back(Completion{connId, std::move(response)});
+                }
+                wake();
+            });
+
+            if (accepted) {
+                conn.executing = true;
+            } else {
+                statRejectedQueue.fetch_add(1, std::memory_order_relaxed);
+                appendResponse(*request, ResponseStatus::Busy, "服务器队列已满", conn.output);
+                --conn.pending;
+            }
+        }
+    }
+
+    /**
+     * @brief 积压队列是否过长，需要暂停读取
+     */
+    bool backlogFull(const Connection& conn) const {
+        return conn.backlog.size() >= limits.maxPendingPerClient * 2;
+    }
+
+    /**
+     * @brief 取出所有已完成的结果
+     */
+    std::vector<Completion> takeCompletions() {
+        std::vector<Completion> done;
+        std::lock_guard<std::mutex> lock(completionsMutex);
+        done.swap(completions);
+        return done;
+    }
+
+    /**
+     * @brief 连接是否已处理完毕可以关闭
+     */
+    static bool finished(const Connection& conn) {
+        if (conn.executing) return false;
+        if (conn.dead) return true;
+        return conn.closing && conn.backlog.empty() && conn.output.size() == conn.outputOffset;
+    }
+
+    /**
+     * @brief 把套接字设置为非阻塞并禁用 Nagle 算法
+     */
+    void prepareClientSocket(int fd, bool nonBlocking) const {
+        if (nonBlocking) {
+            int flags = ::fcntl(fd, F_GETFL, 0);
+            ::fcntl(fd, F_SETFL, flags | O_NONBLOCK);
+        }
+        if (config.unixPath.empty()) {
+            int one = 1;
+            ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        }
+    }
+
+    /**
+     * @brief 阻塞写出全部数据
+     */
+    static bool writeAll(int fd, const char* data, size_t size) {
+        CCM_TRACE_SPAN("flush");
+        while (size > 0) {
+            ssize_t n = ::send(fd, data, size, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+            data += n;
+            size -= static_cast<size_t>(n);
+        }
+        return true;
+    }
+
+    // ========================================================================
+    // Blocking 后端
+    // ========================================================================
+
+    /**
+     * @brief 每连接一个线程的主循环
+     * @details 连接数达到 maxClients 时新连接被立即关闭；每次接受连接前回收已结束的线程
+     */
+    void runBlocking(std::unique_ptr<DispatchPool>&) {
+        while (!stopping) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                break;
+            }
+
+            std::list<ClientThread> finished;
+            {
+                std::lock_guard<std::mutex> lock(clientsMutex);
+                for (auto it = clientThreads.begin(); it != clientThreads.end();) {
+                    auto current = it++;
+                    if (current->finished) finished.splice(finished.end(), clientThreads, current);
+                }
+                if (stopping) {
+                    ::close(fd);
+                    break;
+                }
+                if (admitConnection(clientFds.size(), fd)) {
+                    prepareClientSocket(fd, false);
+                    clientFds.push_back(fd);
+                    clientThreads.emplace_back();
+                    ClientThread& client = clientThreads.back();
+                    client.thread = std::thread([this, fd, &client] {
+                        serveBlockingClient(fd);
+                        std::lock_guard<std::mutex> done(clientsMutex);
+                        client.finished = true;
+                    });
+                }
+            }
+            for (auto& client : finished) client.thread.join();
+        }
+
+        std::list<ClientThread> threads;
+        {
+            std::lock_guard<std::mutex> lock(clientsMutex);
+            for (int fd : clientFds) ::shutdown(fd, SHUT_RDWR);
+            threads.swap(clientThreads);
+        }
+        for (auto& client : threads) client.thread.join();
+    }
+
+    /**
+     * @brief 服务单个阻塞连接
+     * @details 配置了工作线程时，连接线程只负责收发，命令在线程池中执行，
+     *          线程池满时直接返回 BUSY，从而限制同时执行的命令数
+     */
+    void serveBlockingClient(int fd) {
+        Connection conn;
+        conn.fd = fd;
+        conn.session = manager.createSession();
+        std::vector<char> buffer(config.recvBufferSize);
+
+        while (!stopping) {
+            ssize_t n = ::recv(fd, buffer.data(), buffer.size(), 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) break;
+
+            conn.input.append(buffer.data(), static_cast<size_t>(n));
+            bool ok = parseInput(conn);
+
+            conn.output.clear();
+            while (!conn.backlog.empty()) {
+                Request& front = conn.backlog.front();
+                if (front.rejected) {
+                    appendResponse(front, front.rejectStatus, front.rejectReason, conn.output);
+                    conn.backlog.pop_front();
+                    continue;
+                }
+                DispatchPool* workers = pool.load(std::memory_order_relaxed);
+                if (!workers) {
+                    conn.output += runRequest(front, conn.session, Clock::now());
+                    conn.backlog.pop_front();
+                    --conn.pending;
+                    continue;
+                }
+
+                auto request = std::make_shared<Request>(std::move(front));
+                conn.backlog.pop_front();
+                auto result = std::make_shared<std::promise<std::string>>();
+                std::future<std::string> future = result->get_future();
+                Session* session = &conn.session;
+                Clock::time_point enqueued = Clock::now();
+
+                if (workers->trySubmit([this, request, result, session, enqueued] {
+                        result->set_value(runRequest(*request, *session, enqueued));
+                    })) {
+                    // 线程池析构时会丢弃未开始的任务，此时promise被销毁，future得到异常
+                    try {
+                        conn.output += future.get();
+                    } catch (const std::future_error&) {
+                        break;
+                    }
+                } else {
+                    statRejectedQueue.fetch_add(1, std::memory_order_relaxed);
+                    appendResponse(*request, ResponseStatus::Busy, "服务器队列已满", conn.output);
+                }
+                --conn.pending;
+            }
+
+            if (!writeAll(fd, conn.output.data(), conn.output.size()) || !ok) break;
+        }
+
+        std::lock_guard<std::mutex> lock(clientsMutex);
+        clientFds.erase(std::remove(clientFds.begin(), clientFds.end(), fd), clientFds.end());
+        ::close(fd);
+    }
+
+#ifdef __linux__
+    // ========================================================================
+    // Epoll 后端
+    // ========================================================================
+
+    /**
+     * @brief epoll 事件循环
+     */
+    void runEpoll(std::unique_ptr<DispatchPool>& workers) {
+        int epfd = ::epoll_create1(EPOLL_CLOEXEC);
+        if (epfd < 0) {
+            std::cerr << "epoll_create1 失败: " << std::strerror(errno) << std::endl;
+            return;
+        }
+
+        int flags = ::fcntl(listenFd, F_GETFL, 0);
+        ::fcntl(listenFd, F_SETFL, flags | O_NONBLOCK);
+
+        epoll_event ev;
+        std::memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN;
+        ev.data.u64 = LISTEN_ID;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, listenFd, &ev);
+        ev.data.u64 = WAKE_ID;
+        ::epoll_ctl(epfd, EPOLL_CTL_ADD, wakeFd, &ev);
+
+        std::unordered_map<uint64_t, Connection> connections;
+        std::vector<epoll_event> events(128);
+        std::vector<char> buffer(config.recvBufferSize);
+        uint64_t nextId = WAKE_ID + 1;
+
+        // 根据积压和待发送数据更新关注的事件
+        auto updateInterest = [&](Connection& conn) {
+            epoll_event mod;
+            std::memset(&mod, 0, sizeof(mod));
+            mod.data.u64 = conn.id;
+            conn.readPaused = backlogFull(conn);
+            if (!conn.closing && !conn.readPaused) mod.events |= EPOLLIN;
+            if (conn.outputOffset < conn.output.size()) mod.events |= EPOLLOUT;
+            ::epoll_ctl(epfd, EPOLL_CTL_MOD, conn.fd, &mod);
+        };
+
+        // 尽量写出待发送数据
+        auto flushConnection = [&](Connection& conn) {
+            CCM_TRACE_SPAN("flush");
+            while (!conn.dead && conn.outputOffset < conn.output.size()) {
+                ssize_t n = ::send(conn.fd, conn.output.data() + conn.outputOffset,
+                                   conn.output.size() - conn.outputOffset, MSG_NOSIGNAL);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                    conn.dead = true;
+                    break;
+                }
+                conn.outputOffset += static_cast<size_t>(n);
+            }
+            if (conn.outputOffset >= conn.output.size()) {
+                conn.output.clear();
+                conn.outputOffset = 0;
+            }
+        };
+
+        // 处理积压、写出响应，必要时关闭连接
+        auto service = [&](Connection& conn) {
+            pump(conn);
+            flushConnection(conn);
+            if (finished(conn)) {
+                ::epoll_ctl(epfd, EPOLL_CTL_DEL, conn.fd, nullptr);
+                ::close(conn.fd);
+                connections.erase(conn.id);
+                return;
+            }
+            updateInterest(conn);
+        };
+
+        while (!stopping) {
+            int n = ::epoll_wait(epfd, events.data(), static_cast<int>(events.size()), -1);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                break;
+            }
+
+            for (int i = 0; i < n; ++i) {
+                uint64_t id = events[i].data.u64;
+
+                if (id == WAKE_ID) {
+                    uint64_t value;
+                    ssize_t ignored = ::read(wakeFd, &value, sizeof(value));
+                    (void)ignored;
+                    for (auto& done : takeCompletions()) {
+                        auto it = connections.find(done.connId);
+                        if (it == connections.end()) continue;
+                        Connection& conn = it->second;
+                        conn.executing = false;
+                        --conn.pending;
+                        conn.output += done.response;
+                        service(conn);
+                    }
+                    continue;
+                }
+
+                if (id == LISTEN_ID) {
+                    // 一次接受所有排队的连接
+                    while (true) {
+                        int client = ::accept4(listenFd, nullptr, nullptr,
+                                               SOCK_CLOEXEC | SOCK_NONBLOCK);
+                        if (client < 0) break;
+                        if (!admitConnection(connections.size(), client)) continue;
+                        prepareClientSocket(client, false);
+
+                        uint64_t connId = nextId++;
+                        Connection& conn = connections[connId];
+                        conn.id = connId;
+                        conn.fd = client;
+                        conn.session = manager.createSession();
+                        epoll_event cev;
+                        std::memset(&cev, 0, sizeof(cev));
+                        cev.events = EPOLLIN;
+                        cev.data.u64 = connId;
+                        ::epoll_ctl(epfd, EPOLL_CTL_ADD, client, &cev);
+                    }
+                    continue;
+                }
+
+                auto it = connections.find(id);
+                if (it == connections.end()) continue;
+                Connection& conn = it->second;
+
+                if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && !conn.closing) {
+                    while (!backlogFull(conn)) {
+                        ssize_t r = ::recv(conn.fd, buffer.data(), buffer.size(), 0);
+                        if (r > 0) {
+                            conn.input.append(buffer.data(), static_cast<size_t>(r));
+                            if (!parseInput(conn)) {
+                                conn.closing = true;
+                                break;
+                            }
+                            continue;
+                        }
+                        if (r < 0 && errno == EINTR) continue;
+                        if (r < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+                        conn.closing = true;
+                        break;
+                    }
+                }
+
+                service(conn);
+            }
+        }
+
+        // 先停止线程池，再关闭连接
+        attachPool(nullptr);
+        workers.reset();
+        for (auto& entry : connections) {
+            ::close(entry.second.fd);
+        }
+        ::close(epfd);
+    }
+#endif // __linux__
+
+#ifdef CCM_HAS_IO_URING
+    // ========================================================================
+    // io_uring 后端
+    // ========================================================================
+
+    /** @brief io_uring 请求类型，编码在 user_data 的低8位 */
+    enum UringOp : uint64_t {
+        OP_ACCEPT = 1,
+        OP_RECV = 2,
+        OP_SEND = 3,
+        OP_WAKE = 4
+    };
+
+    static uint64_t packUserData(uint64_t id, UringOp op) { return (id << 8) | op; }
+
+    /**
+     * @brief io_uring 事件循环
+     * @details 每轮循环把本轮产生的所有 accept/recv/send 请求一次性提交，
+     *          再收割所有完成事件；recv 完成后解析请求并执行或交给工作线程，
+     *          工作线程完成后通过 eventfd 的读完成事件回到本循环排队 send
+     */
+    void runIoUring(std::unique_ptr<DispatchPool>& workers) {
+        IoUring ring;
+        std::string error;
+        if (!ring.init(config.ringEntries, error)) {
+            std::cerr << error << std::endl;
+            return;
+        }
+
+        std::unordered_map<uint64_t, Connection> connections;
+        uint64_t nextId = 1;
+        uint64_t wakeValue = 0;
+
+        // 获取条目，队列满时先提交已有条目腾出空间
+        auto getSqe = [&ring]() {
+            io_uring_sqe* sqe = ring.getSqe();
+            while (!sqe) {
+                ring.submit(0);
+                sqe = ring.getSqe();
+            }
+            return sqe;
+        };
+
+        auto queueAccept = [&]() {
+            IoUring::prepAccept(getSqe(), listenFd, packUserData(0, OP_ACCEPT));
+        };
+
+        auto queueWake = [&]() {
+            IoUring::prepRead(getSqe(), wakeFd, &wakeValue, sizeof(wakeValue), 0,
+                              packUserData(0, OP_WAKE));
+        };
+
+        auto queueRecv = [&](Connection& conn) {
+            if (conn.recvPending || conn.closing || conn.dead) return;
+            conn.readPaused = backlogFull(conn);
+            if (conn.readPaused) return;
+            IoUring::prepRecv(getSqe(), conn.fd, conn.recvBuffer.data(),
+                              conn.recvBuffer.size(), packUserData(conn.id, OP_RECV));
+            conn.recvPending = true;
+        };
+
+        // 把累积的输出切换到发送缓冲区并排队 send
+        auto queueSend = [&](Connection& conn) {
+            CCM_TRACE_SPAN("flush");
+            if (conn.sendPending || conn.dead) return;
+            if (conn.sendingOffset >= conn.sending.size()) {
+                if (conn.output.empty()) return;
+                conn.sending.swap(conn.output);
+                conn.output.clear();
+                conn.sendingOffset = 0;
+            }
+            IoUring::prepSend(getSqe(), conn.fd, conn.sending.data() + conn.sendingOffset,
+                              conn.sending.size() - conn.sendingOffset,
+                              packUserData(conn.id, OP_SEND));
+            conn.sendPending = true;
+        };
+
+        // 处理积压并排队后续 I/O，所有请求完成后释放连接
+        auto service = [&](Connection& conn) {
+            pump(conn);
+            queueSend(conn);
+            queueRecv(conn);
+
+            bool drained = conn.dead ||
+                (conn.closing && conn.backlog.empty() && conn.output.empty() &&
+                 conn.sendingOffset >= conn.sending.size());
+            if (drained && !conn.executing && !conn.recvPending && !conn.sendPending) {
+                ::close(conn.fd);
+                connections.erase(conn.id);
+            }
+        };
+
+        queueWake();
+        queueAccept();
+
+        while (!stopping) {
+            int rc = ring.submit(1);
+            if (rc < 0 && rc != -EBUSY && rc != -EAGAIN && rc != -EINTR) {
+                std::cerr << "io_uring_enter 失败: " << std::strerror(-rc) << std::endl;
+                break;
+            }
+
+            ring.forEachCompletion([&](uint64_t userData, int res) {
+                uint64_t id = userData >> 8;
+                auto op = static_cast<UringOp>(userData & 0xff);
+
+                if (op == OP_WAKE) {
+                    if (stopping) return;
+                    for (auto& done : takeCompletions()) {
+                        auto it = connections.find(done.connId);
+                        if (it == connections.end()) continue;
+                        Connection& conn = it->second;
+                        conn.executing = false;
+                        --conn.pending;
+                        conn.output += done.response;
+                        service(conn);
+                    }
+                    queueWake();
+                    return;
+                }
+
+                if (op == OP_ACCEPT) {
+                    if (res >= 0 && admitConnection(connections.size(), res)) {
+                        prepareClientSocket(res, false);
+                        uint64_t connId = nextId++;
+                        Connection& conn = connections[connId];
+                        conn.id = connId;
+                        conn.fd = res;
+                        conn.session = manager.createSession();
+                        conn.recvBuffer.resize(config.recvBufferSize);
+                        queueRecv(conn);
+                    }
+                    if (!stopping) queueAccept();
+                    return;
+                }
+
+                auto it = connections.find(id);
+                if (it == connections.end()) return;
+                Connection& conn = it->second;
+
+                if (op == OP_RECV) {
+                    conn.recvPending = false;
+                    if (res <= 0) {
+                        conn.closing = true;
+                    } else {
+                        conn.input.append(conn.recvBuffer.data(), static_cast<size_t>(res));
+                        if (!parseInput(conn)) {
+                            conn.closing = true;
+                        }
+                    }
+                } else if (op == OP_SEND) {
+                    conn.sendPending = false;
+                    if (res < 0) {
+                        conn.dead = true;
+                    } else {
+                        conn.sendingOffset += static_cast<size_t>(res);
+                    }
+                }
+
+                service(conn);
+            });
+        }
+
+        // 先停止线程池，再关闭 ring（取消所有未完成的请求），最后释放连接
+        attachPool(nullptr);
+        workers.reset();
+        ring.close();
+        for (auto& entry : connections) {
+            ::close(entry.second.fd);
+        }
+    }
+#endif // CCM_HAS_IO_URING
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_SERVER_H
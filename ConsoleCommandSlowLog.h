@@ -0,0 +1,344 @@
+/**
+ * @file ConsoleCommandSlowLog.h
+ * @brief 慢命令日志
+ * @details 耗时超过 CommandManager::Config::slowCommandThresholdUs 的命令在完成时生成一条记录，
+ *          包含完整命令行、解析后的选项和标志、各阶段耗时、执行线程和结果。
+ *
+ * 设计要点：
+ * - 执行线程只把记录放进有界的无锁环形队列（Vyukov 有界 MPMC 队列），不做任何 I/O；
+ *   队列满时丢弃新记录并计数，不会阻塞命令执行
+ * - 后台线程每 100ms 取出队列中的记录，格式化为 JSON Lines 追加到日志文件，
+ *   并保留最近的若干条供 slowlog 内置命令查看
+ * - 后台线程在第一条记录提交时才启动，没有慢命令时不占用线程
+ *
+ * 日志每行一个 JSON 对象，例如：
+ * @code
+ * {"time":"2024-05-01T10:00:00.123Z","thread":4242,"command":"cp","line":"cp -r a b","options":{},
+ *  "flags":["r"],"outcome":"success","totalUs":52310,"phasesUs":{"parse":3,"lookup":1,
+ *  "validate":2,"execute":52290,"help":0}}
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_SLOW_LOG_H
+#define CONSOLE_COMMAND_SLOW_LOG_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace ConsoleCommand {
+
+/**
+ * @struct SlowCommandRecord
+ * @brief 一条慢命令记录
+ * @details 各阶段耗时为 0 表示该阶段没有发生或没有测量（例如由调用方预先解析的上下文没有分词耗时）
+ */
+struct SlowCommandRecord {
+    int64_t timestampMs = 0;        ///< 完成时间（Unix 毫秒）
+    uint64_t thread = 0;            ///< 执行线程（Linux 上为内核线程ID）
+    std::string command;            ///< 命令名称
+    std::string commandLine;        ///< 由上下文重建的完整命令行
+    std::vector<std::pair<std::string, std::string>> options;  ///< 解析后的选项
+    std::vector<std::string> flags; ///< 解析后的标志
+    const char* outcome = "";       ///< success / failure / exception
+    uint64_t totalNanos = 0;        ///< 总耗时
+    uint64_t parseNanos = 0;        ///< 分词和解析
+    uint64_t lookupNanos = 0;       ///< 命令查找
+    uint64_t validateNanos = 0;     ///< 参数验证
+    uint64_t executeNanos = 0;      ///< 执行器
+    uint64_t helpNanos = 0;         ///< 帮助文本生成
+};
+
+namespace detail {
+
+inline void appendJsonString(std::string& out, const std::string& s) {
+    out += '"';
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            char buf[8];
+            std::snprintf(buf, sizeof(buf), "\\u%04x", u);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+/**
+ * @brief 获取当前线程的标识
+ */
+inline uint64_t currentThreadTag() {
+#ifdef __linux__
+    thread_local uint64_t tid = static_cast<uint64_t>(::syscall(SYS_gettid));
+    return tid;
+#else
+    return static_cast<uint64_t>(std::hash<std::thread::id>()(std::this_thread::get_id()));
+#endif
+}
+
+} // namespace detail
+
+/**
+ * @brief 把记录格式化为一行 JSON（不含换行）
+ */
+inline std::string formatSlowRecord(const SlowCommandRecord& r) {
+    std::string out;
+    out.reserve(256 + r.commandLine.size());
+
+    char time[40];
+    std::time_t seconds = static_cast<std::time_t>(r.timestampMs / 1000);
+    std::tm tm{};
+#ifdef _WIN32
+    gmtime_s(&tm, &seconds);
+#else
+    gmtime_r(&seconds, &tm);
+#endif
+    size_t n = std::strftime(time, sizeof(time), "%Y-%m-%dT%H:%M:%S", &tm);
+    std::snprintf(time + n, sizeof(time) - n, ".%03dZ", static_cast<int>(r.timestampMs % 1000));
+
+    auto micros = [](uint64_t nanos) { return std::to_string(nanos / 1000); };
+
+    out += "{\"time\":\"";
+    out += time;
+    out += "\",\"thread\":";
+    out += std::to_string(r.thread);
+    out += ",\"command\":";
+    detail::appendJsonString(out, r.command);
+    out += ",\"line\":";
+    detail::appendJsonString(out, r.commandLine);
+    out += ",\"options\":{";
+    for (size_t i = 0; i < r.options.size(); ++i) {
+        if (i) out += ',';
+        detail::appendJsonString(out, r.options[i].first);
+        out += ':';
+        detail::appendJsonString(out, r.options[i].second);
+    }
+    out += "},\"flags\":[";
+    for (size_t i = 0; i < r.flags.size(); ++i) {
+        if (i) out += ',';
+        detail::appendJsonString(out, r.flags[i]);
+    }
+    out += "],\"outcome\":\"";
+    out += r.outcome;
+    out += "\",\"totalUs\":" + micros(r.totalNanos);
+    out += ",\"phasesUs\":{\"parse\":" + micros(r.parseNanos);
+    out += ",\"lookup\":" + micros(r.lookupNanos);
+    out += ",\"validate\":" + micros(r.validateNanos);
+    out += ",\"execute\":" + micros(r.executeNanos);
+    out += ",\"help\":" + micros(r.helpNanos);
+    out += "}}";
+    return out;
+}
+
+/**
+ * @class SlowLog
+ * @brief 慢命令记录的有界无锁队列和异步写出线程
+ */
+class SlowLog {
+public:
+    static constexpr size_t DEFAULT_CAPACITY = 1024;    ///< 队列容量（2的幂）
+    static constexpr size_t RECENT_LIMIT = 64;          ///< 内存中保留的最近记录数
+
+private:
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        SlowCommandRecord record;
+    };
+
+    const size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> enqueuePos{0};
+    alignas(64) std::atomic<size_t> dequeuePos{0};
+
+    std::atomic<uint64_t> submitted{0};
+    std::atomic<uint64_t> dropped{0};
+
+    std::once_flag startOnce;
+    std::thread flusher;
+    std::mutex mutex;                       ///< 保护以下成员，只在后台线程和查询时使用
+    std::condition_variable wake;
+    bool stopping = false;
+    std::string path;
+    std::string openedPath;
+    std::ofstream file;
+    std::deque<std::string> recentLines;
+
+public:
+    /**
+     * @brief 构造
+     * @param capacity 队列容量，向上取整为2的幂
+     */
+    explicit SlowLog(size_t capacity = DEFAULT_CAPACITY)
+        : mask(roundUp(capacity) - 1), slots(new Slot[mask + 1]) {
+        for (size_t i = 0; i <= mask; ++i) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    ~SlowLog() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        if (flusher.joinable()) flusher.join();
+    }
+
+    SlowLog(const SlowLog&) = delete;
+    SlowLog& operator=(const SlowLog&) = delete;
+
+    /**
+     * @brief 设置日志文件路径
+     * @param p 路径，为空时只在内存中保留最近的记录
+     */
+    void setPath(const std::string& p) {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = p;
+    }
+
+    /**
+     * @brief 提交一条记录
+     * @return 队列已满被丢弃时返回false
+     * @details 无锁，不做 I/O；首次调用时启动后台线程
+     */
+    bool submit(SlowCommandRecord&& record) {
+        std::call_once(startOnce, [this] { flusher = std::thread([this] { run(); }); });
+
+        size_t pos = enqueuePos.load(std::memory_order_relaxed);
+        for (;;) {
+            Slot& slot = slots[pos & mask];
+            size_t seq = slot.sequence.load(std::memory_order_acquire);
+            intptr_t diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    slot.record = std::move(record);
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    submitted.fetch_add(1, std::memory_order_relaxed);
+                    return true;
+                }
+            } else if (diff < 0) {
+                dropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            } else {
+                pos = enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /**
+     * @brief 立即写出队列中的记录
+     */
+    void flush() {
+        std::lock_guard<std::mutex> lock(mutex);
+        drain();
+    }
+
+    /**
+     * @brief 获取最近的记录（JSON 行，从旧到新）
+     * @param count 最多返回的条数
+     * @details 先写出队列中尚未处理的记录
+     */
+    std::vector<std::string> recent(size_t count) {
+        std::lock_guard<std::mutex> lock(mutex);
+        drain();
+        size_t first = recentLines.size() > count ? recentLines.size() - count : 0;
+        return std::vector<std::string>(recentLines.begin() + static_cast<std::ptrdiff_t>(first), recentLines.end());
+    }
+
+    uint64_t submittedCount() const { return submitted.load(std::memory_order_relaxed); }  ///< 已提交的记录数
+    uint64_t droppedCount() const { return dropped.load(std::memory_order_relaxed); }      ///< 因队列满丢弃的记录数
+
+    /**
+     * @brief 获取当前日志文件路径
+     */
+    std::string getPath() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return path;
+    }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t size = 2;
+        while (size < n) size <<= 1;
+        return size;
+    }
+
+    /**
+     * @brief 取出一条记录（只在持有 mutex 时调用，因此只有一个消费者）
+     */
+    bool pop(SlowCommandRecord& out) {
+        size_t pos = dequeuePos.load(std::memory_order_relaxed);
+        Slot& slot = slots[pos & mask];
+        size_t seq = slot.sequence.load(std::memory_order_acquire);
+        if (seq != pos + 1) return false;
+        out = std::move(slot.record);
+        slot.record = SlowCommandRecord();
+        dequeuePos.store(pos + 1, std::memory_order_relaxed);
+        slot.sequence.store(pos + mask + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 写出队列中的所有记录（调用者持有 mutex）
+     */
+    void drain() {
+        if (openedPath != path) {
+            file.close();
+            file.clear();
+            openedPath = path;
+            if (!path.empty()) file.open(path, std::ios::app);
+        }
+
+        SlowCommandRecord record;
+        bool wrote = false;
+        while (pop(record)) {
+            std::string line = formatSlowRecord(record);
+            if (file.is_open()) {
+                file << line << '\n';
+                wrote = true;
+            }
+            recentLines.push_back(std::move(line));
+            if (recentLines.size() > RECENT_LIMIT) recentLines.pop_front();
+        }
+        if (wrote) {
+            file.flush();
+            file.clear();   // 写入失败（例如磁盘满）时下次继续尝试
+        }
+    }
+
+    void run() {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (!stopping) {
+            wake.wait_for(lock, std::chrono::milliseconds(100));
+            drain();
+        }
+        drain();
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_SLOW_LOG_H
@@ -0,0 +1,441 @@
+/**
+ * @file ConsoleCommandSnapshot.h
+ * @brief 命令注册表的二进制快照文件格式
+ * @details CommandManager::saveSnapshot 把注册表的元数据（命令名、别名、分类、参数和选项定义、
+ *          帮助文本、名称索引）写成一个与加载地址无关的文件；loadSnapshot 用 mmap 映射它并直接使用，
+ *          不逐条重建命令。加载只检查文件头和各段的边界，耗时与命令数无关；
+ *          命令定义在第一次被访问时才从映射中构造，名称索引的槽位直接使用映射中的数组。
+ *
+ * 文件布局（本机字节序，各段按 8 字节对齐，段内位置都是相对文件开头的偏移）：
+ * - SnapshotHeader
+ * - 命令记录 SnapshotCommand[commandCount]，下标即命令ID
+ * - Details 记录 SnapshotDetails[detailsCount]，内容相同的 Details 只写一份
+ * - 参数记录 SnapshotParameter[parameterCount]、选项记录 SnapshotOption[optionCount]
+ * - 字符串引用 uint32_t[refCount]：别名和示例列表
+ * - 名称索引槽位 {hash, ref}[indexCapacity]，与 detail::NameIndex 的槽位布局相同
+ * - 字符串区：每个字符串前有 4 字节长度、后有 '\0'，与 StringPool 的块格式相同；
+ *   名称查找直接比较映射中的字符数据，构造定义时才把字符串复制到字符串池；偏移 0 表示空字符串
+ *
+ * 映射使用 MAP_PRIVATE：名称索引在加载后注册新命令时就地修改，只有被写的页面会复制。
+ * 文件不做整体校验（那需要读完整个文件）；记录中的字符串偏移、列表范围和索引引用在使用时检查，
+ * 越界的值当作空字符串或空列表，损坏的文件不会导致越界读取。
+ */
+
+#ifndef CONSOLE_COMMAND_SNAPSHOT_H
+#define CONSOLE_COMMAND_SNAPSHOT_H
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace ConsoleCommand {
+namespace detail {
+
+constexpr char SNAPSHOT_MAGIC[8] = {'C', 'C', 'M', 'S', 'N', 'A', 'P', '\0'};
+constexpr uint32_t SNAPSHOT_VERSION = 1;
+constexpr uint32_t SNAPSHOT_BYTE_ORDER = 0x01020304;   ///< 以本机字节序写入，读取时不一致说明字节序不同
+constexpr uint32_t SNAPSHOT_NONE = 0xFFFFFFFFu;        ///< 没有 Details
+constexpr char SNAPSHOT_HASH_PROBE[] = "ConsoleCommand";  ///< 检查写入和加载时名称索引的哈希函数是否一致
+
+/**
+ * @brief 快照文件头
+ */
+struct SnapshotHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t headerSize;        ///< sizeof(SnapshotHeader)
+    uint32_t recordSizes;       ///< 各记录大小的组合，结构体布局不同的构建拒绝加载
+    uint64_t fileSize;
+    uint32_t indexHashCheck;    ///< 写入时名称索引对固定字符串的哈希值，不同时不使用文件中的索引
+    uint32_t commandCount;
+    uint32_t detailsCount;
+    uint32_t parameterCount;
+    uint32_t optionCount;
+    uint32_t refCount;
+    uint32_t indexCapacity;     ///< 索引槽位数，2 的幂或 0
+    uint32_t indexUsed;         ///< 非空槽位数
+    uint32_t indexLive;         ///< 有效键数
+    uint32_t indexAliases;      ///< 有效的别名键数
+    uint64_t commandsOffset;
+    uint64_t detailsOffset;
+    uint64_t parametersOffset;
+    uint64_t optionsOffset;
+    uint64_t refsOffset;
+    uint64_t indexOffset;
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+/**
+ * @brief 命令记录
+ */
+struct SnapshotCommand {
+    uint32_t name;          ///< 字符串偏移
+    uint32_t description;
+    uint32_t category;
+    uint32_t aliasFirst;    ///< 别名在字符串引用中的起始位置
+    uint32_t aliasCount;
+    uint32_t details;       ///< Details 记录下标，SNAPSHOT_NONE 表示没有
+    uint32_t flags;         ///< SNAPSHOT_COALESCABLE、SNAPSHOT_BUILTIN
+    uint32_t messageId;     ///< 消息目录的键前缀，0 表示没有
+};
+
+constexpr uint32_t SNAPSHOT_COALESCABLE = 1;
+constexpr uint32_t SNAPSHOT_BUILTIN = 2;
+
+/**
+ * @brief Details 记录
+ */
+struct SnapshotDetails {
+    uint32_t parameterFirst;
+    uint32_t parameterCount;
+    uint32_t optionFirst;
+    uint32_t optionCount;
+    uint32_t exampleFirst;  ///< 示例在字符串引用中的起始位置
+    uint32_t exampleCount;
+    uint32_t usage;
+    uint32_t helpText;
+    uint32_t version;
+    uint32_t author;
+};
+
+/**
+ * @brief 参数记录
+ * @details 内置类型按 type 恢复；用户类型按 typeName 查找，加载时尚未注册的类型名注册为不做检查的类型
+ */
+struct SnapshotParameter {
+    uint32_t name;
+    uint32_t description;
+    uint32_t defaultValue;
+    uint32_t typeName;
+    uint8_t required;
+    uint8_t type;
+    uint8_t reserved[2];
+};
+
+/**
+ * @brief 选项记录
+ */
+struct SnapshotOption {
+    uint32_t name;
+    uint32_t shortName;
+    uint32_t description;
+    uint32_t defaultValue;
+    uint32_t valueType;
+    uint8_t requiresValue;
+    uint8_t reserved[3];
+};
+
+/**
+ * @brief 名称索引槽位，与 NameIndex 的槽位布局相同
+ */
+struct SnapshotSlot {
+    uint32_t hash;
+    uint32_t ref;
+};
+
+inline constexpr uint32_t snapshotRecordSizes() {
+    return static_cast<uint32_t>(sizeof(SnapshotCommand) | sizeof(SnapshotDetails) << 8 |
+                                 sizeof(SnapshotParameter) << 16 | sizeof(SnapshotOption) << 24);
+}
+
+/**
+ * @class SnapshotFile
+ * @brief 一个已映射的快照文件
+ * @details 由 shared_ptr 持有，最后一个引用它的注册表销毁时解除映射
+ */
+class SnapshotFile {
+public:
+    /**
+     * @brief 映射并检查快照文件
+     * @param path 文件路径
+     * @param errorMsg 失败时的错误信息
+     * @return 成功时返回映射，失败返回空指针
+     */
+    static std::shared_ptr<SnapshotFile> open(const std::string& path, std::string& errorMsg) {
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            errorMsg = "无法打开 " + path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        struct stat st;
+        if (::fstat(fd, &st) < 0) {
+            errorMsg = "无法读取 " + path + " 的大小: " + std::strerror(errno);
+            ::close(fd);
+            return nullptr;
+        }
+        size_t size = static_cast<size_t>(st.st_size);
+        if (size < sizeof(SnapshotHeader)) {
+            errorMsg = path + " 不是命令注册表快照（文件太小）";
+            ::close(fd);
+            return nullptr;
+        }
+        void* addr = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (addr == MAP_FAILED) {
+            errorMsg = "无法映射 " + path + ": " + std::strerror(errno);
+            return nullptr;
+        }
+        std::shared_ptr<SnapshotFile> file(new SnapshotFile(static_cast<char*>(addr), size));
+        if (!file->validate(errorMsg)) {
+            errorMsg = path + ": " + errorMsg;
+            return nullptr;
+        }
+        return file;
+    }
+
+    ~SnapshotFile() { ::munmap(base, size); }
+
+    SnapshotFile(const SnapshotFile&) = delete;
+    SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+    const SnapshotHeader& header() const { return *reinterpret_cast<const SnapshotHeader*>(base); }
+    size_t bytes() const { return size; }
+
+    uint32_t commandCount() const { return header().commandCount; }
+    const SnapshotCommand& command(uint32_t id) const { return section<SnapshotCommand>(header().commandsOffset)[id]; }
+
+    const SnapshotDetails* details(uint32_t i) const {
+        return i < header().detailsCount ? &section<SnapshotDetails>(header().detailsOffset)[i] : nullptr;
+    }
+
+    /** @brief 参数记录，范围越界时返回空指针 */
+    const SnapshotParameter* parameters(uint32_t first, uint32_t count) const {
+        return inRange(first, count, header().parameterCount)
+            ? section<SnapshotParameter>(header().parametersOffset) + first : nullptr;
+    }
+
+    const SnapshotOption* options(uint32_t first, uint32_t count) const {
+        return inRange(first, count, header().optionCount)
+            ? section<SnapshotOption>(header().optionsOffset) + first : nullptr;
+    }
+
+    const uint32_t* refs(uint32_t first, uint32_t count) const {
+        return inRange(first, count, header().refCount) ? section<uint32_t>(header().refsOffset) + first : nullptr;
+    }
+
+    /** @brief 名称索引槽位，可以就地修改（私有映射） */
+    SnapshotSlot* indexSlots() const {
+        return reinterpret_cast<SnapshotSlot*>(base + header().indexOffset);
+    }
+
+    /**
+     * @brief 字符串偏移对应的字符数据（前有长度，后有 '\0'）
+     * @return 偏移为 0 或越界时返回空指针
+     */
+    const char* string(uint32_t offset) const {
+        const SnapshotHeader& h = header();
+        if (offset < sizeof(uint32_t) || offset >= h.stringsSize) return nullptr;
+        const char* data = base + h.stringsOffset + offset;
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(uint32_t), sizeof(n));
+        if (n >= h.stringsSize - offset || data[n] != '\0') return nullptr;
+        return data;
+    }
+
+    /** @brief 字符串偏移对应的内容，无效时返回空串 */
+    std::string_view view(uint32_t offset) const {
+        const char* data = string(offset);
+        if (!data) return std::string_view();
+        uint32_t n;
+        std::memcpy(&n, data - sizeof(uint32_t), sizeof(n));
+        return std::string_view(data, n);
+    }
+
+private:
+    char* base;
+    size_t size;
+
+    SnapshotFile(char* b, size_t s) : base(b), size(s) {}
+
+    template<typename T>
+    const T* section(uint64_t offset) const { return reinterpret_cast<const T*>(base + offset); }
+
+    static bool inRange(uint32_t first, uint32_t count, uint32_t total) {
+        return first <= total && count <= total - first;
+    }
+
+    bool sectionFits(uint64_t offset, uint64_t count, size_t elementSize) const {
+        if (offset % 8 != 0 || offset > size) return false;
+        return count <= (size - offset) / elementSize;
+    }
+
+    bool validate(std::string& errorMsg) const {
+        const SnapshotHeader& h = header();
+        if (std::memcmp(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic)) != 0) {
+            errorMsg = "不是命令注册表快照";
+            return false;
+        }
+        if (h.byteOrder != SNAPSHOT_BYTE_ORDER) {
+            errorMsg = "快照的字节序与本机不同";
+            return false;
+        }
+        if (h.version != SNAPSHOT_VERSION || h.headerSize != sizeof(SnapshotHeader) ||
+            h.recordSizes != snapshotRecordSizes()) {
+            errorMsg = "快照版本 " + std::to_string(h.version) + " 与当前版本 " +
+                       std::to_string(SNAPSHOT_VERSION) + " 不兼容";
+            return false;
+        }
+        if (h.fileSize != size) {
+            errorMsg = "快照文件不完整";
+            return false;
+        }
+        if ((h.indexCapacity & (h.indexCapacity - 1)) != 0 || h.indexLive > h.indexUsed ||
+            h.indexUsed > h.indexCapacity || (h.indexCapacity != 0 && h.indexUsed == h.indexCapacity)) {
+            errorMsg = "快照的名称索引无效";
+            return false;
+        }
+        if (!sectionFits(h.commandsOffset, h.commandCount, sizeof(SnapshotCommand)) ||
+            !sectionFits(h.detailsOffset, h.detailsCount, sizeof(SnapshotDetails)) ||
+            !sectionFits(h.parametersOffset, h.parameterCount, sizeof(SnapshotParameter)) ||
+            !sectionFits(h.optionsOffset, h.optionCount, sizeof(SnapshotOption)) ||
+            !sectionFits(h.refsOffset, h.refCount, sizeof(uint32_t)) ||
+            !sectionFits(h.indexOffset, h.indexCapacity, sizeof(SnapshotSlot)) ||
+            !sectionFits(h.stringsOffset, h.stringsSize, 1) || h.stringsSize > UINT32_MAX) {
+            errorMsg = "快照的段超出文件范围";
+            return false;
+        }
+        return true;
+    }
+};
+
+/**
+ * @class SnapshotWriter
+ * @brief 收集快照的各段并写入文件
+ */
+class SnapshotWriter {
+public:
+    SnapshotWriter() { strings.assign(sizeof(uint32_t), '\0'); }   // 偏移 0 保留给空字符串
+
+    std::vector<SnapshotCommand> commands;
+    std::vector<SnapshotDetails> details;
+    std::vector<SnapshotParameter> parameters;
+    std::vector<SnapshotOption> options;
+    std::vector<uint32_t> refs;
+    std::vector<SnapshotSlot> index;
+    uint32_t indexUsed = 0;
+    uint32_t indexLive = 0;
+    uint32_t indexAliases = 0;
+    uint32_t indexHashCheck = 0;
+
+    /**
+     * @brief 添加字符串，相同内容只写一次
+     * @return 字符串偏移，空字符串为 0
+     */
+    uint32_t addString(std::string_view s) {
+        if (s.empty()) return 0;
+        auto it = offsets.find(std::string(s));
+        if (it != offsets.end()) return it->second;
+        uint32_t n = static_cast<uint32_t>(s.size());
+        strings.append(reinterpret_cast<const char*>(&n), sizeof(n));
+        uint32_t offset = static_cast<uint32_t>(strings.size());
+        strings.append(s.data(), s.size());
+        strings.push_back('\0');
+        offsets.emplace(std::string(s), offset);
+        return offset;
+    }
+
+    /**
+     * @brief 原子地写入文件
+     * @details 先写同目录下的临时文件并 fsync，再 rename 覆盖目标文件
+     */
+    bool write(const std::string& path, std::string& errorMsg) const {
+        if (strings.size() > UINT32_MAX) {
+            errorMsg = "快照的字符串区超过 4GB";
+            return false;
+        }
+        SnapshotHeader h;
+        std::memset(&h, 0, sizeof(h));
+        std::memcpy(h.magic, SNAPSHOT_MAGIC, sizeof(h.magic));
+        h.version = SNAPSHOT_VERSION;
+        h.byteOrder = SNAPSHOT_BYTE_ORDER;
+        h.headerSize = sizeof(SnapshotHeader);
+        h.recordSizes = snapshotRecordSizes();
+        h.indexHashCheck = indexHashCheck;
+        h.commandCount = static_cast<uint32_t>(commands.size());
+        h.detailsCount = static_cast<uint32_t>(details.size());
+        h.parameterCount = static_cast<uint32_t>(parameters.size());
+        h.optionCount = static_cast<uint32_t>(options.size());
+        h.refCount = static_cast<uint32_t>(refs.size());
+        h.indexCapacity = static_cast<uint32_t>(index.size());
+        h.indexUsed = indexUsed;
+        h.indexLive = indexLive;
+        h.indexAliases = indexAliases;
+
+        std::string out(sizeof(SnapshotHeader), '\0');
+        h.commandsOffset = appendSection(out, commands);
+        h.detailsOffset = appendSection(out, details);
+        h.parametersOffset = appendSection(out, parameters);
+        h.optionsOffset = appendSection(out, options);
+        h.refsOffset = appendSection(out, refs);
+        h.indexOffset = appendSection(out, index);
+        pad(out);
+        h.stringsOffset = out.size();
+        h.stringsSize = strings.size();
+        out += strings;
+        h.fileSize = out.size();
+        std::memcpy(&out[0], &h, sizeof(h));
+
+        std::string tmp = path + ".tmp." + std::to_string(::getpid());
+        int fd = ::open(tmp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd < 0) {
+            errorMsg = "无法创建 " + tmp + ": " + std::strerror(errno);
+            return false;
+        }
+        size_t offset = 0;
+        while (offset < out.size()) {
+            ssize_t n = ::write(fd, out.data() + offset, out.size() - offset);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                errorMsg = "写入 " + tmp + " 失败: " + std::strerror(errno);
+                ::close(fd);
+                ::unlink(tmp.c_str());
+                return false;
+            }
+            offset += static_cast<size_t>(n);
+        }
+        ::fsync(fd);
+        ::close(fd);
+        if (::rename(tmp.c_str(), path.c_str()) < 0) {
+            errorMsg = "重命名为 " + path + " 失败: " + std::strerror(errno);
+            ::unlink(tmp.c_str());
+            return false;
+        }
+        return true;
+    }
+
+private:
+    std::string strings;                                ///< 字符串区
+    std::unordered_map<std::string, uint32_t> offsets;  ///< 已写入的字符串
+
+    static void pad(std::string& out) {
+        out.resize((out.size() + 7) & ~size_t(7), '\0');
+    }
+
+    template<typename T>
+    static uint64_t appendSection(std::string& out, const std::vector<T>& items) {
+        pad(out);
+        uint64_t offset = out.size();
+        if (!items.empty()) {
+            out.append(reinterpret_cast<const char*>(items.data()), items.size() * sizeof(T));
+        }
+        return offset;
+    }
+};
+
+} // namespace detail
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_SNAPSHOT_H
@@ -0,0 +1,590 @@
+/**
+ * @file ConsoleCommandStats.h
+ * @brief 按命令统计延迟分布和执行结果
+ * @details CommandManager::processCommand 对每个已知命令记录一次耗时和结果（成功/失败/异常）。
+ *
+ * 设计要点：
+ * - 延迟使用 HDR 风格的对数-线性直方图：每个2的幂区间再均分为16个子桶，
+ *   相对误差约6%，覆盖 1ns 到 uint64 上限，记录一次只需一次位运算和一次加法
+ * - 每个线程写入自己的分片，计数器只有所属线程修改（relaxed 读改写，不需要原子 RMW），
+ *   读取方遍历所有分片合并，因此记录路径无锁、无共享缓存行
+ * - 重置通过递增纪元实现：写入方发现计数器纪元过期时先清零再记录，
+ *   读取方忽略过期的计数器，不需要与写入方同步
+ * - 线程退出时分片被标记为空闲，后续新线程复用，短生命周期线程不会让分片无限增长
+ * - 开启性能计数器时（见 ConsoleCommandPerf.h），每次执行的计数器差值同样累计到分片中
+ */
+
+#ifndef CONSOLE_COMMAND_STATS_H
+#define CONSOLE_COMMAND_STATS_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "ConsoleCommandPerf.h"
+
+namespace ConsoleCommand {
+
+// ============================================================================
+// 延迟直方图
+// ============================================================================
+
+/**
+ * @class LatencyHistogram
+ * @brief 对数-线性分桶的延迟直方图（纳秒）
+ */
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 4;                     ///< 每个2的幂区间的子桶位数
+    static constexpr size_t SUB_BUCKETS = size_t(1) << SUB_BUCKET_BITS;  ///< 每个2的幂区间的子桶数
+    static constexpr size_t BUCKET_COUNT = (64 - SUB_BUCKET_BITS + 1) * SUB_BUCKETS;  ///< 桶总数
+
+private:
+    std::array<uint64_t, BUCKET_COUNT> counts{};  ///< 各桶计数
+    uint64_t total = 0;                           ///< 样本数
+    uint64_t sum = 0;                             ///< 样本总和
+    uint64_t maxValue = 0;                        ///< 最大样本
+
+public:
+    /**
+     * @brief 计算数值所在的桶
+     * @param value 数值
+     * @return 桶下标
+     */
+    static size_t bucketIndex(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned msb = 63u - static_cast<unsigned>(countLeadingZeros(value));
+        unsigned shift = msb - SUB_BUCKET_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>((value >> shift) - SUB_BUCKETS);
+    }
+
+    /**
+     * @brief 获取桶能表示的最小值
+     */
+    static uint64_t bucketLowerBound(size_t index) {
+        if (index < SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        return static_cast<uint64_t>(SUB_BUCKETS + index % SUB_BUCKETS) << shift;
+    }
+
+    /**
+     * @brief 获取桶能表示的最大值
+     */
+    static uint64_t bucketUpperBound(size_t index) {
+        if (index < SUB_BUCKETS) return index;
+        unsigned shift = static_cast<unsigned>(index / SUB_BUCKETS) - 1;
+        return bucketLowerBound(index) + ((uint64_t(1) << shift) - 1);
+    }
+
+    /**
+     * @brief 记录一个样本
+     */
+    void record(uint64_t value) {
+        ++counts[bucketIndex(value)];
+        ++total;
+        sum += value;
+        maxValue = std::max(maxValue, value);
+    }
+
+    /**
+     * @brief 按桶累加计数
+     * @param index 桶下标
+     * @param count 计数
+     */
+    void addBucket(size_t index, uint64_t count) {
+        counts[index] += count;
+        total += count;
+    }
+
+    /**
+     * @brief 累加样本总和与最大值（与 addBucket 配合用于合并分片）
+     */
+    void addSummary(uint64_t sampleSum, uint64_t sampleMax) {
+        sum += sampleSum;
+        maxValue = std::max(maxValue, sampleMax);
+    }
+
+    /**
+     * @brief 合并另一个直方图
+     */
+    void merge(const LatencyHistogram& other) {
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) counts[i] += other.counts[i];
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    /**
+     * @brief 计算分位数
+     * @param p 分位（0.0 ~ 1.0）
+     * @return 分位数所在桶的上界（不超过最大样本），没有样本时返回0
+     */
+    uint64_t percentile(double p) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total) + 0.5);
+        rank = std::min(std::max<uint64_t>(rank, 1), total);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKET_COUNT; ++i) {
+            seen += counts[i];
+            if (seen >= rank) return std::min(bucketUpperBound(i), maxValue);
+        }
+        return maxValue;
+    }
+
+    uint64_t count() const { return total; }
+    uint64_t max() const { return maxValue; }
+    uint64_t getSum() const { return sum; }
+    uint64_t bucketCount(size_t index) const { return counts[index]; }
+
+    /**
+     * @brief 计算平均值
+     */
+    double mean() const { return total ? static_cast<double>(sum) / static_cast<double>(total) : 0.0; }
+
+private:
+    static int countLeadingZeros(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_clzll(value);
+#else
+        int n = 0;
+        for (uint64_t bit = uint64_t(1) << 63; !(value & bit); bit >>= 1) ++n;
+        return n;
+#endif
+    }
+};
+
+// ============================================================================
+// 统计快照
+// ============================================================================
+
+/**
+ * @struct CommandStatsSnapshot
+ * @brief 单个命令的统计快照
+ */
+struct CommandStatsSnapshot {
+    std::string name;               ///< 命令名称
+    uint32_t commandId = 0;         ///< 命令ID
+    uint64_t successes = 0;         ///< 执行成功次数
+    uint64_t failures = 0;          ///< 执行失败次数（含参数验证失败）
+    uint64_t exceptions = 0;        ///< 执行器抛出异常的次数
+    LatencyHistogram latency;       ///< 延迟分布（纳秒）
+    uint64_t perfSamples = 0;       ///< 带性能计数器读数的执行次数
+    PerfSample perf;                ///< 性能计数器累计值，perf.events 为各次读数共有的事件
+
+    /** @brief 总调用次数 */
+    uint64_t calls() const { return successes + failures + exceptions; }
+};
+
+/**
+ * @struct StatsSnapshot
+ * @brief 所有命令的统计快照
+ */
+struct StatsSnapshot {
+    std::vector<CommandStatsSnapshot> commands;  ///< 有调用记录的命令，按调用次数降序
+    uint64_t unknownCommands = 0;                ///< 未知命令的次数
+    double elapsedSeconds = 0.0;                 ///< 自上次重置以来的秒数
+
+    /**
+     * @brief 按名称查找命令统计
+     * @return 找不到返回nullptr
+     */
+    const CommandStatsSnapshot* find(const std::string& name) const {
+        for (const auto& c : commands) {
+            if (c.name == name) return &c;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief 计算命令的每秒调用次数
+     */
+    double qps(const CommandStatsSnapshot& c) const {
+        return elapsedSeconds > 0.0 ? static_cast<double>(c.calls()) / elapsedSeconds : 0.0;
+    }
+};
+
+/**
+ * @brief 把纳秒数格式化为带单位的短字符串
+ * @param nanos 纳秒
+ * @return 例如 "850ns"、"12.3us"、"4.56ms"、"1.20s"
+ */
+inline std::string formatDuration(uint64_t nanos) {
+    char buf[32];
+    double v = static_cast<double>(nanos);
+    if (nanos < 1000) std::snprintf(buf, sizeof(buf), "%lluns", static_cast<unsigned long long>(nanos));
+    else if (nanos < 1000000) std::snprintf(buf, sizeof(buf), "%.1fus", v / 1e3);
+    else if (nanos < 1000000000) std::snprintf(buf, sizeof(buf), "%.2fms", v / 1e6);
+    else std::snprintf(buf, sizeof(buf), "%.2fs", v / 1e9);
+    return buf;
+}
+
+// ============================================================================
+// 分片存储
+// ============================================================================
+
+namespace detail {
+
+/**
+ * @brief 只由单个线程写入的计数器递增
+ * @details 读取方可能并发读取，因此仍然是原子变量，但写入不需要 lock 前缀的 RMW
+ */
+inline void bump(std::atomic<uint64_t>& counter, uint64_t delta = 1) {
+    counter.store(counter.load(std::memory_order_relaxed) + delta, std::memory_order_relaxed);
+}
+
+/**
+ * @brief 单个线程中单个命令的计数器
+ */
+struct CommandCounters {
+    std::atomic<uint64_t> epoch{0};       ///< 计数器所属的纪元，过期时视为零
+    std::atomic<uint64_t> successes{0};
+    std::atomic<uint64_t> failures{0};
+    std::atomic<uint64_t> exceptions{0};
+    std::atomic<uint64_t> sumNanos{0};
+    std::atomic<uint64_t> maxNanos{0};
+    std::array<std::atomic<uint64_t>, LatencyHistogram::BUCKET_COUNT> buckets{};
+    std::atomic<uint64_t> perfSamples{0};
+    std::atomic<uint32_t> perfEvents{0};  ///< 各次读数共有的事件
+    std::atomic<uint64_t> perfTaskClock{0};
+    std::atomic<uint64_t> perfCycles{0};
+    std::atomic<uint64_t> perfInstructions{0};
+    std::atomic<uint64_t> perfCacheMisses{0};
+    std::atomic<uint64_t> perfBranchMisses{0};
+
+    void clear() {
+        successes.store(0, std::memory_order_relaxed);
+        failures.store(0, std::memory_order_relaxed);
+        exceptions.store(0, std::memory_order_relaxed);
+        sumNanos.store(0, std::memory_order_relaxed);
+        maxNanos.store(0, std::memory_order_relaxed);
+        for (auto& b : buckets) b.store(0, std::memory_order_relaxed);
+        perfSamples.store(0, std::memory_order_relaxed);
+        perfEvents.store(0, std::memory_order_relaxed);
+        perfTaskClock.store(0, std::memory_order_relaxed);
+        perfCycles.store(0, std::memory_order_relaxed);
+        perfInstructions.store(0, std::memory_order_relaxed);
+        perfCacheMisses.store(0, std::memory_order_relaxed);
+        perfBranchMisses.store(0, std::memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief 一个线程的统计分片
+ * @details 命令ID到计数器的表只由所属线程扩容：新表发布后旧表保留到分片销毁，
+ *          读取方因此可以随时无锁遍历
+ */
+class StatsShard {
+private:
+    struct Table {
+        size_t size;
+        std::unique_ptr<std::atomic<CommandCounters*>[]> slots;
+        explicit Table(size_t n) : size(n), slots(new std::atomic<CommandCounters*>[n]) {
+            for (size_t i = 0; i < n; ++i) slots[i].store(nullptr, std::memory_order_relaxed);
+        }
+    };
+
+    std::atomic<Table*> table{nullptr};
+    std::vector<std::unique_ptr<Table>> tables;               ///< 所有表（只由所属线程修改）
+    std::vector<std::unique_ptr<CommandCounters>> owned;      ///< 所有计数器（只由所属线程修改）
+
+public:
+    std::atomic<bool> inUse{true};           ///< 是否有线程正在使用该分片
+    std::atomic<uint64_t> unknownEpoch{0};   ///< 未知命令计数所属的纪元
+    std::atomic<uint64_t> unknown{0};        ///< 未知命令计数
+
+    /**
+     * @brief 获取命令的计数器（仅所属线程调用）
+     */
+    CommandCounters& at(uint32_t commandId) {
+        Table* t = table.load(std::memory_order_relaxed);
+        if (!t || commandId >= t->size) {
+            t = grow(commandId);
+        }
+        CommandCounters* c = t->slots[commandId].load(std::memory_order_relaxed);
+        if (!c) {
+            owned.emplace_back(new CommandCounters());
+            c = owned.back().get();
+            t->slots[commandId].store(c, std::memory_order_release);
+        }
+        return *c;
+    }
+
+    /**
+     * @brief 遍历所有计数器（可由任意线程调用）
+     */
+    template<typename Func>
+    void forEach(Func&& func) const {
+        Table* t = table.load(std::memory_order_acquire);
+        if (!t) return;
+        for (size_t i = 0; i < t->size; ++i) {
+            CommandCounters* c = t->slots[i].load(std::memory_order_acquire);
+            if (c) func(static_cast<uint32_t>(i), *c);
+        }
+    }
+
+private:
+    Table* grow(uint32_t commandId) {
+        Table* old = table.load(std::memory_order_relaxed);
+        size_t size = old ? old->size : 16;
+        while (size <= commandId) size *= 2;
+
+        tables.emplace_back(new Table(size));
+        Table* t = tables.back().get();
+        if (old) {
+            for (size_t i = 0; i < old->size; ++i) {
+                t->slots[i].store(old->slots[i].load(std::memory_order_relaxed), std::memory_order_relaxed);
+            }
+        }
+        table.store(t, std::memory_order_release);
+        return t;
+    }
+};
+
+} // namespace detail
+
+// ============================================================================
+// 统计收集器
+// ============================================================================
+
+/**
+ * @class CommandStats
+ * @brief 线程分片的命令统计收集器
+ */
+class CommandStats {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @enum Outcome
+     * @brief 命令执行结果
+     */
+    enum class Outcome {
+        Success,    ///< 执行成功
+        Failure,    ///< 执行失败或参数验证失败
+        Exception   ///< 执行器抛出异常
+    };
+
+private:
+    const uint64_t instanceId;                  ///< 进程内唯一ID，用于线程本地缓存
+    std::atomic<uint64_t> epoch{1};             ///< 当前纪元，重置时递增
+    std::atomic<int64_t> startNanos;            ///< 上次重置的时间
+
+    mutable std::mutex shardsMutex;             ///< 只保护分片列表，不在记录路径上
+    std::vector<std::shared_ptr<detail::StatsShard>> shards;
+
+public:
+    CommandStats() : instanceId(nextInstanceId()), startNanos(nowNanos()) {}
+
+    CommandStats(const CommandStats&) = delete;
+    CommandStats& operator=(const CommandStats&) = delete;
+
+    /**
+     * @brief 记录一次命令执行
+     * @param commandId 命令ID
+     * @param outcome 执行结果
+     * @param nanos 耗时（纳秒）
+     * @details 只写当前线程的分片，无锁
+     */
+    void record(uint32_t commandId, Outcome outcome, uint64_t nanos) {
+        detail::CommandCounters& c = localShard().at(commandId);
+        uint64_t current = epoch.load(std::memory_order_relaxed);
+        if (c.epoch.load(std::memory_order_relaxed) != current) {
+            c.clear();
+            c.epoch.store(current, std::memory_order_release);
+        }
+
+        switch (outcome) {
+            case Outcome::Success:   detail::bump(c.successes); break;
+            case Outcome::Failure:   detail::bump(c.failures); break;
+            case Outcome::Exception: detail::bump(c.exceptions); break;
+        }
+        detail::bump(c.sumNanos, nanos);
+        if (nanos > c.maxNanos.load(std::memory_order_relaxed)) {
+            c.maxNanos.store(nanos, std::memory_order_relaxed);
+        }
+        detail::bump(c.buckets[LatencyHistogram::bucketIndex(nanos)]);
+    }
+
+    /**
+     * @brief 记录一次执行的性能计数器差值
+     * @param commandId 命令ID
+     * @param sample 执行前后读数的差值
+     * @details 与 record() 一样只写当前线程的分片；应在同一次执行的 record() 之前调用，
+     *          保证纪元切换时两者落在同一纪元
+     */
+    void recordPerf(uint32_t commandId, const PerfSample& sample) {
+        detail::CommandCounters& c = localShard().at(commandId);
+        uint64_t current = epoch.load(std::memory_order_relaxed);
+        if (c.epoch.load(std::memory_order_relaxed) != current) {
+            c.clear();
+            c.epoch.store(current, std::memory_order_release);
+        }
+
+        uint32_t events = c.perfSamples.load(std::memory_order_relaxed) == 0
+            ? sample.events : (c.perfEvents.load(std::memory_order_relaxed) & sample.events);
+        c.perfEvents.store(events, std::memory_order_relaxed);
+        detail::bump(c.perfSamples);
+        detail::bump(c.perfTaskClock, sample.taskClockNanos);
+        detail::bump(c.perfCycles, sample.cycles);
+        detail::bump(c.perfInstructions, sample.instructions);
+        detail::bump(c.perfCacheMisses, sample.cacheMisses);
+        detail::bump(c.perfBranchMisses, sample.branchMisses);
+    }
+
+    /**
+     * @brief 记录一次未知命令
+     */
+    void recordUnknown() {
+        detail::StatsShard& shard = localShard();
+        uint64_t current = epoch.load(std::memory_order_relaxed);
+        if (shard.unknownEpoch.load(std::memory_order_relaxed) != current) {
+            shard.unknown.store(0, std::memory_order_relaxed);
+            shard.unknownEpoch.store(current, std::memory_order_release);
+        }
+        detail::bump(shard.unknown);
+    }
+
+    /**
+     * @brief 合并所有分片得到快照
+     * @param names 命令ID到名称的映射（ID即下标）
+     * @return 快照，命令按调用次数降序排列
+     */
+    StatsSnapshot snapshot(const std::vector<std::string>& names) const {
+        StatsSnapshot result;
+        uint64_t current = epoch.load(std::memory_order_acquire);
+        result.elapsedSeconds = static_cast<double>(nowNanos() - startNanos.load(std::memory_order_relaxed)) / 1e9;
+
+        std::vector<std::unique_ptr<CommandStatsSnapshot>> byId;
+        std::lock_guard<std::mutex> lock(shardsMutex);
+        for (const auto& shard : shards) {
+            if (shard->unknownEpoch.load(std::memory_order_acquire) == current) {
+                result.unknownCommands += shard->unknown.load(std::memory_order_relaxed);
+            }
+            shard->forEach([&](uint32_t id, const detail::CommandCounters& c) {
+                if (c.epoch.load(std::memory_order_acquire) != current) return;
+                if (byId.size() <= id) byId.resize(id + 1);
+                if (!byId[id]) {
+                    byId[id].reset(new CommandStatsSnapshot());
+                    byId[id]->commandId = id;
+                    if (id < names.size()) byId[id]->name = names[id];
+                }
+                CommandStatsSnapshot& s = *byId[id];
+                s.successes += c.successes.load(std::memory_order_relaxed);
+                s.failures += c.failures.load(std::memory_order_relaxed);
+                s.exceptions += c.exceptions.load(std::memory_order_relaxed);
+                for (size_t i = 0; i < LatencyHistogram::BUCKET_COUNT; ++i) {
+                    uint64_t n = c.buckets[i].load(std::memory_order_relaxed);
+                    if (n) s.latency.addBucket(i, n);
+                }
+                s.latency.addSummary(c.sumNanos.load(std::memory_order_relaxed),
+                                     c.maxNanos.load(std::memory_order_relaxed));
+
+                uint64_t perfSamples = c.perfSamples.load(std::memory_order_relaxed);
+                if (perfSamples > 0) {
+                    uint32_t events = c.perfEvents.load(std::memory_order_relaxed);
+                    s.perf.events = s.perfSamples == 0 ? events : (s.perf.events & events);
+                    s.perfSamples += perfSamples;
+                    s.perf.taskClockNanos += c.perfTaskClock.load(std::memory_order_relaxed);
+                    s.perf.cycles += c.perfCycles.load(std::memory_order_relaxed);
+                    s.perf.instructions += c.perfInstructions.load(std::memory_order_relaxed);
+                    s.perf.cacheMisses += c.perfCacheMisses.load(std::memory_order_relaxed);
+                    s.perf.branchMisses += c.perfBranchMisses.load(std::memory_order_relaxed);
+                }
+            });
+        }
+
+        for (auto& s : byId) {
+            if (s && s->calls() > 0) result.commands.push_back(std::move(*s));
+        }
+        std::stable_sort(result.commands.begin(), result.commands.end(),
+                         [](const CommandStatsSnapshot& a, const CommandStatsSnapshot& b) {
+                             return a.calls() > b.calls();
+                         });
+        return result;
+    }
+
+    /**
+     * @brief 清空所有统计并重新开始计时
+     */
+    void reset() {
+        startNanos.store(nowNanos(), std::memory_order_relaxed);
+        epoch.fetch_add(1, std::memory_order_release);
+    }
+
+private:
+    static uint64_t nextInstanceId() {
+        static std::atomic<uint64_t> counter{0};
+        return ++counter;
+    }
+
+    static int64_t nowNanos() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    /**
+     * @brief 获取当前线程在本收集器中的分片
+     * @details 快速路径只扫描线程本地的小数组；首次使用时复用空闲分片或创建新分片
+     */
+    detail::StatsShard& localShard() {
+        // 最近使用的分片，平凡类型的线程本地变量不需要初始化检查
+        thread_local uint64_t lastOwner = 0;
+        thread_local detail::StatsShard* lastShard = nullptr;
+        if (lastOwner == instanceId) return *lastShard;
+
+        struct Entry {
+            uint64_t owner;
+            std::shared_ptr<detail::StatsShard> shard;
+        };
+        struct Cache {
+            std::vector<Entry> entries;
+            ~Cache() {
+                for (auto& e : entries) e.shard->inUse.store(false, std::memory_order_release);
+            }
+        };
+        thread_local Cache cache;
+
+        for (auto& e : cache.entries) {
+            if (e.owner == instanceId) {
+                lastOwner = instanceId;
+                lastShard = e.shard.get();
+                return *e.shard;
+            }
+        }
+
+        // 清理已销毁的收集器留下的条目
+        cache.entries.erase(std::remove_if(cache.entries.begin(), cache.entries.end(),
+                                           [](const Entry& e) { return e.shard.use_count() == 1; }),
+                            cache.entries.end());
+
+        std::shared_ptr<detail::StatsShard> shard;
+        {
+            std::lock_guard<std::mutex> lock(shardsMutex);
+            for (auto& s : shards) {
+                bool idle = false;
+                if (s->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+                    shard = s;
+                    break;
+                }
+            }
+            if (!shard) {
+                shard = std::make_shared<detail::StatsShard>();
+                shards.push_back(shard);
+            }
+        }
+        cache.entries.push_back(Entry{instanceId, shard});
+        lastOwner = instanceId;
+        lastShard = shard.get();
+        return *shard;
+    }
+};
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_STATS_H
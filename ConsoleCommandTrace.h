@@ -0,0 +1,316 @@
+/**
+ * @file ConsoleCommandTrace.h
+ * @brief 命令处理各阶段的轻量追踪
+ * @details 在命令处理的关键阶段（分词、查找、验证、执行、帮助生成、输出发送）放置作用域追踪点，
+ *          追踪开启时每个追踪点把开始时间和耗时写入当前线程的环形缓冲区，
+ *          导出为 Chrome trace_event JSON，可在 chrome://tracing 或 Perfetto 中查看。
+ *
+ * 开销：
+ * - 编译时定义 CCM_DISABLE_TRACING 后，CCM_TRACE_SPAN 展开为空语句，没有任何开销
+ * - 编译进来但未开启时，每个追踪点只有一次 relaxed 原子读取和一次分支
+ * - 开启时每个追踪点读取两次时钟，并写入线程本地缓冲区，不加锁
+ *
+ * 环形缓冲区写满后覆盖最旧的事件，因此导出的总是每个线程最近的事件。
+ *
+ * 使用示例：
+ * @code
+ * void parse() {
+ *     CCM_TRACE_SPAN("tokenize");
+ *     ...
+ * }
+ * ConsoleCommand::Tracer::start();
+ * ...
+ * ConsoleCommand::Tracer::stop();
+ * std::ofstream out("trace.json");
+ * ConsoleCommand::Tracer::writeChromeTrace(out);
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_TRACE_H
+#define CONSOLE_COMMAND_TRACE_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace ConsoleCommand {
+
+const uint32_t TRACE_NO_COMMAND = 0xFFFFFFFFu;      ///< 追踪事件不关联命令
+const size_t TRACE_RING_CAPACITY = 1 << 15;         ///< 每个线程保留的最近事件数
+
+namespace detail {
+
+/**
+ * @brief 一个已完成的追踪事件
+ * @details 字段都是原子变量，导出时可以与写入线程并发读取；x86 上 relaxed 存取就是普通的 mov
+ */
+struct TraceEvent {
+    std::atomic<const char*> name{nullptr};       ///< 阶段名称，必须是静态字符串
+    std::atomic<uint32_t> commandId{TRACE_NO_COMMAND};  ///< 关联的命令ID
+    std::atomic<uint64_t> start{0};               ///< 开始时间（纳秒）
+    std::atomic<uint64_t> duration{0};            ///< 耗时（纳秒）
+};
+
+/**
+ * @brief 一个线程的环形事件缓冲区，只由所属线程写入
+ */
+struct TraceRing {
+    std::unique_ptr<TraceEvent[]> events{new TraceEvent[TRACE_RING_CAPACITY]};
+    std::atomic<uint64_t> head{0};        ///< 已写入的事件总数
+    std::atomic<uint64_t> generation{0};  ///< 缓冲区内容所属的追踪轮次
+    std::atomic<bool> inUse{true};        ///< 是否有线程正在使用
+    uint32_t threadId = 0;                ///< 导出时使用的线程编号
+};
+
+} // namespace detail
+
+/**
+ * @class Tracer
+ * @brief 进程级追踪控制
+ */
+class Tracer {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief 追踪是否开启
+     */
+    static bool enabled() {
+        return active.load(std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief 开始新一轮追踪，丢弃上一轮的事件
+     */
+    static void start() {
+        State& s = state();
+        s.generation.fetch_add(1, std::memory_order_relaxed);
+        s.startNanos.store(nowNanos(), std::memory_order_relaxed);
+        active.store(true, std::memory_order_release);
+    }
+
+    /**
+     * @brief 停止追踪，已记录的事件保留到下次 start()
+     */
+    static void stop() {
+        active.store(false, std::memory_order_release);
+    }
+
+    /**
+     * @brief 获取当前纳秒时间戳
+     */
+    static uint64_t nowNanos() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+            Clock::now().time_since_epoch()).count());
+    }
+
+    /**
+     * @brief 记录一个已完成的事件
+     * @param name 阶段名称（静态字符串）
+     * @param commandId 关联的命令ID
+     * @param start 开始时间（纳秒）
+     * @param end 结束时间（纳秒）
+     */
+    static void record(const char* name, uint32_t commandId, uint64_t start, uint64_t end) {
+        State& s = state();
+        detail::TraceRing& ring = localRing();
+        uint64_t generation = s.generation.load(std::memory_order_relaxed);
+        if (ring.generation.load(std::memory_order_relaxed) != generation) {
+            ring.head.store(0, std::memory_order_relaxed);
+            ring.generation.store(generation, std::memory_order_release);
+        }
+
+        uint64_t index = ring.head.load(std::memory_order_relaxed);
+        detail::TraceEvent& e = ring.events[index % TRACE_RING_CAPACITY];
+        e.name.store(name, std::memory_order_relaxed);
+        e.commandId.store(commandId, std::memory_order_relaxed);
+        e.start.store(start, std::memory_order_relaxed);
+        e.duration.store(end - start, std::memory_order_relaxed);
+        ring.head.store(index + 1, std::memory_order_release);
+    }
+
+    /**
+     * @brief 获取本轮追踪中仍保留的事件数
+     */
+    static size_t eventCount() {
+        State& s = state();
+        uint64_t generation = s.generation.load(std::memory_order_relaxed);
+        size_t total = 0;
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& ring : s.rings) {
+            if (ring->generation.load(std::memory_order_acquire) != generation) continue;
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            total += static_cast<size_t>(std::min<uint64_t>(head, TRACE_RING_CAPACITY));
+        }
+        return total;
+    }
+
+    /**
+     * @brief 以 Chrome trace_event JSON 格式导出本轮追踪的事件
+     * @param os 输出流
+     * @param commandNames 命令ID到名称的映射，用于事件参数
+     * @return 导出的事件数
+     * @details 可以在追踪进行中调用，导出期间被覆盖的事件会被丢弃
+     */
+    static size_t writeChromeTrace(std::ostream& os, const std::vector<std::string>& commandNames = {}) {
+        State& s = state();
+        uint64_t generation = s.generation.load(std::memory_order_relaxed);
+        uint64_t origin = static_cast<uint64_t>(s.startNanos.load(std::memory_order_relaxed));
+        size_t written = 0;
+
+        os << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (const auto& ring : s.rings) {
+            if (ring->generation.load(std::memory_order_acquire) != generation) continue;
+
+            os << (written ? ",\n" : "\n")
+               << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->threadId
+               << ",\"args\":{\"name\":\"thread " << ring->threadId << "\"}}";
+            ++written;
+
+            uint64_t head = ring->head.load(std::memory_order_acquire);
+            uint64_t first = head > TRACE_RING_CAPACITY ? head - TRACE_RING_CAPACITY : 0;
+            for (uint64_t i = first; i < head; ++i) {
+                const detail::TraceEvent& e = ring->events[i % TRACE_RING_CAPACITY];
+                const char* name = e.name.load(std::memory_order_relaxed);
+                uint32_t commandId = e.commandId.load(std::memory_order_relaxed);
+                uint64_t start = e.start.load(std::memory_order_relaxed);
+                uint64_t duration = e.duration.load(std::memory_order_relaxed);
+
+                // 读取期间写入方可能已经绕回覆盖了这个位置
+                uint64_t now = ring->head.load(std::memory_order_acquire);
+                if (now > TRACE_RING_CAPACITY && i < now - TRACE_RING_CAPACITY) continue;
+                if (!name || start < origin) continue;
+
+                os << ",\n{\"name\":\"" << name << "\",\"cat\":\"ccm\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                   << ring->threadId << ",\"ts\":";
+                writeMicros(os, start - origin);
+                os << ",\"dur\":";
+                writeMicros(os, duration);
+                if (commandId != TRACE_NO_COMMAND && commandId < commandNames.size()) {
+                    os << ",\"args\":{\"command\":\"";
+                    writeEscaped(os, commandNames[commandId]);
+                    os << "\"}";
+                }
+                os << "}";
+                ++written;
+            }
+        }
+        os << "\n]}\n";
+        return written;
+    }
+
+private:
+    /// 开关单独存放：常量初始化的静态成员不需要函数内静态变量的初始化检查
+    static inline std::atomic<bool> active{false};
+
+    struct State {
+        std::atomic<uint64_t> generation{0};
+        std::atomic<int64_t> startNanos{0};
+        std::mutex mutex;                                       ///< 只保护缓冲区列表
+        std::vector<std::shared_ptr<detail::TraceRing>> rings;
+        uint32_t nextThreadId = 1;
+    };
+
+    static State& state() {
+        static State s;
+        return s;
+    }
+
+    /**
+     * @brief 获取当前线程的缓冲区，首次使用时复用空闲缓冲区或创建新缓冲区
+     */
+    static detail::TraceRing& localRing() {
+        thread_local detail::TraceRing* cached = nullptr;
+        if (cached) return *cached;
+
+        struct Holder {
+            std::shared_ptr<detail::TraceRing> ring;
+            ~Holder() {
+                if (ring) ring->inUse.store(false, std::memory_order_release);
+            }
+        };
+        thread_local Holder holder;
+
+        State& s = state();
+        std::lock_guard<std::mutex> lock(s.mutex);
+        for (auto& r : s.rings) {
+            bool idle = false;
+            if (r->inUse.compare_exchange_strong(idle, true, std::memory_order_acquire)) {
+                holder.ring = r;
+                break;
+            }
+        }
+        if (!holder.ring) {
+            holder.ring = std::make_shared<detail::TraceRing>();
+            holder.ring->threadId = s.nextThreadId++;
+            s.rings.push_back(holder.ring);
+        }
+        cached = holder.ring.get();
+        return *cached;
+    }
+
+    static void writeMicros(std::ostream& os, uint64_t nanos) {
+        os << nanos / 1000 << '.';
+        uint64_t frac = nanos % 1000;
+        os << static_cast<char>('0' + frac / 100) << static_cast<char>('0' + frac / 10 % 10)
+           << static_cast<char>('0' + frac % 10);
+    }
+
+    static void writeEscaped(std::ostream& os, const std::string& s) {
+        for (char c : s) {
+            if (c == '"' || c == '\\') os << '\\' << c;
+            else if (static_cast<unsigned char>(c) < 0x20) os << ' ';
+            else os << c;
+        }
+    }
+};
+
+/**
+ * @class TraceSpan
+ * @brief 作用域追踪点，析构时记录从构造到析构的耗时
+ */
+class TraceSpan {
+private:
+    const char* name;
+    uint32_t commandId;
+    uint64_t start;
+
+public:
+    explicit TraceSpan(const char* n, uint32_t id = TRACE_NO_COMMAND)
+        : name(n), commandId(id), start(Tracer::enabled() ? Tracer::nowNanos() : 0) {}
+
+    ~TraceSpan() {
+        if (start != 0) {
+            Tracer::record(name, commandId, start, Tracer::nowNanos());
+        }
+    }
+
+    TraceSpan(const TraceSpan&) = delete;
+    TraceSpan& operator=(const TraceSpan&) = delete;
+};
+
+} // namespace ConsoleCommand
+
+#define CCM_TRACE_CONCAT_INNER(a, b) a##b
+#define CCM_TRACE_CONCAT(a, b) CCM_TRACE_CONCAT_INNER(a, b)
+
+#ifndef CCM_DISABLE_TRACING
+/// 追踪当前作用域，name 必须是静态字符串
+#define CCM_TRACE_SPAN(name) \
+    ::ConsoleCommand::TraceSpan CCM_TRACE_CONCAT(ccmTraceSpan, __LINE__)(name)
+/// 追踪当前作用域并关联命令ID
+#define CCM_TRACE_SPAN_CMD(name, commandId) \
+    ::ConsoleCommand::TraceSpan CCM_TRACE_CONCAT(ccmTraceSpan, __LINE__)(name, commandId)
+#else
+#define CCM_TRACE_SPAN(name) ((void)0)
+#define CCM_TRACE_SPAN_CMD(name, commandId) ((void)0)
+#endif
+
+#endif // CONSOLE_COMMAND_TRACE_H
@@ -0,0 +1,405 @@
+/**
+ * @file ConsoleCommandWorkload.h
+ * @brief 合成负载生成与回放
+ * @details WorkloadGenerator 根据管理器中已注册命令的参数和选项定义生成命令行，
+ *          replayWorkload 把生成的命令流逐条解析执行（与 processString 相同的路径）或交给 processBatch，
+ *          统计吞吐量和延迟分位数。
+ *
+ * 负载分布（WorkloadSpec）：
+ * - 命令热度服从 Zipf 分布，排名由种子打乱，与命令名的字母顺序无关
+ * - 必需参数总是生成，可选参数和选项按概率生成；值按参数类型生成，长度在给定范围内
+ * - 一定比例的命令名带有拼写错误（替换、删除、插入或交换一个字符），走未知命令和建议路径
+ * - 一定比例的值包含空格并用引号括起，走分词器的引号处理路径
+ *
+ * 随机数只使用 std::mt19937_64 的原始输出并自行映射到区间，
+ * 同一种子和注册表在不同标准库实现上生成完全相同的命令流。
+ *
+ * 使用示例：
+ * @code
+ * ConsoleCommand::WorkloadSpec spec;
+ * spec.seed = 7;
+ * spec.typoRate = 0.02;
+ * ConsoleCommand::WorkloadGenerator generator(manager, spec);
+ * std::vector<std::string> lines = generator.generate(100000);
+ * ConsoleCommand::ReplayReport report = ConsoleCommand::replayWorkload(manager, lines);
+ * @endcode
+ */
+
+#ifndef CONSOLE_COMMAND_WORKLOAD_H
+#define CONSOLE_COMMAND_WORKLOAD_H
+
+#include "ConsoleCommandManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <ostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace ConsoleCommand {
+
+/**
+ * @struct WorkloadSpec
+ * @brief 合成负载的分布参数
+ */
+struct WorkloadSpec {
+    uint64_t seed = 1;                  ///< 随机种子，相同种子和注册表生成相同的命令流
+    double zipfExponent = 1.0;          ///< 命令热度的 Zipf 指数，0 表示均匀分布
+    size_t minValueLength = 1;          ///< 生成的参数值最短长度
+    size_t maxValueLength = 16;         ///< 生成的参数值最长长度
+    double optionalRate = 0.5;          ///< 每个可选参数出现的概率
+    double optionRate = 0.3;            ///< 每个选项出现的概率
+    double typoRate = 0.0;              ///< 命令名带拼写错误的概率
+    double quoteRate = 0.1;             ///< 参数值含空格并加引号的概率
+    std::vector<std::string> commands;  ///< 参与生成的命令，为空时使用除内置命令（CommandDefinition::isBuiltin()）外的全部命令
+};
+
+/**
+ * @class WorkloadGenerator
+ * @brief 按 WorkloadSpec 生成可复现的命令流
+ * @details 构造时复制所需的命令定义，之后与管理器无关，可以在另一个线程中生成
+ */
+class WorkloadGenerator {
+private:
+    WorkloadSpec spec;
+    std::vector<CommandDefinition> commands;    ///< 按热度排名排列
+    std::vector<double> cumulative;             ///< Zipf 累积分布
+    std::vector<std::string> allNames;          ///< TYPE_COMMAND 参数的取值范围
+    std::mt19937_64 rng;
+
+public:
+    /**
+     * @brief 构造
+     * @param manager 提供命令定义的管理器
+     * @param s 分布参数
+     * @details spec.commands 中不存在的命令被忽略
+     */
+    WorkloadGenerator(const CommandManager& manager, const WorkloadSpec& s) : spec(s), rng(s.seed) {
+        allNames = manager.getCommandList();
+        std::vector<std::string> names = spec.commands;
+        if (names.empty()) {
+            for (const auto& name : allNames) {
+                const CommandDefinition* def = manager.getCommand(name);
+                if (def && !def->isBuiltin()) {
+                    names.push_back(name);
+                }
+            }
+        }
+        for (const auto& name : names) {
+            const CommandDefinition* def = manager.getCommand(name);
+            if (def) {
+                commands.push_back(*def);
+            }
+        }
+
+        // 打乱热度排名，再按 1/rank^s 计算累积分布
+        for (size_t i = commands.size(); i > 1; --i) {
+            std::swap(commands[i - 1], commands[uniform(i)]);
+        }
+        double total = 0.0;
+        for (size_t rank = 1; rank <= commands.size(); ++rank) {
+            total += 1.0 / std::pow(static_cast<double>(rank), spec.zipfExponent);
+            cumulative.push_back(total);
+        }
+        for (double& c : cumulative) {
+            c /= total;
+        }
+    }
+
+    /**
+     * @brief 参与生成的命令数
+     */
+    size_t commandCount() const { return commands.size(); }
+
+    /**
+     * @brief 生成下一条命令行
+     * @return 没有可用命令时返回空字符串
+     */
+    std::string next() {
+        if (commands.empty()) return "";
+        size_t index = static_cast<size_t>(
+            std::lower_bound(cumulative.begin(), cumulative.end(), unit()) - cumulative.begin());
+        const CommandDefinition& cmd = commands[std::min(index, commands.size() - 1)];
+
+        std::string line = cmd.getName();
+        if (spec.typoRate > 0.0 && unit() < spec.typoRate) {
+            line = misspell(line);
+        }
+
+        // 位置参数：必需参数总是生成，可选参数遇到第一个未生成的即停止，保持位置连续
+        for (const auto& param : cmd.getParameters()) {
+            if (param.name == "...") {
+                for (size_t n = 1 + uniform(3); n > 0; --n) {
+                    line += ' ';
+                    line += value(param.type);
+                }
+                break;
+            }
+            if (!param.required && unit() >= spec.optionalRate) break;
+            line += ' ';
+            line += value(param.type);
+        }
+
+        // 选项放在位置参数之后，避免不带值的短选项把后面的参数当作它的值
+        for (const auto& opt : cmd.getOptions()) {
+            if (unit() >= spec.optionRate) continue;
+            bool useShort = !opt.shortName.empty() && (opt.name.empty() || uniform(2) == 0);
+            line += useShort ? " -" + opt.shortName : " --" + opt.name;
+            if (opt.requiresValue) {
+                ParamType type = TYPE_STRING;
+                if (isInteger(opt.defaultValue)) {
+                    type = TYPE_INTEGER;
+                } else if (!ParamTypes::find(opt.valueType, type)) {
+                    type = TYPE_STRING;
+                }
+                line += (!useShort && uniform(2) == 0) ? '=' : ' ';
+                line += value(type);
+            }
+        }
+        return line;
+    }
+
+    /**
+     * @brief 生成指定条数的命令行
+     */
+    std::vector<std::string> generate(size_t count) {
+        std::vector<std::string> lines;
+        lines.reserve(count);
+        for (size_t i = 0; i < count; ++i) {
+            lines.push_back(next());
+        }
+        return lines;
+    }
+
+private:
+    /** @brief [0, n) 内的均匀整数 */
+    size_t uniform(size_t n) {
+        return static_cast<size_t>(rng() % n);
+    }
+
+    /** @brief [0, 1) 内的均匀实数 */
+    double unit() {
+        return static_cast<double>(rng() >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static bool isInteger(const std::string& s) {
+        if (s.empty()) return false;
+        size_t start = s[0] == '-' ? 1 : 0;
+        if (start == s.size()) return false;
+        return std::all_of(s.begin() + static_cast<std::ptrdiff_t>(start), s.end(),
+                           [](char c) { return c >= '0' && c <= '9'; });
+    }
+
+    std::string word(size_t length) {
+        static const char letters[] = "abcdefghijklmnopqrstuvwxyz0123456789_";
+        std::string w;
+        w.reserve(length);
+        for (size_t i = 0; i < length; ++i) {
+            w += letters[uniform(sizeof(letters) - 1)];
+        }
+        return w;
+    }
+
+    size_t valueLength() {
+        size_t lo = std::max<size_t>(1, spec.minValueLength);
+        size_t hi = std::max(lo, spec.maxValueLength);
+        return lo + uniform(hi - lo + 1);
+    }
+
+    /**
+     * @brief 按类型生成参数值
+     * @details 用户注册的类型如果提供补全，从补全候选中取值，保证生成的值能通过验证
+     */
+    std::string value(ParamType type) {
+        if (type >= ParamType::UserFirst) {
+            std::vector<std::string> candidates = ParamTypes::complete(type, "");
+            if (!candidates.empty()) {
+                return candidates[uniform(candidates.size())];
+            }
+        }
+        if (type == TYPE_INTEGER) {
+            return std::to_string(uniform(100000));
+        }
+        if (type == TYPE_FLOAT) {
+            char buf[32];
+            std::snprintf(buf, sizeof(buf), "%.3f", unit() * 1000.0);
+            return buf;
+        }
+        if (type == TYPE_BOOL) {
+            return uniform(2) ? "true" : "false";
+        }
+        if (type == TYPE_COMMAND && !allNames.empty()) {
+            return allNames[uniform(allNames.size())];
+        }
+
+        size_t length = valueLength();
+        std::string v;
+        if (type == TYPE_PATH || type == TYPE_FILE) {
+            // 由若干段组成的相对路径
+            while (v.size() < length) {
+                if (!v.empty()) v += '/';
+                v += word(std::min<size_t>(length - v.size(), 1 + uniform(8)));
+            }
+        } else {
+            v = word(length);
+        }
+
+        if (spec.quoteRate > 0.0 && unit() < spec.quoteRate && v.size() > 1) {
+            v[1 + uniform(v.size() - 1)] = ' ';
+            if (v.back() == ' ') v.back() = 'x';
+            return '"' + v + '"';
+        }
+        return v;
+    }
+
+    /**
+     * @brief 随机替换、删除、插入或交换命令名中的一个字符
+     */
+    std::string misspell(std::string name) {
+        size_t pos = uniform(name.size());
+        switch (uniform(4)) {
+            case 0: {
+                char c = static_cast<char>('a' + uniform(26));
+                name[pos] = c == name[pos] ? static_cast<char>('a' + (c - 'a' + 1) % 26) : c;
+                break;
+            }
+            case 1:
+                if (name.size() > 1) {
+                    name.erase(pos, 1);
+                    break;
+                }
+                // fallthrough
+            case 2:
+                name.insert(pos, 1, static_cast<char>('a' + uniform(26)));
+                break;
+            default:
+                if (name.size() > 1) {
+                    size_t p = std::min(pos, name.size() - 2);
+                    if (name[p] == name[p + 1]) {
+                        name.insert(p, 1, 'x');
+                    } else {
+                        std::swap(name[p], name[p + 1]);
+                    }
+                } else {
+                    name += 'x';
+                }
+                break;
+        }
+        return name;
+    }
+};
+
+// ============================================================================
+// 回放
+// ============================================================================
+
+/**
+ * @struct ReplayOptions
+ * @brief 回放方式
+ */
+struct ReplayOptions {
+    size_t batchSize = 0;           ///< 0 表示逐条解析执行（与 processString 相同的路径），否则按此大小调用 processBatch
+    std::ostream* output = nullptr; ///< 命令输出，为空时丢弃
+};
+
+/**
+ * @struct ReplayReport
+ * @brief 回放结果
+ * @details 逐条模式下的延迟是每条命令的耗时；批量模式下是每批耗时除以批大小，
+ *          反映的是批内的平均耗时而不是单条命令的尾延迟
+ */
+struct ReplayReport {
+    size_t commands = 0;            ///< 执行的命令数
+    size_t succeeded = 0;           ///< 执行成功的命令数
+    double seconds = 0.0;           ///< 总耗时
+    double throughput = 0.0;        ///< 每秒命令数
+    uint64_t p50Nanos = 0;          ///< 延迟中位数
+    uint64_t p90Nanos = 0;
+    uint64_t p99Nanos = 0;
+    uint64_t p999Nanos = 0;
+    uint64_t maxNanos = 0;
+};
+
+namespace detail {
+
+/**
+ * @brief 丢弃所有写入内容的流缓冲区
+ */
+class DiscardBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+inline uint64_t percentile(const std::vector<uint64_t>& sorted, double q) {
+    if (sorted.empty()) return 0;
+    size_t index = static_cast<size_t>(q * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[std::min(index, sorted.size() - 1)];
+}
+
+} // namespace detail
+
+/**
+ * @brief 在管理器的默认会话中回放命令流
+ * @param manager 执行命令的管理器
+ * @param lines 命令行
+ * @param options 回放方式
+ */
+inline ReplayReport replayWorkload(CommandManager& manager, const std::vector<std::string>& lines,
+                                   const ReplayOptions& options = ReplayOptions()) {
+    using Clock = std::chrono::steady_clock;
+    detail::DiscardBuffer discard;
+    std::ostream sink(&discard);
+    std::ostream* os = options.output ? options.output : &sink;
+
+    ReplayReport report;
+    std::vector<uint64_t> latencies;
+    latencies.reserve(lines.size());
+    Session& session = manager.getDefaultSession();
+
+    auto begin = Clock::now();
+    if (options.batchSize == 0) {
+        CommandContext context;
+        context.setSession(&session);
+        context.setOutput(os);
+        context.setErrorOutput(os);
+        for (const auto& line : lines) {
+            auto start = Clock::now();
+            context.parse(line);
+            if (manager.processCommand(context)) ++report.succeeded;
+            latencies.push_back(static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count()));
+        }
+    } else {
+        std::vector<std::string> batch;
+        batch.reserve(options.batchSize);
+        for (size_t i = 0; i < lines.size(); i += options.batchSize) {
+            size_t end = std::min(lines.size(), i + options.batchSize);
+            batch.assign(lines.begin() + static_cast<std::ptrdiff_t>(i), lines.begin() + static_cast<std::ptrdiff_t>(end));
+            auto start = Clock::now();
+            report.succeeded += manager.processBatch(batch, session, os, os);
+            uint64_t nanos = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+            latencies.push_back(nanos / batch.size());
+        }
+    }
+    report.seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+    report.commands = lines.size();
+    report.throughput = report.seconds > 0.0 ? static_cast<double>(lines.size()) / report.seconds : 0.0;
+
+    std::sort(latencies.begin(), latencies.end());
+    report.p50Nanos = detail::percentile(latencies, 0.50);
+    report.p90Nanos = detail::percentile(latencies, 0.90);
+    report.p99Nanos = detail::percentile(latencies, 0.99);
+    report.p999Nanos = detail::percentile(latencies, 0.999);
+    report.maxNanos = latencies.empty() ? 0 : latencies.back();
+    return report;
+}
+
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_WORKLOAD_H
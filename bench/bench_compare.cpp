@@ -0,0 +1,279 @@
+/**
+ * @file bench_compare.cpp
+ * @brief 比较两次 ccm_bench 的 JSON 结果，发现性能回退
+ * @details 按（基准名, 注册表大小）配对两份结果，由每次重复的样本重新计算中位数和 MAD。
+ *          只有同时满足以下两个条件时才判定为回退：
+ *          - 新结果的中位数比基线慢超过阈值（--threshold，百分比）
+ *          - 差值超出噪声带：noise-k × 1.4826 × (基线 MAD + 新结果 MAD)，即两边离散程度之和换算成标准差的 k 倍
+ *          因此重复次数少、抖动大的基准不会因为一次偶然的慢样本而失败。
+ *
+ *          --track 指定需要检查的基准（名称子串，可重复），缺省检查全部；
+ *          被跟踪的基准在新结果中缺失也视为失败。
+ *          返回值：0 无回退，1 存在回退，2 参数或文件错误。
+ *
+ * 用法: ccm_bench_compare 基线.json 新结果.json [--threshold 5] [--noise-k 3]
+ *                         [--track 子串]...
+ */
+
+#include "ConsoleCommandHttp.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+using ConsoleCommand::detail::JsonReader;
+
+namespace {
+
+struct Entry {
+    std::vector<double> samples;    ///< 每次重复的 ns/op
+    double median = 0.0;
+    double mad = 0.0;
+};
+
+using Key = std::pair<std::string, long>;   ///< （基准名, 注册表大小）
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+/**
+ * @brief 跳过任意 JSON 值（对象和数组递归跳过）
+ */
+bool skipValue(JsonReader& reader) {
+    char c = reader.peek();
+    if (c == '{' || c == '[') {
+        char close = c == '{' ? '}' : ']';
+        reader.consume(c);
+        if (reader.consume(close)) return true;
+        do {
+            if (c == '{') {
+                std::string key;
+                if (!reader.readString(key) || !reader.consume(':')) return false;
+            }
+            if (!skipValue(reader)) return false;
+        } while (reader.consume(','));
+        return reader.consume(close);
+    }
+    std::string text;
+    JsonReader::Kind kind;
+    return reader.readScalar(text, kind);
+}
+
+bool readNumber(JsonReader& reader, double& out) {
+    std::string text;
+    JsonReader::Kind kind;
+    if (!reader.readScalar(text, kind) || kind != JsonReader::Number) return false;
+    out = std::strtod(text.c_str(), nullptr);
+    return true;
+}
+
+bool readBenchmark(JsonReader& reader, std::map<Key, Entry>& out) {
+    if (!reader.consume('{')) return false;
+    std::string name;
+    double registry = 0.0, medianNs = 0.0, madNs = 0.0;
+    Entry entry;
+    if (!reader.consume('}')) {
+        do {
+            std::string key;
+            if (!reader.readString(key) || !reader.consume(':')) return false;
+            bool ok;
+            if (key == "name") {
+                ok = reader.readString(name);
+            } else if (key == "registry") {
+                ok = readNumber(reader, registry);
+            } else if (key == "median_ns") {
+                ok = readNumber(reader, medianNs);
+            } else if (key == "mad_ns") {
+                ok = readNumber(reader, madNs);
+            } else if (key == "samples_ns") {
+                ok = ConsoleCommand::detail::readScalarArray(reader, [&entry](const std::string& text) {
+                    entry.samples.push_back(std::strtod(text.c_str(), nullptr));
+                });
+            } else {
+                ok = skipValue(reader);
+            }
+            if (!ok) return false;
+        } while (reader.consume(','));
+        if (!reader.consume('}')) return false;
+    }
+    if (name.empty()) return false;
+
+    // 有样本时以样本为准，否则使用文件中给出的统计量
+    if (!entry.samples.empty()) {
+        entry.median = median(entry.samples);
+        std::vector<double> deviations;
+        for (double s : entry.samples) deviations.push_back(std::fabs(s - entry.median));
+        entry.mad = median(deviations);
+    } else {
+        entry.median = medianNs;
+        entry.mad = madNs;
+    }
+    out[Key(name, static_cast<long>(registry))] = std::move(entry);
+    return true;
+}
+
+/**
+ * @brief 读取 ccm_bench 输出的 JSON 文件
+ */
+bool loadResults(const std::string& path, std::map<Key, Entry>& out, std::string& errorMsg) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) {
+        errorMsg = "无法打开 " + path;
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << file.rdbuf();
+    std::string text = buffer.str();
+
+    JsonReader reader(text.data(), text.size());
+    bool ok = reader.consume('{');
+    bool sawBenchmarks = false;
+    if (ok && !reader.consume('}')) {
+        do {
+            std::string key;
+            if (!reader.readString(key) || !reader.consume(':')) {
+                ok = false;
+                break;
+            }
+            if (key == "benchmarks") {
+                sawBenchmarks = true;
+                if (!reader.consume('[')) {
+                    ok = false;
+                    break;
+                }
+                if (!reader.consume(']')) {
+                    do {
+                        ok = readBenchmark(reader, out);
+                    } while (ok && reader.consume(','));
+                    ok = ok && reader.consume(']');
+                }
+            } else {
+                ok = skipValue(reader);
+            }
+        } while (ok && reader.consume(','));
+        ok = ok && reader.consume('}');
+    }
+    if (!ok || !sawBenchmarks) {
+        errorMsg = path + ": 不是有效的基准结果文件";
+        return false;
+    }
+    return true;
+}
+
+std::string formatNs(double ns) {
+    char buf[32];
+    if (ns >= 1e6) std::snprintf(buf, sizeof(buf), "%.2fms", ns / 1e6);
+    else if (ns >= 1e3) std::snprintf(buf, sizeof(buf), "%.2fus", ns / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%.1fns", ns);
+    return buf;
+}
+
+void usage() {
+    std::cerr << "用法: ccm_bench_compare 基线.json 新结果.json [--threshold 5] [--noise-k 3] [--track 子串]...\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> files;
+    std::vector<std::string> tracked;
+    double threshold = 5.0;
+    double noiseK = 3.0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threshold" || arg == "--noise-k" || arg == "--track") {
+            if (i + 1 >= argc) {
+                usage();
+                return 2;
+            }
+            const char* value = argv[++i];
+            if (arg == "--threshold") threshold = std::atof(value);
+            else if (arg == "--noise-k") noiseK = std::atof(value);
+            else tracked.push_back(value);
+        } else if (!arg.empty() && arg[0] == '-') {
+            usage();
+            return 2;
+        } else {
+            files.push_back(arg);
+        }
+    }
+    if (files.size() != 2) {
+        usage();
+        return 2;
+    }
+
+    std::map<Key, Entry> baseline, contender;
+    std::string errorMsg;
+    if (!loadResults(files[0], baseline, errorMsg) || !loadResults(files[1], contender, errorMsg)) {
+        std::cerr << errorMsg << "\n";
+        return 2;
+    }
+
+    auto isTracked = [&tracked](const std::string& name) {
+        if (tracked.empty()) return true;
+        for (const auto& t : tracked) {
+            if (name.find(t) != std::string::npos) return true;
+        }
+        return false;
+    };
+
+    int regressions = 0;
+    int missing = 0;
+    std::printf("%-28s %8s %12s %12s %9s %8s  %s\n", "基准", "注册表", "基线", "新结果", "变化", "噪声", "结论");
+    for (const auto& item : baseline) {
+        const Key& key = item.first;
+        const Entry& base = item.second;
+        bool track = isTracked(key.first);
+
+        auto it = contender.find(key);
+        if (it == contender.end()) {
+            std::printf("%-28s %8ld %12s %12s %9s %8s  %s\n", key.first.c_str(), key.second,
+                        formatNs(base.median).c_str(), "-", "-", "-", track ? "缺失" : "缺失（未跟踪）");
+            if (track) ++missing;
+            continue;
+        }
+        const Entry& cur = it->second;
+
+        double change = base.median > 0.0 ? (cur.median - base.median) / base.median * 100.0 : 0.0;
+        double noise = noiseK * 1.4826 * (base.mad + cur.mad);
+        double noisePercent = base.median > 0.0 ? noise / base.median * 100.0 : 0.0;
+        double delta = cur.median - base.median;
+
+        const char* verdict;
+        if (change > threshold && delta > noise) {
+            verdict = track ? "回退" : "变慢（未跟踪）";
+            if (track) ++regressions;
+        } else if (-change > threshold && -delta > noise) {
+            verdict = "变快";
+        } else if (std::fabs(change) > threshold) {
+            verdict = "噪声内";
+        } else {
+            verdict = "持平";
+        }
+
+        std::printf("%-28s %8ld %12s %12s %+8.1f%% %7.1f%%  %s\n", key.first.c_str(), key.second,
+                    formatNs(base.median).c_str(), formatNs(cur.median).c_str(), change, noisePercent, verdict);
+    }
+    for (const auto& item : contender) {
+        if (baseline.find(item.first) == baseline.end()) {
+            std::printf("%-28s %8ld %12s %12s %9s %8s  %s\n", item.first.first.c_str(), item.first.second, "-",
+                        formatNs(item.second.median).c_str(), "-", "-", "新增");
+        }
+    }
+
+    std::printf("\n阈值 %.1f%%，噪声带 %.1f×MAD：%d 项回退，%d 项缺失\n", threshold, noiseK, regressions, missing);
+    return regressions || missing ? 1 : 0;
+}
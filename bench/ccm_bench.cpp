@@ -0,0 +1,461 @@
+/**
+ * @file ccm_bench.cpp
+ * @brief CommandManager 核心路径的微基准
+ * @details 覆盖命令处理的每个阶段：
+ *          - CommandContext::parseString / parseArgs
+ *          - 命令查找：命中、别名命中、未命中（通过 commandExists）
+ *          - CommandDefinition::validateArguments / generateHelp
+ *          - 未知命令的相似命令建议（通过 processCommand 走 handleUnknownCommand）
+ *          - 端到端 processString
+ *          - 新建管理器并用 loadSnapshot 加载注册表快照（含一次查找）
+ *          - 上下文使用 std::pmr 资源时的解析和端到端处理：
+ *            线程独占的 unsynchronized_pool_resource，以及每条命令一个栈上缓冲区的 monotonic_buffer_resource
+ *
+ *          查找、建议和端到端基准分别在 10、1k、100k 条命令的合成注册表上运行；
+ *          注册表和查询序列由固定种子生成，结果可复现。
+ *          每个注册表还记录每条命令占用的内存：getRegistryMemory() 的估算值，
+ *          以及 glibc 上用 mallinfo2 测得的堆增长（包括字符串池和分配器开销）。
+ *          每个基准先自动标定迭代次数使单次测量不短于 --min-time，再重复 --repetitions 次，
+ *          输出中位数、MAD 和最小值，结果以 JSON 写到标准输出或 --out 指定的文件。
+ *
+ * 用法: ccm_bench [--sizes 10,1000,100000] [--repetitions 5] [--min-time-ms 50]
+ *                 [--filter 子串] [--seed 42] [--out 结果.json]
+ */
+
+#include "ConsoleCommandManager.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory_resource>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+#include <malloc.h>
+#define CCM_BENCH_HAVE_MALLINFO2 1
+#endif
+
+using namespace ConsoleCommand;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile size_t sink = 0;
+
+/**
+ * @brief 丢弃所有输出的流缓冲区
+ */
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+NullBuffer nullBuffer;
+std::ostream nullStream(&nullBuffer);
+
+struct Options {
+    std::vector<size_t> sizes = {10, 1000, 100000};
+    int repetitions = 5;
+    double minTimeMs = 50.0;
+    std::string filter;
+    uint32_t seed = 42;
+    std::string out;
+};
+
+struct Result {
+    std::string name;
+    size_t registry = 0;            ///< 注册表大小，0表示与注册表无关
+    uint64_t iterations = 0;        ///< 每次重复的迭代次数
+    std::vector<double> samples;    ///< 每次重复的 ns/op
+    double median = 0.0;
+    double mad = 0.0;
+    double min = 0.0;
+};
+
+struct MemoryResult {
+    size_t registry = 0;
+    double estimatedBytes = 0.0;    ///< 每条命令，getRegistryMemory().ownBytes()
+    double heapBytes = -1.0;        ///< 每条命令，mallinfo2 测得的堆增长；不可用时为-1
+};
+
+/**
+ * @brief 当前已分配的堆字节数，不可用时返回-1
+ */
+long long heapInUse() {
+#ifdef CCM_BENCH_HAVE_MALLINFO2
+    return static_cast<long long>(mallinfo2().uordblks);
+#else
+    return -1;
+#endif
+}
+
+double median(std::vector<double> v) {
+    if (v.empty()) return 0.0;
+    std::sort(v.begin(), v.end());
+    size_t n = v.size();
+    return n % 2 ? v[n / 2] : (v[n / 2 - 1] + v[n / 2]) / 2.0;
+}
+
+/**
+ * @brief 运行一个基准
+ * @param func 被测操作，参数为本次迭代序号
+ */
+template<typename Func>
+Result measure(const Options& opt, const std::string& name, size_t registry, Func&& func) {
+    Result r;
+    r.name = name;
+    r.registry = registry;
+
+    // 标定：迭代次数翻倍直到单次测量达到最短时间
+    uint64_t iterations = 1;
+    for (;;) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) func(i);
+        double ms = std::chrono::duration<double, std::milli>(Clock::now() - t0).count();
+        if (ms >= opt.minTimeMs || iterations >= (uint64_t(1) << 30)) break;
+        double scale = ms > 0.0 ? std::min(10.0, std::max(2.0, 1.2 * opt.minTimeMs / ms)) : 10.0;
+        iterations = static_cast<uint64_t>(static_cast<double>(iterations) * scale);
+    }
+    r.iterations = iterations;
+
+    for (int rep = 0; rep < opt.repetitions; ++rep) {
+        auto t0 = Clock::now();
+        for (uint64_t i = 0; i < iterations; ++i) func(i);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count();
+        r.samples.push_back(ns / static_cast<double>(iterations));
+    }
+
+    r.median = median(r.samples);
+    std::vector<double> deviations;
+    for (double s : r.samples) deviations.push_back(std::fabs(s - r.median));
+    r.mad = median(deviations);
+    r.min = *std::min_element(r.samples.begin(), r.samples.end());
+
+    std::fprintf(stderr, "  %-28s %8zu %12.1f ns/op  (MAD %.1f)\n",
+                 name.c_str(), registry, r.median, r.mad);
+    return r;
+}
+
+/**
+ * @brief 由种子生成可读的、互不相同的命令名
+ */
+std::vector<std::string> makeNames(size_t count, std::mt19937& rng) {
+    static const char* syllables[] = {"ka", "lo", "mi", "tu", "re", "sa", "no", "vi", "de", "po",
+                                      "ch", "fe", "gu", "ji", "ra", "xo", "ze", "bi", "qu", "ly"};
+    std::uniform_int_distribution<int> pick(0, 19);
+    std::uniform_int_distribution<int> length(1, 3);
+    std::vector<std::string> names;
+    names.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string name;
+        int n = length(rng);
+        for (int s = 0; s < n; ++s) name += syllables[pick(rng)];
+        name += std::to_string(i);   // 保证唯一
+        names.push_back(name);
+    }
+    return names;
+}
+
+/**
+ * @brief 构造一个带参数、选项和示例的典型命令定义
+ */
+CommandDefinition makeTypicalCommand() {
+    CommandDefinition cmd("copy", "复制文件或目录到目标位置");
+    cmd.setCategory("文件");
+    cmd.addAlias("cp");
+    cmd.addParameter(ParameterDefinition("source", "源路径", true, "", TYPE_PATH));
+    cmd.addParameter(ParameterDefinition("dest", "目标路径", true, "", TYPE_PATH));
+    cmd.addParameter(ParameterDefinition("count", "最多复制的文件数", false, "0", TYPE_INTEGER));
+    cmd.addOption(OptionDefinition("recursive", "r", "递归复制目录", false));
+    cmd.addOption(OptionDefinition("mode", "m", "复制模式", true, "fast", "模式"));
+    cmd.addOption(OptionDefinition("buffer", "b", "缓冲区大小", true, "65536", "字节"));
+    cmd.addExample("copy a.txt b.txt");
+    cmd.addExample("copy -r src/ dst/ --mode=safe");
+    return cmd;
+}
+
+void writeJson(std::ostream& os, const Options& opt, const std::vector<Result>& results,
+               const std::vector<MemoryResult>& memory) {
+    char date[32];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    os << "{\n  \"context\": {\"date\": \"" << date << "\", \"seed\": " << opt.seed
+       << ", \"repetitions\": " << opt.repetitions << ", \"min_time_ms\": " << opt.minTimeMs
+#if defined(__clang__)
+       << ", \"compiler\": \"clang " << __clang_major__ << "." << __clang_minor__ << "\""
+#elif defined(__GNUC__)
+       << ", \"compiler\": \"gcc " << __GNUC__ << "." << __GNUC_MINOR__ << "\""
+#endif
+#ifdef NDEBUG
+       << ", \"build\": \"release\""
+#else
+       << ", \"build\": \"debug\""
+#endif
+       << "},\n  \"benchmarks\": [";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        char buf[128];
+        os << (i ? ",\n" : "\n") << "    {\"name\": \"" << r.name << "\", \"registry\": " << r.registry
+           << ", \"iterations\": " << r.iterations << ", \"samples_ns\": [";
+        for (size_t s = 0; s < r.samples.size(); ++s) {
+            std::snprintf(buf, sizeof(buf), "%s%.2f", s ? ", " : "", r.samples[s]);
+            os << buf;
+        }
+        std::snprintf(buf, sizeof(buf), "], \"median_ns\": %.2f, \"mad_ns\": %.2f, \"min_ns\": %.2f}",
+                      r.median, r.mad, r.min);
+        os << buf;
+    }
+    os << "\n  ],\n  \"memory\": [";
+    for (size_t i = 0; i < memory.size(); ++i) {
+        char buf[160];
+        std::snprintf(buf, sizeof(buf), "%s\n    {\"registry\": %zu, \"estimated_bytes_per_command\": %.1f, "
+                      "\"heap_bytes_per_command\": %.1f}", i ? "," : "", memory[i].registry,
+                      memory[i].estimatedBytes, memory[i].heapBytes);
+        os << buf;
+    }
+    os << "\n  ]\n}\n";
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!value) {
+            std::cerr << "缺少参数值: " << arg << "\n";
+            return false;
+        }
+        if (arg == "--sizes") {
+            opt.sizes.clear();
+            std::stringstream ss(value);
+            std::string item;
+            while (std::getline(ss, item, ',')) opt.sizes.push_back(std::stoul(item));
+        } else if (arg == "--repetitions") {
+            opt.repetitions = std::max(1, std::atoi(value));
+        } else if (arg == "--min-time-ms") {
+            opt.minTimeMs = std::atof(value);
+        } else if (arg == "--filter") {
+            opt.filter = value;
+        } else if (arg == "--seed") {
+            opt.seed = static_cast<uint32_t>(std::stoul(value));
+        } else if (arg == "--out") {
+            opt.out = value;
+        } else {
+            std::cerr << "未知参数: " << arg << "\n";
+            return false;
+        }
+        ++i;
+    }
+    return true;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        std::cerr << "用法: ccm_bench [--sizes 10,1000,100000] [--repetitions 5] [--min-time-ms 50]"
+                     " [--filter 子串] [--seed 42] [--out 结果.json]\n";
+        return 2;
+    }
+
+    std::vector<Result> results;
+    std::vector<MemoryResult> memory;
+    auto wanted = [&opt](const std::string& name) {
+        return opt.filter.empty() || name.find(opt.filter) != std::string::npos;
+    };
+    auto run = [&](const std::string& name, size_t registry, auto&& func) {
+        if (wanted(name)) results.push_back(measure(opt, name, registry, func));
+    };
+
+    std::fprintf(stderr, "  %-28s %8s %12s\n", "基准", "注册表", "中位数");
+
+    // ------------------------------------------------------------------
+    // 与注册表大小无关的基准
+    // ------------------------------------------------------------------
+    const std::string line = "copy -r \"/data/my photos/2024\" /backup/photos --mode=safe --buffer 1048576";
+    run("parseString", 0, [&](uint64_t) {
+        CommandContext ctx(line);
+        sink = sink + ctx.argumentCount();
+    });
+    std::pmr::unsynchronized_pool_resource pool;
+    run("parseString/pmr_pool", 0, [&](uint64_t) {
+        CommandContext ctx(line, &pool);
+        sink = sink + ctx.argumentCount();
+    });
+    run("parseString/pmr_monotonic", 0, [&](uint64_t) {
+        alignas(std::max_align_t) char buffer[2048];
+        std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+        CommandContext ctx(line, &arena);
+        sink = sink + ctx.argumentCount();
+    });
+
+    std::vector<std::string> argvStorage = {"copy", "-r", "/data/my photos/2024", "/backup/photos",
+                                            "--mode=safe", "--buffer", "1048576"};
+    std::vector<char*> argvPointers;
+    for (auto& a : argvStorage) argvPointers.push_back(&a[0]);
+    run("parseArgs", 0, [&](uint64_t) {
+        CommandContext ctx(static_cast<int>(argvPointers.size()), argvPointers.data());
+        sink = sink + ctx.argumentCount();
+    });
+
+    CommandDefinition typical = makeTypicalCommand();
+    CommandContext validCtx("copy /data/a.txt /backup/a.txt 10 --mode=safe");
+    run("validateArguments", 0, [&](uint64_t) {
+        std::string error;
+        sink = sink + typical.validateArguments(validCtx, error);
+    });
+    run("generateHelp", 0, [&](uint64_t) {
+        sink = sink + typical.generateHelp().size();
+    });
+    run("generateHelp/detailed", 0, [&](uint64_t) {
+        sink = sink + typical.generateHelp(true).size();
+    });
+
+    // ------------------------------------------------------------------
+    // 依赖注册表大小的基准
+    // ------------------------------------------------------------------
+    for (size_t size : opt.sizes) {
+        std::mt19937 rng(opt.seed);
+        std::vector<std::string> names = makeNames(size, rng);
+
+        long long heapBefore = heapInUse();
+        CommandManager manager;
+        for (size_t i = 0; i < names.size(); ++i) {
+            CommandDefinition cmd(names[i], "合成命令 " + std::to_string(i));
+            cmd.addAlias("a_" + names[i]);
+            cmd.addParameter(ParameterDefinition("target", "目标", false));
+            cmd.addOption(OptionDefinition("level", "l", "级别", true, "1"));
+            cmd.setExecutor([](const CommandContext& ctx) {
+                sink = sink + ctx.argumentCount();
+                return true;
+            });
+            manager.registerCommand(cmd);
+        }
+        
+        MemoryResult mem;
+        mem.registry = size;
+        mem.estimatedBytes = static_cast<double>(manager.getRegistryMemory().ownBytes()) / static_cast<double>(size);
+        long long heapAfter = heapInUse();
+        if (heapBefore >= 0 && heapAfter >= 0) {
+            mem.heapBytes = static_cast<double>(heapAfter - heapBefore) / static_cast<double>(size);
+        }
+        memory.push_back(mem);
+        std::fprintf(stderr, "\n  注册表 %zu 条命令: 估算 %.1f 字节/命令，堆增长 %.1f 字节/命令\n",
+                     size, mem.estimatedBytes, mem.heapBytes);
+
+        // 预先生成查询序列，避免在计时循环中使用随机数
+        const size_t QUERIES = 4096;
+        std::uniform_int_distribution<size_t> pick(0, names.size() - 1);
+        std::vector<std::string> hits, aliases, misses, typos, lines;
+        for (size_t q = 0; q < QUERIES; ++q) {
+            const std::string& name = names[pick(rng)];
+            hits.push_back(name);
+            aliases.push_back("a_" + name);
+            misses.push_back("zz" + std::to_string(q) + "qx");
+            std::string typo = name;
+            typo[typo.size() / 2] = typo[typo.size() / 2] == 'q' ? 'w' : 'q';
+            typos.push_back(typo);
+            lines.push_back(name + " /tmp/file" + std::to_string(q) + " --level=3");
+        }
+        auto mask = QUERIES - 1;
+
+        std::fprintf(stderr, "\n");
+        run("findCommand/hit", size, [&](uint64_t i) {
+            sink = sink + manager.commandExists(hits[i & mask]);
+        });
+        run("findCommand/alias", size, [&](uint64_t i) {
+            sink = sink + manager.commandExists(aliases[i & mask]);
+        });
+        run("findCommand/miss", size, [&](uint64_t i) {
+            sink = sink + manager.commandExists(misses[i & mask]);
+        });
+        run("suggestions/typo", size, [&](uint64_t i) {
+            CommandContext ctx;
+            ctx.setCommandName(typos[i & mask]);
+            ctx.setOutput(&nullStream);
+            ctx.setErrorOutput(&nullStream);
+            sink = sink + manager.processCommand(ctx);
+        });
+        run("suggestions/none", size, [&](uint64_t i) {
+            CommandContext ctx;
+            ctx.setCommandName(misses[i & mask]);
+            ctx.setOutput(&nullStream);
+            ctx.setErrorOutput(&nullStream);
+            sink = sink + manager.processCommand(ctx);
+        });
+        run("processString", size, [&](uint64_t i) {
+            sink = sink + manager.processString(lines[i & mask]);
+        });
+        run("processString/pmr_monotonic", size, [&](uint64_t i) {
+            alignas(std::max_align_t) char buffer[2048];
+            std::pmr::monotonic_buffer_resource arena(buffer, sizeof(buffer));
+            CommandContext ctx(lines[i & mask], &arena);
+            sink = sink + manager.processCommand(ctx);
+        });
+        
+        if (wanted("snapshot/load")) {
+            std::string snapshotPath = (std::filesystem::temp_directory_path() /
+                                        ("ccm_bench_" + std::to_string(size) + ".snap")).string();
+            if (manager.saveSnapshot(snapshotPath)) {
+                run("snapshot/load", size, [&](uint64_t i) {
+                    CommandManager loaded;
+                    sink = sink + loaded.loadSnapshot(snapshotPath) + loaded.commandExists(hits[i & mask]);
+                });
+                std::remove(snapshotPath.c_str());
+            }
+        }
+        
+        // 先加载完整注册表的快照，再加载只有内置命令的快照：前者的命令在后者之后重新注册，
+        // 定义的副本在管理器销毁后仍要可用（字符串不能指向已解除的映射）
+        if (wanted("snapshot/reload")) {
+            std::string fullPath = (std::filesystem::temp_directory_path() /
+                                    ("ccm_bench_full_" + std::to_string(size) + ".snap")).string();
+            std::string emptyPath = (std::filesystem::temp_directory_path() /
+                                     ("ccm_bench_empty_" + std::to_string(size) + ".snap")).string();
+            if (manager.saveSnapshot(fullPath) && CommandManager().saveSnapshot(emptyPath)) {
+                run("snapshot/reload", size, [&](uint64_t i) {
+                    std::optional<CommandDefinition> copy;
+                    {
+                        CommandManager loaded;
+                        bool ok = loaded.loadSnapshot(fullPath) && loaded.commandExists(hits[i & mask]) &&
+                                  loaded.loadSnapshot(emptyPath) && loaded.commandExists(hits[i & mask]);
+                        if (!ok) {
+                            std::cerr << "snapshot/reload: 重新加载快照后找不到 " << hits[i & mask] << "\n";
+                            std::exit(1);
+                        }
+                        copy = *loaded.getCommand(hits[i & mask]);
+                    }
+                    sink = sink + (copy->getName() == hits[i & mask]);
+                });
+            }
+            std::remove(fullPath.c_str());
+            std::remove(emptyPath.c_str());
+        }
+    }
+
+    if (opt.out.empty()) {
+        writeJson(std::cout, opt, results, memory);
+    } else {
+        std::ofstream file(opt.out);
+        if (!file) {
+            std::cerr << "无法写入 " << opt.out << "\n";
+            return 1;
+        }
+        writeJson(file, opt, results, memory);
+        std::fprintf(stderr, "\n结果已写入 %s\n", opt.out.c_str());
+    }
+    return 0;
+}
@@ -0,0 +1,142 @@
+/**
+ * @file codec_bench.cpp
+ * @brief 二进制帧编解码与字符串解析的对比基准
+ * @details 对同一组命令分别测量：
+ *          1. 文本路径：客户端拼接命令行 + 服务端 CommandContext 字符串解析
+ *          2. 二进制路径：encodeRequest + decodeRequest 直接填充 CommandContext
+ *          以及两条路径中服务端部分（仅解析/仅解码）的单独开销。
+ *
+ * 用法: codec_bench [迭代次数]
+ */
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandProtocol.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ConsoleCommand;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile size_t sink = 0;
+
+/**
+ * @brief 运行基准并打印每次操作的纳秒数
+ */
+template<typename Func>
+void run(const std::string& name, int iterations, Func&& func) {
+    for (int i = 0; i < iterations / 10; ++i) func();  // 预热
+
+    auto t0 = Clock::now();
+    for (int i = 0; i < iterations; ++i) func();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iterations;
+
+    std::cout << "  " << std::left << std::setw(36) << name
+              << std::right << std::setw(10) << std::fixed << std::setprecision(1) << ns << " ns/op\n";
+}
+
+/**
+ * @brief 把请求拼接成命令行文本，模拟远程调用者的字符串序列化
+ */
+std::string toCommandLine(const WireRequest& req) {
+    std::string line = req.commandName;
+    for (const auto& a : req.args) {
+        line += ' ';
+        if (a.find(' ') != std::string::npos) {
+            line += '"' + a + '"';
+        } else {
+            line += a;
+        }
+    }
+    for (const auto& o : req.options) line += " --" + o.first + "=" + o.second;
+    for (const auto& f : req.flags) line += " --" + f;
+    return line;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int iterations = argc > 1 ? std::atoi(argv[1]) : 200000;
+
+    auto manager = createManager();
+    manager.createCommand("cp", "复制", [](const CommandContext&) { return true; });
+    uint32_t cpId = manager.getCommandId("cp");
+
+    struct Case {
+        std::string name;
+        WireRequest request;
+    };
+    std::vector<Case> cases;
+
+    WireRequest small;
+    small.commandName = "cp";
+    small.args = {"a.txt", "b.txt"};
+    small.flags = {"force"};
+    cases.push_back({"小请求 (2参数)", small});
+
+    WireRequest medium = small;
+    medium.args = {"/var/log/app/service.log", "/backup/logs/2026/service log copy.log"};
+    medium.options = {{"mode", "fast"}, {"buffer", "1048576"}, {"owner", "ops"}};
+    medium.flags = {"force", "recursive"};
+    cases.push_back({"中请求 (引号+选项)", medium});
+
+    WireRequest large = medium;
+    large.args.clear();
+    for (int i = 0; i < 32; ++i) large.args.push_back("/data/shard" + std::to_string(i) + "/part-0000.bin");
+    cases.push_back({"大请求 (32参数)", large});
+
+    std::cout << "迭代次数: " << iterations << "\n";
+    for (const auto& c : cases) {
+        std::cout << "\n" << c.name << ":\n";
+
+        std::string line = toCommandLine(c.request);
+        std::string frame;
+        encodeRequest(c.request, frame);
+
+        WireRequest byId = c.request;
+        byId.commandId = cpId;
+        std::string idFrame;
+        encodeRequest(byId, idFrame);
+
+        run("文本: 拼接 + parseString", iterations, [&] {
+            CommandContext ctx(toCommandLine(c.request));
+            sink = sink + ctx.argumentCount();
+        });
+        run("二进制: encode + decode", iterations, [&] {
+            std::string buffer;
+            encodeRequest(c.request, buffer);
+            CommandContext ctx;
+            size_t consumed = 0;
+            std::string error;
+            decodeRequest(buffer.data(), buffer.size(), consumed, ctx, manager, error);
+            sink = sink + ctx.argumentCount();
+        });
+        run("仅解析: parseString", iterations, [&] {
+            CommandContext ctx(line);
+            sink = sink + ctx.argumentCount();
+        });
+        run("仅解码: decode (名称)", iterations, [&] {
+            CommandContext ctx;
+            size_t consumed = 0;
+            std::string error;
+            decodeRequest(frame.data(), frame.size(), consumed, ctx, manager, error);
+            sink = sink + ctx.argumentCount();
+        });
+        run("仅解码: decode (命令ID)", iterations, [&] {
+            CommandContext ctx;
+            size_t consumed = 0;
+            std::string error;
+            decodeRequest(idFrame.data(), idFrame.size(), consumed, ctx, manager, error);
+            sink = sink + ctx.argumentCount();
+        });
+
+        std::cout << "  文本 " << line.size() << " 字节, 帧 " << frame.size() << " 字节\n";
+    }
+    return 0;
+}
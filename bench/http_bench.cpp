@@ -0,0 +1,218 @@
+/**
+ * @file http_bench.cpp
+ * @brief HTTP/1.1 JSON 网关基准
+ * @details 第一部分单独测量网关在服务端的协议开销：解析请求、映射为 CommandContext、编码 JSON 响应。
+ *          第二部分启动 Http 协议的 CommandServer，用 keep-alive 连接按给定流水线深度发送
+ *          POST /cmd/ping，统计吞吐量和延迟分位数。
+ *
+ * 用法: http_bench [客户端数] [每客户端请求数] [流水线深度]
+ */
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandHttp.h"
+#include "ConsoleCommandServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace ConsoleCommand;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+volatile size_t sink = 0;
+
+std::string makeRequest() {
+    std::string body = "{\"args\":[\"a\",\"b\"],\"options\":{\"n\":\"5\"},\"flags\":[]}";
+    return "POST /cmd/ping HTTP/1.1\r\n"
+           "Host: 127.0.0.1\r\n"
+           "Content-Type: application/json\r\n"
+           "Content-Length: " + std::to_string(body.size()) + "\r\n"
+           "\r\n" + body;
+}
+
+const std::string REQUEST = makeRequest();
+
+int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief 从缓冲区取出一个完整的 HTTP 响应
+ * @return 取到返回true
+ */
+bool takeResponse(std::string& buffer, bool& ok) {
+    size_t headerEnd = buffer.find("\r\n\r\n");
+    if (headerEnd == std::string::npos) return false;
+    size_t lengthPos = buffer.find("Content-Length: ");
+    size_t length = std::stoul(buffer.substr(lengthPos + 16, buffer.find("\r\n", lengthPos) - lengthPos - 16));
+    if (buffer.size() < headerEnd + 4 + length) return false;
+    ok = buffer.compare(0, 12, "HTTP/1.1 200") == 0;
+    buffer.erase(0, headerEnd + 4 + length);
+    return true;
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<long>(index), samples.end());
+    return samples[index];
+}
+
+/**
+ * @brief 测量服务端单个请求的协议处理开销
+ */
+void benchCodec(const CommandManager& manager, int iterations) {
+    std::string output = "pong\n";
+    auto t0 = Clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        HttpRequest http;
+        size_t consumed = 0;
+        unsigned status = 0;
+        std::string error;
+        decodeHttpRequest(REQUEST.data(), REQUEST.size(), consumed, http, status, error, 64 * 1024);
+        CommandContext ctx;
+        httpRequestToContext(http, ctx, manager, status, error);
+        std::string response;
+        encodeHttpResponse(200, "ok", output, true, response);
+        sink = sink + ctx.argumentCount() + response.size();
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - t0).count() / iterations;
+    std::cout << "解析 + 映射 + 编码: " << std::fixed << std::setprecision(1) << ns << " ns/请求\n\n";
+}
+
+/**
+ * @brief 对一个后端运行 keep-alive 流水线基准
+ */
+void benchServer(CommandManager& manager, ServerBackend backend, int clients, int requests, int window) {
+    ServerConfig cfg;
+    cfg.backend = backend;
+    cfg.protocol = ServerProtocol::Http;
+    CommandServer server(manager, cfg);
+    std::string error;
+    if (!server.start(error)) {
+        std::cout << std::left << std::setw(10) << backendName(backend) << " 跳过: " << error << "\n";
+        return;
+    }
+    std::thread serverThread([&server] { server.run(); });
+
+    std::vector<std::vector<double>> latencies(static_cast<size_t>(clients));
+    std::vector<size_t> failures(static_cast<size_t>(clients), 0);
+    std::vector<std::thread> threads;
+    auto begin = Clock::now();
+
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = connectTo(server.port());
+            if (fd < 0) return;
+            auto& samples = latencies[static_cast<size_t>(c)];
+            samples.reserve(static_cast<size_t>(requests));
+            std::deque<Clock::time_point> outstanding;
+            std::string buffer;
+            char chunk[16384];
+            int sent = 0;
+
+            // 先发出一个窗口的请求，之后每收到一个响应补发一个
+            std::string batch;
+            while (sent < requests && sent < window) {
+                batch += REQUEST;
+                outstanding.push_back(Clock::now());
+                ++sent;
+            }
+            ::send(fd, batch.data(), batch.size(), MSG_NOSIGNAL);
+
+            while (!outstanding.empty()) {
+                ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+                if (n <= 0) break;
+                buffer.append(chunk, static_cast<size_t>(n));
+
+                batch.clear();
+                bool ok;
+                while (takeResponse(buffer, ok)) {
+                    samples.push_back(std::chrono::duration<double, std::micro>(
+                        Clock::now() - outstanding.front()).count());
+                    outstanding.pop_front();
+                    if (!ok) ++failures[static_cast<size_t>(c)];
+                    if (sent < requests) {
+                        batch += REQUEST;
+                        outstanding.push_back(Clock::now());
+                        ++sent;
+                    }
+                }
+                if (!batch.empty()) ::send(fd, batch.data(), batch.size(), MSG_NOSIGNAL);
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    server.stop();
+    serverThread.join();
+
+    std::vector<double> all;
+    size_t failed = 0;
+    for (size_t i = 0; i < latencies.size(); ++i) {
+        all.insert(all.end(), latencies[i].begin(), latencies[i].end());
+        failed += failures[i];
+    }
+    double qps = static_cast<double>(all.size()) / seconds;
+
+    std::cout << std::left << std::setw(10) << backendName(server.backend())
+              << std::right << std::setw(12) << std::fixed << std::setprecision(0) << qps << " req/s"
+              << "  p50 " << std::setw(8) << std::setprecision(1) << percentile(all, 0.50) << " us"
+              << "  p99 " << std::setw(8) << percentile(all, 0.99) << " us";
+    if (failed > 0) std::cout << "  非200: " << failed;
+    std::cout << "\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 4;
+    int requests = argc > 2 ? std::atoi(argv[2]) : 50000;
+    int window = argc > 3 ? std::atoi(argv[3]) : 16;
+
+    auto manager = createManager();
+    manager.createCommand("ping", "返回pong",
+        [](const CommandContext& ctx) {
+            ctx.out() << "pong\n";
+            return true;
+        });
+
+    benchCodec(manager, 200000);
+
+    for (int depth : {1, window}) {
+        std::cout << "HTTP 网关: " << clients << " 个客户端 x " << requests
+                  << " 个请求, 流水线深度 " << depth << "\n";
+        benchServer(manager, ServerBackend::Blocking, clients, requests, depth);
+        benchServer(manager, ServerBackend::Epoll, clients, requests, depth);
+        benchServer(manager, ServerBackend::IoUring, clients, requests, depth);
+        std::cout << "\n";
+    }
+    return 0;
+}
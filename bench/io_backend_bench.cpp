@@ -0,0 +1,236 @@
+/**
+ * @file io_backend_bench.cpp
+ * @brief 服务器 I/O 后端与文件读取路径的对比基准
+ * @details 第一部分在同一台机器上依次启动 blocking/epoll/uring 后端的 CommandServer，
+ *          用多个客户端连接发送 ping 命令，统计吞吐量和延迟分位数。
+ *          第二部分对比 read() 循环与 io_uring 批量读取一个临时文件的吞吐量。
+ *
+ * 用法: io_backend_bench [客户端数] [每客户端请求数] [文件MB数]
+ */
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace ConsoleCommand;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * @brief 连接到服务器
+ */
+int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief 发送一行请求并读取完整响应
+ */
+bool roundTrip(int fd, const std::string& request, std::string& buffer) {
+    if (::send(fd, request.data(), request.size(), MSG_NOSIGNAL) != static_cast<ssize_t>(request.size())) {
+        return false;
+    }
+
+    buffer.clear();
+    char chunk[4096];
+    size_t expected = std::string::npos;
+    while (true) {
+        if (expected == std::string::npos) {
+            size_t newline = buffer.find('\n');
+            if (newline != std::string::npos) {
+                size_t space = buffer.find(' ');
+                expected = newline + 1 + std::stoul(buffer.substr(space + 1, newline - space - 1));
+            }
+        }
+        if (expected != std::string::npos && buffer.size() >= expected) return true;
+
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) return false;
+        buffer.append(chunk, static_cast<size_t>(n));
+    }
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<long>(index), samples.end());
+    return samples[index];
+}
+
+/**
+ * @brief 对一个后端运行请求-响应基准
+ */
+void benchServer(CommandManager& manager, ServerBackend backend, int clients, int requests) {
+    ServerConfig cfg;
+    cfg.backend = backend;
+    CommandServer server(manager, cfg);
+    std::string error;
+    if (!server.start(error)) {
+        std::cout << std::left << std::setw(10) << backendName(backend) << " 跳过: " << error << "\n";
+        return;
+    }
+    std::thread serverThread([&server] { server.run(); });
+
+    std::vector<std::vector<double>> latencies(static_cast<size_t>(clients));
+    std::vector<std::thread> threads;
+    auto begin = Clock::now();
+
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back([&, c] {
+            int fd = connectTo(server.port());
+            if (fd < 0) return;
+            std::string buffer;
+            auto& samples = latencies[static_cast<size_t>(c)];
+            samples.reserve(static_cast<size_t>(requests));
+            for (int i = 0; i < requests; ++i) {
+                auto t0 = Clock::now();
+                if (!roundTrip(fd, "ping\n", buffer)) break;
+                samples.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+            }
+            ::close(fd);
+        });
+    }
+    for (auto& t : threads) t.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    server.stop();
+    serverThread.join();
+
+    std::vector<double> all;
+    for (auto& v : latencies) all.insert(all.end(), v.begin(), v.end());
+    double qps = static_cast<double>(all.size()) / seconds;
+    double p50 = percentile(all, 0.50);
+    double p99 = percentile(all, 0.99);
+
+    std::cout << std::left << std::setw(10) << backendName(server.backend())
+              << std::right << std::setw(12) << std::fixed << std::setprecision(0) << qps << " req/s"
+              << "  p50 " << std::setw(8) << std::setprecision(1) << p50 << " us"
+              << "  p99 " << std::setw(8) << p99 << " us\n";
+}
+
+/**
+ * @brief 用 read() 循环读取整个文件
+ */
+double readPosix(const std::string& path, size_t chunk) {
+    std::vector<char> buffer(chunk);
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    auto t0 = Clock::now();
+    size_t total = 0;
+    ssize_t n;
+    while ((n = ::read(fd, buffer.data(), buffer.size())) > 0) total += static_cast<size_t>(n);
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    ::close(fd);
+    return static_cast<double>(total) / (1024.0 * 1024.0) / seconds;
+}
+
+#ifdef CCM_HAS_IO_URING
+/**
+ * @brief 用 io_uring 保持多个读请求在途读取整个文件
+ */
+double readUring(const std::string& path, size_t chunk, unsigned depth) {
+    std::vector<std::vector<char>> buffers(depth, std::vector<char>(chunk));
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    off_t size = ::lseek(fd, 0, SEEK_END);
+
+    IoUring ring;
+    std::string error;
+    if (!ring.init(depth, error)) {
+        ::close(fd);
+        return 0.0;
+    }
+
+    auto t0 = Clock::now();
+    uint64_t nextOffset = 0;
+    unsigned inflight = 0;
+    size_t total = 0;
+    for (unsigned i = 0; i < depth && nextOffset < static_cast<uint64_t>(size); ++i) {
+        IoUring::prepRead(ring.getSqe(), fd, buffers[i].data(), chunk, nextOffset, i);
+        nextOffset += chunk;
+        ++inflight;
+    }
+    while (inflight > 0) {
+        ring.submit(1);
+        ring.forEachCompletion([&](uint64_t slot, int res) {
+            --inflight;
+            if (res > 0) total += static_cast<size_t>(res);
+            if (nextOffset < static_cast<uint64_t>(size)) {
+                IoUring::prepRead(ring.getSqe(), fd, buffers[slot].data(), chunk, nextOffset, slot);
+                nextOffset += chunk;
+                ++inflight;
+            }
+        });
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    ::close(fd);
+    return static_cast<double>(total) / (1024.0 * 1024.0) / seconds;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 4;
+    int requests = argc > 2 ? std::atoi(argv[2]) : 20000;
+    int fileMb = argc > 3 ? std::atoi(argv[3]) : 256;
+
+    auto manager = createManager();
+    manager.createCommand("ping", "返回pong",
+        [](const CommandContext& ctx) {
+            ctx.out() << "pong\n";
+            return true;
+        });
+
+    std::cout << "服务器后端: " << clients << " 个客户端 x " << requests << " 个请求\n";
+    benchServer(manager, ServerBackend::Blocking, clients, requests);
+    benchServer(manager, ServerBackend::Epoll, clients, requests);
+    benchServer(manager, ServerBackend::IoUring, clients, requests);
+
+    // 文件读取对比，文件已在页缓存中，测量的是提交路径本身的开销
+    char path[] = "/tmp/ccm_io_benchXXXXXX";
+    int fd = ::mkstemp(path);
+    std::vector<char> block(1024 * 1024, 'x');
+    for (int i = 0; i < fileMb; ++i) {
+        if (::write(fd, block.data(), block.size()) < 0) break;
+    }
+    ::close(fd);
+
+    const size_t chunk = 128 * 1024;
+    std::cout << "\n文件读取 (" << fileMb << " MB, 块大小 128 KB):\n";
+    readPosix(path, chunk);  // 预热页缓存
+    std::cout << "  read()      " << std::fixed << std::setprecision(0)
+              << readPosix(path, chunk) << " MB/s\n";
+#ifdef CCM_HAS_IO_URING
+    if (IoUring::isSupported()) {
+        std::cout << "  io_uring x8 " << readUring(path, chunk, 8) << " MB/s\n";
+    }
+#endif
+    ::unlink(path);
+    return 0;
+}
@@ -0,0 +1,222 @@
+/**
+ * @file overload_bench.cpp
+ * @brief 过载场景下准入控制的效果基准
+ * @details 注册一个耗时固定的 work 命令，用多个客户端连接以流水线方式持续发送请求，
+ *          使请求到达速率远超工作线程的处理能力。分别在以下配置下运行：
+ *          1. 无界：队列和每客户端上限都很大，所有请求最终都会执行
+ *          2. 有界：限制队列深度和每客户端并发数，超出的请求立即返回 BUSY
+ *          3. 有界 + 排队超时：额外丢弃排队过久的请求
+ *          对比成功请求的延迟分位数和被拒绝的请求数。
+ *
+ * 用法: overload_bench [客户端数] [流水线深度] [持续秒数] [命令耗时微秒]
+ */
+
+#include "ConsoleCommandManager.h"
+#include "ConsoleCommandServer.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using namespace ConsoleCommand;
+using Clock = std::chrono::steady_clock;
+
+namespace {
+
+/**
+ * @brief 单个客户端的统计结果
+ */
+struct ClientResult {
+    std::vector<double> okLatencies;   ///< 成功请求的延迟（微秒）
+    std::vector<double> busyLatencies; ///< BUSY 响应的延迟（微秒）
+    size_t failed = 0;                 ///< FAIL 响应数
+};
+
+int connectTo(uint16_t port) {
+    int fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    ::inet_pton(AF_INET, "127.0.0.1", &addr.sin_addr);
+    if (::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+        ::close(fd);
+        return -1;
+    }
+    int one = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+/**
+ * @brief 从缓冲区取出一个完整响应的状态
+ * @return 取到返回true
+ */
+bool takeResponse(std::string& buffer, std::string& status) {
+    size_t newline = buffer.find('\n');
+    if (newline == std::string::npos) return false;
+    size_t space = buffer.find(' ');
+    size_t length = std::stoul(buffer.substr(space + 1, newline - space - 1));
+    if (buffer.size() < newline + 1 + length) return false;
+    status = buffer.substr(0, space);
+    buffer.erase(0, newline + 1 + length);
+    return true;
+}
+
+/**
+ * @brief 以固定流水线深度持续发送请求，直到时间用完且所有响应都已收到
+ */
+void runClient(uint16_t port, int window, double seconds, ClientResult& result) {
+    int fd = connectTo(port);
+    if (fd < 0) return;
+
+    const std::string request = "work\n";
+    std::deque<Clock::time_point> outstanding;
+    std::string buffer;
+    char chunk[4096];
+    auto deadline = Clock::now() + std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<double>(seconds));
+
+    auto sendOne = [&] {
+        outstanding.push_back(Clock::now());
+        return ::send(fd, request.data(), request.size(), MSG_NOSIGNAL) ==
+               static_cast<ssize_t>(request.size());
+    };
+
+    for (int i = 0; i < window; ++i) {
+        if (!sendOne()) break;
+    }
+
+    while (!outstanding.empty()) {
+        ssize_t n = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (n <= 0) break;
+        buffer.append(chunk, static_cast<size_t>(n));
+
+        std::string status;
+        while (takeResponse(buffer, status)) {
+            double us = std::chrono::duration<double, std::micro>(Clock::now() - outstanding.front()).count();
+            outstanding.pop_front();
+            if (status == "OK") result.okLatencies.push_back(us);
+            else if (status == "BUSY") result.busyLatencies.push_back(us);
+            else ++result.failed;
+
+            if (Clock::now() < deadline) sendOne();
+        }
+    }
+    ::close(fd);
+}
+
+double percentile(std::vector<double>& samples, double p) {
+    if (samples.empty()) return 0.0;
+    size_t index = static_cast<size_t>(p * static_cast<double>(samples.size() - 1));
+    std::nth_element(samples.begin(), samples.begin() + static_cast<long>(index), samples.end());
+    return samples[index];
+}
+
+/**
+ * @brief 在给定准入配置下运行一轮过载测试
+ */
+void runScenario(CommandManager& manager, const std::string& name, const CommandManager::Config& limits,
+                 int clients, int window, double seconds) {
+    manager.setConfig(limits);
+
+    ServerConfig cfg;
+    cfg.backend = ServerBackend::Epoll;
+    CommandServer server(manager, cfg);
+    std::string error;
+    if (!server.start(error)) {
+        std::cout << name << " 启动失败: " << error << "\n";
+        return;
+    }
+    std::thread serverThread([&server] { server.run(); });
+
+    std::vector<ClientResult> results(static_cast<size_t>(clients));
+    std::vector<std::thread> threads;
+    auto begin = Clock::now();
+    for (int c = 0; c < clients; ++c) {
+        threads.emplace_back(runClient, server.port(), window, seconds, std::ref(results[static_cast<size_t>(c)]));
+    }
+    for (auto& t : threads) t.join();
+    double elapsed = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    AdmissionStats stats = server.getAdmissionStats();
+    server.stop();
+    serverThread.join();
+
+    std::vector<double> ok, busy;
+    size_t failed = 0;
+    for (auto& r : results) {
+        ok.insert(ok.end(), r.okLatencies.begin(), r.okLatencies.end());
+        busy.insert(busy.end(), r.busyLatencies.begin(), r.busyLatencies.end());
+        failed += r.failed;
+    }
+
+    double maxOk = ok.empty() ? 0.0 : *std::max_element(ok.begin(), ok.end());
+    double avgQueueUs = stats.completed + stats.rejectedQueueTimeout > 0
+        ? static_cast<double>(stats.queueTimeTotalUs) / static_cast<double>(stats.completed + stats.rejectedQueueTimeout)
+        : 0.0;
+
+    std::cout << std::fixed << std::setprecision(1)
+              << name << ":\n"
+              << "  成功 " << ok.size() << " (" << static_cast<double>(ok.size()) / elapsed << " req/s)"
+              << ", BUSY " << busy.size() << ", FAIL " << failed << "\n"
+              << "  成功延迟  p50 " << percentile(ok, 0.50) / 1000.0 << " ms"
+              << "  p99 " << percentile(ok, 0.99) / 1000.0 << " ms"
+              << "  max " << maxOk / 1000.0 << " ms\n"
+              << "  BUSY 延迟 p50 " << percentile(busy, 0.50) / 1000.0 << " ms\n"
+              << "  拒绝: 客户端上限 " << stats.rejectedClientLimit
+              << ", 队列满 " << stats.rejectedQueueFull
+              << ", 排队超时 " << stats.rejectedQueueTimeout
+              << ", 速率 " << stats.rejectedRate << "\n"
+              << "  平均排队 " << avgQueueUs / 1000.0 << " ms, 最长排队 "
+              << static_cast<double>(stats.queueTimeMaxUs) / 1000.0 << " ms\n";
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    int clients = argc > 1 ? std::atoi(argv[1]) : 32;
+    int window = argc > 2 ? std::atoi(argv[2]) : 16;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 2.0;
+    int workUs = argc > 4 ? std::atoi(argv[4]) : 1000;
+
+    auto manager = createManager();
+    manager.createCommand("work", "模拟固定耗时的命令",
+        [workUs](const CommandContext& ctx) {
+            std::this_thread::sleep_for(std::chrono::microseconds(workUs));
+            ctx.out() << "done\n";
+            return true;
+        });
+
+    std::cout << clients << " 个客户端 x 流水线深度 " << window << ", 持续 " << seconds
+              << " 秒, 命令耗时 " << workUs << " us\n\n";
+
+    CommandManager::Config unbounded = manager.getConfig();
+    unbounded.dispatchThreads = 4;
+    unbounded.maxQueueDepth = 1 << 20;
+    unbounded.maxPendingPerClient = 1 << 20;
+    unbounded.maxQueueTimeMs = 0;
+    runScenario(manager, "无界队列", unbounded, clients, window, seconds);
+
+    CommandManager::Config bounded = unbounded;
+    bounded.maxQueueDepth = 8;
+    bounded.maxPendingPerClient = 2;
+    runScenario(manager, "有界队列", bounded, clients, window, seconds);
+
+    CommandManager::Config timed = bounded;
+    timed.maxQueueDepth = 64;
+    timed.maxQueueTimeMs = 5;
+    runScenario(manager, "有界队列 + 5ms 排队超时", timed, clients, window, seconds);
+    return 0;
+}
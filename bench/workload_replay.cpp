@@ -0,0 +1,198 @@
+/**
+ * @file workload_replay.cpp
+ * @brief 用合成负载回放测量命令处理的吞吐量和尾延迟
+ * @details 注册一组与示例文件管理器参数结构相同、但执行器不做 I/O 的命令
+ *          （可用 --synthetic 追加更多命令），由 WorkloadGenerator 按给定分布生成命令流，
+ *          再通过逐条执行或 processBatch 回放，输出吞吐量和延迟分位数。
+ *
+ *          --dump 把生成的命令流写入文件（每行一条），--input 从文件读取命令流代替生成，
+ *          便于在不同版本之间回放完全相同的负载。
+ *
+ * 用法: workload_replay [--count 100000] [--seed 1] [--zipf 1.0] [--typo-rate 0.01]
+ *                       [--quote-rate 0.1] [--value-length 1:16] [--synthetic 0]
+ *                       [--batch 0] [--dump 文件] [--input 文件]
+ */
+
+#include "ConsoleCommandWorkload.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace ConsoleCommand;
+
+namespace {
+
+volatile size_t sink = 0;
+
+struct Options {
+    size_t count = 100000;
+    WorkloadSpec spec;
+    size_t synthetic = 0;
+    size_t batch = 0;
+    std::string dump;
+    std::string input;
+};
+
+bool noop(const CommandContext& ctx) {
+    sink = sink + ctx.argumentCount();
+    return true;
+}
+
+/**
+ * @brief 注册与示例文件管理器相同参数结构的命令
+ */
+void registerCommands(CommandManager& manager, size_t synthetic) {
+    manager.createCommand("ls", "列出目录内容", noop)
+        .addParameter("path", "目录路径", false, ".", TYPE_PATH)
+        .addOption("long", "l", "长格式显示", false)
+        .addOption("all", "a", "显示隐藏文件", false);
+    manager.createCommand("cp", "复制文件或目录", noop)
+        .addParameter("source", "源文件路径", true, "", TYPE_FILE)
+        .addParameter("dest", "目标文件路径", true, "", TYPE_FILE)
+        .addOption("recursive", "r", "递归复制目录", false)
+        .addOption("force", "f", "覆盖目标文件", false);
+    manager.createCommand("mv", "移动或重命名文件", noop)
+        .addParameter("source", "源文件路径", true, "", TYPE_FILE)
+        .addParameter("dest", "目标文件路径", true, "", TYPE_FILE)
+        .addOption("force", "f", "覆盖目标文件", false);
+    manager.createCommand("rm", "删除文件或目录", noop)
+        .addParameter("path", "要删除的路径", true, "", TYPE_PATH)
+        .addOption("recursive", "r", "递归删除目录", false)
+        .addOption("force", "f", "强制删除", false);
+    manager.createCommand("mkdir", "创建目录", noop)
+        .addParameter("path", "目录路径", true, "", TYPE_PATH)
+        .addOption("parents", "p", "创建父目录", false);
+    manager.createCommand("cat", "显示文件内容", noop)
+        .addParameter("file", "文件路径", true, "", TYPE_FILE)
+        .addOption("number", "n", "显示行号", false)
+        .addOption("lines", "", "最多显示的行数", true, "0", "行数");
+    manager.createCommand("cd", "切换工作目录", noop)
+        .addParameter("path", "目标目录", false, "", TYPE_PATH);
+    manager.createCommand("pwd", "显示工作目录", noop);
+    manager.createCommand("info", "显示文件信息", noop)
+        .addParameter("path", "文件路径", true, "", TYPE_PATH);
+    manager.createCommand("grep", "在文件中搜索文本", noop)
+        .addParameter("pattern", "搜索文本", true, "", TYPE_STRING)
+        .addParameter("...", "文件列表", false)
+        .addOption("ignore-case", "i", "忽略大小写", false)
+        .addOption("max-count", "m", "最多匹配数", true, "0", "数量");
+    manager.createCommand("sleep", "等待指定时间", noop)
+        .addParameter("seconds", "秒数", true, "", TYPE_FLOAT);
+
+    for (size_t i = 0; i < synthetic; ++i) {
+        manager.createCommand("task" + std::to_string(i), "合成命令", noop)
+            .addParameter("target", "目标", true, "", TYPE_STRING)
+            .addParameter("count", "次数", false, "1", TYPE_INTEGER)
+            .addOption("verbose", "v", "详细输出", false)
+            .addOption("level", "L", "级别", true, "1", "级别");
+    }
+}
+
+bool parseOptions(int argc, char* argv[], Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) {
+            std::cerr << "缺少参数值: " << arg << "\n";
+            return false;
+        }
+        std::string value = argv[++i];
+        if (arg == "--count") {
+            opt.count = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--seed") {
+            opt.spec.seed = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (arg == "--zipf") {
+            opt.spec.zipfExponent = std::atof(value.c_str());
+        } else if (arg == "--typo-rate") {
+            opt.spec.typoRate = std::atof(value.c_str());
+        } else if (arg == "--quote-rate") {
+            opt.spec.quoteRate = std::atof(value.c_str());
+        } else if (arg == "--value-length") {
+            size_t colon = value.find(':');
+            if (colon == std::string::npos) {
+                std::cerr << "--value-length 格式为 最短:最长\n";
+                return false;
+            }
+            opt.spec.minValueLength = std::strtoul(value.substr(0, colon).c_str(), nullptr, 10);
+            opt.spec.maxValueLength = std::strtoul(value.substr(colon + 1).c_str(), nullptr, 10);
+        } else if (arg == "--synthetic") {
+            opt.synthetic = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--batch") {
+            opt.batch = std::strtoul(value.c_str(), nullptr, 10);
+        } else if (arg == "--dump") {
+            opt.dump = value;
+        } else if (arg == "--input") {
+            opt.input = value;
+        } else {
+            std::cerr << "未知参数: " << arg << "\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string formatNanos(uint64_t nanos) {
+    char buf[32];
+    if (nanos >= 1000000) std::snprintf(buf, sizeof(buf), "%.2fms", static_cast<double>(nanos) / 1e6);
+    else if (nanos >= 1000) std::snprintf(buf, sizeof(buf), "%.2fus", static_cast<double>(nanos) / 1e3);
+    else std::snprintf(buf, sizeof(buf), "%luns", static_cast<unsigned long>(nanos));
+    return buf;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Options opt;
+    if (!parseOptions(argc, argv, opt)) {
+        std::cerr << "用法: workload_replay [--count N] [--seed S] [--zipf S] [--typo-rate R] [--quote-rate R]"
+                     " [--value-length 最短:最长] [--synthetic N] [--batch N] [--dump 文件] [--input 文件]\n";
+        return 2;
+    }
+
+    CommandManager manager;
+    registerCommands(manager, opt.synthetic);
+
+    std::vector<std::string> lines;
+    if (!opt.input.empty()) {
+        std::ifstream in(opt.input);
+        if (!in) {
+            std::cerr << "无法打开 " << opt.input << "\n";
+            return 1;
+        }
+        std::string line;
+        while (std::getline(in, line)) lines.push_back(line);
+    } else {
+        WorkloadGenerator generator(manager, opt.spec);
+        lines = generator.generate(opt.count);
+        std::printf("生成 %zu 条命令（%zu 个命令，种子 %llu，Zipf %.2f，拼写错误 %.1f%%，引号 %.1f%%）\n",
+                    lines.size(), generator.commandCount(), static_cast<unsigned long long>(opt.spec.seed),
+                    opt.spec.zipfExponent, opt.spec.typoRate * 100.0, opt.spec.quoteRate * 100.0);
+    }
+
+    if (!opt.dump.empty()) {
+        std::ofstream out(opt.dump);
+        for (const auto& line : lines) out << line << '\n';
+        if (!out) {
+            std::cerr << "无法写入 " << opt.dump << "\n";
+            return 1;
+        }
+    }
+
+    ReplayOptions replay;
+    replay.batchSize = opt.batch;
+    ReplayReport report = replayWorkload(manager, lines, replay);
+
+    std::printf("模式:     %s\n", opt.batch ? ("processBatch(" + std::to_string(opt.batch) + ")").c_str() : "逐条");
+    std::printf("命令:     %zu（成功 %zu，失败 %zu）\n", report.commands, report.succeeded,
+                report.commands - report.succeeded);
+    std::printf("耗时:     %.3fs\n", report.seconds);
+    std::printf("吞吐量:   %.0f 命令/秒\n", report.throughput);
+    std::printf("延迟%s:  p50 %s  p90 %s  p99 %s  p99.9 %s  max %s\n", opt.batch ? "(批内平均)" : "",
+                formatNanos(report.p50Nanos).c_str(), formatNanos(report.p90Nanos).c_str(),
+                formatNanos(report.p99Nanos).c_str(), formatNanos(report.p999Nanos).c_str(),
+                formatNanos(report.maxNanos).c_str());
+    return 0;
+}
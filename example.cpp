@@ -1,8 +1,25 @@
 #include "ConsoleCommandManager.h"
+#include "ConsoleCommandServer.h"
+#include "ConsoleCommandMetrics.h"
+#include "ConsoleCommandFileOps.h"
 #include <iostream>
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <charconv>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+#ifdef CCM_HAS_IO_URING
+#include <sys/stat.h>
+#endif
 
 using namespace ConsoleCommand;
 
@@ -12,18 +29,33 @@ using namespace ConsoleCommand;
  * 
  * 演示了如何使用ConsoleCommandManager框架来构建一个实用的CLI应用程序。
  * 实现了ls、cp、mv、rm、mkdir、cat、info等常见文件操作命令。
+ * 
+ * 设置环境变量 CCM_IO_BACKEND=uring 后，ls、cp、cat 会在支持的内核上
+ * 使用 io_uring 批量提交 statx/read/write 请求，否则使用标准库实现；
+ * cat 输出到终端或管道时用 sendfile 直接发送文件内容。
  */
 class SimpleFileManager {
 public:
+    /**
+     * @brief 构造函数
+     * @details 根据环境变量 CCM_IO_BACKEND 选择文件命令的I/O后端
+     */
+    SimpleFileManager() {
+#ifdef CCM_HAS_IO_URING
+        const char* backend = std::getenv("CCM_IO_BACKEND");
+        useIoUring = backend && std::string(backend) == "uring" && IoUring::isSupported();
+#endif
+    }
+    
     /**
      * @brief 初始化文件管理器
      * @return CommandManager实例
      */
-    static CommandManager initialize() {
+    CommandManager initialize() {
         auto manager = createManager();
         manager.setPrompt("fm> ");
         
-        // 注册ls命令
+        // 注册ls命令（不合并并发请求：大目录的输出直接写出，不缓存在内存中）
         manager.createCommand("ls", "列出目录内容",
             [this](const CommandContext& ctx) {
                 return handleLS(ctx);
@@ -33,7 +65,8 @@ public:
             .addOption("all", "a", "显示隐藏文件", false)
             .addExample("ls                 # 列出当前目录")
             .addExample("ls /path/to/dir   # 列出指定目录")
-            .addExample("ls -l              # 长格式显示");
+            .addExample("ls -l              # 长格式显示")
+            .addExample("ls -a              # 包括隐藏文件");
         
         // 注册cp命令
         manager.createCommand("cp", "复制文件或目录",
@@ -44,8 +77,10 @@ public:
             .addParameter("dest", "目标文件路径", true, "", "file")
             .addOption("recursive", "r", "递归复制目录", false)
             .addOption("force", "f", "覆盖目标文件", false)
+            .addOption("jobs", "j", "并行复制的线程数，0表示CPU核数", true, "0", "数量")
             .addExample("cp source.txt dest.txt      # 复制文件")
-            .addExample("cp -r src_dir dest_dir      # 复制目录");
+            .addExample("cp -r src_dir dest_dir      # 复制目录")
+            .addExample("cp src_dir dest_dir -r -j 8 # 用8个线程复制目录");
         
         // 注册mv命令
         manager.createCommand("mv", "移动或重命名文件",
@@ -79,7 +114,7 @@ public:
             .addExample("mkdir newdir                   # 创建目录")
             .addExample("mkdir -p parent/child/subdir   # 创建多层目录");
         
-        // 注册cat命令
+        // 注册cat命令（不合并并发请求：合并要把整个输出缓存在内存中，大文件无法直接发送到输出）
         manager.createCommand("cat", "显示文件内容",
             [this](const CommandContext& ctx) {
                 return handleCAT(ctx);
@@ -89,6 +124,22 @@ public:
             .addExample("cat file.txt      # 显示文件内容")
             .addExample("cat -n file.txt   # 显示文件内容并标记行号");
         
+        // 注册cd命令
+        manager.createCommand("cd", "切换当前会话的工作目录",
+            [this](const CommandContext& ctx) {
+                return handleCD(ctx);
+            })
+            .addParameter("path", "目标目录", true, "", "path")
+            .addExample("cd /tmp            # 切换到/tmp")
+            .addExample("cd ..              # 切换到上级目录");
+        
+        // 注册pwd命令
+        manager.createCommand("pwd", "显示当前会话的工作目录",
+            [this](const CommandContext& ctx) {
+                return handlePWD(ctx);
+            })
+            .addExample("pwd                # 显示工作目录");
+        
         // 注册info命令
         manager.createCommand("info", "显示文件信息",
             [this](const CommandContext& ctx) {
@@ -96,45 +147,252 @@ public:
             })
             .addParameter("path", "文件或目录路径", true, "", "path")
             .addExample("info file.txt     # 显示文件信息")
-            .addExample("info directory/   # 显示目录信息");
+            .addExample("info directory/   # 显示目录信息")
+            .setCoalescable();
         
+        registerServerCommand(manager);
         return manager;
     }
     
+    /**
+     * @brief 注册serve命令
+     * @param manager 命令管理器，serve运行期间由服务器使用
+     * @details 执行器通过上下文取得分发它的管理器，管理器之后被移动也不受影响
+     */
+    void registerServerCommand(CommandManager& manager) {
+        manager.createCommand("serve", "以服务器模式运行，通过本地套接字接受命令",
+            [](const CommandContext& ctx) {
+                return ctx.getManager() && handleSERVE(*ctx.getManager(), ctx);
+            })
+            .addParameter("port", "TCP端口（仅监听127.0.0.1）", false, "0", "int")
+            .addOption("unix", "u", "使用Unix域套接字路径代替TCP", true, "", "路径")
+            .addOption("backend", "b", "I/O后端: auto/blocking/epoll/uring", true, "auto", "名称")
+            .addOption("protocol", "P", "请求协议: line/binary/http", true, "line", "名称")
+            .addOption("threads", "t", "执行命令的工作线程数，0表示在I/O线程中执行", true, "0", "数量")
+            .addOption("queue", "q", "等待工作线程的最大请求数，超出时返回BUSY", true, "1024", "数量")
+            .addOption("metrics", "m", "Prometheus指标: 端口、Unix套接字路径或 file:路径", true, "", "地址")
+            .addExample("serve 9000              # 在127.0.0.1:9000上监听")
+            .addExample("serve -u /tmp/fm.sock   # 在Unix域套接字上监听")
+            .addExample("serve 9000 -b epoll     # 强制使用epoll后端")
+            .addExample("serve 9000 -P binary    # 使用二进制帧协议")
+            .addExample("serve 9000 -P http      # HTTP/1.1 JSON网关: POST /cmd/<命令名>")
+            .addExample("serve 9000 -t 4 -q 64   # 4个工作线程，最多64个请求排队")
+            .addExample("serve 9000 -m 9464      # 在127.0.0.1:9464/metrics上导出指标")
+            .addExample("serve 9000 -m file:/var/lib/node_exporter/fm.prom  # 每10秒写入指标文件");
+    }
+    
 private:
+    bool useIoUring = false;  ///< 文件命令是否使用io_uring
+    
+    /**
+     * @brief 把用户输入的路径解析为相对于会话工作目录的路径
+     */
+    static std::string resolvePath(const CommandContext& ctx, const std::string& path) {
+        const Session* view = ctx.getSessionView();
+        return view ? view->resolvePath(path) : path;
+    }
+    
+    /**
+     * @brief 解析非负整数选项
+     * @details std::stoul 会接受 "-1" 并回绕成极大值，这里只接受十进制数字
+     * @param text 选项值
+     * @param max 允许的最大值
+     * @param value 输出参数，解析结果
+     * @return 全部是数字且不超过 max 时返回true
+     */
+    static bool parseCount(const std::string& text, size_t max, size_t& value) {
+        if (text.empty() || text.size() > 19) return false;
+        size_t result = 0;
+        for (char c : text) {
+            if (c < '0' || c > '9') return false;
+            result = result * 10 + static_cast<size_t>(c - '0');
+        }
+        if (result > max) return false;
+        value = result;
+        return true;
+    }
+    
+    /**
+     * @brief 处理cd命令
+     */
+    bool handleCD(const CommandContext& ctx) {
+        Session* session = ctx.getSession();
+        if (!session) {
+            ctx.err() << "✗ 当前没有会话" << std::endl;
+            return false;
+        }
+        
+        try {
+            auto target = std::filesystem::absolute(resolvePath(ctx, ctx.getArgument(0)));
+            target = std::filesystem::weakly_canonical(target);
+            if (!std::filesystem::is_directory(target)) {
+                ctx.err() << "✗ 不是目录: " << target.string() << std::endl;
+                return false;
+            }
+            session->setWorkingDirectory(target.string());
+            return true;
+        } catch (const std::exception& e) {
+            ctx.err() << "✗ 切换目录失败: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    
+    /**
+     * @brief 处理pwd命令
+     */
+    bool handlePWD(const CommandContext& ctx) {
+        const Session* view = ctx.getSessionView();
+        if (view && !view->getWorkingDirectory().empty()) {
+            ctx.out() << view->getWorkingDirectory() << std::endl;
+        } else {
+            ctx.out() << std::filesystem::current_path().string() << std::endl;
+        }
+        return true;
+    }
+    
+    /**
+     * @brief 处理serve命令
+     */
+    static bool handleSERVE(CommandManager& manager, const CommandContext& ctx) {
+        ServerConfig cfg;
+        size_t port = 0;
+        if (!parseCount(ctx.getArgument(0, "0"), 65535, port)) {
+            ctx.err() << "✗ 端口必须是 0 到 65535 之间的整数" << std::endl;
+            return false;
+        }
+        cfg.port = static_cast<uint16_t>(port);
+        cfg.unixPath = ctx.getOption("unix", ctx.getOption("u", ""));
+        
+        std::string backendName = ctx.getOption("backend", ctx.getOption("b", "auto"));
+        if (!parseBackend(backendName, cfg.backend)) {
+            ctx.err() << "✗ 未知的后端: " << backendName << std::endl;
+            return false;
+        }
+        
+        std::string protocol = ctx.getOption("protocol", ctx.getOption("P", "line"));
+        if (protocol == "binary") {
+            cfg.protocol = ServerProtocol::Binary;
+        } else if (protocol == "http") {
+            cfg.protocol = ServerProtocol::Http;
+        } else if (protocol != "line") {
+            ctx.err() << "✗ 未知的协议: " << protocol << std::endl;
+            return false;
+        }
+        
+        CommandManager::Config limits = manager.getConfig();
+        if (!parseCount(ctx.getOption("threads", ctx.getOption("t", "0")), 1024, limits.dispatchThreads)) {
+            ctx.err() << "✗ 线程数必须是 0 到 1024 之间的整数" << std::endl;
+            return false;
+        }
+        if (!parseCount(ctx.getOption("queue", ctx.getOption("q", "1024")), 1 << 20, limits.maxQueueDepth)) {
+            ctx.err() << "✗ 队列长度必须是 0 到 1048576 之间的整数" << std::endl;
+            return false;
+        }
+        manager.setConfig(limits);
+        
+        MetricsConfig metricsCfg;
+        std::string metrics = ctx.getOption("metrics", ctx.getOption("m", ""));
+        if (metrics.compare(0, 5, "file:") == 0) {
+            metricsCfg.filePath = metrics.substr(5);
+        } else if (!metrics.empty() && metrics.find_first_not_of("0123456789") == std::string::npos) {
+            size_t metricsPort = 0;
+            if (!parseCount(metrics, 65535, metricsPort)) {
+                ctx.err() << "✗ 指标端口必须是 0 到 65535 之间的整数" << std::endl;
+                return false;
+            }
+            metricsCfg.port = static_cast<uint16_t>(metricsPort);
+        } else {
+            metricsCfg.unixPath = metrics;
+        }
+        
+        CommandServer server(manager, cfg);
+        std::string error;
+        if (!server.start(error)) {
+            ctx.err() << "✗ 服务器启动失败: " << error << std::endl;
+            return false;
+        }
+        
+        MetricsExporter exporter(manager, metricsCfg);
+        exporter.setServer(&server);
+        if (!metrics.empty()) {
+            if (!exporter.start(error)) {
+                ctx.err() << "✗ 指标导出启动失败: " << error << std::endl;
+                return false;
+            }
+            ctx.out() << "✓ 指标导出: " << metrics << std::endl;
+        }
+        
+        if (cfg.unixPath.empty()) {
+            ctx.out() << "✓ 正在监听 127.0.0.1:" << server.port();
+        } else {
+            ctx.out() << "✓ 正在监听 " << cfg.unixPath;
+        }
+        ctx.out() << " (后端: " << ConsoleCommand::backendName(server.backend()) << ")" << std::endl;
+        
+        server.run();
+        return true;
+    }
+
     /**
      * @brief 处理ls命令
+     * @details Linux 上由 DirectoryLister 用 getdents64 读取目录，只对需要的项调用 statx，
+     *          输出成块写出；不显示以 '.' 开头的项，除非指定 -a
      */
     bool handleLS(const CommandContext& ctx) {
-        std::string path = ctx.getArgument(0, ".");
+        std::string path = resolvePath(ctx, ctx.getArgument(0, "."));
+        bool longFormat = ctx.hasFlag("l") || ctx.hasFlag("long");
+        bool showAll = ctx.hasFlag("a") || ctx.hasFlag("all");
         
         try {
-            std::cout << "目录内容: " << path << std::endl;
-            std::cout << std::string(50, '-') << std::endl;
+            ctx.out() << "目录内容: " << path << std::endl;
+            ctx.out() << std::string(50, '-') << std::endl;
             
+#ifdef CCM_HAS_IO_URING
+            if (useIoUring && !longFormat) {
+                return listWithIoUring(ctx, path, showAll);
+            }
+#endif
+            
+#ifdef CCM_HAS_FAST_FS
+            ListOptions options;
+            options.showAll = showAll;
+            options.longFormat = longFormat;
+            OutputSink out = OutputSink::forStream(ctx.out());
+            std::string error;
+            if (!DirectoryLister::list(path, options, out, error)) {
+                ctx.err() << "错误: " << error << std::endl;
+                return false;
+            }
+#else
             for (const auto& entry : std::filesystem::directory_iterator(path)) {
+                std::string name = entry.path().filename().string();
+                if (!showAll && !name.empty() && name[0] == '.') continue;
                 std::string type = entry.is_directory() ? "[DIR]" : "[FILE]";
-                std::cout << type << " " << entry.path().filename().string();
+                ctx.out() << type << " " << name;
                 
                 if (entry.is_regular_file()) {
-                    std::cout << " (" << entry.file_size() << " bytes)";
+                    ctx.out() << " (" << entry.file_size() << " bytes)";
                 }
-                std::cout << std::endl;
+                ctx.out() << '\n';
             }
+            ctx.out().flush();
+#endif
             
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "错误: " << e.what() << std::endl;
+            ctx.err() << "错误: " << e.what() << std::endl;
             return false;
         }
     }
     
     /**
      * @brief 处理cp命令
+     * @details Linux 上文件和递归复制由 TreeCopier 完成：多线程并行遍历目录树，
+     *          数据依次尝试 reflink、copy_file_range、read/write，并保留权限、属主和时间戳
      */
     bool handleCP(const CommandContext& ctx) {
-        std::string source = ctx.getArgument(0);
-        std::string dest = ctx.getArgument(1);
+        std::string source = resolvePath(ctx, ctx.getArgument(0));
+        std::string dest = resolvePath(ctx, ctx.getArgument(1));
         bool recursive = ctx.hasFlag("r") || ctx.hasFlag("recursive");
         
         try {
@@ -145,29 +403,89 @@ private:
             if (ctx.hasFlag("f") || ctx.hasFlag("force")) {
                 opts |= std::filesystem::copy_options::overwrite_existing;
             }
+            bool force = (opts & std::filesystem::copy_options::overwrite_existing) !=
+                         std::filesystem::copy_options::none;
+            
+#ifdef CCM_HAS_IO_URING
+            if (useIoUring && std::filesystem::is_regular_file(source)) {
+                std::string error;
+                if (!copyWithIoUring(source, dest, force, error)) {
+                    ctx.err() << "✗ 复制失败: " << error << std::endl;
+                    return false;
+                }
+                ctx.out() << "✓ 复制成功: " << source << " -> " << dest << std::endl;
+                return true;
+            }
+#endif
+            
+#ifdef CCM_HAS_FAST_FS
+            if (recursive || !std::filesystem::is_directory(source)) {
+                CopyOptions options;
+                options.overwrite = force;
+                size_t jobs = 0;
+                if (!parseCount(ctx.getOption("jobs", ctx.getOption("j", "0")), 1024, jobs)) {
+                    ctx.err() << "✗ 线程数必须是 0 到 1024 之间的整数" << std::endl;
+                    return false;
+                }
+                options.threads = static_cast<unsigned>(jobs);
+                
+                CopyStats stats;
+                std::string error;
+                bool ok = TreeCopier::copy(source, dest, options, error, &stats);
+                if (!ok) {
+                    ctx.err() << "✗ 复制失败: " << error << std::endl;
+                } else {
+                    ctx.out() << "✓ 复制成功: " << source << " -> " << dest << std::endl;
+                }
+                if (recursive && (ok || stats.files > 0)) {
+                    printCopyStats(ctx, stats);
+                }
+                return ok;
+            }
+#endif
             
             std::filesystem::copy(source, dest, opts);
-            std::cout << "✓ 复制成功: " << source << " -> " << dest << std::endl;
+            ctx.out() << "✓ 复制成功: " << source << " -> " << dest << std::endl;
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "✗ 复制失败: " << e.what() << std::endl;
+            ctx.err() << "✗ 复制失败: " << e.what() << std::endl;
             return false;
         }
     }
     
+#ifdef CCM_HAS_FAST_FS
+    /**
+     * @brief 输出递归复制的数量、吞吐量和各种数据复制方式的文件数
+     */
+    static void printCopyStats(const CommandContext& ctx, const CopyStats& stats) {
+        double seconds = std::max(stats.seconds, 1e-6);
+        double mb = static_cast<double>(stats.bytes) / (1024.0 * 1024.0);
+        char line[256];
+        std::snprintf(line, sizeof(line),
+                      "  %llu 个文件, %llu 个目录, %llu 个符号链接, %.1f MB, 用时 %.3f 秒 (%.0f 文件/秒, %.1f MB/秒, %u 线程)",
+                      static_cast<unsigned long long>(stats.files),
+                      static_cast<unsigned long long>(stats.directories),
+                      static_cast<unsigned long long>(stats.symlinks), mb, stats.seconds,
+                      static_cast<double>(stats.files) / seconds, mb / seconds, stats.threads);
+        ctx.out() << line << std::endl;
+        ctx.out() << "  reflink " << stats.reflinked << ", copy_file_range " << stats.rangeCopied
+                  << ", read/write " << stats.bufferCopied << std::endl;
+    }
+#endif
+    
     /**
      * @brief 处理mv命令
      */
     bool handleMV(const CommandContext& ctx) {
-        std::string source = ctx.getArgument(0);
-        std::string dest = ctx.getArgument(1);
+        std::string source = resolvePath(ctx, ctx.getArgument(0));
+        std::string dest = resolvePath(ctx, ctx.getArgument(1));
         
         try {
             std::filesystem::rename(source, dest);
-            std::cout << "✓ 移动成功: " << source << " -> " << dest << std::endl;
+            ctx.out() << "✓ 移动成功: " << source << " -> " << dest << std::endl;
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "✗ 移动失败: " << e.what() << std::endl;
+            ctx.err() << "✗ 移动失败: " << e.what() << std::endl;
             return false;
         }
     }
@@ -176,20 +494,20 @@ private:
      * @brief 处理rm命令
      */
     bool handleRM(const CommandContext& ctx) {
-        std::string path = ctx.getArgument(0);
+        std::string path = resolvePath(ctx, ctx.getArgument(0));
         bool recursive = ctx.hasFlag("r") || ctx.hasFlag("recursive");
         
         try {
             if (std::filesystem::is_directory(path) && !recursive) {
-                std::cerr << "✗ 错误: 目录需要使用 -r 选项删除" << std::endl;
+                ctx.err() << "✗ 错误: 目录需要使用 -r 选项删除" << std::endl;
                 return false;
             }
             
             auto removed = std::filesystem::remove_all(path);
-            std::cout << "✓ 删除成功: " << path << " (" << removed << " 项目)" << std::endl;
+            ctx.out() << "✓ 删除成功: " << path << " (" << removed << " 项目)" << std::endl;
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "✗ 删除失败: " << e.what() << std::endl;
+            ctx.err() << "✗ 删除失败: " << e.what() << std::endl;
             return false;
         }
     }
@@ -198,7 +516,7 @@ private:
      * @brief 处理mkdir命令
      */
     bool handleMKDIR(const CommandContext& ctx) {
-        std::string path = ctx.getArgument(0);
+        std::string path = resolvePath(ctx, ctx.getArgument(0));
         bool parents = ctx.hasFlag("p") || ctx.hasFlag("parents");
         
         try {
@@ -207,10 +525,10 @@ private:
             } else {
                 std::filesystem::create_directory(path);
             }
-            std::cout << "✓ 目录创建成功: " << path << std::endl;
+            ctx.out() << "✓ 目录创建成功: " << path << std::endl;
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "✗ 创建失败: " << e.what() << std::endl;
+            ctx.err() << "✗ 创建失败: " << e.what() << std::endl;
             return false;
         }
     }
@@ -219,59 +537,510 @@ private:
      * @brief 处理cat命令
      */
     bool handleCAT(const CommandContext& ctx) {
-        std::string file = ctx.getArgument(0);
+        std::string file = resolvePath(ctx, ctx.getArgument(0));
         bool showNumbers = ctx.hasFlag("n") || ctx.hasFlag("number");
         
         try {
-            std::ifstream ifs(file);
-            if (!ifs.is_open()) {
-                std::cerr << "✗ 无法打开文件: " << file << std::endl;
-                return false;
+#ifdef CCM_HAS_IO_URING
+            if (useIoUring) {
+                std::string error;
+                if (!catWithIoUring(ctx, file, showNumbers, error)) {
+                    ctx.err() << "✗ " << error << std::endl;
+                    return false;
+                }
+                return true;
             }
+#endif
             
-            std::string line;
-            int lineNum = 1;
+            std::string error;
+            if (!catFile(ctx, file, showNumbers, error)) {
+                ctx.err() << "✗ " << error << std::endl;
+                return false;
+            }
+            return true;
+        } catch (const std::exception& e) {
+            ctx.err() << "✗ 读取失败: " << e.what() << std::endl;
+            return false;
+        }
+    }
+    
+    // ========================================================================
+    // cat 的输出路径
+    // ========================================================================
+    
+    static constexpr size_t CAT_BUFFER = 1 << 20;   ///< 读取和输出缓冲区大小
+    
+    /**
+     * @brief 输出文件内容
+     * @details 不显示行号且输出是进程的标准输出时，用 sendfile 在内核中把文件送到 stdout，
+     *          数据不经过用户空间；sendfile 不支持该输出（例如某些终端）时改为大块读写。
+     *          其他输出流按 CAT_BUFFER 大块读取后整块写出，不再每行刷新一次。
+     *          显示行号时用 memchr（glibc 中是向量化实现）在整块数据中查找换行，
+     *          行号和内容拼接到输出缓冲区，缓冲区满时才写出。
+     *          与原来的逐行实现一致，最后一行没有换行时补一个换行。
+     *          不使用 mmap：被截断的日志文件（例如 copytruncate 轮转）会让访问映射的进程收到 SIGBUS
+     */
+    static bool catFile(const CommandContext& ctx, const std::string& file, bool showNumbers, std::string& error) {
+        int in = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            error = "无法打开文件: " + file;
+            return false;
+        }
+#ifdef POSIX_FADV_SEQUENTIAL
+        ::posix_fadvise(in, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+        
+        OutputSink out = OutputSink::forStream(ctx.out());
+        
+        bool ok = showNumbers ? catNumbered(in, out, error) : catPlain(in, out, error);
+        ::close(in);
+        if (ok) ctx.out().flush();
+        return ok;
+    }
+    
+    /**
+     * @brief 原样输出文件内容
+     */
+    static bool catPlain(int in, OutputSink& out, std::string& error) {
+        char last = '\n';
+        off_t offset = 0;
+#ifdef __linux__
+        if (out.descriptor() >= 0) {
+            for (;;) {
+                ssize_t n = ::sendfile(out.descriptor(), in, &offset, 1 << 30);
+                if (n > 0) continue;
+                if (n == 0) {
+                    if (offset > 0 && ::pread(in, &last, 1, offset - 1) != 1) last = '\n';
+                    return offset == 0 || last == '\n' || out.write("\n", 1, error);
+                }
+                if (errno == EINTR) continue;
+                if ((errno == EINVAL || errno == ENOSYS) && offset == 0) break;  // 输出不支持 sendfile
+                error = std::string("发送失败: ") + std::strerror(errno);
+                return false;
+            }
+        }
+#endif
+        std::unique_ptr<char[]> buffer(new char[CAT_BUFFER]);
+        for (;;) {
+            ssize_t n = ::read(in, buffer.get(), CAT_BUFFER);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("读取失败: ") + std::strerror(errno);
+                return false;
+            }
+            if (n == 0) break;
+            if (!out.write(buffer.get(), static_cast<size_t>(n), error)) return false;
+            last = buffer[n - 1];
+        }
+        return last == '\n' || out.write("\n", 1, error);
+    }
+    
+    /**
+     * @brief 带行号输出文件内容，格式与逐行实现相同（"%4d | 行内容"）
+     */
+    static bool catNumbered(int in, OutputSink& out, std::string& error) {
+        std::unique_ptr<char[]> buffer(new char[CAT_BUFFER]);
+        std::string pending;
+        pending.reserve(CAT_BUFFER + CAT_BUFFER / 4);
+        uint64_t lineNum = 1;
+        bool atLineStart = true;
+        
+        for (;;) {
+            ssize_t n = ::read(in, buffer.get(), CAT_BUFFER);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                error = std::string("读取失败: ") + std::strerror(errno);
+                return false;
+            }
+            if (n == 0) break;
             
-            while (std::getline(ifs, line)) {
-                if (showNumbers) {
-                    std::cout << std::setw(4) << lineNum++ << " | ";
+            const char* data = buffer.get();
+            const char* end = data + n;
+            while (data < end) {
+                if (atLineStart) {
+                    char digits[24];
+                    size_t len = static_cast<size_t>(std::to_chars(digits, digits + sizeof(digits), lineNum++).ptr - digits);
+                    if (len < 4) pending.append(4 - len, ' ');
+                    pending.append(digits, len);
+                    pending.append(" | ");
+                }
+                const char* newline = static_cast<const char*>(std::memchr(data, '\n', static_cast<size_t>(end - data)));
+                const char* stop = newline ? newline + 1 : end;
+                pending.append(data, static_cast<size_t>(stop - data));
+                atLineStart = newline != nullptr;
+                data = stop;
+                if (pending.size() >= CAT_BUFFER) {
+                    if (!out.write(pending.data(), pending.size(), error)) return false;
+                    pending.clear();
                 }
-                std::cout << line << std::endl;
             }
+        }
+        if (!atLineStart) pending.push_back('\n');
+        return out.write(pending.data(), pending.size(), error);
+    }
+    
+#ifdef CCM_HAS_IO_URING
+    // ========================================================================
+    // io_uring 文件操作
+    // ========================================================================
+    
+    static constexpr unsigned URING_DEPTH = 8;          ///< 同时在途的读写请求数
+    static constexpr size_t URING_CHUNK = 128 * 1024;   ///< 每个请求的数据块大小
+    
+    /**
+     * @brief 按行输出数据块，处理跨块的行边界
+     */
+    struct LineWriter {
+        std::ostream& os;
+        bool showNumbers;
+        int lineNum = 1;
+        bool atLineStart = true;
+        
+        void write(const char* data, size_t size) {
+            if (!showNumbers) {
+                os.write(data, static_cast<std::streamsize>(size));
+                atLineStart = size == 0 ? atLineStart : data[size - 1] == '\n';
+                return;
+            }
+            const char* end = data + size;
+            while (data < end) {
+                if (atLineStart) {
+                    os << std::setw(4) << lineNum++ << " | ";
+                    atLineStart = false;
+                }
+                const char* newline = static_cast<const char*>(
+                    std::memchr(data, '\n', static_cast<size_t>(end - data)));
+                const char* stop = newline ? newline + 1 : end;
+                os.write(data, stop - data);
+                atLineStart = newline != nullptr;
+                data = stop;
+            }
+        }
+        
+        void finish() {
+            // 与getline实现保持一致：最后一行总是以换行结束
+            if (!atLineStart) os << '\n';
+            os.flush();
+        }
+    };
+    
+    /**
+     * @brief 使用io_uring批量读取并输出文件
+     * @details 保持URING_DEPTH个顺序读请求在途，按偏移顺序输出完成的数据块
+     */
+    static bool catWithIoUring(const CommandContext& ctx, const std::string& file,
+                               bool showNumbers, std::string& error) {
+        int fd = ::open(file.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd < 0) {
+            error = "无法打开文件: " + file;
+            return false;
+        }
+        
+        struct Slot {
+            std::vector<char> buffer;
+            size_t filled = 0;  ///< 已读入的字节数，读取可能不足一块，剩余部分再次提交
+            int result = 0;
+            bool done = false;
+            bool pending = false;
+        };
+        std::vector<Slot> slots(URING_DEPTH);
+        for (auto& slot : slots) slot.buffer.resize(URING_CHUNK);
+        
+        IoUring ring;
+        if (!ring.init(URING_DEPTH, error)) {
+            ::close(fd);
+            return false;
+        }
+        
+        unsigned inflight = 0;
+        auto submitRead = [&](uint64_t seq) {
+            Slot& slot = slots[seq % URING_DEPTH];
+            slot.pending = true;
+            IoUring::prepRead(ring.getSqe(), fd, slot.buffer.data() + slot.filled,
+                              static_cast<unsigned>(URING_CHUNK - slot.filled),
+                              seq * URING_CHUNK + slot.filled, seq);
+            ++inflight;
+        };
+        auto queueRead = [&](uint64_t seq) {
+            Slot& slot = slots[seq % URING_DEPTH];
+            slot.done = false;
+            slot.filled = 0;
+            submitRead(seq);
+        };
+        
+        for (uint64_t seq = 0; seq < URING_DEPTH; ++seq) queueRead(seq);
+        
+        LineWriter writer{ctx.out(), showNumbers};
+        uint64_t emitSeq = 0;
+        bool eof = false;
+        bool ok = true;
+        
+        while (inflight > 0) {
+            ring.submit(1);
+            ring.forEachCompletion([&](uint64_t seq, int res) {
+                Slot& slot = slots[seq % URING_DEPTH];
+                slot.pending = false;
+                --inflight;
+                if (res == -EINTR || res == -EAGAIN) {
+                    submitRead(seq);
+                    return;
+                }
+                if (res > 0) {
+                    slot.filled += static_cast<size_t>(res);
+                    if (slot.filled < URING_CHUNK) {
+                        submitRead(seq);    // 读取不足一块不代表文件结束，继续读剩余部分
+                        return;
+                    }
+                }
+                slot.result = res;
+                slot.done = true;
+            });
             
-            return true;
-        } catch (const std::exception& e) {
-            std::cerr << "✗ 读取失败: " << e.what() << std::endl;
+            // 按顺序输出已完成的块，并为腾出的槽位排队下一个读请求；
+            // 只有某次读取返回 0 时块才会不满，说明到达文件末尾
+            while (!eof && slots[emitSeq % URING_DEPTH].done) {
+                Slot& slot = slots[emitSeq % URING_DEPTH];
+                slot.done = false;
+                if (slot.result < 0) {
+                    error = std::string("读取失败: ") + std::strerror(-slot.result);
+                    ok = false;
+                    eof = true;
+                    break;
+                }
+                writer.write(slot.buffer.data(), slot.filled);
+                if (slot.filled < URING_CHUNK) {
+                    eof = true;
+                    break;
+                }
+                queueRead(emitSeq + URING_DEPTH);
+                ++emitSeq;
+            }
+        }
+        
+        ring.close();
+        ::close(fd);
+        if (ok) writer.finish();
+        return ok;
+    }
+    
+    /**
+     * @brief 使用io_uring复制单个普通文件
+     * @details 每个槽位先读后写，写完成后立即复用槽位读取下一个数据块
+     */
+    static bool copyWithIoUring(const std::string& source, std::string dest,
+                                bool force, std::string& error) {
+        if (std::filesystem::is_directory(dest)) {
+            dest = (std::filesystem::path(dest) / std::filesystem::path(source).filename()).string();
+        }
+        
+        int in = ::open(source.c_str(), O_RDONLY | O_CLOEXEC);
+        if (in < 0) {
+            error = "无法打开源文件: " + source;
             return false;
         }
+        struct stat st;
+        if (::fstat(in, &st) < 0) {
+            error = std::string("无法获取源文件信息: ") + std::strerror(errno);
+            ::close(in);
+            return false;
+        }
+        
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (force ? O_TRUNC : O_EXCL);
+        int out = ::open(dest.c_str(), flags, st.st_mode & 07777);
+        if (out < 0) {
+            error = "无法创建目标文件: " + dest + " (" + std::strerror(errno) + ")";
+            ::close(in);
+            return false;
+        }
+        
+        struct Slot {
+            std::vector<char> buffer;
+            uint64_t offset = 0; ///< 当前读写位置
+            uint64_t end = 0;    ///< 本槽位负责的块的结束位置
+            size_t length = 0;   ///< 读到的字节数
+            size_t written = 0;  ///< 已写出的字节数
+        };
+        std::vector<Slot> slots(URING_DEPTH);
+        for (auto& slot : slots) slot.buffer.resize(URING_CHUNK);
+        
+        IoUring ring;
+        if (!ring.init(URING_DEPTH, error)) {
+            ::close(in);
+            ::close(out);
+            return false;
+        }
+        
+        const uint64_t fileSize = static_cast<uint64_t>(st.st_size);
+        uint64_t nextOffset = 0;
+        unsigned inflight = 0;
+        bool ok = true;
+        
+        // user_data: 槽位编号 << 1 | 是否为写请求
+        auto submitRead = [&](unsigned index) {
+            Slot& slot = slots[index];
+            slot.length = slot.written = 0;
+            IoUring::prepRead(ring.getSqe(), in, slot.buffer.data(),
+                              static_cast<size_t>(slot.end - slot.offset),
+                              slot.offset, index << 1);
+            ++inflight;
+        };
+        auto queueRead = [&](unsigned index) {
+            if (!ok || nextOffset >= fileSize) return;
+            Slot& slot = slots[index];
+            slot.offset = nextOffset;
+            slot.end = nextOffset + URING_CHUNK;
+            nextOffset += URING_CHUNK;
+            submitRead(index);
+        };
+        auto queueWrite = [&](unsigned index) {
+            Slot& slot = slots[index];
+            IoUring::prepWrite(ring.getSqe(), out, slot.buffer.data() + slot.written,
+                               slot.length - slot.written, slot.offset + slot.written,
+                               (index << 1) | 1);
+            ++inflight;
+        };
+        
+        for (unsigned i = 0; i < URING_DEPTH; ++i) queueRead(i);
+        
+        while (inflight > 0) {
+            ring.submit(1);
+            ring.forEachCompletion([&](uint64_t userData, int res) {
+                unsigned index = static_cast<unsigned>(userData >> 1);
+                bool isWrite = (userData & 1) != 0;
+                Slot& slot = slots[index];
+                --inflight;
+                
+                if (res == -EINTR || res == -EAGAIN) {
+                    if (!ok) return;
+                    if (isWrite) queueWrite(index);
+                    else submitRead(index);
+                    return;
+                }
+                if (res < 0) {
+                    if (ok) error = std::string(isWrite ? "写入失败: " : "读取失败: ") + std::strerror(-res);
+                    ok = false;
+                    return;
+                }
+                if (!ok) return;
+                
+                if (!isWrite) {
+                    slot.length = static_cast<size_t>(res);
+                    if (slot.length == 0) return;
+                    queueWrite(index);
+                } else {
+                    slot.written += static_cast<size_t>(res);
+                    if (slot.written < slot.length) {
+                        queueWrite(index);  // 短写，继续写剩余部分
+                        return;
+                    }
+                    slot.offset += slot.length;
+                    if (slot.offset < slot.end) {
+                        submitRead(index);  // 短读不代表文件结束，从 offset+res 处读完本块
+                    } else {
+                        queueRead(index);
+                    }
+                }
+            });
+        }
+        
+        ring.close();
+        ::close(in);
+        if (::close(out) < 0 && ok) {
+            error = std::string("关闭目标文件失败: ") + std::strerror(errno);
+            ok = false;
+        }
+        return ok;
+    }
+    
+    /**
+     * @brief 使用io_uring批量statx列出目录
+     * @details 目录项类型来自readdir的d_type，只有普通文件才提交statx获取大小
+     */
+    bool listWithIoUring(const CommandContext& ctx, const std::string& path, bool showAll) {
+        struct Entry {
+            std::string name;
+            std::string fullPath;
+            bool isDirectory = false;
+            bool isRegular = false;
+            struct statx stx;
+            int result = 0;
+        };
+        std::vector<Entry> entries;
+        
+        for (const auto& entry : std::filesystem::directory_iterator(path)) {
+            Entry e;
+            e.name = entry.path().filename().string();
+            if (!showAll && !e.name.empty() && e.name[0] == '.') continue;
+            e.fullPath = entry.path().string();
+            e.isDirectory = entry.is_directory();
+            e.isRegular = entry.is_regular_file();
+            entries.push_back(std::move(e));
+        }
+        
+        IoUring ring;
+        std::string error;
+        if (!ring.init(64, error)) {
+            ctx.err() << "错误: " << error << std::endl;
+            return false;
+        }
+        
+        // 按队列容量分批提交statx
+        size_t next = 0;
+        while (next < entries.size()) {
+            unsigned batch = 0;
+            for (; next < entries.size() && batch < ring.capacity(); ++next) {
+                Entry& e = entries[next];
+                if (!e.isRegular) continue;
+                IoUring::prepStatx(ring.getSqe(), AT_FDCWD, e.fullPath.c_str(), 0,
+                                   STATX_SIZE, &e.stx, next);
+                ++batch;
+            }
+            while (batch > 0) {
+                ring.submit(1);
+                batch -= ring.forEachCompletion([&](uint64_t index, int res) {
+                    entries[index].result = res;
+                });
+            }
+        }
+        
+        for (const auto& e : entries) {
+            ctx.out() << (e.isDirectory ? "[DIR]" : "[FILE]") << " " << e.name;
+            if (e.isRegular && e.result == 0) {
+                ctx.out() << " (" << e.stx.stx_size << " bytes)";
+            }
+            ctx.out() << '\n';
+        }
+        ctx.out().flush();
+        return true;
     }
+#endif // CCM_HAS_IO_URING
     
     /**
      * @brief 处理info命令
      */
     bool handleINFO(const CommandContext& ctx) {
-        std::string path = ctx.getArgument(0);
+        std::string path = resolvePath(ctx, ctx.getArgument(0));
         
         try {
             if (!std::filesystem::exists(path)) {
-                std::cerr << "✗ 路径不存在: " << path << std::endl;
+                ctx.err() << "✗ 路径不存在: " << path << std::endl;
                 return false;
             }
             
             auto absPath = std::filesystem::absolute(path);
-            std::cout << "路径信息:" << std::endl;
-            std::cout << "  绝对路径: " << absPath << std::endl;
+            ctx.out() << "路径信息:" << std::endl;
+            ctx.out() << "  绝对路径: " << absPath << std::endl;
             
             if (std::filesystem::is_directory(path)) {
-                std::cout << "  类型: 目录" << std::endl;
+                ctx.out() << "  类型: 目录" << std::endl;
                 int fileCount = 0;
                 for (const auto& entry : std::filesystem::directory_iterator(path)) {
                     fileCount++;
                 }
-                std::cout << "  包含项目数: " << fileCount << std::endl;
+                ctx.out() << "  包含项目数: " << fileCount << std::endl;
             } else if (std::filesystem::is_regular_file(path)) {
-                std::cout << "  类型: 文件" << std::endl;
-                std::cout << "  大小: " << std::filesystem::file_size(path) << " bytes" << std::endl;
+                ctx.out() << "  类型: 文件" << std::endl;
+                ctx.out() << "  大小: " << std::filesystem::file_size(path) << " bytes" << std::endl;
             }
             
             auto lastWrite = std::filesystem::last_write_time(path);
@@ -281,11 +1050,11 @@ private:
                     std::chrono::system_clock::now()
                 )
             );
-            std::cout << "  最后修改: " << std::ctime(&sctp);
+            ctx.out() << "  最后修改: " << std::ctime(&sctp);
             
             return true;
         } catch (const std::exception& e) {
-            std::cerr << "✗ 获取信息失败: " << e.what() << std::endl;
+            ctx.err() << "✗ 获取信息失败: " << e.what() << std::endl;
             return false;
         }
     }
@@ -298,14 +1067,32 @@ int main(int argc, char* argv[]) {
     SimpleFileManager manager;
     auto cmd = manager.initialize();
     
+    // CCM_PERF_COUNTERS=1 时在 stats 中显示每个命令的硬件性能计数器；
+    // CCM_SLOW_US=<微秒> 时把超过该耗时的命令写入慢命令日志（CCM_SLOW_LOG 指定文件）
+    CommandManager::Config config = cmd.getConfig();
+    const char* perf = std::getenv("CCM_PERF_COUNTERS");
+    config.collectPerfCounters = perf && std::string(perf) == "1";
+    const char* slowUs = std::getenv("CCM_SLOW_US");
+    const char* slowPath = std::getenv("CCM_SLOW_LOG");
+    config.slowCommandThresholdUs = slowUs ? static_cast<uint32_t>(std::strtoul(slowUs, nullptr, 10)) : 0;
+    config.slowLogPath = slowPath ? slowPath : "";
+    cmd.setConfig(config);
+    
+    int status = 0;
     if (argc > 1) {
-        // 命令行模式
-        return cmd.processArgs(argc, argv) ? 0 : 1;
+        // 命令行模式，跳过程序名
+        status = cmd.processArgs(argc - 1, argv + 1) ? 0 : 1;
     } else {
         // 交互模式
         std::cout << "ConsoleCommandManager - 文件管理器示例" << std::endl;
         std::cout << "输入 'help' 查看帮助，'list' 列出所有命令" << std::endl;
         cmd.runInteractive();
-        return 0;
     }
+    
+#ifdef CCM_ALLOC_ACCOUNTING
+    // filemanager_alloccount: 退出时输出分配报告
+    std::cerr << "\n内存分配:\n";
+    cmd.writeAllocationReport(std::cerr);
+#endif
+    return status;
 }
@@ -0,0 +1,169 @@
+/**
+ * @file FuzzCommon.h
+ * @brief fuzz 目标共用的单输入时间和分配预算
+ * @details 每个输入的耗时和分配字节数都有与输入长度成线性关系的预算：
+ *          预算 = 基数 + 每字节额度 × 输入长度。超出预算说明处理代价随输入超线性增长
+ *          （例如平方级的拼接），按发现处理：打印输入摘要后 abort()，
+ *          libFuzzer 会把该输入保存为 crash-* 文件。
+ *
+ * 每字节额度按线性基准校准：用 64 KiB 的重复片段输入测得最慢的线性路径在 -O2 下约 40ns/字节，
+ * ASan+UBSan 下约 150ns/字节，默认值再留出约 3 倍余量；平方级路径在几十 KiB 的输入上就会超出。
+ * 在更慢的环境中可用 CCM_FUZZ_TIME_PER_BYTE_NS 放宽。
+ *
+ * 时间超预算时会重跑一次确认，避免调度抖动和冷缓存造成误报；分配量是确定的，不重跑。
+ *
+ * 分配量的来源：
+ * - libFuzzer/sanitizer 构建：通过 __sanitizer_install_malloc_and_free_hooks 统计
+ * - 独立驱动构建（定义了 CCM_ALLOC_ACCOUNTING）：使用 ConsoleCommandAlloc.h 的计数器
+ * - 两者都没有时只检查时间
+ *
+ * 预算可用环境变量调整：CCM_FUZZ_TIME_BASE_US、CCM_FUZZ_TIME_PER_BYTE_NS、
+ * CCM_FUZZ_ALLOC_BASE、CCM_FUZZ_ALLOC_PER_BYTE。
+ */
+
+#ifndef CONSOLE_COMMAND_FUZZ_COMMON_H
+#define CONSOLE_COMMAND_FUZZ_COMMON_H
+
+#include "ConsoleCommandAlloc.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+extern "C" int __sanitizer_install_malloc_and_free_hooks(
+    void (*malloc_hook)(const volatile void*, size_t),
+    void (*free_hook)(const volatile void*)) __attribute__((weak));
+
+namespace ConsoleCommand {
+namespace fuzz {
+
+/**
+ * @struct Budget
+ * @brief 单个输入的预算
+ */
+struct Budget {
+    uint64_t timeBaseNanos = 20000000;      ///< 时间基数（20ms，覆盖 sanitizer 的开销）
+    uint64_t timePerByteNanos = 500;        ///< 每字节时间额度
+    uint64_t allocBaseBytes = 1 << 20;      ///< 分配基数
+    uint64_t allocPerByte = 512;            ///< 每字节分配额度
+
+    uint64_t timeLimit(size_t size) const { return timeBaseNanos + timePerByteNanos * size; }
+    uint64_t allocLimit(size_t size) const { return allocBaseBytes + allocPerByte * size; }
+};
+
+namespace detail {
+
+inline std::atomic<uint64_t>& hookedBytes() {
+    static std::atomic<uint64_t> bytes{0};
+    return bytes;
+}
+
+inline void mallocHook(const volatile void*, size_t size) {
+    hookedBytes().fetch_add(size, std::memory_order_relaxed);
+}
+
+inline void freeHook(const volatile void*) {}
+
+inline uint64_t envOr(const char* name, uint64_t fallback) {
+    const char* value = std::getenv(name);
+    return value && *value ? std::strtoull(value, nullptr, 10) : fallback;
+}
+
+/**
+ * @brief 打印输入的前若干字节，不可打印字符转义
+ */
+inline void printPreview(const uint8_t* data, size_t size) {
+    std::fprintf(stderr, "  输入（%zu 字节）: \"", size);
+    size_t shown = size < 96 ? size : 96;
+    for (size_t i = 0; i < shown; ++i) {
+        unsigned char c = data[i];
+        if (c == '"' || c == '\\') std::fprintf(stderr, "\\%c", c);
+        else if (c >= 0x20 && c < 0x7F) std::fputc(c, stderr);
+        else std::fprintf(stderr, "\\x%02x", c);
+    }
+    std::fprintf(stderr, "\"%s\n", shown < size ? "..." : "");
+}
+
+} // namespace detail
+
+/**
+ * @brief 进程的预算设置，首次调用时读取环境变量
+ */
+inline const Budget& budget() {
+    static const Budget b = [] {
+        Budget d;
+        d.timeBaseNanos = detail::envOr("CCM_FUZZ_TIME_BASE_US", d.timeBaseNanos / 1000) * 1000;
+        d.timePerByteNanos = detail::envOr("CCM_FUZZ_TIME_PER_BYTE_NS", d.timePerByteNanos);
+        d.allocBaseBytes = detail::envOr("CCM_FUZZ_ALLOC_BASE", d.allocBaseBytes);
+        d.allocPerByte = detail::envOr("CCM_FUZZ_ALLOC_PER_BYTE", d.allocPerByte);
+        return d;
+    }();
+    return b;
+}
+
+/**
+ * @brief 进程累计分配的字节数
+ * @param available 输出：是否有可用的统计来源
+ */
+inline uint64_t allocatedBytes(bool& available) {
+    static const bool hooked = __sanitizer_install_malloc_and_free_hooks &&
+                               __sanitizer_install_malloc_and_free_hooks(detail::mallocHook, detail::freeHook) != 0;
+    if (hooked) {
+        available = true;
+        return detail::hookedBytes().load(std::memory_order_relaxed);
+    }
+    available = AllocAccounting::compiledIn();
+    uint64_t total = 0;
+    for (size_t p = 0; p < ALLOC_PHASE_COUNT; ++p) {
+        total += AllocAccounting::phase(static_cast<AllocPhase>(p)).bytes;
+    }
+    return total;
+}
+
+/**
+ * @brief 在预算内执行一个输入，超出预算时报告并 abort()
+ * @param target 目标名称，用于报告
+ * @param func 处理输入的函数
+ */
+template<typename Func>
+void runWithBudget(const char* target, const uint8_t* data, size_t size, Func&& func) {
+    using Clock = std::chrono::steady_clock;
+    const Budget& b = budget();
+
+    bool allocAvailable = false;
+    uint64_t bytesBefore = allocatedBytes(allocAvailable);
+    auto start = Clock::now();
+    func();
+    uint64_t nanos = static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    uint64_t bytes = allocatedBytes(allocAvailable) - bytesBefore;
+
+    if (allocAvailable && bytes > b.allocLimit(size)) {
+        std::fprintf(stderr, "\n==ccm-fuzz== %s: 分配 %llu 字节，超出预算 %llu 字节\n", target,
+                     static_cast<unsigned long long>(bytes), static_cast<unsigned long long>(b.allocLimit(size)));
+        detail::printPreview(data, size);
+        std::abort();
+    }
+
+    if (nanos > b.timeLimit(size)) {
+        start = Clock::now();
+        func();
+        uint64_t retry = static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+        if (retry > b.timeLimit(size)) {
+            std::fprintf(stderr, "\n==ccm-fuzz== %s: 耗时 %lluus（重跑 %lluus），超出预算 %lluus\n", target,
+                         static_cast<unsigned long long>(nanos / 1000), static_cast<unsigned long long>(retry / 1000),
+                         static_cast<unsigned long long>(b.timeLimit(size) / 1000));
+            detail::printPreview(data, size);
+            std::abort();
+        }
+    }
+}
+
+} // namespace fuzz
+} // namespace ConsoleCommand
+
+#endif // CONSOLE_COMMAND_FUZZ_COMMON_H
@@ -0,0 +1,35 @@
+/**
+ * @file fuzz_parse_args.cpp
+ * @brief CommandContext argc/argv 解析的 fuzz 目标
+ * @details 输入按 '\0' 切分为 argv 各项，语料中的文件也使用这种格式
+ */
+
+#include "ConsoleCommandManager.h"
+#include "FuzzCommon.h"
+
+#include <string>
+#include <vector>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::vector<std::string> storage;
+    const char* begin = reinterpret_cast<const char*>(data);
+    const char* end = begin + size;
+    for (const char* p = begin; p <= end; ++p) {
+        if (p == end || *p == '\0') {
+            storage.emplace_back(begin, p);
+            begin = p + 1;
+        }
+    }
+    std::vector<char*> argv;
+    for (auto& arg : storage) {
+        argv.push_back(&arg[0]);
+    }
+    argv.push_back(nullptr);
+
+    ConsoleCommand::fuzz::runWithBudget("parseArgs", data, size, [&argv] {
+        ConsoleCommand::CommandContext ctx(static_cast<int>(argv.size() - 1), argv.data());
+        volatile size_t sink = ctx.argumentCount() + ctx.getAllOptions().size() + ctx.getAllFlags().size();
+        (void)sink;
+    });
+    return 0;
+}
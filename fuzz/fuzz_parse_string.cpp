@@ -0,0 +1,19 @@
+/**
+ * @file fuzz_parse_string.cpp
+ * @brief CommandContext 字符串解析（分词、引号拼接、选项解析）的 fuzz 目标
+ */
+
+#include "ConsoleCommandManager.h"
+#include "FuzzCommon.h"
+
+#include <string>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    std::string input(reinterpret_cast<const char*>(data), size);
+    ConsoleCommand::fuzz::runWithBudget("parseString", data, size, [&input] {
+        ConsoleCommand::CommandContext ctx(input);
+        volatile size_t sink = ctx.argumentCount() + ctx.getAllOptions().size() + ctx.getAllFlags().size();
+        (void)sink;
+    });
+    return 0;
+}
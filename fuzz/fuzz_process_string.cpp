@@ -0,0 +1,78 @@
+/**
+ * @file fuzz_process_string.cpp
+ * @brief processString 端到端（解析、查找、未知命令建议、验证、帮助、内置命令）的 fuzz 目标
+ * @details 注册与示例文件管理器参数结构相同、执行器不做 I/O 的命令。
+ *          每个输入在新会话中执行，set 等内置命令不会在输入之间累积状态；
+ *          命令输出被丢弃，预算报告直接写 stderr。
+ *          构建时定义 CCM_DISABLE_TRACING，trace dump 不会写文件；定义 CCM_DISABLE_FILE_BUILTINS，
+ *          registry snapshot、catalog compile 不会写文件，catalog load/off 不会修改进程级的消息目录。
+ */
+
+#include "ConsoleCommandManager.h"
+#include "FuzzCommon.h"
+
+#include <iostream>
+#include <string>
+
+using namespace ConsoleCommand;
+
+namespace {
+
+class NullBuffer : public std::streambuf {
+protected:
+    int overflow(int c) override { return c; }
+    std::streamsize xsputn(const char*, std::streamsize n) override { return n; }
+};
+
+bool noop(const CommandContext& ctx) {
+    return ctx.argumentCount() < 64;
+}
+
+void registerCommands(CommandManager& m) {
+    m.createCommand("ls", "列出目录内容", noop)
+        .addParameter("path", "目录路径", false, ".", TYPE_PATH)
+        .addOption("long", "l", "长格式显示", false)
+        .addOption("all", "a", "显示隐藏文件", false);
+    m.createCommand("cp", "复制文件或目录", noop)
+        .addParameter("source", "源文件路径", true, "", TYPE_FILE)
+        .addParameter("dest", "目标文件路径", true, "", TYPE_FILE)
+        .addOption("recursive", "r", "递归复制目录", false)
+        .addOption("force", "f", "覆盖目标文件", false);
+    m.createCommand("rm", "删除文件或目录", noop)
+        .addParameter("path", "要删除的路径", true, "", TYPE_PATH)
+        .addOption("recursive", "r", "递归删除目录", false);
+    m.createCommand("cat", "显示文件内容", noop)
+        .addParameter("file", "文件路径", true, "", TYPE_FILE)
+        .addOption("lines", "n", "最多显示的行数", true, "0", "行数");
+    m.createCommand("sleep", "等待指定时间", noop)
+        .addParameter("seconds", "秒数", true, "", TYPE_FLOAT)
+        .addParameter("repeat", "次数", false, "1", TYPE_INTEGER)
+        .addParameter("quiet", "安静模式", false, "false", TYPE_BOOL);
+    m.createCommand("echo", "输出参数", noop)
+        .addParameter("...", "任意参数", false);
+}
+
+CommandManager& fuzzManager() {
+    static NullBuffer discard;
+    static CommandManager manager;
+    static bool initialized = [] {
+        std::cout.rdbuf(&discard);
+        std::cerr.rdbuf(&discard);
+        registerCommands(manager);
+        return true;
+    }();
+    (void)initialized;
+    return manager;
+}
+
+} // namespace
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    CommandManager& manager = fuzzManager();
+    std::string input(reinterpret_cast<const char*>(data), size);
+    ConsoleCommand::fuzz::runWithBudget("processString", data, size, [&manager, &input] {
+        Session session = manager.createSession();
+        manager.processString(input, session);
+    });
+    return 0;
+}
@@ -0,0 +1,172 @@
+/**
+ * @file standalone_main.cpp
+ * @brief 没有 libFuzzer 时使用的 fuzz 驱动
+ * @details 与 fuzz 目标链接成普通程序（GCC 等不支持 -fsanitize=fuzzer 的编译器）：
+ *          - 依次执行命令行给出的文件和目录（不递归）中的每个输入，用于回放语料和 crash 文件
+ *          - 指定 -runs=N 时再从语料中随机选取输入做 N 次变异执行。变异没有覆盖率反馈，
+ *            但包含把片段重复多次的放大操作，能暴露代价随输入长度超线性增长的路径
+ *
+ *          本文件生成分配统计用的 operator new/delete，时间和分配预算与 libFuzzer 构建相同。
+ *          变异输入触发 abort() 时写入当前目录的 crash-standalone 文件，可直接作为参数回放。
+ *
+ * 用法: fuzz_目标 [-runs=N] [-seed=S] [-max_len=N] 文件或目录...
+ */
+
+#define CCM_ALLOC_DEFINE_OPERATORS
+#include "ConsoleCommandAlloc.h"
+
+#include <algorithm>
+#include <csignal>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size);
+
+namespace {
+
+using Input = std::vector<uint8_t>;
+
+const Input* currentInput = nullptr;    ///< 正在执行的变异输入
+
+/**
+ * @brief SIGABRT 处理：保存触发问题的输入（只使用异步信号安全的调用）
+ */
+void saveCrashInput(int sig) {
+    if (currentInput) {
+        int fd = ::open("crash-standalone", O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd >= 0) {
+            ssize_t written = ::write(fd, currentInput->data(), currentInput->size());
+            (void)written;
+            ::close(fd);
+        }
+        const char msg[] = "==ccm-fuzz== 输入已保存到 crash-standalone\n";
+        ssize_t written = ::write(STDERR_FILENO, msg, sizeof(msg) - 1);
+        (void)written;
+    }
+    std::signal(sig, SIG_DFL);
+    std::raise(sig);
+}
+
+bool readFile(const std::filesystem::path& path, Input& out) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file) return false;
+    out.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+/**
+ * @brief 对输入做 1~4 次随机变异
+ */
+void mutate(Input& input, std::mt19937_64& rng, size_t maxLen) {
+    static const char* tokens[] = {"\"", " ", "-", "--", "=", "\"\"", "-- ", "help", "\t", "\n"};
+    auto pick = [&rng](size_t n) { return static_cast<size_t>(rng() % n); };
+
+    for (size_t round = 1 + pick(4); round > 0; --round) {
+        switch (pick(6)) {
+            case 0:     // 翻转一个字节的某一位
+                if (!input.empty()) input[pick(input.size())] ^= static_cast<uint8_t>(1u << pick(8));
+                break;
+            case 1:     // 插入随机字节
+                input.insert(input.begin() + static_cast<std::ptrdiff_t>(pick(input.size() + 1)),
+                             static_cast<uint8_t>(rng()));
+                break;
+            case 2:     // 删除一段
+                if (!input.empty()) {
+                    size_t pos = pick(input.size());
+                    size_t len = 1 + pick(std::min<size_t>(8, input.size() - pos));
+                    input.erase(input.begin() + static_cast<std::ptrdiff_t>(pos),
+                                input.begin() + static_cast<std::ptrdiff_t>(pos + len));
+                }
+                break;
+            case 3: {   // 插入语法相关的记号
+                const char* t = tokens[pick(sizeof(tokens) / sizeof(tokens[0]))];
+                input.insert(input.begin() + static_cast<std::ptrdiff_t>(pick(input.size() + 1)),
+                             t, t + std::strlen(t));
+                break;
+            }
+            default: {  // 把一段重复多次，放大输入
+                if (input.empty()) break;
+                size_t pos = pick(input.size());
+                size_t len = 1 + pick(std::min<size_t>(16, input.size() - pos));
+                Input chunk(input.begin() + static_cast<std::ptrdiff_t>(pos),
+                            input.begin() + static_cast<std::ptrdiff_t>(pos + len));
+                size_t times = 1 + pick(256);
+                for (size_t i = 0; i < times && input.size() + chunk.size() <= maxLen; ++i) {
+                    input.insert(input.begin() + static_cast<std::ptrdiff_t>(pos), chunk.begin(), chunk.end());
+                }
+                break;
+            }
+        }
+    }
+    if (input.size() > maxLen) input.resize(maxLen);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint64_t runs = 0;
+    uint64_t seed = 1;
+    size_t maxLen = 4096;
+    std::vector<Input> corpus;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 6, "-runs=") == 0) {
+            runs = std::strtoull(arg.c_str() + 6, nullptr, 10);
+        } else if (arg.compare(0, 6, "-seed=") == 0) {
+            seed = std::strtoull(arg.c_str() + 6, nullptr, 10);
+        } else if (arg.compare(0, 9, "-max_len=") == 0) {
+            maxLen = std::strtoull(arg.c_str() + 9, nullptr, 10);
+        } else if (!arg.empty() && arg[0] == '-') {
+            std::fprintf(stderr, "忽略不支持的参数: %s\n", arg.c_str());
+        } else {
+            std::error_code ec;
+            std::vector<std::filesystem::path> files;
+            if (std::filesystem::is_directory(arg, ec)) {
+                for (const auto& entry : std::filesystem::directory_iterator(arg, ec)) {
+                    if (entry.is_regular_file()) files.push_back(entry.path());
+                }
+                std::sort(files.begin(), files.end());
+            } else {
+                files.push_back(arg);
+            }
+            for (const auto& path : files) {
+                Input input;
+                if (!readFile(path, input)) {
+                    std::fprintf(stderr, "无法读取 %s\n", path.string().c_str());
+                    return 1;
+                }
+                LLVMFuzzerTestOneInput(input.data(), input.size());
+                corpus.push_back(std::move(input));
+            }
+        }
+    }
+    std::fprintf(stderr, "已执行 %zu 个语料输入\n", corpus.size());
+
+    if (runs > 0) {
+        if (corpus.empty()) corpus.emplace_back();
+        std::signal(SIGABRT, saveCrashInput);
+        std::mt19937_64 rng(seed);
+        for (uint64_t r = 0; r < runs; ++r) {
+            Input input = corpus[static_cast<size_t>(rng() % corpus.size())];
+            mutate(input, rng, maxLen);
+            currentInput = &input;
+            LLVMFuzzerTestOneInput(input.data(), input.size());
+            currentInput = nullptr;
+        }
+        std::fprintf(stderr, "已执行 %llu 次变异输入（种子 %llu）\n",
+                     static_cast<unsigned long long>(runs), static_cast<unsigned long long>(seed));
+    }
+    return 0;
+}